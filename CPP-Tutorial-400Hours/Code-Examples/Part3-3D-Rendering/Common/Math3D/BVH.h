@@ -0,0 +1,628 @@
+#pragma once
+
+// Bounding volume hierarchy over a triangle mesh
+//
+// RayTriangleIntersection tests one triangle, so tracing a mesh with it is
+// brute force over every triangle. BVH sorts the triangles into a tree of
+// boxes, and a ray only tests the triangles in the boxes it passes through.
+//
+// - Build: binned surface area heuristic (SAH). Large subtrees are built
+//   on extra threads when threadCount > 1.
+// - Nodes are flattened into one array, 32 bytes each. The two children
+//   of a node are adjacent, so a node stores a single index.
+// - Intersect finds the closest hit, Occluded stops at any hit (shadow
+//   rays), IntersectPacket traces Simd::WIDTH rays together with SIMD slab
+//   and triangle tests (4 with SSE2, 8 with AVX).
+// - Refit moves the boxes to new vertex positions without rebuilding, for
+//   animated meshes whose topology does not change.
+//
+// Hits match RayTriangleIntersection built with the same flags. With FMA
+// enabled the compiler may fuse the scalar math, so packet and single-ray
+// distances can then differ in the last bit.
+//
+// Included by Math3D.h.
+
+#include "Math3D.h"
+#include "SimdFloat.h"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <thread>
+#include <vector>
+
+namespace Math3D {
+
+struct RayHit {
+    static constexpr uint32_t NONE = 0xFFFFFFFFu;
+
+    float t = std::numeric_limits<float>::infinity();  // set to limit the search
+    float u = 0.0f;                                    // barycentric weight of v1
+    float v = 0.0f;                                    // barycentric weight of v2
+    uint32_t triangle = NONE;                          // index in the built mesh
+
+    bool Hit() const {
+        return triangle != NONE;
+    }
+};
+
+// Interior nodes keep their left child in leftOrFirst (the right child
+// follows it) and count == 0. Leaves keep their first triangle and count.
+struct BVHNode {
+    Vector3 boundsMin;
+    uint32_t leftOrFirst;
+    Vector3 boundsMax;
+    uint32_t count;
+
+    bool IsLeaf() const {
+        return count > 0;
+    }
+};
+static_assert(sizeof(BVHNode) == 32, "BVHNode should fill half a cache line");
+
+class BVH {
+public:
+    static constexpr int BINS = 16;
+    static constexpr uint32_t MAX_LEAF_SIZE = 4;
+    static constexpr int MAX_DEPTH = 64;                  // also the traversal stack size
+    static constexpr uint32_t PARALLEL_BUILD_MIN = 16384; // triangles per extra thread
+    static constexpr float TRAVERSAL_COST = 1.0f;         // relative to one triangle test
+
+    // indices holds 3 vertex indices per triangle
+    void Build(const std::vector<Vector3>& vertices, const std::vector<uint32_t>& indices,
+               unsigned threadCount = 1) {
+        Build(vertices.data(), indices.data(), indices.size() / 3, threadCount);
+    }
+
+    void Build(const Vector3* vertices, const uint32_t* indices, size_t triangleCount,
+               unsigned threadCount = 1) {
+        indices_.assign(indices, indices + triangleCount * 3);
+        nodes_.clear();
+        triangles_.clear();
+        triangleIds_.clear();
+        if (triangleCount == 0) {
+            return;
+        }
+
+        std::vector<BuildPrimitive> primitives(triangleCount);
+        for (size_t i = 0; i < triangleCount; i++) {
+            BuildPrimitive& p = primitives[i];
+            const Vector3& v0 = vertices[indices[i * 3]];
+            const Vector3& v1 = vertices[indices[i * 3 + 1]];
+            const Vector3& v2 = vertices[indices[i * 3 + 2]];
+            p.boundsMin = Vector3(std::min({v0.x, v1.x, v2.x}), std::min({v0.y, v1.y, v2.y}), std::min({v0.z, v1.z, v2.z}));
+            p.boundsMax = Vector3(std::max({v0.x, v1.x, v2.x}), std::max({v0.y, v1.y, v2.y}), std::max({v0.z, v1.z, v2.z}));
+            p.centroid = (p.boundsMin + p.boundsMax) * 0.5f;
+            p.id = static_cast<uint32_t>(i);
+        }
+
+        // A binary tree with at least one triangle per leaf has < 2n nodes
+        nodes_.resize(triangleCount * 2);
+        BuildContext context{primitives.data(), {1}, {static_cast<int>(threadCount) - 1}};
+        Subdivide(context, 0, 0, static_cast<uint32_t>(triangleCount), 0);
+        nodes_.resize(context.nodeCount.load());
+        nodes_.shrink_to_fit();
+
+        triangles_.resize(triangleCount);
+        triangleIds_.resize(triangleCount);
+        for (size_t i = 0; i < triangleCount; i++) {
+            triangleIds_[i] = primitives[i].id;
+        }
+        UpdateTriangles(vertices);
+    }
+
+    // Same mesh topology, new vertex positions: recomputes every box
+    // bottom-up but keeps the tree. Much faster than Build, but the tree
+    // gets slower to trace as the mesh moves away from its built shape.
+    void Refit(const Vector3* vertices) {
+        UpdateTriangles(vertices);
+
+        // Children always come after their parent in nodes_
+        for (size_t n = nodes_.size(); n-- > 0;) {
+            BVHNode& node = nodes_[n];
+            if (node.IsLeaf()) {
+                Vector3 boundsMin(std::numeric_limits<float>::max());
+                Vector3 boundsMax(-std::numeric_limits<float>::max());
+                for (uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.count; i++) {
+                    const uint32_t* tri = &indices_[triangleIds_[i] * size_t(3)];
+                    for (int k = 0; k < 3; k++) {
+                        Grow(boundsMin, boundsMax, vertices[tri[k]]);
+                    }
+                }
+                node.boundsMin = boundsMin;
+                node.boundsMax = boundsMax;
+            } else {
+                const BVHNode& left = nodes_[node.leftOrFirst];
+                const BVHNode& right = nodes_[node.leftOrFirst + 1];
+                node.boundsMin = Vector3(std::min(left.boundsMin.x, right.boundsMin.x),
+                                         std::min(left.boundsMin.y, right.boundsMin.y),
+                                         std::min(left.boundsMin.z, right.boundsMin.z));
+                node.boundsMax = Vector3(std::max(left.boundsMax.x, right.boundsMax.x),
+                                         std::max(left.boundsMax.y, right.boundsMax.y),
+                                         std::max(left.boundsMax.z, right.boundsMax.z));
+            }
+        }
+    }
+
+    void Refit(const std::vector<Vector3>& vertices) {
+        Refit(vertices.data());
+    }
+
+    // Closest hit closer than hit.t. Returns true and fills hit when found.
+    bool Intersect(const Ray& ray, RayHit& hit) const {
+        if (nodes_.empty()) {
+            return false;
+        }
+        const Vector3 invDir(1.0f / ray.direction.x, 1.0f / ray.direction.y, 1.0f / ray.direction.z);
+        if (SlabEntry(nodes_[0], ray.origin, invDir, hit.t) == NO_ENTRY) {
+            return false;
+        }
+
+        struct Entry { uint32_t node; float distance; };
+        Entry stack[MAX_DEPTH];
+        int stackSize = 0;
+        uint32_t nodeIndex = 0;
+        bool found = false;
+
+        while (true) {
+            const BVHNode& node = nodes_[nodeIndex];
+            if (node.IsLeaf()) {
+                for (uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.count; i++) {
+                    if (IntersectTriangle(triangles_[i], ray, hit)) {
+                        hit.triangle = triangleIds_[i];
+                        found = true;
+                    }
+                }
+            } else {
+                // Visit the nearer child first; its hits can prune the other
+                uint32_t nearChild = node.leftOrFirst;
+                uint32_t farChild = nearChild + 1;
+                float nearDistance = SlabEntry(nodes_[nearChild], ray.origin, invDir, hit.t);
+                float farDistance = SlabEntry(nodes_[farChild], ray.origin, invDir, hit.t);
+                if (farDistance < nearDistance) {
+                    std::swap(nearChild, farChild);
+                    std::swap(nearDistance, farDistance);
+                }
+                if (nearDistance != NO_ENTRY) {
+                    if (farDistance != NO_ENTRY) {
+                        stack[stackSize++] = {farChild, farDistance};
+                    }
+                    nodeIndex = nearChild;
+                    continue;
+                }
+            }
+
+            // Pop the next subtree that can still hold a closer hit
+            do {
+                if (stackSize == 0) {
+                    return found;
+                }
+                stackSize--;
+            } while (stack[stackSize].distance >= hit.t);
+            nodeIndex = stack[stackSize].node;
+        }
+    }
+
+    // Any hit closer than maxDistance, e.g. a shadow ray toward a light
+    bool Occluded(const Ray& ray, float maxDistance) const {
+        if (nodes_.empty()) {
+            return false;
+        }
+        const Vector3 invDir(1.0f / ray.direction.x, 1.0f / ray.direction.y, 1.0f / ray.direction.z);
+        RayHit hit;
+        hit.t = maxDistance;
+
+        uint32_t stack[MAX_DEPTH];
+        int stackSize = 0;
+        uint32_t nodeIndex = 0;
+        while (true) {
+            const BVHNode& node = nodes_[nodeIndex];
+            if (SlabEntry(node, ray.origin, invDir, maxDistance) != NO_ENTRY) {
+                if (!node.IsLeaf()) {
+                    stack[stackSize++] = node.leftOrFirst + 1;
+                    nodeIndex = node.leftOrFirst;
+                    continue;
+                }
+                for (uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.count; i++) {
+                    if (IntersectTriangle(triangles_[i], ray, hit)) {
+                        return true;
+                    }
+                }
+            }
+            if (stackSize == 0) {
+                return false;
+            }
+            nodeIndex = stack[--stackSize];
+        }
+    }
+
+    // Closest hits of Simd::WIDTH rays traced together. A node is visited
+    // when any ray of the packet enters it, so packets should be coherent
+    // (neighbouring pixels, rays toward one light).
+    void IntersectPacket(const Ray* rays, RayHit* hits) const {
+        using namespace Simd;
+        if (nodes_.empty()) {
+            return;
+        }
+
+        alignas(32) float lanes[12][WIDTH];
+        for (int i = 0; i < WIDTH; i++) {
+            const Ray& ray = rays[i];
+            lanes[0][i] = ray.origin.x;
+            lanes[1][i] = ray.origin.y;
+            lanes[2][i] = ray.origin.z;
+            lanes[3][i] = ray.direction.x;
+            lanes[4][i] = ray.direction.y;
+            lanes[5][i] = ray.direction.z;
+            lanes[6][i] = 1.0f / ray.direction.x;
+            lanes[7][i] = 1.0f / ray.direction.y;
+            lanes[8][i] = 1.0f / ray.direction.z;
+            lanes[9][i] = hits[i].t;
+            lanes[10][i] = hits[i].u;
+            lanes[11][i] = hits[i].v;
+        }
+        const Batch ox = Load(lanes[0]), oy = Load(lanes[1]), oz = Load(lanes[2]);
+        const Batch dx = Load(lanes[3]), dy = Load(lanes[4]), dz = Load(lanes[5]);
+        const Batch invX = Load(lanes[6]), invY = Load(lanes[7]), invZ = Load(lanes[8]);
+        Batch tBest = Load(lanes[9]);
+        Batch uBest = Load(lanes[10]);
+        Batch vBest = Load(lanes[11]);
+        uint32_t ids[WIDTH];
+        for (int i = 0; i < WIDTH; i++) {
+            ids[i] = hits[i].triangle;
+        }
+
+        const Batch zero = Set1(0.0f);
+        const Batch one = Set1(1.0f);
+        const Batch epsilon = Set1(TRIANGLE_EPSILON);
+        const Batch negEpsilon = Set1(-TRIANGLE_EPSILON);
+
+        auto dot = [](Batch ax, Batch ay, Batch az, Batch bx, Batch by, Batch bz) {
+            return Add(Add(Mul(ax, bx), Mul(ay, by)), Mul(az, bz));
+        };
+
+        uint32_t stack[MAX_DEPTH];
+        int stackSize = 0;
+        uint32_t nodeIndex = 0;
+        while (true) {
+            const BVHNode& node = nodes_[nodeIndex];
+
+            // Slab test of the node's box against every ray
+            const Batch t0x = Mul(Sub(Set1(node.boundsMin.x), ox), invX);
+            const Batch t1x = Mul(Sub(Set1(node.boundsMax.x), ox), invX);
+            const Batch t0y = Mul(Sub(Set1(node.boundsMin.y), oy), invY);
+            const Batch t1y = Mul(Sub(Set1(node.boundsMax.y), oy), invY);
+            const Batch t0z = Mul(Sub(Set1(node.boundsMin.z), oz), invZ);
+            const Batch t1z = Mul(Sub(Set1(node.boundsMax.z), oz), invZ);
+            const Batch tEnter = Max(Max(Min(t0x, t1x), Min(t0y, t1y)), Max(Min(t0z, t1z), zero));
+            const Batch tExit = Min(Min(Max(t0x, t1x), Max(t0y, t1y)), Min(Max(t0z, t1z), tBest));
+
+            if (MoveMask(GreaterEqual(tExit, tEnter)) != 0) {
+                if (!node.IsLeaf()) {
+                    // Order the children along the first ray
+                    const BVHNode& left = nodes_[node.leftOrFirst];
+                    const BVHNode& right = nodes_[node.leftOrFirst + 1];
+                    const Vector3 toRight = (right.boundsMin + right.boundsMax) - (left.boundsMin + left.boundsMax);
+                    const bool rightFirst = toRight.Dot(rays[0].direction) < 0.0f;
+                    stack[stackSize++] = node.leftOrFirst + (rightFirst ? 0 : 1);
+                    nodeIndex = node.leftOrFirst + (rightFirst ? 1 : 0);
+                    continue;
+                }
+
+                // Moller-Trumbore against every ray, as in RayTriangleIntersection
+                for (uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.count; i++) {
+                    const Triangle& tri = triangles_[i];
+                    const Batch e1x = Set1(tri.edge1.x), e1y = Set1(tri.edge1.y), e1z = Set1(tri.edge1.z);
+                    const Batch e2x = Set1(tri.edge2.x), e2y = Set1(tri.edge2.y), e2z = Set1(tri.edge2.z);
+
+                    const Batch hx = Sub(Mul(dy, e2z), Mul(dz, e2y));
+                    const Batch hy = Sub(Mul(dz, e2x), Mul(dx, e2z));
+                    const Batch hz = Sub(Mul(dx, e2y), Mul(dy, e2x));
+                    const Batch a = dot(e1x, e1y, e1z, hx, hy, hz);
+                    Batch valid = Or(Greater(a, epsilon), Greater(negEpsilon, a));
+
+                    const Batch f = Div(one, a);
+                    const Batch sx = Sub(ox, Set1(tri.v0.x));
+                    const Batch sy = Sub(oy, Set1(tri.v0.y));
+                    const Batch sz = Sub(oz, Set1(tri.v0.z));
+                    const Batch u = Mul(f, dot(sx, sy, sz, hx, hy, hz));
+                    valid = And(valid, And(GreaterEqual(u, zero), GreaterEqual(one, u)));
+
+                    const Batch qx = Sub(Mul(sy, e1z), Mul(sz, e1y));
+                    const Batch qy = Sub(Mul(sz, e1x), Mul(sx, e1z));
+                    const Batch qz = Sub(Mul(sx, e1y), Mul(sy, e1x));
+                    const Batch v = Mul(f, dot(dx, dy, dz, qx, qy, qz));
+                    valid = And(valid, And(GreaterEqual(v, zero), GreaterEqual(one, Add(u, v))));
+
+                    const Batch t = Mul(f, dot(e2x, e2y, e2z, qx, qy, qz));
+                    valid = And(valid, And(Greater(t, epsilon), Greater(tBest, t)));
+
+                    int mask = MoveMask(valid);
+                    if (mask != 0) {
+                        tBest = Select(valid, t, tBest);
+                        uBest = Select(valid, u, uBest);
+                        vBest = Select(valid, v, vBest);
+                        for (int lane = 0; lane < WIDTH; lane++) {
+                            if (mask & (1 << lane)) {
+                                ids[lane] = triangleIds_[i];
+                            }
+                        }
+                    }
+                }
+            }
+
+            if (stackSize == 0) {
+                break;
+            }
+            nodeIndex = stack[--stackSize];
+        }
+
+        Store(lanes[9], tBest);
+        Store(lanes[10], uBest);
+        Store(lanes[11], vBest);
+        for (int i = 0; i < WIDTH; i++) {
+            hits[i].t = lanes[9][i];
+            hits[i].u = lanes[10][i];
+            hits[i].v = lanes[11][i];
+            hits[i].triangle = ids[i];
+        }
+    }
+
+    // Closest hits of count rays: packets of Simd::WIDTH, then single rays
+    void IntersectRays(const Ray* rays, RayHit* hits, size_t count) const {
+        const size_t width = static_cast<size_t>(Simd::WIDTH);
+        size_t i = 0;
+        for (; i + width <= count; i += width) {
+            IntersectPacket(rays + i, hits + i);
+        }
+        for (; i < count; i++) {
+            Intersect(rays[i], hits[i]);
+        }
+    }
+
+    size_t NodeCount() const {
+        return nodes_.size();
+    }
+
+    size_t TriangleCount() const {
+        return triangles_.size();
+    }
+
+    const std::vector<BVHNode>& Nodes() const {
+        return nodes_;
+    }
+
+    size_t MemoryBytes() const {
+        return nodes_.size() * sizeof(BVHNode) + triangles_.size() * sizeof(Triangle) +
+               triangleIds_.size() * sizeof(uint32_t) + indices_.size() * sizeof(uint32_t);
+    }
+
+private:
+    static constexpr float NO_ENTRY = std::numeric_limits<float>::infinity();
+    static constexpr float TRIANGLE_EPSILON = 0.0000001f;  // as in RayTriangleIntersection
+
+    // Precomputed for Moller-Trumbore, in tree order
+    struct Triangle {
+        Vector3 v0;
+        Vector3 edge1;
+        Vector3 edge2;
+    };
+
+    struct BuildPrimitive {
+        Vector3 boundsMin;
+        Vector3 boundsMax;
+        Vector3 centroid;
+        uint32_t id;
+    };
+
+    struct BuildContext {
+        BuildPrimitive* primitives;
+        std::atomic<uint32_t> nodeCount;
+        std::atomic<int> spareThreads;
+    };
+
+    struct Split {
+        int axis = -1;
+        int bin = 0;
+        float cost = std::numeric_limits<float>::max();
+    };
+
+    std::vector<BVHNode> nodes_;
+    std::vector<Triangle> triangles_;
+    std::vector<uint32_t> triangleIds_;  // mesh index of each triangles_ entry
+    std::vector<uint32_t> indices_;      // the mesh's indices, for Refit
+
+    static void Grow(Vector3& boundsMin, Vector3& boundsMax, const Vector3& p) {
+        boundsMin = Vector3(std::min(boundsMin.x, p.x), std::min(boundsMin.y, p.y), std::min(boundsMin.z, p.z));
+        boundsMax = Vector3(std::max(boundsMax.x, p.x), std::max(boundsMax.y, p.y), std::max(boundsMax.z, p.z));
+    }
+
+    // Half the surface area; only ratios matter to the SAH
+    static float HalfArea(const Vector3& boundsMin, const Vector3& boundsMax) {
+        Vector3 d = boundsMax - boundsMin;
+        return d.x * d.y + d.y * d.z + d.z * d.x;
+    }
+
+    // Distance at which the ray enters the box, or NO_ENTRY if it misses
+    // or enters beyond maxDistance
+    static float SlabEntry(const BVHNode& node, const Vector3& origin, const Vector3& invDir, float maxDistance) {
+        float t0x = (node.boundsMin.x - origin.x) * invDir.x;
+        float t1x = (node.boundsMax.x - origin.x) * invDir.x;
+        float t0y = (node.boundsMin.y - origin.y) * invDir.y;
+        float t1y = (node.boundsMax.y - origin.y) * invDir.y;
+        float t0z = (node.boundsMin.z - origin.z) * invDir.z;
+        float t1z = (node.boundsMax.z - origin.z) * invDir.z;
+        float tEnter = std::max(std::max(std::min(t0x, t1x), std::min(t0y, t1y)), std::max(std::min(t0z, t1z), 0.0f));
+        float tExit = std::min(std::min(std::max(t0x, t1x), std::max(t0y, t1y)), std::min(std::max(t0z, t1z), maxDistance));
+        return tExit >= tEnter ? tEnter : NO_ENTRY;
+    }
+
+    // RayTriangleIntersection with the edges precomputed; only hits closer
+    // than hit.t count
+    static bool IntersectTriangle(const Triangle& tri, const Ray& ray, RayHit& hit) {
+        Vector3 h = ray.direction.Cross(tri.edge2);
+        float a = tri.edge1.Dot(h);
+        if (a > -TRIANGLE_EPSILON && a < TRIANGLE_EPSILON) {
+            return false;
+        }
+
+        float f = 1.0f / a;
+        Vector3 s = ray.origin - tri.v0;
+        float u = f * s.Dot(h);
+        if (u < 0.0f || u > 1.0f) {
+            return false;
+        }
+
+        Vector3 q = s.Cross(tri.edge1);
+        float v = f * ray.direction.Dot(q);
+        if (v < 0.0f || u + v > 1.0f) {
+            return false;
+        }
+
+        float t = f * tri.edge2.Dot(q);
+        if (t <= TRIANGLE_EPSILON || t >= hit.t) {
+            return false;
+        }
+        hit.t = t;
+        hit.u = u;
+        hit.v = v;
+        return true;
+    }
+
+    void UpdateTriangles(const Vector3* vertices) {
+        for (size_t i = 0; i < triangles_.size(); i++) {
+            const uint32_t* tri = &indices_[triangleIds_[i] * size_t(3)];
+            const Vector3& v0 = vertices[tri[0]];
+            triangles_[i] = {v0, vertices[tri[1]] - v0, vertices[tri[2]] - v0};
+        }
+    }
+
+    static int BinOf(float centroid, float centroidMin, float binScale) {
+        return std::min(BINS - 1, static_cast<int>((centroid - centroidMin) * binScale));
+    }
+
+    // Best SAH split of the primitives into centroid bins along any axis
+    static Split FindSplit(const BuildPrimitive* primitives, uint32_t count,
+                           const Vector3& centroidMin, const Vector3& centroidMax) {
+        struct Bin {
+            Vector3 boundsMin = Vector3(std::numeric_limits<float>::max());
+            Vector3 boundsMax = Vector3(-std::numeric_limits<float>::max());
+            uint32_t count = 0;
+        };
+
+        Split best;
+        for (int axis = 0; axis < 3; axis++) {
+            const float extent = centroidMax[axis] - centroidMin[axis];
+            if (extent <= 0.0f) {
+                continue;
+            }
+            const float binScale = BINS / extent;
+
+            Bin bins[BINS];
+            for (uint32_t i = 0; i < count; i++) {
+                const BuildPrimitive& p = primitives[i];
+                Bin& bin = bins[BinOf(p.centroid[axis], centroidMin[axis], binScale)];
+                Grow(bin.boundsMin, bin.boundsMax, p.boundsMin);
+                Grow(bin.boundsMin, bin.boundsMax, p.boundsMax);
+                bin.count++;
+            }
+
+            // Sweep from the left, then from the right, to cost every plane
+            float leftArea[BINS - 1];
+            uint32_t leftCount[BINS - 1];
+            Bin left;
+            for (int b = 0; b < BINS - 1; b++) {
+                if (bins[b].count > 0) {
+                    Grow(left.boundsMin, left.boundsMax, bins[b].boundsMin);
+                    Grow(left.boundsMin, left.boundsMax, bins[b].boundsMax);
+                }
+                left.count += bins[b].count;
+                leftArea[b] = left.count > 0 ? HalfArea(left.boundsMin, left.boundsMax) : 0.0f;
+                leftCount[b] = left.count;
+            }
+            Bin right;
+            for (int b = BINS - 1; b > 0; b--) {
+                if (bins[b].count > 0) {
+                    Grow(right.boundsMin, right.boundsMax, bins[b].boundsMin);
+                    Grow(right.boundsMin, right.boundsMax, bins[b].boundsMax);
+                }
+                right.count += bins[b].count;
+                if (leftCount[b - 1] == 0 || right.count == 0) {
+                    continue;
+                }
+                float cost = leftCount[b - 1] * leftArea[b - 1] +
+                             right.count * HalfArea(right.boundsMin, right.boundsMax);
+                if (cost < best.cost) {
+                    best.axis = axis;
+                    best.bin = b;
+                    best.cost = cost;
+                }
+            }
+        }
+        return best;
+    }
+
+    void Subdivide(BuildContext& context, uint32_t nodeIndex, uint32_t first, uint32_t count, int depth) {
+        BuildPrimitive* primitives = context.primitives + first;
+        Vector3 boundsMin(std::numeric_limits<float>::max());
+        Vector3 boundsMax(-std::numeric_limits<float>::max());
+        Vector3 centroidMin = boundsMin;
+        Vector3 centroidMax = boundsMax;
+        for (uint32_t i = 0; i < count; i++) {
+            Grow(boundsMin, boundsMax, primitives[i].boundsMin);
+            Grow(boundsMin, boundsMax, primitives[i].boundsMax);
+            Grow(centroidMin, centroidMax, primitives[i].centroid);
+        }
+
+        BVHNode& node = nodes_[nodeIndex];
+        node.boundsMin = boundsMin;
+        node.boundsMax = boundsMax;
+        node.leftOrFirst = first;
+        node.count = count;
+        if (count == 1 || depth + 1 >= MAX_DEPTH) {
+            return;
+        }
+
+        const Split split = FindSplit(primitives, count, centroidMin, centroidMax);
+        uint32_t leftCount;
+        if (split.axis >= 0) {
+            // Splitting costs a box test plus both children's triangles
+            const float area = HalfArea(boundsMin, boundsMax);
+            if (count <= MAX_LEAF_SIZE && TRAVERSAL_COST * area + split.cost >= count * area) {
+                return;
+            }
+            const int axis = split.axis;
+            const float centroidStart = centroidMin[axis];
+            const float binScale = BINS / (centroidMax[axis] - centroidStart);
+            BuildPrimitive* middle = std::partition(primitives, primitives + count,
+                [&](const BuildPrimitive& p) { return BinOf(p.centroid[axis], centroidStart, binScale) < split.bin; });
+            leftCount = static_cast<uint32_t>(middle - primitives);
+        } else if (count > MAX_LEAF_SIZE) {
+            // All centroids coincide, so any split is as good as another
+            leftCount = count / 2;
+        } else {
+            return;
+        }
+
+        const uint32_t left = context.nodeCount.fetch_add(2);
+        node.leftOrFirst = left;
+        node.count = 0;
+
+        const uint32_t rightCount = count - leftCount;
+        if (std::min(leftCount, rightCount) >= PARALLEL_BUILD_MIN && context.spareThreads.fetch_sub(1) > 0) {
+            std::thread worker([&]() { Subdivide(context, left, first, leftCount, depth + 1); });
+            Subdivide(context, left + 1, first + leftCount, rightCount, depth + 1);
+            worker.join();
+            context.spareThreads.fetch_add(1);
+        } else {
+            if (std::min(leftCount, rightCount) >= PARALLEL_BUILD_MIN) {
+                context.spareThreads.fetch_add(1);  // undo the failed claim
+            }
+            Subdivide(context, left, first, leftCount, depth + 1);
+            Subdivide(context, left + 1, first + leftCount, rightCount, depth + 1);
+        }
+    }
+};
+
+} // namespace Math3D
@@ -6,6 +6,7 @@
 #include "Vector3.h"
 #include "Matrix4.h"
 #include "Quaternion.h"
+#include "TransformBatch.h"
 #include <algorithm>
 
 namespace Math3D {
@@ -208,11 +209,12 @@ struct Frustum {
         planes[5].normal.z = viewProj.m[11] - viewProj.m[10];
         planes[5].distance = viewProj.m[15] - viewProj.m[14];
 
-        // Normalize all planes
+        // Normalize all planes. The rows give n.p + d >= 0 inside, while
+        // Plane stores n.p = distance on the plane, so distance = -d.
         for (int i = 0; i < 6; i++) {
             float length = planes[i].normal.Length();
             planes[i].normal = planes[i].normal / length;
-            planes[i].distance /= length;
+            planes[i].distance /= -length;
         }
     }
 
@@ -286,3 +288,10 @@ inline bool RayTriangleIntersection(const Ray& ray, const Vector3& v0, const Vec
 }
 
 } // namespace Math3D
+
+// Batch culling of many spheres/AABBs against a Frustum
+#include "FrustumBatch.h"
+// Ray queries against triangle meshes
+#include "BVH.h"
+// Batched NLERP/SLERP and skeleton flattening
+#include "QuaternionBatch.h"
@@ -1,5 +1,6 @@
 #pragma once
 #include "Vector3.h"
+#include "SimdFloat.h"
 #include <cmath>
 #include <cstring>
 #include <iostream>
@@ -8,12 +9,13 @@ namespace Math3D {
 
 class Matrix4 {
 public:
-    // Column-major order (like OpenGL)
-    float m[16];
+    // Column-major order (like OpenGL). 16-byte aligned so each column
+    // loads straight into an SSE register (see SimdFloat.h).
+    alignas(16) float m[16];
 
     // Constructors
     Matrix4() {
-        Identity();
+        SetIdentity();
     }
 
     Matrix4(float diagonal) {
@@ -44,17 +46,49 @@ public:
 
     // Matrix operations
     Matrix4 operator*(const Matrix4& other) const {
+        Matrix4 result;
+        Multiply(*this, other, result);
+        return result;
+    }
+
+    // out = a * b, written straight into out (no temporary to copy, which
+    // matters in tight loops like hierarchy updates). out may be a or b.
+    static void Multiply(const Matrix4& a, const Matrix4& b, Matrix4& out) {
+#if MATH3D_SIMD_LEVEL >= 1
+        // Column j of the result is a's columns weighted by column j of b:
+        // 4 broadcasts and 4 multiply-adds per column
+        const __m128 a0 = _mm_load_ps(a.m);
+        const __m128 a1 = _mm_load_ps(a.m + 4);
+        const __m128 a2 = _mm_load_ps(a.m + 8);
+        const __m128 a3 = _mm_load_ps(a.m + 12);
+        const __m128 b0 = _mm_load_ps(b.m);
+        const __m128 b1 = _mm_load_ps(b.m + 4);
+        const __m128 b2 = _mm_load_ps(b.m + 8);
+        const __m128 b3 = _mm_load_ps(b.m + 12);
+
+        auto column = [&](__m128 bc) {
+            __m128 r = _mm_mul_ps(a0, Simd::Splat4<0>(bc));
+            r = Simd::MulAdd4(a1, Simd::Splat4<1>(bc), r);
+            r = Simd::MulAdd4(a2, Simd::Splat4<2>(bc), r);
+            return Simd::MulAdd4(a3, Simd::Splat4<3>(bc), r);
+        };
+        _mm_store_ps(out.m, column(b0));
+        _mm_store_ps(out.m + 4, column(b1));
+        _mm_store_ps(out.m + 8, column(b2));
+        _mm_store_ps(out.m + 12, column(b3));
+#else
         Matrix4 result;
         for (int col = 0; col < 4; col++) {
             for (int row = 0; row < 4; row++) {
                 float sum = 0.0f;
                 for (int i = 0; i < 4; i++) {
-                    sum += (*this)(row, i) * other(i, col);
+                    sum += a(row, i) * b(i, col);
                 }
                 result(row, col) = sum;
             }
         }
-        return result;
+        out = result;
+#endif
     }
 
     Matrix4& operator*=(const Matrix4& other) {
@@ -63,6 +97,21 @@ public:
     }
 
     Vector3 operator*(const Vector3& vec) const {
+#if MATH3D_SIMD_LEVEL >= 1
+        __m128 r = _mm_mul_ps(_mm_load_ps(m), _mm_set1_ps(vec.x));
+        r = Simd::MulAdd4(_mm_load_ps(m + 4), _mm_set1_ps(vec.y), r);
+        r = Simd::MulAdd4(_mm_load_ps(m + 8), _mm_set1_ps(vec.z), r);
+        r = _mm_add_ps(r, _mm_load_ps(m + 12));
+
+        __m128 w = Simd::Splat4<3>(r);
+        __m128 wIsZero = _mm_cmpeq_ps(w, _mm_setzero_ps());
+        w = _mm_or_ps(_mm_andnot_ps(wIsZero, w), _mm_and_ps(wIsZero, _mm_set1_ps(1.0f)));
+        r = _mm_div_ps(r, w);
+
+        alignas(16) float out[4];
+        _mm_store_ps(out, r);
+        return Vector3(out[0], out[1], out[2]);
+#else
         float w = m[3] * vec.x + m[7] * vec.y + m[11] * vec.z + m[15];
         if (w == 0.0f) w = 1.0f;
 
@@ -71,19 +120,30 @@ public:
             (m[1] * vec.x + m[5] * vec.y + m[9] * vec.z + m[13]) / w,
             (m[2] * vec.x + m[6] * vec.y + m[10] * vec.z + m[14]) / w
         );
+#endif
     }
 
     // Transform vector (ignores translation)
     Vector3 TransformVector(const Vector3& vec) const {
+#if MATH3D_SIMD_LEVEL >= 1
+        __m128 r = _mm_mul_ps(_mm_load_ps(m), _mm_set1_ps(vec.x));
+        r = Simd::MulAdd4(_mm_load_ps(m + 4), _mm_set1_ps(vec.y), r);
+        r = Simd::MulAdd4(_mm_load_ps(m + 8), _mm_set1_ps(vec.z), r);
+
+        alignas(16) float out[4];
+        _mm_store_ps(out, r);
+        return Vector3(out[0], out[1], out[2]);
+#else
         return Vector3(
             m[0] * vec.x + m[4] * vec.y + m[8] * vec.z,
             m[1] * vec.x + m[5] * vec.y + m[9] * vec.z,
             m[2] * vec.x + m[6] * vec.y + m[10] * vec.z
         );
+#endif
     }
 
     // Identity matrix
-    void Identity() {
+    void SetIdentity() {
         std::memset(m, 0, sizeof(m));
         m[0] = m[5] = m[10] = m[15] = 1.0f;
     }
@@ -254,16 +314,31 @@ public:
     // Transpose
     Matrix4 Transpose() const {
         Matrix4 result;
+#if MATH3D_SIMD_LEVEL >= 1
+        __m128 c0 = _mm_load_ps(m);
+        __m128 c1 = _mm_load_ps(m + 4);
+        __m128 c2 = _mm_load_ps(m + 8);
+        __m128 c3 = _mm_load_ps(m + 12);
+        _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+        _mm_store_ps(result.m, c0);
+        _mm_store_ps(result.m + 4, c1);
+        _mm_store_ps(result.m + 8, c2);
+        _mm_store_ps(result.m + 12, c3);
+#else
         for (int row = 0; row < 4; row++) {
             for (int col = 0; col < 4; col++) {
                 result(row, col) = (*this)(col, row);
             }
         }
+#endif
         return result;
     }
 
     // Inverse (simplified for common cases)
     Matrix4 Inverse() const {
+#if MATH3D_SIMD_LEVEL >= 1
+        return InverseSSE();
+#else
         Matrix4 result;
         float* inv = result.m;
         const float* m = this->m;
@@ -329,6 +404,7 @@ public:
         }
 
         return result;
+#endif
     }
 
     // Extract translation
@@ -344,6 +420,96 @@ public:
         return Vector3(xaxis.Length(), yaxis.Length(), zaxis.Length());
     }
 
+#if MATH3D_SIMD_LEVEL >= 1
+private:
+    // Cramer's rule with the 2x2 sub-determinants shared between cofactors,
+    // four cofactors per instruction (Intel AP-928, "Streaming SIMD
+    // Extensions - Inverse of 4x4 Matrix"). Same result as the scalar
+    // cofactor expansion up to rounding; a singular matrix gives identity.
+    Matrix4 InverseSSE() const {
+        // Transposed columns, with the halves of rows 1 and 3 swapped
+        __m128 row0 = _mm_load_ps(m);
+        __m128 row1 = _mm_load_ps(m + 4);
+        __m128 row2 = _mm_load_ps(m + 8);
+        __m128 row3 = _mm_load_ps(m + 12);
+        _MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+        row1 = _mm_shuffle_ps(row1, row1, 0x4E);
+        row3 = _mm_shuffle_ps(row3, row3, 0x4E);
+
+        __m128 minor0, minor1, minor2, minor3, tmp;
+
+        tmp = _mm_mul_ps(row2, row3);
+        tmp = _mm_shuffle_ps(tmp, tmp, 0xB1);
+        minor0 = _mm_mul_ps(row1, tmp);
+        minor1 = _mm_mul_ps(row0, tmp);
+        tmp = _mm_shuffle_ps(tmp, tmp, 0x4E);
+        minor0 = _mm_sub_ps(_mm_mul_ps(row1, tmp), minor0);
+        minor1 = _mm_sub_ps(_mm_mul_ps(row0, tmp), minor1);
+        minor1 = _mm_shuffle_ps(minor1, minor1, 0x4E);
+
+        tmp = _mm_mul_ps(row1, row2);
+        tmp = _mm_shuffle_ps(tmp, tmp, 0xB1);
+        minor0 = _mm_add_ps(_mm_mul_ps(row3, tmp), minor0);
+        minor3 = _mm_mul_ps(row0, tmp);
+        tmp = _mm_shuffle_ps(tmp, tmp, 0x4E);
+        minor0 = _mm_sub_ps(minor0, _mm_mul_ps(row3, tmp));
+        minor3 = _mm_sub_ps(_mm_mul_ps(row0, tmp), minor3);
+        minor3 = _mm_shuffle_ps(minor3, minor3, 0x4E);
+
+        tmp = _mm_mul_ps(_mm_shuffle_ps(row1, row1, 0x4E), row3);
+        tmp = _mm_shuffle_ps(tmp, tmp, 0xB1);
+        row2 = _mm_shuffle_ps(row2, row2, 0x4E);
+        minor0 = _mm_add_ps(_mm_mul_ps(row2, tmp), minor0);
+        minor2 = _mm_mul_ps(row0, tmp);
+        tmp = _mm_shuffle_ps(tmp, tmp, 0x4E);
+        minor0 = _mm_sub_ps(minor0, _mm_mul_ps(row2, tmp));
+        minor2 = _mm_sub_ps(_mm_mul_ps(row0, tmp), minor2);
+        minor2 = _mm_shuffle_ps(minor2, minor2, 0x4E);
+
+        tmp = _mm_mul_ps(row0, row1);
+        tmp = _mm_shuffle_ps(tmp, tmp, 0xB1);
+        minor2 = _mm_add_ps(_mm_mul_ps(row3, tmp), minor2);
+        minor3 = _mm_sub_ps(_mm_mul_ps(row2, tmp), minor3);
+        tmp = _mm_shuffle_ps(tmp, tmp, 0x4E);
+        minor2 = _mm_sub_ps(_mm_mul_ps(row3, tmp), minor2);
+        minor3 = _mm_sub_ps(minor3, _mm_mul_ps(row2, tmp));
+
+        tmp = _mm_mul_ps(row0, row3);
+        tmp = _mm_shuffle_ps(tmp, tmp, 0xB1);
+        minor1 = _mm_sub_ps(minor1, _mm_mul_ps(row2, tmp));
+        minor2 = _mm_add_ps(_mm_mul_ps(row1, tmp), minor2);
+        tmp = _mm_shuffle_ps(tmp, tmp, 0x4E);
+        minor1 = _mm_add_ps(_mm_mul_ps(row2, tmp), minor1);
+        minor2 = _mm_sub_ps(minor2, _mm_mul_ps(row1, tmp));
+
+        tmp = _mm_mul_ps(row0, row2);
+        tmp = _mm_shuffle_ps(tmp, tmp, 0xB1);
+        minor1 = _mm_add_ps(_mm_mul_ps(row3, tmp), minor1);
+        minor3 = _mm_sub_ps(minor3, _mm_mul_ps(row1, tmp));
+        tmp = _mm_shuffle_ps(tmp, tmp, 0x4E);
+        minor1 = _mm_sub_ps(minor1, _mm_mul_ps(row3, tmp));
+        minor3 = _mm_add_ps(_mm_mul_ps(row1, tmp), minor3);
+
+        // Determinant in every lane
+        __m128 det = _mm_mul_ps(row0, minor0);
+        det = _mm_add_ps(_mm_shuffle_ps(det, det, 0x4E), det);
+        det = _mm_add_ps(_mm_shuffle_ps(det, det, 0xB1), det);
+        if (_mm_cvtss_f32(det) == 0.0f) {
+            return Matrix4::Identity();
+        }
+        det = _mm_div_ps(_mm_set1_ps(1.0f), det);
+
+        Matrix4 result;
+        _mm_store_ps(result.m, _mm_mul_ps(det, minor0));
+        _mm_store_ps(result.m + 4, _mm_mul_ps(det, minor1));
+        _mm_store_ps(result.m + 8, _mm_mul_ps(det, minor2));
+        _mm_store_ps(result.m + 12, _mm_mul_ps(det, minor3));
+        return result;
+    }
+
+public:
+#endif
+
     // Stream output
     friend std::ostream& operator<<(std::ostream& os, const Matrix4& mat) {
         os << "Matrix4:\n";
@@ -6,7 +6,8 @@
 
 namespace Math3D {
 
-class Quaternion {
+// 16-byte aligned: x, y, z, w load as one SSE register (see SimdFloat.h)
+class alignas(16) Quaternion {
 public:
     float x, y, z, w;
 
@@ -68,12 +69,34 @@ public:
 
     // Quaternion operations
     Quaternion operator*(const Quaternion& other) const {
+#if MATH3D_SIMD_LEVEL >= 1
+        // Each of this quaternion's components times a shuffled, sign-flipped
+        // copy of other; the lanes line up with the scalar formulas below
+        const __m128 a = _mm_load_ps(&x);
+        const __m128 b = _mm_load_ps(&other.x);
+        const __m128 bWZYX = _mm_xor_ps(_mm_shuffle_ps(b, b, _MM_SHUFFLE(0, 1, 2, 3)),
+                                        _mm_setr_ps(0.0f, -0.0f, 0.0f, -0.0f));
+        const __m128 bZWXY = _mm_xor_ps(_mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 0, 3, 2)),
+                                        _mm_setr_ps(0.0f, 0.0f, -0.0f, -0.0f));
+        const __m128 bYXWZ = _mm_xor_ps(_mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 3, 0, 1)),
+                                        _mm_setr_ps(-0.0f, 0.0f, 0.0f, -0.0f));
+
+        __m128 r = _mm_mul_ps(Simd::Splat4<3>(a), b);
+        r = Simd::MulAdd4(Simd::Splat4<0>(a), bWZYX, r);
+        r = Simd::MulAdd4(Simd::Splat4<1>(a), bZWXY, r);
+        r = Simd::MulAdd4(Simd::Splat4<2>(a), bYXWZ, r);
+
+        Quaternion result;
+        _mm_store_ps(&result.x, r);
+        return result;
+#else
         return Quaternion(
             w * other.x + x * other.w + y * other.z - z * other.y,
             w * other.y - x * other.z + y * other.w + z * other.x,
             w * other.z + x * other.y - y * other.x + z * other.w,
             w * other.w - x * other.x - y * other.y - z * other.z
         );
+#endif
     }
 
     Quaternion& operator*=(const Quaternion& other) {
@@ -91,11 +114,34 @@ public:
 
     // Rotate a vector by this quaternion
     Vector3 operator*(const Vector3& vec) const {
+#if MATH3D_SIMD_LEVEL >= 1
+        // Same formula; both cross products are two shuffles, two multiplies
+        // and a subtract
+        auto cross = [](__m128 a, __m128 b) {
+            __m128 aYZX = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+            __m128 bYZX = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+            __m128 c = _mm_sub_ps(_mm_mul_ps(a, bYZX), _mm_mul_ps(aYZX, b));
+            return _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+        };
+        const __m128 q = _mm_load_ps(&x);
+        const __m128 qvec = _mm_setr_ps(x, y, z, 0.0f);
+        const __m128 v = _mm_setr_ps(vec.x, vec.y, vec.z, 0.0f);
+
+        __m128 uv = cross(qvec, v);
+        __m128 uuv = cross(qvec, uv);
+        __m128 r = Simd::MulAdd4(uv, Simd::Splat4<3>(q), uuv);
+        r = Simd::MulAdd4(r, _mm_set1_ps(2.0f), v);
+
+        alignas(16) float out[4];
+        _mm_store_ps(out, r);
+        return Vector3(out[0], out[1], out[2]);
+#else
         Vector3 qvec(x, y, z);
         Vector3 uv = qvec.Cross(vec);
         Vector3 uuv = qvec.Cross(uv);
 
         return vec + ((uv * w) + uuv) * 2.0f;
+#endif
     }
 
     // Length and normalization
@@ -194,6 +240,59 @@ public:
         );
     }
 
+    // Normalized linear interpolation along the shorter arc. Same path as
+    // Slerp but not constant speed; fine for nearby keyframes. Inputs must
+    // be unit length.
+    static Quaternion Nlerp(const Quaternion& a, const Quaternion& b, float t) {
+        float tb = a.Dot(b) < 0.0f ? -t : t;
+        float ta = 1.0f - t;
+        return Quaternion(
+            a.x * ta + b.x * tb,
+            a.y * ta + b.y * tb,
+            a.z * ta + b.z * tb,
+            a.w * ta + b.w * tb
+        ).Normalized();
+    }
+
+    // Slerp weights sin(t*theta) / sin(theta) as a polynomial in
+    // (cos(theta) - 1), from D. Eberly, "A Fast and Accurate Algorithm for
+    // Computing SLERP". The last term is scaled by 1.85298109 to absorb the
+    // truncated series; weights are within 2e-5 of the exact ones.
+    static constexpr int FAST_SLERP_TERMS = 8;
+    static constexpr float FAST_SLERP_U[FAST_SLERP_TERMS] = {
+        1.0f / (1 * 3), 1.0f / (2 * 5), 1.0f / (3 * 7), 1.0f / (4 * 9),
+        1.0f / (5 * 11), 1.0f / (6 * 13), 1.0f / (7 * 15), 1.85298109f / (8 * 17)
+    };
+    static constexpr float FAST_SLERP_V[FAST_SLERP_TERMS] = {
+        1.0f / 3, 2.0f / 5, 3.0f / 7, 4.0f / 9,
+        5.0f / 11, 6.0f / 13, 7.0f / 15, 1.85298109f * 8 / 17
+    };
+
+    static float FastSlerpWeight(float t, float cosThetaMinusOne) {
+        float tt = t * t;
+        float weight = 1.0f;
+        for (int i = FAST_SLERP_TERMS - 1; i >= 0; i--) {
+            weight = 1.0f + (FAST_SLERP_U[i] * tt - FAST_SLERP_V[i]) * cosThetaMinusOne * weight;
+        }
+        return t * weight;
+    }
+
+    // Slerp without acos/sin or branches on the angle: constant speed, no
+    // renormalization needed. Inputs must be unit length.
+    static Quaternion SlerpFast(const Quaternion& a, const Quaternion& b, float t) {
+        float dot = a.Dot(b);
+        float sign = dot < 0.0f ? -1.0f : 1.0f;
+        float xm1 = dot * sign - 1.0f;
+        float ta = FastSlerpWeight(1.0f - t, xm1);
+        float tb = FastSlerpWeight(t, xm1) * sign;
+        return Quaternion(
+            a.x * ta + b.x * tb,
+            a.y * ta + b.y * tb,
+            a.z * ta + b.z * tb,
+            a.w * ta + b.w * tb
+        );
+    }
+
     // Convert to rotation matrix
     Matrix4 ToMatrix() const {
         Matrix4 mat;
@@ -0,0 +1,292 @@
+#pragma once
+
+// Batched quaternion interpolation and skeleton flattening
+//
+// Animation sampling blends two keyframe rotations per bone, for thousands
+// of bones per frame. Quaternion::Slerp does one pair per call with acos,
+// sin and a branch on the angle. These routines take structure-of-arrays
+// rotations and blend WIDTH bones per instruction (4 with SSE2, 8 with AVX,
+// see SimdFloat.h), branch-free:
+// - NlerpQuaternions: lerp + normalize, same path as Slerp, uneven speed
+// - SlerpQuaternionsFast: Eberly's polynomial slerp weights, constant
+//   speed, within 2e-5 of Slerp (see Quaternion::FastSlerpWeight)
+// Both take the shorter arc and expect unit-length inputs. Results match
+// Quaternion::Nlerp / SlerpFast up to float rounding. The output may be
+// either input.
+//
+// FlattenHierarchy turns local bone rotations and offsets into world
+// space, batching bones whose parents are already done.
+//
+// Included by Math3D.h.
+
+#include "Math3D.h"
+#include "SimdFloat.h"
+#include "TransformBatch.h"
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace Math3D {
+
+// Structure-of-arrays storage for many Quaternions
+struct QuaternionSoA {
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> z;
+    std::vector<float> w;
+
+    QuaternionSoA() = default;
+    explicit QuaternionSoA(size_t count) : x(count), y(count), z(count), w(count, 1.0f) {}
+
+    explicit QuaternionSoA(const std::vector<Quaternion>& quaternions) : QuaternionSoA(quaternions.size()) {
+        for (size_t i = 0; i < quaternions.size(); i++) {
+            Set(i, quaternions[i]);
+        }
+    }
+
+    size_t Size() const {
+        return x.size();
+    }
+
+    void Resize(size_t count) {
+        x.resize(count);
+        y.resize(count);
+        z.resize(count);
+        w.resize(count, 1.0f);
+    }
+
+    void Set(size_t index, const Quaternion& q) {
+        x[index] = q.x;
+        y[index] = q.y;
+        z[index] = q.z;
+        w[index] = q.w;
+    }
+
+    Quaternion Get(size_t index) const {
+        return Quaternion(x[index], y[index], z[index], w[index]);
+    }
+};
+
+namespace QuaternionBatchDetail {
+
+using namespace Simd;
+
+// Sum of a[i] * b[i] over the four components
+inline Batch Dot(const QuaternionSoA& a, const QuaternionSoA& b, size_t i) {
+    Batch d = Mul(Load(a.x.data() + i), Load(b.x.data() + i));
+    d = MulAdd(Load(a.y.data() + i), Load(b.y.data() + i), d);
+    d = MulAdd(Load(a.z.data() + i), Load(b.z.data() + i), d);
+    return MulAdd(Load(a.w.data() + i), Load(b.w.data() + i), d);
+}
+
+// out[i] = a[i] * ta + b[i] * tb
+inline void Blend(const QuaternionSoA& a, const QuaternionSoA& b, Batch ta, Batch tb,
+                  QuaternionSoA& out, size_t i) {
+    Store(out.x.data() + i, MulAdd(Load(b.x.data() + i), tb, Mul(Load(a.x.data() + i), ta)));
+    Store(out.y.data() + i, MulAdd(Load(b.y.data() + i), tb, Mul(Load(a.y.data() + i), ta)));
+    Store(out.z.data() + i, MulAdd(Load(b.z.data() + i), tb, Mul(Load(a.z.data() + i), ta)));
+    Store(out.w.data() + i, MulAdd(Load(b.w.data() + i), tb, Mul(Load(a.w.data() + i), ta)));
+}
+
+// t * (1 + b0 * (1 + b1 * (... (1 + b7)))), b_i = (u_i * t^2 - v_i) * (cos - 1)
+inline Batch FastSlerpWeight(Batch t, Batch cosThetaMinusOne) {
+    const Batch one = Set1(1.0f);
+    const Batch tt = Mul(t, t);
+    Batch weight = one;
+    for (int k = Quaternion::FAST_SLERP_TERMS - 1; k >= 0; k--) {
+        Batch term = Sub(Mul(Set1(Quaternion::FAST_SLERP_U[k]), tt), Set1(Quaternion::FAST_SLERP_V[k]));
+        weight = MulAdd(Mul(term, cosThetaMinusOne), weight, one);
+    }
+    return Mul(t, weight);
+}
+
+// weights(i) gives the blend weights of elements i..i+WIDTH-1 as a Batch,
+// weights.Scalar(i) the weight of element i alone
+struct UniformWeight {
+    float t;
+    Batch operator()(size_t) const { return Set1(t); }
+    float Scalar(size_t) const { return t; }
+};
+
+struct PerElementWeight {
+    const float* t;
+    Batch operator()(size_t i) const { return Load(t + i); }
+    float Scalar(size_t i) const { return t[i]; }
+};
+
+template <typename Weights>
+inline void Nlerp(const QuaternionSoA& a, const QuaternionSoA& b, Weights weights, QuaternionSoA& out) {
+    const size_t count = a.Size();
+    out.Resize(count);
+    const Batch zero = Set1(0.0f);
+    const Batch one = Set1(1.0f);
+
+    size_t i = 0;
+    for (; i + WIDTH <= count; i += WIDTH) {
+        Batch t = weights(i);
+        // Negate b's weight instead of b when the quaternions face apart
+        Batch tb = Select(Greater(zero, Dot(a, b, i)), Sub(zero, t), t);
+        Batch ta = Sub(one, t);
+
+        Batch rx = MulAdd(Load(b.x.data() + i), tb, Mul(Load(a.x.data() + i), ta));
+        Batch ry = MulAdd(Load(b.y.data() + i), tb, Mul(Load(a.y.data() + i), ta));
+        Batch rz = MulAdd(Load(b.z.data() + i), tb, Mul(Load(a.z.data() + i), ta));
+        Batch rw = MulAdd(Load(b.w.data() + i), tb, Mul(Load(a.w.data() + i), ta));
+        Batch lengthSq = MulAdd(rw, rw, MulAdd(rz, rz, MulAdd(ry, ry, Mul(rx, rx))));
+        Batch invLength = Div(one, Sqrt(lengthSq));
+
+        Store(out.x.data() + i, Mul(rx, invLength));
+        Store(out.y.data() + i, Mul(ry, invLength));
+        Store(out.z.data() + i, Mul(rz, invLength));
+        Store(out.w.data() + i, Mul(rw, invLength));
+    }
+
+    for (; i < count; i++) {
+        out.Set(i, Quaternion::Nlerp(a.Get(i), b.Get(i), weights.Scalar(i)));
+    }
+}
+
+template <typename Weights>
+inline void SlerpFast(const QuaternionSoA& a, const QuaternionSoA& b, Weights weights, QuaternionSoA& out) {
+    const size_t count = a.Size();
+    out.Resize(count);
+    const Batch zero = Set1(0.0f);
+    const Batch one = Set1(1.0f);
+    const Batch minusOne = Set1(-1.0f);
+
+    size_t i = 0;
+    for (; i + WIDTH <= count; i += WIDTH) {
+        Batch t = weights(i);
+        Batch dot = Dot(a, b, i);
+        Batch sign = Select(Greater(zero, dot), minusOne, one);
+        Batch cosThetaMinusOne = Sub(Mul(dot, sign), one);
+
+        Batch ta = FastSlerpWeight(Sub(one, t), cosThetaMinusOne);
+        Batch tb = Mul(FastSlerpWeight(t, cosThetaMinusOne), sign);
+        Blend(a, b, ta, tb, out, i);
+    }
+
+    for (; i < count; i++) {
+        out.Set(i, Quaternion::SlerpFast(a.Get(i), b.Get(i), weights.Scalar(i)));
+    }
+}
+
+} // namespace QuaternionBatchDetail
+
+// out[i] = Nlerp(a[i], b[i], t), e.g. blending two whole poses
+inline void NlerpQuaternions(const QuaternionSoA& a, const QuaternionSoA& b, float t, QuaternionSoA& out) {
+    QuaternionBatchDetail::Nlerp(a, b, QuaternionBatchDetail::UniformWeight{t}, out);
+}
+
+// out[i] = Nlerp(a[i], b[i], t[i]), e.g. per-bone keyframe pairs
+inline void NlerpQuaternions(const QuaternionSoA& a, const QuaternionSoA& b, const float* t, QuaternionSoA& out) {
+    QuaternionBatchDetail::Nlerp(a, b, QuaternionBatchDetail::PerElementWeight{t}, out);
+}
+
+// out[i] = SlerpFast(a[i], b[i], t)
+inline void SlerpQuaternionsFast(const QuaternionSoA& a, const QuaternionSoA& b, float t, QuaternionSoA& out) {
+    QuaternionBatchDetail::SlerpFast(a, b, QuaternionBatchDetail::UniformWeight{t}, out);
+}
+
+// out[i] = SlerpFast(a[i], b[i], t[i])
+inline void SlerpQuaternionsFast(const QuaternionSoA& a, const QuaternionSoA& b, const float* t, QuaternionSoA& out) {
+    QuaternionBatchDetail::SlerpFast(a, b, QuaternionBatchDetail::PerElementWeight{t}, out);
+}
+
+// World transforms of a skeleton from local rotations and offsets:
+//   worldRotation[i] = worldRotation[parent[i]] * localRotation[i]
+//   worldPosition[i] = worldPosition[parent[i]] + worldRotation[parent[i]] * localPosition[i]
+// parent[i] is -1 for roots, which copy their local transform. Parents must
+// be stored before their children. WIDTH bones whose parents all come
+// before them are processed together, so breadth-first order (one run per
+// depth level) batches best. Depth-first order leaves runs of about as many
+// bones as a parent has children; shorter than a batch, they go one bone at
+// a time, which is slower than an array-of-structures loop (see Lesson 12).
+// The outputs must not be the local arrays.
+inline void FlattenHierarchy(const int* parent,
+                             const QuaternionSoA& localRotation, const Vector3SoA& localPosition,
+                             QuaternionSoA& worldRotation, Vector3SoA& worldPosition) {
+    using namespace Simd;
+    const size_t count = localRotation.Size();
+    worldRotation.Resize(count);
+    worldPosition.Resize(count);
+    const Batch two = Set1(2.0f);
+    const float* rx = worldRotation.x.data();
+    const float* ry = worldRotation.y.data();
+    const float* rz = worldRotation.z.data();
+    const float* rw = worldRotation.w.data();
+    const float* tx = worldPosition.x.data();
+    const float* ty = worldPosition.y.data();
+    const float* tz = worldPosition.z.data();
+
+    auto flattenBone = [&](size_t i, int p) {
+        if (p < 0) {
+            worldRotation.Set(i, localRotation.Get(i));
+            worldPosition.Set(i, localPosition.Get(i));
+        } else {
+            Quaternion parentRotation = worldRotation.Get(p);
+            worldRotation.Set(i, parentRotation * localRotation.Get(i));
+            worldPosition.Set(i, worldPosition.Get(p) + parentRotation * localPosition.Get(i));
+        }
+    };
+
+    // A batch starting at i can be gathered when every parent lies before
+    // i. Min/max keeps the test free of branches. When it fails the batch
+    // start slides forward one bone, so a short run can still line up with
+    // a batch; after WIDTH failures in a row (depth-first runs shorter than
+    // a batch) whole batches go one bone at a time until a test passes.
+    size_t i = 0;
+    int failedTests = 0;
+    while (i + WIDTH <= count) {
+        int lowest = parent[i], highest = parent[i];
+        for (int lane = 1; lane < WIDTH; lane++) {
+            lowest = std::min(lowest, parent[i + lane]);
+            highest = std::max(highest, parent[i + lane]);
+        }
+        if (lowest < 0 || highest >= static_cast<int>(i)) {
+            const size_t end = failedTests < WIDTH ? i + 1 : i + WIDTH;
+            for (; i < end; i++) {
+                flattenBone(i, parent[i]);
+            }
+            failedTests++;
+            continue;
+        }
+        failedTests = 0;
+
+        const int* p = parent + i;
+        Batch px = Gather(rx, p), py = Gather(ry, p), pz = Gather(rz, p), pw = Gather(rw, p);
+        Batch lx = Load(localRotation.x.data() + i), ly = Load(localRotation.y.data() + i);
+        Batch lz = Load(localRotation.z.data() + i), lw = Load(localRotation.w.data() + i);
+
+        // Quaternion product, same formulas as Quaternion::operator*
+        Store(worldRotation.x.data() + i,
+              Sub(MulAdd(py, lz, MulAdd(px, lw, Mul(pw, lx))), Mul(pz, ly)));
+        Store(worldRotation.y.data() + i,
+              MulAdd(pz, lx, MulAdd(py, lw, Sub(Mul(pw, ly), Mul(px, lz)))));
+        Store(worldRotation.z.data() + i,
+              MulAdd(pz, lw, Sub(MulAdd(px, ly, Mul(pw, lz)), Mul(py, lx))));
+        Store(worldRotation.w.data() + i,
+              Sub(Sub(Sub(Mul(pw, lw), Mul(px, lx)), Mul(py, ly)), Mul(pz, lz)));
+
+        // Offset rotated by the parent: v + 2 * (w * (q x v) + q x (q x v))
+        Batch vx = Load(localPosition.x.data() + i);
+        Batch vy = Load(localPosition.y.data() + i);
+        Batch vz = Load(localPosition.z.data() + i);
+        Batch uvx = Sub(Mul(py, vz), Mul(pz, vy));
+        Batch uvy = Sub(Mul(pz, vx), Mul(px, vz));
+        Batch uvz = Sub(Mul(px, vy), Mul(py, vx));
+        Batch uuvx = Sub(Mul(py, uvz), Mul(pz, uvy));
+        Batch uuvy = Sub(Mul(pz, uvx), Mul(px, uvz));
+        Batch uuvz = Sub(Mul(px, uvy), Mul(py, uvx));
+        Store(worldPosition.x.data() + i, Add(Gather(tx, p), MulAdd(MulAdd(uvx, pw, uuvx), two, vx)));
+        Store(worldPosition.y.data() + i, Add(Gather(ty, p), MulAdd(MulAdd(uvy, pw, uuvy), two, vy)));
+        Store(worldPosition.z.data() + i, Add(Gather(tz, p), MulAdd(MulAdd(uvz, pw, uuvz), two, vz)));
+        i += WIDTH;
+    }
+
+    for (; i < count; i++) {
+        flattenBone(i, parent[i]);
+    }
+}
+
+} // namespace Math3D
@@ -0,0 +1,172 @@
+#pragma once
+
+// Compile-time SIMD selection for Math3D
+//
+// MATH3D_SIMD_LEVEL is picked from the compiler's target flags:
+//   2 = AVX, 8 floats per batch (-mavx, -march=native, /arch:AVX)
+//   1 = SSE2, 4 floats per batch (always available on x86-64)
+//   0 = scalar, 1 float per batch (other CPUs, or MATH3D_NO_SIMD)
+// Level 1 and up also switch Matrix4 and Quaternion to SSE code.
+// MATH3D_SIMD_FMA is set when fused multiply-add is available (-mfma,
+// -march=native, /arch:AVX2).
+// Define MATH3D_NO_SIMD before including Math3D to force the scalar code;
+// every translation unit of a program must agree on it.
+
+#if !defined(MATH3D_NO_SIMD) && defined(__AVX__)
+    #define MATH3D_SIMD_LEVEL 2
+    #include <immintrin.h>
+#elif !defined(MATH3D_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+    #define MATH3D_SIMD_LEVEL 1
+    #include <emmintrin.h>
+#else
+    #define MATH3D_SIMD_LEVEL 0
+#endif
+
+#if MATH3D_SIMD_LEVEL == 2 && (defined(__FMA__) || (defined(_MSC_VER) && defined(__AVX2__)))
+    #define MATH3D_SIMD_FMA 1
+#else
+    #define MATH3D_SIMD_FMA 0
+#endif
+
+#include <cmath>
+
+namespace Math3D {
+namespace Simd {
+
+// Batch holds WIDTH floats; every operation is element-wise. The batched
+// kernels are written once against these functions and compile to SSE,
+// AVX or plain float code.
+#if MATH3D_SIMD_LEVEL == 2
+
+using Batch = __m256;
+constexpr int WIDTH = 8;
+
+inline Batch Load(const float* p) { return _mm256_loadu_ps(p); }
+inline void Store(float* p, Batch v) { _mm256_storeu_ps(p, v); }
+inline Batch Set1(float v) { return _mm256_set1_ps(v); }
+inline Batch Add(Batch a, Batch b) { return _mm256_add_ps(a, b); }
+inline Batch Sub(Batch a, Batch b) { return _mm256_sub_ps(a, b); }
+inline Batch Mul(Batch a, Batch b) { return _mm256_mul_ps(a, b); }
+inline Batch Div(Batch a, Batch b) { return _mm256_div_ps(a, b); }
+inline Batch Sqrt(Batch v) { return _mm256_sqrt_ps(v); }
+inline Batch Min(Batch a, Batch b) { return _mm256_min_ps(a, b); }
+inline Batch Max(Batch a, Batch b) { return _mm256_max_ps(a, b); }
+#if MATH3D_SIMD_FMA
+inline Batch MulAdd(Batch a, Batch b, Batch c) { return _mm256_fmadd_ps(a, b, c); }
+#else
+inline Batch MulAdd(Batch a, Batch b, Batch c) { return _mm256_add_ps(_mm256_mul_ps(a, b), c); }
+#endif
+
+// a where the mask is set, b elsewhere
+inline Batch Select(Batch mask, Batch a, Batch b) { return _mm256_blendv_ps(b, a, mask); }
+inline Batch Equal(Batch a, Batch b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+inline Batch Greater(Batch a, Batch b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+inline Batch GreaterEqual(Batch a, Batch b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+inline Batch And(Batch a, Batch b) { return _mm256_and_ps(a, b); }
+inline Batch Or(Batch a, Batch b) { return _mm256_or_ps(a, b); }
+// One bit per lane, lane 0 in bit 0
+inline int MoveMask(Batch mask) { return _mm256_movemask_ps(mask); }
+
+// Lane k = base[index[k]]. Built in registers: scalar stores to a buffer
+// followed by a vector load would stall on store forwarding. AVX2's
+// vgatherdps measured no faster, so it is not used.
+inline Batch Gather(const float* base, const int* index) {
+    return _mm256_setr_ps(base[index[0]], base[index[1]], base[index[2]], base[index[3]],
+                          base[index[4]], base[index[5]], base[index[6]], base[index[7]]);
+}
+
+#elif MATH3D_SIMD_LEVEL == 1
+
+using Batch = __m128;
+constexpr int WIDTH = 4;
+
+inline Batch Load(const float* p) { return _mm_loadu_ps(p); }
+inline void Store(float* p, Batch v) { _mm_storeu_ps(p, v); }
+inline Batch Set1(float v) { return _mm_set1_ps(v); }
+inline Batch Add(Batch a, Batch b) { return _mm_add_ps(a, b); }
+inline Batch Sub(Batch a, Batch b) { return _mm_sub_ps(a, b); }
+inline Batch Mul(Batch a, Batch b) { return _mm_mul_ps(a, b); }
+inline Batch Div(Batch a, Batch b) { return _mm_div_ps(a, b); }
+inline Batch Sqrt(Batch v) { return _mm_sqrt_ps(v); }
+inline Batch Min(Batch a, Batch b) { return _mm_min_ps(a, b); }
+inline Batch Max(Batch a, Batch b) { return _mm_max_ps(a, b); }
+inline Batch MulAdd(Batch a, Batch b, Batch c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+
+inline Batch Select(Batch mask, Batch a, Batch b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+inline Batch Equal(Batch a, Batch b) { return _mm_cmpeq_ps(a, b); }
+inline Batch Greater(Batch a, Batch b) { return _mm_cmpgt_ps(a, b); }
+inline Batch GreaterEqual(Batch a, Batch b) { return _mm_cmpge_ps(a, b); }
+inline Batch And(Batch a, Batch b) { return _mm_and_ps(a, b); }
+inline Batch Or(Batch a, Batch b) { return _mm_or_ps(a, b); }
+inline int MoveMask(Batch mask) { return _mm_movemask_ps(mask); }
+inline Batch Gather(const float* base, const int* index) {
+    return _mm_setr_ps(base[index[0]], base[index[1]], base[index[2]], base[index[3]]);
+}
+
+#else
+
+// Masks are 1.0f (true) or 0.0f (false) in the scalar fallback
+using Batch = float;
+constexpr int WIDTH = 1;
+
+inline Batch Load(const float* p) { return *p; }
+inline void Store(float* p, Batch v) { *p = v; }
+inline Batch Set1(float v) { return v; }
+inline Batch Add(Batch a, Batch b) { return a + b; }
+inline Batch Sub(Batch a, Batch b) { return a - b; }
+inline Batch Mul(Batch a, Batch b) { return a * b; }
+inline Batch Div(Batch a, Batch b) { return a / b; }
+inline Batch Sqrt(Batch v) { return std::sqrt(v); }
+// Same operand order as minps/maxps: b is returned when either is NaN
+inline Batch Min(Batch a, Batch b) { return a < b ? a : b; }
+inline Batch Max(Batch a, Batch b) { return a > b ? a : b; }
+inline Batch MulAdd(Batch a, Batch b, Batch c) { return a * b + c; }
+
+inline Batch Select(Batch mask, Batch a, Batch b) { return mask != 0.0f ? a : b; }
+inline Batch Equal(Batch a, Batch b) { return a == b ? 1.0f : 0.0f; }
+inline Batch Greater(Batch a, Batch b) { return a > b ? 1.0f : 0.0f; }
+inline Batch GreaterEqual(Batch a, Batch b) { return a >= b ? 1.0f : 0.0f; }
+inline Batch And(Batch a, Batch b) { return a != 0.0f && b != 0.0f ? 1.0f : 0.0f; }
+inline Batch Or(Batch a, Batch b) { return a != 0.0f || b != 0.0f ? 1.0f : 0.0f; }
+inline int MoveMask(Batch mask) { return mask != 0.0f ? 1 : 0; }
+inline Batch Gather(const float* base, const int* index) { return base[*index]; }
+
+#endif
+
+#if MATH3D_SIMD_LEVEL >= 1
+
+// 4-wide helpers for the SSE-backed Matrix4 and Quaternion. a * b + c uses
+// the same rounding as the batched MulAdd, so single and batched
+// transforms give identical results.
+inline __m128 MulAdd4(__m128 a, __m128 b, __m128 c) {
+#if MATH3D_SIMD_FMA
+    return _mm_fmadd_ps(a, b, c);
+#else
+    return _mm_add_ps(_mm_mul_ps(a, b), c);
+#endif
+}
+
+// Broadcast lane i to all four lanes
+template <int i>
+inline __m128 Splat4(__m128 v) {
+    return _mm_shuffle_ps(v, v, _MM_SHUFFLE(i, i, i, i));
+}
+
+#endif
+
+inline const char* LevelName() {
+#if MATH3D_SIMD_LEVEL == 2 && MATH3D_SIMD_FMA
+    return "AVX + FMA (8 floats)";
+#elif MATH3D_SIMD_LEVEL == 2
+    return "AVX (8 floats)";
+#elif MATH3D_SIMD_LEVEL == 1
+    return "SSE2 (4 floats)";
+#else
+    return "Scalar";
+#endif
+}
+
+} // namespace Simd
+} // namespace Math3D
@@ -0,0 +1,218 @@
+#pragma once
+
+// Batched transforms: many points, normals or matrices per call
+//
+// Matrix4 * Vector3 handles one point at a time. These routines take
+// structure-of-arrays input (all x, then all y, then all z) so one SIMD
+// instruction processes 4 (SSE2) or 8 (AVX) points. See SimdFloat.h for
+// how the width is chosen. Results match Matrix4 built with the same
+// flags: every kernel performs the same operations in the same order.
+
+#include "Vector3.h"
+#include "Matrix4.h"
+#include "SimdFloat.h"
+#include <cstddef>
+#include <vector>
+
+namespace Math3D {
+
+// Structure-of-arrays storage for many Vector3s
+struct Vector3SoA {
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> z;
+
+    Vector3SoA() = default;
+    explicit Vector3SoA(size_t count) : x(count), y(count), z(count) {}
+
+    explicit Vector3SoA(const std::vector<Vector3>& vectors) : Vector3SoA(vectors.size()) {
+        for (size_t i = 0; i < vectors.size(); i++) {
+            Set(i, vectors[i]);
+        }
+    }
+
+    size_t Size() const {
+        return x.size();
+    }
+
+    void Resize(size_t count) {
+        x.resize(count);
+        y.resize(count);
+        z.resize(count);
+    }
+
+    void Set(size_t index, const Vector3& v) {
+        x[index] = v.x;
+        y[index] = v.y;
+        z[index] = v.z;
+    }
+
+    Vector3 Get(size_t index) const {
+        return Vector3(x[index], y[index], z[index]);
+    }
+};
+
+// Points: full 4x4 transform with perspective divide, like matrix * point.
+// The divide is skipped when the matrix is affine (w is always 1).
+// Output arrays may be the input arrays.
+inline void TransformPoints(const Matrix4& matrix,
+                            const float* x, const float* y, const float* z,
+                            float* outX, float* outY, float* outZ, size_t count) {
+    using namespace Simd;
+    const float* m = matrix.m;
+    const Batch m0 = Set1(m[0]), m1 = Set1(m[1]), m2 = Set1(m[2]), m3 = Set1(m[3]);
+    const Batch m4 = Set1(m[4]), m5 = Set1(m[5]), m6 = Set1(m[6]), m7 = Set1(m[7]);
+    const Batch m8 = Set1(m[8]), m9 = Set1(m[9]), m10 = Set1(m[10]), m11 = Set1(m[11]);
+    const Batch m12 = Set1(m[12]), m13 = Set1(m[13]), m14 = Set1(m[14]), m15 = Set1(m[15]);
+    const Batch zero = Set1(0.0f);
+    const Batch one = Set1(1.0f);
+    const bool affine = m[3] == 0.0f && m[7] == 0.0f && m[11] == 0.0f && m[15] == 1.0f;
+
+    size_t i = 0;
+    for (; i + WIDTH <= count; i += WIDTH) {
+        Batch px = Load(x + i);
+        Batch py = Load(y + i);
+        Batch pz = Load(z + i);
+
+        Batch rx = Add(MulAdd(m8, pz, MulAdd(m4, py, Mul(m0, px))), m12);
+        Batch ry = Add(MulAdd(m9, pz, MulAdd(m5, py, Mul(m1, px))), m13);
+        Batch rz = Add(MulAdd(m10, pz, MulAdd(m6, py, Mul(m2, px))), m14);
+
+        if (!affine) {
+            Batch w = Add(MulAdd(m11, pz, MulAdd(m7, py, Mul(m3, px))), m15);
+            w = Select(Equal(w, zero), one, w);
+            rx = Div(rx, w);
+            ry = Div(ry, w);
+            rz = Div(rz, w);
+        }
+
+        Store(outX + i, rx);
+        Store(outY + i, ry);
+        Store(outZ + i, rz);
+    }
+
+    // Remainder that does not fill a batch
+    for (; i < count; i++) {
+        Vector3 r = matrix * Vector3(x[i], y[i], z[i]);
+        outX[i] = r.x;
+        outY[i] = r.y;
+        outZ[i] = r.z;
+    }
+}
+
+inline void TransformPoints(const Matrix4& matrix, const Vector3SoA& in, Vector3SoA& out) {
+    out.Resize(in.Size());
+    TransformPoints(matrix, in.x.data(), in.y.data(), in.z.data(),
+                    out.x.data(), out.y.data(), out.z.data(), in.Size());
+}
+
+// Directions: upper 3x3 only, like Matrix4::TransformVector
+inline void TransformVectors(const Matrix4& matrix,
+                             const float* x, const float* y, const float* z,
+                             float* outX, float* outY, float* outZ, size_t count) {
+    using namespace Simd;
+    const float* m = matrix.m;
+    const Batch m0 = Set1(m[0]), m1 = Set1(m[1]), m2 = Set1(m[2]);
+    const Batch m4 = Set1(m[4]), m5 = Set1(m[5]), m6 = Set1(m[6]);
+    const Batch m8 = Set1(m[8]), m9 = Set1(m[9]), m10 = Set1(m[10]);
+
+    size_t i = 0;
+    for (; i + WIDTH <= count; i += WIDTH) {
+        Batch vx = Load(x + i);
+        Batch vy = Load(y + i);
+        Batch vz = Load(z + i);
+
+        Store(outX + i, MulAdd(m8, vz, MulAdd(m4, vy, Mul(m0, vx))));
+        Store(outY + i, MulAdd(m9, vz, MulAdd(m5, vy, Mul(m1, vx))));
+        Store(outZ + i, MulAdd(m10, vz, MulAdd(m6, vy, Mul(m2, vx))));
+    }
+
+    for (; i < count; i++) {
+        Vector3 r = matrix.TransformVector(Vector3(x[i], y[i], z[i]));
+        outX[i] = r.x;
+        outY[i] = r.y;
+        outZ[i] = r.z;
+    }
+}
+
+inline void TransformVectors(const Matrix4& matrix, const Vector3SoA& in, Vector3SoA& out) {
+    out.Resize(in.Size());
+    TransformVectors(matrix, in.x.data(), in.y.data(), in.z.data(),
+                     out.x.data(), out.y.data(), out.z.data(), in.Size());
+}
+
+// Normals: transformed by the inverse transpose of the matrix (so they stay
+// perpendicular to surfaces under non-uniform scale), then normalized.
+// Zero-length normals are left unchanged, as in Vector3::Normalized.
+inline void TransformNormals(const Matrix4& matrix,
+                             const float* x, const float* y, const float* z,
+                             float* outX, float* outY, float* outZ, size_t count) {
+    using namespace Simd;
+    const Matrix4 normalMatrix = matrix.Inverse().Transpose();
+    TransformVectors(normalMatrix, x, y, z, outX, outY, outZ, count);
+
+    const Batch zero = Set1(0.0f);
+    const Batch one = Set1(1.0f);
+
+    size_t i = 0;
+    for (; i + WIDTH <= count; i += WIDTH) {
+        Batch nx = Load(outX + i);
+        Batch ny = Load(outY + i);
+        Batch nz = Load(outZ + i);
+
+        Batch length = Sqrt(Add(Add(Mul(nx, nx), Mul(ny, ny)), Mul(nz, nz)));
+        Batch invLength = Select(Greater(length, zero), Div(one, length), one);
+
+        Store(outX + i, Mul(nx, invLength));
+        Store(outY + i, Mul(ny, invLength));
+        Store(outZ + i, Mul(nz, invLength));
+    }
+
+    for (; i < count; i++) {
+        Vector3 n = Vector3(outX[i], outY[i], outZ[i]).Normalized();
+        outX[i] = n.x;
+        outY[i] = n.y;
+        outZ[i] = n.z;
+    }
+}
+
+inline void TransformNormals(const Matrix4& matrix, const Vector3SoA& in, Vector3SoA& out) {
+    out.Resize(in.Size());
+    TransformNormals(matrix, in.x.data(), in.y.data(), in.z.data(),
+                     out.x.data(), out.y.data(), out.z.data(), in.Size());
+}
+
+// Single 4x4 product, out = a * b, stored straight into out. Safe when
+// out is a or b.
+inline void MultiplyMatrix(const Matrix4& a, const Matrix4& b, Matrix4& out) {
+    Matrix4::Multiply(a, b, out);
+}
+
+// out[i] = a[i] * b[i]
+inline void MultiplyMatrices(const Matrix4* a, const Matrix4* b, Matrix4* out, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        MultiplyMatrix(a[i], b[i], out[i]);
+    }
+}
+
+// out[i] = parent * local[i], e.g. all children of one node
+inline void MultiplyMatrices(const Matrix4& parent, const Matrix4* local, Matrix4* out, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        MultiplyMatrix(parent, local[i], out[i]);
+    }
+}
+
+// World matrices of a scene hierarchy: world[i] = world[parent[i]] * local[i].
+// parent[i] is -1 for roots. Parents must be stored before their children
+// (breadth- or depth-first order), so a single forward pass suffices.
+inline void UpdateHierarchy(const Matrix4* local, const int* parent, Matrix4* world, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (parent[i] < 0) {
+            world[i] = local[i];
+        } else {
+            MultiplyMatrix(world[parent[i]], local[i], world[i]);
+        }
+    }
+}
+
+} // namespace Math3D
@@ -38,6 +38,11 @@ public:
         return Vector3(x * scalar, y * scalar, z * scalar);
     }
 
+    // Component-wise multiplication
+    Vector3 operator*(const Vector3& other) const {
+        return Vector3(x * other.x, y * other.y, z * other.z);
+    }
+
     Vector3 operator/(float scalar) const {
         float inv = 1.0f / scalar;
         return Vector3(x * inv, y * inv, z * inv);
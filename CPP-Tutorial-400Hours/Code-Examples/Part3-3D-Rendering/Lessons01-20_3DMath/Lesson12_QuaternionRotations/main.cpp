@@ -1,23 +1,284 @@
 /*
  * Quaternion Rotations
- * Complete working demonstration
+ * Interpolating rotations for animation: exact Slerp against NLERP and a
+ * polynomial fast SLERP, batched over thousands of bones with SIMD
+ * (QuaternionBatch.h), plus the local-to-world skeleton pass
  */
 
 #include <iostream>
 #include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+#include <algorithm>
 #include "../../Common/Math3D/Math3D.h"
 
 using namespace Math3D;
 
+const size_t BONES = 10000;
+
 void PrintHeader(const std::string& title) {
     std::cout << "\n" << std::string(60, '=') << std::endl;
     std::cout << "  " << title << std::endl;
     std::cout << std::string(60, '=') << std::endl;
 }
 
+// Milliseconds for `repeats` calls of func
+template <typename Func>
+double TimeMs(int repeats, Func&& func) {
+    func();  // warmup: page in the output arrays
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int r = 0; r < repeats; r++) {
+        func();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// Rotation angle between two orientations in degrees, in double precision.
+// q and -q are the same rotation.
+double AngleBetweenDegrees(const Quaternion& a, const Quaternion& b) {
+    double la = std::sqrt(static_cast<double>(a.LengthSquared()));
+    double lb = std::sqrt(static_cast<double>(b.LengthSquared()));
+    double sign = a.Dot(b) < 0.0f ? -1.0 : 1.0;
+    double diff = 0.0, sum = 0.0;
+    const float* pa = &a.x;
+    const float* pb = &b.x;
+    for (int k = 0; k < 4; k++) {
+        double ca = pa[k] / la;
+        double cb = sign * pb[k] / lb;
+        diff += (ca - cb) * (ca - cb);
+        sum += (ca + cb) * (ca + cb);
+    }
+    return 4.0 * std::atan2(std::sqrt(diff), std::sqrt(sum)) * 180.0 / 3.14159265358979;
+}
+
+// Keyframe pairs: a random orientation, the same turned by up to
+// maxDegrees about a random axis, and a random blend weight. Half of the
+// second keys are negated to exercise the shorter-arc flip.
+struct KeyPairs {
+    QuaternionSoA from;
+    QuaternionSoA to;
+    std::vector<float> t;
+};
+
+KeyPairs RandomKeyPairs(size_t count, float maxDegrees, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> gauss(0.0f, 1.0f);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    KeyPairs keys{QuaternionSoA(count), QuaternionSoA(count), std::vector<float>(count)};
+    for (size_t i = 0; i < count; i++) {
+        Quaternion a = Quaternion(gauss(rng), gauss(rng), gauss(rng), gauss(rng)).Normalized();
+        Vector3 axis(gauss(rng), gauss(rng), gauss(rng));
+        Quaternion b = (a * Quaternion(axis, Radians(maxDegrees * unit(rng)))).Normalized();
+        if (i % 2 == 1) {
+            b = b * -1.0f;
+        }
+        keys.from.Set(i, a);
+        keys.to.Set(i, b);
+        keys.t[i] = unit(rng);
+    }
+    return keys;
+}
+
 void Demonstration() {
-    PrintHeader("Main Demonstration");
-    std::cout << "Complete working example for this lesson." << std::endl;
+    PrintHeader("Interpolating a 150 degree turn");
+
+    const Quaternion a = Quaternion::Identity();
+    const Quaternion b = Quaternion::RotationY(Radians(150.0f));
+
+    // Slerp turns at constant speed; NLERP moves along the same arc but
+    // fastest in the middle
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << std::setw(6) << "t" << std::setw(12) << "Slerp" << std::setw(12) << "Nlerp"
+              << std::setw(12) << "SlerpFast" << "   (degrees turned)" << std::endl;
+    for (float t : {0.0f, 0.1f, 0.25f, 0.5f, 0.75f, 0.9f, 1.0f}) {
+        std::cout << std::setw(6) << t
+                  << std::setw(12) << AngleBetweenDegrees(a, Quaternion::Slerp(a, b, t))
+                  << std::setw(12) << AngleBetweenDegrees(a, Quaternion::Nlerp(a, b, t))
+                  << std::setw(12) << AngleBetweenDegrees(a, Quaternion::SlerpFast(a, b, t))
+                  << std::endl;
+    }
+}
+
+void AccuracyReport() {
+    PrintHeader("Accuracy against Quaternion::Slerp (10K bones)");
+
+    std::cout << std::setw(10) << "Key gap" << std::setw(13) << "Nlerp max" << std::setw(13) << "Nlerp mean"
+              << std::setw(13) << "Fast max" << std::setw(13) << "Fast |q|-1" << std::endl;
+    std::cout << std::string(62, '-') << std::endl;
+
+    for (float maxDegrees : {10.0f, 45.0f, 90.0f, 180.0f}) {
+        KeyPairs keys = RandomKeyPairs(BONES, maxDegrees, 7);
+        QuaternionSoA nlerp, fast;
+        NlerpQuaternions(keys.from, keys.to, keys.t.data(), nlerp);
+        SlerpQuaternionsFast(keys.from, keys.to, keys.t.data(), fast);
+
+        double nlerpMax = 0.0, nlerpSum = 0.0, fastMax = 0.0, fastLength = 0.0;
+        for (size_t i = 0; i < BONES; i++) {
+            Quaternion exact = Quaternion::Slerp(keys.from.Get(i), keys.to.Get(i), keys.t[i]);
+            double nlerpError = AngleBetweenDegrees(exact, nlerp.Get(i));
+            nlerpMax = std::max(nlerpMax, nlerpError);
+            nlerpSum += nlerpError;
+            fastMax = std::max(fastMax, AngleBetweenDegrees(exact, fast.Get(i)));
+            fastLength = std::max(fastLength, std::abs(static_cast<double>(fast.Get(i).Length()) - 1.0));
+        }
+
+        std::cout << std::fixed << std::setprecision(0) << std::setw(9) << maxDegrees << "d"
+                  << std::scientific << std::setprecision(2)
+                  << std::setw(13) << nlerpMax << std::setw(13) << nlerpSum / BONES
+                  << std::setw(13) << fastMax << std::setw(13) << fastLength << std::endl;
+    }
+    std::cout << std::fixed;
+    std::cout << "Errors in degrees. Key gap is the largest rotation between the two keys;" << std::endl;
+    std::cout << "animation keys are usually a few degrees apart, where NLERP is enough." << std::endl;
+}
+
+// ========== Benchmarks ==========
+
+void BenchmarkInterpolation() {
+    PrintHeader("Benchmark: Interpolating 10K bones (per-bone t)");
+
+    KeyPairs keys = RandomKeyPairs(BONES, 90.0f, 11);
+    std::vector<Quaternion> from(BONES), to(BONES), single(BONES);
+    for (size_t i = 0; i < BONES; i++) {
+        from[i] = keys.from.Get(i);
+        to[i] = keys.to.Get(i);
+    }
+    QuaternionSoA batched(BONES);
+
+    const int repeats = 2000;
+    auto perBone = [&](Quaternion (*interpolate)(const Quaternion&, const Quaternion&, float)) {
+        return TimeMs(repeats, [&]() {
+            for (size_t i = 0; i < BONES; i++) {
+                single[i] = interpolate(from[i], to[i], keys.t[i]);
+            }
+        });
+    };
+    const double slerpMs = perBone(&Quaternion::Slerp);
+
+    struct Row {
+        const char* name;
+        double ms;
+    };
+    const Row rows[] = {
+        {"Slerp (one at a time)", slerpMs},
+        {"Nlerp (one at a time)", perBone(&Quaternion::Nlerp)},
+        {"SlerpFast (one at a time)", perBone(&Quaternion::SlerpFast)},
+        {"NlerpQuaternions", TimeMs(repeats, [&]() {
+             NlerpQuaternions(keys.from, keys.to, keys.t.data(), batched);
+         })},
+        {"SlerpQuaternionsFast", TimeMs(repeats, [&]() {
+             SlerpQuaternionsFast(keys.from, keys.to, keys.t.data(), batched);
+         })},
+    };
+
+    std::cout << "SIMD level: " << Simd::LevelName() << std::endl;
+    std::cout << std::setw(28) << std::left << "Method" << std::right << std::setw(14) << "us / 10K"
+              << std::setw(12) << "ns/bone" << std::setw(10) << "vs Slerp" << std::endl;
+    std::cout << std::string(64, '-') << std::endl;
+    for (const Row& row : rows) {
+        std::cout << std::setw(28) << std::left << row.name << std::right << std::fixed
+                  << std::setprecision(1) << std::setw(14) << row.ms * 1000.0 / repeats
+                  << std::setprecision(2) << std::setw(12) << row.ms * 1e6 / (static_cast<double>(BONES) * repeats)
+                  << std::setprecision(1) << std::setw(9) << slerpMs / row.ms << "x" << std::endl;
+    }
+}
+
+// Skeleton with up to `children` children per bone, stored breadth-first or
+// depth-first (parents always before children)
+std::vector<int> MakeSkeleton(size_t count, int children, bool breadthFirst) {
+    std::vector<int> parent(count);
+    if (breadthFirst) {
+        for (size_t i = 0; i < count; i++) {
+            parent[i] = i == 0 ? -1 : static_cast<int>((i - 1) / children);
+        }
+        return parent;
+    }
+    // Pre-order walk of the same tree
+    std::vector<int> stack = {0};
+    std::vector<int> newIndex(count);
+    size_t next = 0;
+    while (!stack.empty()) {
+        int node = stack.back();
+        stack.pop_back();
+        newIndex[node] = static_cast<int>(next++);
+        for (int c = children; c >= 1; c--) {
+            size_t child = static_cast<size_t>(node) * children + c;
+            if (child < count) {
+                stack.push_back(static_cast<int>(child));
+            }
+        }
+    }
+    for (size_t i = 0; i < count; i++) {
+        parent[newIndex[i]] = i == 0 ? -1 : newIndex[(i - 1) / children];
+    }
+    return parent;
+}
+
+void BenchmarkHierarchy() {
+    PrintHeader("Benchmark: Local-to-World for 10K bones");
+
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> angle(-0.5f, 0.5f);
+    QuaternionSoA localRotation(BONES);
+    Vector3SoA localPosition(BONES);
+    for (size_t i = 0; i < BONES; i++) {
+        localRotation.Set(i, Quaternion::FromEuler(angle(rng), angle(rng), angle(rng)));
+        localPosition.Set(i, Vector3(0.0f, 0.1f, 0.02f * (i % 3)));
+    }
+
+    std::cout << std::setw(14) << "Order" << std::setw(16) << "Single ns/bone"
+              << std::setw(15) << "Batch ns/bone" << std::setw(10) << "Speedup"
+              << std::setw(11) << "Max diff" << std::endl;
+    std::cout << std::string(66, '-') << std::endl;
+
+    for (bool breadthFirst : {true, false}) {
+        std::vector<int> parent = MakeSkeleton(BONES, 3, breadthFirst);
+
+        // One bone at a time with Quaternion and Vector3
+        std::vector<Quaternion> rotation(BONES);
+        std::vector<Vector3> position(BONES);
+        const int repeats = 2000;
+        double singleMs = TimeMs(repeats, [&]() {
+            for (size_t i = 0; i < BONES; i++) {
+                Quaternion local = localRotation.Get(i);
+                Vector3 offset = localPosition.Get(i);
+                int p = parent[i];
+                rotation[i] = p < 0 ? local : rotation[p] * local;
+                position[i] = p < 0 ? offset : position[p] + rotation[p] * offset;
+            }
+        });
+
+        QuaternionSoA worldRotation;
+        Vector3SoA worldPosition;
+        double batchMs = TimeMs(repeats, [&]() {
+            FlattenHierarchy(parent.data(), localRotation, localPosition, worldRotation, worldPosition);
+        });
+
+        float maxDiff = 0.0f;
+        for (size_t i = 0; i < BONES; i++) {
+            Quaternion q = worldRotation.Get(i);
+            Vector3 d = worldPosition.Get(i) - position[i];
+            maxDiff = std::max({maxDiff, std::abs(q.x - rotation[i].x), std::abs(q.y - rotation[i].y),
+                                std::abs(q.z - rotation[i].z), std::abs(q.w - rotation[i].w),
+                                std::abs(d.x), std::abs(d.y), std::abs(d.z)});
+        }
+
+        double perBone = 1e6 / (static_cast<double>(BONES) * repeats);
+        std::cout << std::setw(14) << (breadthFirst ? "breadth-first" : "depth-first")
+                  << std::fixed << std::setprecision(2)
+                  << std::setw(16) << singleMs * perBone << std::setw(15) << batchMs * perBone
+                  << std::setw(9) << singleMs / batchMs << "x"
+                  << std::setw(11) << std::scientific << std::setprecision(1) << maxDiff
+                  << std::fixed << std::endl;
+    }
+    std::cout << "Breadth-first order puts each depth level in one run, so whole runs" << std::endl;
+    std::cout << "are batched. Depth-first order leaves runs of about 4 bones: they fill" << std::endl;
+    std::cout << "4-wide SSE batches, but not 8-wide AVX ones, and one bone at a time" << std::endl;
+    std::cout << "the SoA arrays are slower than this AoS loop (AVX: below 1x)." << std::endl;
 }
 
 int main() {
@@ -26,6 +287,9 @@ int main() {
     std::cout << "==========================================" << std::endl;
 
     Demonstration();
+    AccuracyReport();
+    BenchmarkInterpolation();
+    BenchmarkHierarchy();
 
     std::cout << "\n==========================================" << std::endl;
     std::cout << "  Lesson Complete!" << std::endl;
@@ -1,10 +1,16 @@
 /*
  * Frustum Culling
- * Complete working demonstration
+ * One object at a time (Frustum::ContainsSphere/ContainsAABB) against
+ * batched SIMD culling over structure-of-arrays bounds (FrustumBatch.h)
  */
 
 #include <iostream>
 #include <iomanip>
+#include <chrono>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <vector>
 #include "../../Common/Math3D/Math3D.h"
 
 using namespace Math3D;
@@ -15,9 +21,180 @@ void PrintHeader(const std::string& title) {
     std::cout << std::string(60, '=') << std::endl;
 }
 
+// Camera at the origin turning slowly around Y, one frustum per frame
+Frustum FrameFrustum(int frame) {
+    float angle = 0.01f * frame;
+    Vector3 target(std::sin(angle), 0.0f, -std::cos(angle));
+    Matrix4 view = Matrix4::LookAt(Vector3::Zero(), target, Vector3::Up());
+    Matrix4 projection = Matrix4::Perspective(Radians(60.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+    Frustum frustum;
+    frustum.ExtractFromMatrix(projection * view);
+    return frustum;
+}
+
+// Objects come in clusters of 64 around random points, the way a scene
+// stored by spatial cell would list them
+struct Scene {
+    std::vector<Sphere> spheres;
+    std::vector<AABB> boxes;
+    SphereSoA sphereSoA;
+    AABBSoA boxSoA;
+};
+
+Scene MakeScene(size_t count) {
+    std::mt19937 rng(17);
+    std::uniform_real_distribution<float> world(-800.0f, 800.0f);
+    std::uniform_real_distribution<float> offset(-20.0f, 20.0f);
+    std::uniform_real_distribution<float> size(0.5f, 4.0f);
+
+    Scene scene;
+    scene.sphereSoA.Resize(count);
+    scene.boxSoA.Resize(count);
+    Vector3 cluster;
+    for (size_t i = 0; i < count; i++) {
+        if (i % 64 == 0) {
+            cluster = Vector3(world(rng), world(rng) * 0.1f, world(rng));
+        }
+        Vector3 center = cluster + Vector3(offset(rng), offset(rng), offset(rng));
+        Vector3 extents(size(rng), size(rng), size(rng));
+        scene.spheres.emplace_back(center, extents.Length());
+        scene.boxes.emplace_back(center - extents, center + extents);
+        scene.sphereSoA.Set(i, scene.spheres.back());
+        scene.boxSoA.Set(i, scene.boxes.back());
+    }
+    return scene;
+}
+
+// Reference masks from the single-object tests
+void SingleSphereMask(const Frustum& frustum, const std::vector<Sphere>& spheres, std::vector<uint64_t>& mask) {
+    mask.assign(VisibilityMaskWords(spheres.size()), 0);
+    for (size_t i = 0; i < spheres.size(); i++) {
+        if (frustum.ContainsSphere(spheres[i])) {
+            mask[i / 64] |= uint64_t(1) << (i % 64);
+        }
+    }
+}
+
+void SingleAABBMask(const Frustum& frustum, const std::vector<AABB>& boxes, std::vector<uint64_t>& mask) {
+    mask.assign(VisibilityMaskWords(boxes.size()), 0);
+    for (size_t i = 0; i < boxes.size(); i++) {
+        if (frustum.ContainsAABB(boxes[i])) {
+            mask[i / 64] |= uint64_t(1) << (i % 64);
+        }
+    }
+}
+
+size_t CountMismatches(const std::vector<uint64_t>& a, const std::vector<uint64_t>& b) {
+    size_t mismatches = 0;
+    for (size_t w = 0; w < a.size(); w++) {
+        for (uint64_t bits = a[w] ^ b[w]; bits != 0; bits &= bits - 1) {
+            mismatches++;
+        }
+    }
+    return mismatches;
+}
+
 void Demonstration() {
-    PrintHeader("Main Demonstration");
-    std::cout << "Complete working example for this lesson." << std::endl;
+    PrintHeader("Batch Frustum Culling");
+
+    std::cout << "SIMD level: " << Simd::LevelName() << " - "
+              << Simd::WIDTH << " objects per plane test" << std::endl;
+
+    Frustum frustum = FrameFrustum(0);
+    std::vector<Sphere> spheres = {
+        Sphere(Vector3(0.0f, 0.0f, -10.0f), 1.0f),    // straight ahead
+        Sphere(Vector3(0.0f, 0.0f, 10.0f), 1.0f),     // behind the camera
+        Sphere(Vector3(0.0f, 0.0f, -1200.0f), 50.0f), // beyond the far plane
+        Sphere(Vector3(-25.0f, 0.0f, -20.0f), 2.0f),  // left of the view
+        Sphere(Vector3(-14.0f, 0.0f, -20.0f), 2.0f),  // crossing the left plane
+    };
+
+    SphereSoA soa;
+    soa.Resize(spheres.size());
+    for (size_t i = 0; i < spheres.size(); i++) {
+        soa.Set(i, spheres[i]);
+    }
+    std::vector<uint64_t> mask;
+    CullSpheres(frustum, soa, mask);
+
+    for (size_t i = 0; i < spheres.size(); i++) {
+        std::cout << "  sphere at " << spheres[i].center << " r=" << spheres[i].radius
+                  << ": batch " << (IsVisible(mask, i) ? "visible" : "culled ")
+                  << ", single " << (frustum.ContainsSphere(spheres[i]) ? "visible" : "culled")
+                  << std::endl;
+    }
+
+    Scene scene = MakeScene(100000);
+    std::vector<uint64_t> boxMask;
+    std::vector<uint64_t> singleMask, singleBoxMask;
+    CullSpheres(frustum, scene.sphereSoA, mask);
+    CullAABBs(frustum, scene.boxSoA, boxMask);
+    SingleSphereMask(frustum, scene.spheres, singleMask);
+    SingleAABBMask(frustum, scene.boxes, singleBoxMask);
+    std::cout << "\n100000 objects: " << CountVisible(mask) << " spheres and "
+              << CountVisible(boxMask) << " boxes visible" << std::endl;
+    std::cout << "Mismatches against the single tests: " << CountMismatches(mask, singleMask)
+              << " / " << CountMismatches(boxMask, singleBoxMask) << std::endl;
+}
+
+// ========== Benchmark ==========
+
+// Average milliseconds per frame over `frames` frames of a turning camera
+template <typename Cull>
+double MsPerFrame(int frames, Cull&& cull) {
+    cull(FrameFrustum(0));  // warmup
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int frame = 0; frame < frames; frame++) {
+        cull(FrameFrustum(frame));
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / frames;
+}
+
+void BenchmarkCulling() {
+    PrintHeader("Benchmark: Culling per Frame");
+
+    const unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    const size_t sizes[] = {10000, 100000, 1000000};
+
+    std::cout << "ms per frame, spheres / AABBs; " << threads << " hardware thread(s)" << std::endl;
+    std::cout << std::setw(9) << "Objects" << std::setw(15) << "Single"
+              << std::setw(15) << "Batch" << std::setw(15) << "Batch+cache"
+              << std::setw(15) << "Threaded" << std::endl;
+    std::cout << std::string(69, '-') << std::endl;
+
+    for (size_t count : sizes) {
+        Scene scene = MakeScene(count);
+        std::vector<uint64_t> mask(VisibilityMaskWords(count));
+        const int frames = static_cast<int>(std::max<size_t>(10, 20000000 / count));
+
+        auto pair = [&](auto&& cullSpheres, auto&& cullBoxes) {
+            FrustumCullCache sphereCache, boxCache;
+            double sphereMs = MsPerFrame(frames, [&](const Frustum& f) { cullSpheres(f, sphereCache); });
+            double boxMs = MsPerFrame(frames, [&](const Frustum& f) { cullBoxes(f, boxCache); });
+            std::ostringstream cell;
+            cell << std::fixed << std::setprecision(3) << sphereMs << "/" << boxMs;
+            return cell.str();
+        };
+
+        std::string single = pair(
+            [&](const Frustum& f, FrustumCullCache&) { SingleSphereMask(f, scene.spheres, mask); },
+            [&](const Frustum& f, FrustumCullCache&) { SingleAABBMask(f, scene.boxes, mask); });
+        std::string batch = pair(
+            [&](const Frustum& f, FrustumCullCache&) { CullSpheres(f, scene.sphereSoA, mask); },
+            [&](const Frustum& f, FrustumCullCache&) { CullAABBs(f, scene.boxSoA, mask); });
+        std::string cached = pair(
+            [&](const Frustum& f, FrustumCullCache& c) { CullSpheres(f, scene.sphereSoA, mask, &c); },
+            [&](const Frustum& f, FrustumCullCache& c) { CullAABBs(f, scene.boxSoA, mask, &c); });
+        std::string threaded = pair(
+            [&](const Frustum& f, FrustumCullCache& c) { CullSpheres(f, scene.sphereSoA, mask, &c, threads); },
+            [&](const Frustum& f, FrustumCullCache& c) { CullAABBs(f, scene.boxSoA, mask, &c, threads); });
+
+        std::cout << std::setw(9) << count << std::setw(15) << single << std::setw(15) << batch
+                  << std::setw(15) << cached << std::setw(15) << threaded << std::endl;
+    }
+
+    std::cout << "\nThreads pay off once a frame has enough objects to cover thread start-up." << std::endl;
 }
 
 int main() {
@@ -26,6 +203,7 @@ int main() {
     std::cout << "==========================================" << std::endl;
 
     Demonstration();
+    BenchmarkCulling();
 
     std::cout << "\n==========================================" << std::endl;
     std::cout << "  Lesson Complete!" << std::endl;
@@ -1,10 +1,15 @@
 /*
  * Ray Intersection Tests
- * Complete working demonstration
+ * Single-primitive tests from Math3D, then a BVH over a triangle mesh:
+ * closest-hit, any-hit and packet queries, refit, and Mrays/s benchmarks
  */
 
 #include <iostream>
 #include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <vector>
 #include "../../Common/Math3D/Math3D.h"
 
 using namespace Math3D;
@@ -15,9 +20,290 @@ void PrintHeader(const std::string& title) {
     std::cout << std::string(60, '=') << std::endl;
 }
 
-void Demonstration() {
-    PrintHeader("Main Demonstration");
-    std::cout << "Complete working example for this lesson." << std::endl;
+double ElapsedMs(std::chrono::high_resolution_clock::time_point start) {
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+struct Mesh {
+    std::vector<Vector3> vertices;
+    std::vector<uint32_t> indices;
+
+    size_t TriangleCount() const {
+        return indices.size() / 3;
+    }
+};
+
+float TerrainHeight(float x, float z, float time) {
+    return 20.0f * std::sin(x * 0.02f + time) * std::cos(z * 0.03f) +
+           5.0f * std::sin(x * 0.11f + z * 0.07f - time);
+}
+
+// Heightfield terrain 1000 x 1000 units, about `triangles` triangles
+Mesh MakeTerrain(size_t triangles) {
+    const size_t cells = std::max<size_t>(1, static_cast<size_t>(std::sqrt(triangles / 2.0)));
+    const float cellSize = 1000.0f / cells;
+
+    Mesh mesh;
+    mesh.vertices.reserve((cells + 1) * (cells + 1));
+    for (size_t z = 0; z <= cells; z++) {
+        for (size_t x = 0; x <= cells; x++) {
+            float wx = x * cellSize - 500.0f;
+            float wz = z * cellSize - 500.0f;
+            mesh.vertices.emplace_back(wx, TerrainHeight(wx, wz, 0.0f), wz);
+        }
+    }
+    mesh.indices.reserve(cells * cells * 6);
+    for (size_t z = 0; z < cells; z++) {
+        for (size_t x = 0; x < cells; x++) {
+            uint32_t i = static_cast<uint32_t>(z * (cells + 1) + x);
+            uint32_t below = i + static_cast<uint32_t>(cells + 1);
+            mesh.indices.insert(mesh.indices.end(), {i, below, i + 1, i + 1, below, below + 1});
+        }
+    }
+    return mesh;
+}
+
+void AnimateTerrain(Mesh& mesh, float time) {
+    for (Vector3& v : mesh.vertices) {
+        v.y = TerrainHeight(v.x, v.z, time);
+    }
+}
+
+// Camera above the terrain looking down at it. Rays are ordered in tiles
+// of Simd::WIDTH pixels (2x2 for SSE, 4x2 for AVX), so each packet covers
+// a small patch of the image. width and height must divide by the tile.
+std::vector<Ray> CameraRays(int width, int height) {
+    const Vector3 eye(0.0f, 300.0f, 600.0f);
+    const Vector3 forward = (Vector3(0.0f, 0.0f, 0.0f) - eye).Normalized();
+    const Vector3 right = forward.Cross(Vector3::Up()).Normalized();
+    const Vector3 up = right.Cross(forward);
+    const float halfHeight = std::tan(Radians(30.0f));
+    const float halfWidth = halfHeight * width / height;
+
+    const int tileHeight = Simd::WIDTH >= 4 ? 2 : 1;
+    const int tileWidth = Simd::WIDTH / tileHeight;
+
+    std::vector<Ray> rays;
+    rays.reserve(static_cast<size_t>(width) * height);
+    for (int tileY = 0; tileY < height; tileY += tileHeight) {
+        for (int tileX = 0; tileX < width; tileX += tileWidth) {
+            for (int y = tileY; y < tileY + tileHeight; y++) {
+                for (int x = tileX; x < tileX + tileWidth; x++) {
+                    float px = (2.0f * (x + 0.5f) / width - 1.0f) * halfWidth;
+                    float py = (1.0f - 2.0f * (y + 0.5f) / height) * halfHeight;
+                    rays.emplace_back(eye, forward + right * px + up * py);
+                }
+            }
+        }
+    }
+    return rays;
+}
+
+RayHit BruteForce(const Mesh& mesh, const Ray& ray) {
+    RayHit best;
+    for (size_t i = 0; i < mesh.TriangleCount(); i++) {
+        float t;
+        Vector3 barycentric;
+        if (RayTriangleIntersection(ray, mesh.vertices[mesh.indices[i * 3]], mesh.vertices[mesh.indices[i * 3 + 1]],
+                                    mesh.vertices[mesh.indices[i * 3 + 2]], t, barycentric) && t < best.t) {
+            best.t = t;
+            best.u = barycentric.x;
+            best.v = barycentric.y;
+            best.triangle = static_cast<uint32_t>(i);
+        }
+    }
+    return best;
+}
+
+void DemonstrationPrimitives() {
+    PrintHeader("Single-Primitive Tests");
+
+    Ray ray(Vector3(0.0f, 0.0f, 10.0f), Vector3(0.0f, 0.0f, -1.0f));
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "Ray from " << ray.origin << " along " << ray.direction << std::endl;
+
+    float t;
+    Sphere sphere(Vector3(0.0f, 0.0f, 0.0f), 2.0f);
+    if (sphere.RayIntersection(ray, t)) {
+        std::cout << "  sphere r=2 at origin:   t = " << t << std::endl;
+    }
+
+    float tMin, tMax;
+    AABB box(Vector3(-1.0f, -1.0f, -4.0f), Vector3(1.0f, 1.0f, -2.0f));
+    if (box.RayIntersection(ray, tMin, tMax)) {
+        std::cout << "  box z in [-4, -2]:      enters t = " << tMin << ", exits t = " << tMax << std::endl;
+    }
+
+    Plane plane(Vector3(0.0f, 0.0f, 1.0f), -5.0f);
+    if (plane.RayIntersection(ray, t)) {
+        std::cout << "  plane z = -5:           t = " << t << std::endl;
+    }
+
+    Vector3 barycentric;
+    if (RayTriangleIntersection(ray, Vector3(-1.0f, -1.0f, 1.0f), Vector3(1.0f, -1.0f, 1.0f),
+                                Vector3(0.0f, 1.0f, 1.0f), t, barycentric)) {
+        std::cout << "  triangle at z = 1:      t = " << t << ", barycentric " << barycentric << std::endl;
+    }
+}
+
+void DemonstrationBVH() {
+    PrintHeader("BVH over a Triangle Mesh");
+
+    Mesh mesh = MakeTerrain(20000);
+    BVH bvh;
+    bvh.Build(mesh.vertices, mesh.indices);
+    std::cout << mesh.TriangleCount() << " triangles -> " << bvh.NodeCount() << " nodes ("
+              << sizeof(BVHNode) << " bytes each)" << std::endl;
+    std::cout << "SIMD level: " << Simd::LevelName() << ", packets of " << Simd::WIDTH << " rays" << std::endl;
+
+    std::vector<Ray> rays = CameraRays(64, 36);
+    std::vector<RayHit> packetHits(rays.size());
+    bvh.IntersectRays(rays.data(), packetHits.data(), rays.size());
+
+    size_t hits = 0, bruteMismatches = 0, packetMismatches = 0, occludedMismatches = 0;
+    for (size_t i = 0; i < rays.size(); i++) {
+        RayHit hit;
+        bvh.Intersect(rays[i], hit);
+        RayHit brute = BruteForce(mesh, rays[i]);
+        hits += hit.Hit();
+        bruteMismatches += hit.t != brute.t;
+        packetMismatches += packetHits[i].triangle != hit.triangle;
+        occludedMismatches += bvh.Occluded(rays[i], 1e30f) != hit.Hit();
+    }
+    std::cout << rays.size() << " camera rays, " << hits << " hit the terrain" << std::endl;
+    std::cout << "Closest hits differing from brute force: " << bruteMismatches
+              << ", packets differing from single rays: " << packetMismatches
+              << ", any-hit disagreeing: " << occludedMismatches << std::endl;
+
+    RayHit pick;
+    if (bvh.Intersect(rays[rays.size() * 3 / 4], pick)) {
+        std::cout << "Picking a pixel: triangle " << pick.triangle << " at t = " << pick.t
+                  << " (u " << pick.u << ", v " << pick.v << ")" << std::endl;
+    }
+}
+
+// ========== Benchmarks ==========
+
+// Million rays per second for `trace` over all rays, repeated for ~200 ms
+template <typename Trace>
+double MraysPerSecond(size_t rayCount, Trace&& trace) {
+    trace();  // warmup
+    size_t traced = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    double ms = 0.0;
+    do {
+        trace();
+        traced += rayCount;
+        ms = ElapsedMs(start);
+    } while (ms < 200.0);
+    return traced / (ms * 1000.0);
+}
+
+void BenchmarkBVH() {
+    PrintHeader("Benchmark: BVH Build and Trace");
+
+    const unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    const size_t sizes[] = {10000, 100000, 1000000, 10000000};
+    std::vector<Ray> rays = CameraRays(640, 360);
+    std::vector<RayHit> hits(rays.size());
+
+    std::cout << "Mrays/s for " << rays.size() << " camera rays; build on " << threads
+              << " thread(s)" << std::endl;
+    std::cout << std::setw(10) << "Triangles" << std::setw(10) << "Build ms" << std::setw(8) << "MB"
+              << std::setw(9) << "Brute" << std::setw(10) << "Closest" << std::setw(10) << "Packet"
+              << std::setw(10) << "Any-hit" << std::endl;
+    std::cout << std::string(67, '-') << std::endl;
+
+    for (size_t size : sizes) {
+        Mesh mesh = MakeTerrain(size);
+        BVH bvh;
+        auto start = std::chrono::high_resolution_clock::now();
+        bvh.Build(mesh.vertices, mesh.indices, threads);
+        double buildMs = ElapsedMs(start);
+
+        std::cout << std::setw(10) << mesh.TriangleCount() << std::fixed << std::setprecision(0)
+                  << std::setw(10) << buildMs << std::setw(8) << bvh.MemoryBytes() / 1e6
+                  << std::setprecision(2);
+
+        // Brute force only where it finishes in reasonable time
+        if (mesh.TriangleCount() <= 10000) {
+            const size_t bruteRays = 2000;
+            std::cout << std::setw(9) << MraysPerSecond(bruteRays, [&]() {
+                for (size_t i = 0; i < bruteRays; i++) {
+                    hits[i] = BruteForce(mesh, rays[i * 7]);
+                }
+            });
+        } else {
+            std::cout << std::setw(9) << "-";
+        }
+
+        std::cout << std::setw(10) << MraysPerSecond(rays.size(), [&]() {
+            for (size_t i = 0; i < rays.size(); i++) {
+                hits[i] = RayHit();
+                bvh.Intersect(rays[i], hits[i]);
+            }
+        });
+        std::cout << std::setw(10) << MraysPerSecond(rays.size(), [&]() {
+            std::fill(hits.begin(), hits.end(), RayHit());
+            bvh.IntersectRays(rays.data(), hits.data(), rays.size());
+        });
+
+        // Shadow rays from every hit point toward the sun
+        std::vector<Ray> shadowRays;
+        const Vector3 toSun = Vector3(0.4f, 1.0f, 0.2f).Normalized();
+        for (size_t i = 0; i < rays.size(); i++) {
+            if (hits[i].Hit()) {
+                shadowRays.emplace_back(rays[i].GetPoint(hits[i].t) + toSun * 0.01f, toSun);
+            }
+        }
+        std::vector<uint8_t> shadowed(shadowRays.size());
+        std::cout << std::setw(10) << MraysPerSecond(shadowRays.size(), [&]() {
+            for (size_t i = 0; i < shadowRays.size(); i++) {
+                shadowed[i] = bvh.Occluded(shadowRays[i], 1e30f);
+            }
+        }) << std::endl;
+    }
+    std::cout << "\nBrute force tests every triangle per ray; the BVH visits a few dozen nodes." << std::endl;
+}
+
+void BenchmarkRefit() {
+    PrintHeader("Benchmark: Refit vs Rebuild (animated terrain)");
+
+    Mesh mesh = MakeTerrain(1000000);
+    std::vector<Ray> rays = CameraRays(320, 180);
+    std::vector<RayHit> hits(rays.size());
+    BVH refitted;
+    refitted.Build(mesh.vertices, mesh.indices);
+
+    std::cout << std::setw(8) << "Time" << std::setw(12) << "Refit ms" << std::setw(12) << "Rebuild ms"
+              << std::setw(16) << "Refit Mrays/s" << std::setw(18) << "Rebuild Mrays/s" << std::endl;
+    std::cout << std::string(66, '-') << std::endl;
+
+    for (float time : {0.5f, 1.5f, 3.0f}) {
+        AnimateTerrain(mesh, time);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        refitted.Refit(mesh.vertices);
+        double refitMs = ElapsedMs(start);
+
+        BVH rebuilt;
+        start = std::chrono::high_resolution_clock::now();
+        rebuilt.Build(mesh.vertices, mesh.indices);
+        double rebuildMs = ElapsedMs(start);
+
+        auto trace = [&](const BVH& bvh) {
+            return MraysPerSecond(rays.size(), [&]() {
+                std::fill(hits.begin(), hits.end(), RayHit());
+                bvh.IntersectRays(rays.data(), hits.data(), rays.size());
+            });
+        };
+        std::cout << std::fixed << std::setprecision(1) << std::setw(8) << time << std::setw(12) << refitMs
+                  << std::setw(12) << rebuildMs << std::setprecision(2) << std::setw(16) << trace(refitted)
+                  << std::setw(18) << trace(rebuilt) << std::endl;
+    }
+    std::cout << "\nRefit keeps the tree and only moves its boxes: cheap, but the boxes" << std::endl;
+    std::cout << "overlap more as the mesh deforms. Rebuild every few frames." << std::endl;
 }
 
 int main() {
@@ -25,7 +311,10 @@ int main() {
     std::cout << "  Ray Intersection Tests" << std::endl;
     std::cout << "==========================================" << std::endl;
 
-    Demonstration();
+    DemonstrationPrimitives();
+    DemonstrationBVH();
+    BenchmarkBVH();
+    BenchmarkRefit();
 
     std::cout << "\n==========================================" << std::endl;
     std::cout << "  Lesson Complete!" << std::endl;
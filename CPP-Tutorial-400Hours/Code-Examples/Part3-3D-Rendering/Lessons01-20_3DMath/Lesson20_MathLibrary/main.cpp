@@ -1,10 +1,16 @@
 /*
  * Complete Math Library
- * Complete working demonstration
+ * Batched transforms: the same Matrix4 math applied to thousands or
+ * millions of points, normals and matrices per call, with SIMD over
+ * structure-of-arrays data (TransformBatch.h)
  */
 
 #include <iostream>
 #include <iomanip>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <algorithm>
 #include "../../Common/Math3D/Math3D.h"
 
 using namespace Math3D;
@@ -15,9 +21,191 @@ void PrintHeader(const std::string& title) {
     std::cout << std::string(60, '=') << std::endl;
 }
 
+// Milliseconds for `repeats` calls of func
+template <typename Func>
+double TimeMs(int repeats, Func&& func) {
+    func();  // warmup: page in the output arrays
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int r = 0; r < repeats; r++) {
+        func();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+std::vector<Vector3> RandomVectors(size_t count, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> dist(-50.0f, 50.0f);
+    std::vector<Vector3> result(count);
+    for (Vector3& v : result) {
+        v = Vector3(dist(rng), dist(rng), dist(rng));
+    }
+    return result;
+}
+
+float MaxDifference(const std::vector<Vector3>& expected, const Vector3SoA& actual) {
+    float maxDiff = 0.0f;
+    for (size_t i = 0; i < expected.size(); i++) {
+        Vector3 d = expected[i] - actual.Get(i);
+        maxDiff = std::max(maxDiff, std::max(std::abs(d.x), std::max(std::abs(d.y), std::abs(d.z))));
+    }
+    return maxDiff;
+}
+
+Matrix4 ModelMatrix() {
+    return Matrix4::Translation(1.0f, 2.0f, -30.0f) *
+           Matrix4::RotationAxis(Vector3(1.0f, 1.0f, 0.0f), 0.7f) *
+           Matrix4::Scale(2.0f, 0.5f, 1.0f);
+}
+
+Matrix4 ModelViewProjection() {
+    Matrix4 view = Matrix4::LookAt(Vector3(0.0f, 5.0f, 10.0f), Vector3::Zero(), Vector3::Up());
+    Matrix4 projection = Matrix4::Perspective(Radians(60.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+    return projection * view * ModelMatrix();
+}
+
 void Demonstration() {
-    PrintHeader("Main Demonstration");
-    std::cout << "Complete working example for this lesson." << std::endl;
+    PrintHeader("Batched Transforms");
+
+    std::cout << "SIMD level: " << Simd::LevelName() << std::endl;
+
+    std::vector<Vector3> points = {
+        Vector3(0.0f, 0.0f, 0.0f), Vector3(1.0f, 0.0f, 0.0f), Vector3(0.0f, 1.0f, 0.0f),
+        Vector3(0.0f, 0.0f, 1.0f), Vector3(1.0f, 1.0f, 1.0f), Vector3(-2.0f, 3.0f, -4.0f),
+        Vector3(5.0f, -1.0f, 2.0f), Vector3(0.5f, 0.25f, -0.75f), Vector3(10.0f, 0.0f, -10.0f)
+    };
+
+    // Points are stored as three arrays (x[], y[], z[]) instead of Vector3[]
+    Vector3SoA soa(points);
+    Vector3SoA transformed;
+    Matrix4 mvp = ModelViewProjection();
+    TransformPoints(mvp, soa, transformed);
+
+    std::cout << std::fixed << std::setprecision(4);
+    std::cout << "\nTransformPoints (model-view-projection, with perspective divide):" << std::endl;
+    for (size_t i = 0; i < 3; i++) {
+        std::cout << "  " << points[i] << " -> " << transformed.Get(i)
+                  << "   single: " << mvp * points[i] << std::endl;
+    }
+    std::cout << "  ... " << points.size() << " points, the last "
+              << points.size() % Simd::WIDTH << " in the scalar remainder loop" << std::endl;
+
+    Vector3SoA normals(std::vector<Vector3>{Vector3::Up(), Vector3::Right(), Vector3(1.0f, 1.0f, 0.0f)});
+    Vector3SoA transformedNormals;
+    TransformNormals(ModelMatrix(), normals, transformedNormals);
+    std::cout << "\nTransformNormals (inverse transpose, renormalized):" << std::endl;
+    for (size_t i = 0; i < normals.Size(); i++) {
+        std::cout << "  " << normals.Get(i) << " -> " << transformedNormals.Get(i) << std::endl;
+    }
+}
+
+// ========== Benchmarks ==========
+
+void BenchmarkPoints() {
+    PrintHeader("Benchmark: Points (Matrix4 * Vector3 per point vs batched)");
+
+    const Matrix4 mvp = ModelViewProjection();
+    const size_t sizes[] = {1000, 10000, 100000, 1000000, 10000000};
+
+    std::cout << std::setw(10) << "Points" << std::setw(14) << "Single ns/pt"
+              << std::setw(14) << "Batch ns/pt" << std::setw(10) << "Speedup"
+              << std::setw(12) << "Max diff" << std::endl;
+    std::cout << std::string(60, '-') << std::endl;
+
+    for (size_t count : sizes) {
+        std::vector<Vector3> input = RandomVectors(count, 1);
+        std::vector<Vector3> singleOut(count);
+        Vector3SoA soaIn(input);
+        Vector3SoA soaOut(count);
+
+        // About 20 million points per measurement
+        const int repeats = static_cast<int>(std::max<size_t>(1, 20000000 / count));
+
+        double singleMs = TimeMs(repeats, [&]() {
+            for (size_t i = 0; i < count; i++) {
+                singleOut[i] = mvp * input[i];
+            }
+        });
+        double batchMs = TimeMs(repeats, [&]() {
+            TransformPoints(mvp, soaIn, soaOut);
+        });
+
+        double perPoint = 1e6 / (static_cast<double>(count) * repeats);
+        std::cout << std::setw(10) << count << std::fixed << std::setprecision(2)
+                  << std::setw(14) << singleMs * perPoint
+                  << std::setw(14) << batchMs * perPoint
+                  << std::setw(9) << singleMs / batchMs << "x"
+                  << std::setw(12) << std::scientific << std::setprecision(1)
+                  << MaxDifference(singleOut, soaOut) << std::endl;
+    }
+    std::cout << std::fixed;
+    std::cout << "\nLarge batches are limited by memory bandwidth (24 bytes per point)." << std::endl;
+}
+
+void BenchmarkNormals() {
+    PrintHeader("Benchmark: Normals");
+
+    const Matrix4 model = ModelMatrix();
+    const size_t count = 1000000;
+    std::vector<Vector3> input = RandomVectors(count, 2);
+    std::vector<Vector3> singleOut(count);
+    Vector3SoA soaIn(input);
+    Vector3SoA soaOut(count);
+
+    double singleMs = TimeMs(10, [&]() {
+        Matrix4 normalMatrix = model.Inverse().Transpose();
+        for (size_t i = 0; i < count; i++) {
+            singleOut[i] = normalMatrix.TransformVector(input[i]).Normalized();
+        }
+    });
+    double batchMs = TimeMs(10, [&]() {
+        TransformNormals(model, soaIn, soaOut);
+    });
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << count << " normals: per normal " << singleMs / 10 << " ms, batched "
+              << batchMs / 10 << " ms (" << singleMs / batchMs << "x), max diff "
+              << std::scientific << std::setprecision(1) << MaxDifference(singleOut, soaOut)
+              << std::fixed << std::endl;
+}
+
+void BenchmarkHierarchy() {
+    PrintHeader("Benchmark: Scene Hierarchy (Matrix4 x Matrix4)");
+
+    // Each node has up to 4 children; parents precede children
+    const size_t count = 10000;
+    std::vector<Matrix4> local(count);
+    std::vector<int> parent(count);
+    for (size_t i = 0; i < count; i++) {
+        parent[i] = i == 0 ? -1 : static_cast<int>((i - 1) / 4);
+        local[i] = Matrix4::Translation(0.1f * (i % 7), 0.2f, -0.1f * (i % 5)) *
+                   Matrix4::RotationY(0.01f * i) * Matrix4::Scale(0.99f);
+    }
+    std::vector<Matrix4> world(count);
+
+    const int repeats = 200;
+    double ms = TimeMs(repeats, [&]() {
+        UpdateHierarchy(local.data(), parent.data(), world.data(), count);
+    });
+
+    // Same product, one node at a time
+    std::vector<Matrix4> expected(count);
+    for (size_t i = 0; i < count; i++) {
+        expected[i] = parent[i] < 0 ? local[i] : expected[parent[i]] * local[i];
+    }
+    float maxDiff = 0.0f;
+    for (size_t i = 0; i < count; i++) {
+        for (int k = 0; k < 16; k++) {
+            maxDiff = std::max(maxDiff, std::abs(expected[i].m[k] - world[i].m[k]));
+        }
+    }
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << count << " nodes: " << ms * 1e6 / (static_cast<double>(count) * repeats)
+              << " ns/matrix, max diff " << std::scientific << std::setprecision(1) << maxDiff
+              << std::fixed << std::endl;
+    std::cout << "Matrix4 * Matrix4 is 4 broadcasts + 4 multiply-adds per column (SSE);" << std::endl;
+    std::cout << "see math3d_benchmark for the speedup over the scalar build." << std::endl;
 }
 
 int main() {
@@ -26,6 +214,9 @@ int main() {
     std::cout << "==========================================" << std::endl;
 
     Demonstration();
+    BenchmarkPoints();
+    BenchmarkNormals();
+    BenchmarkHierarchy();
 
     std::cout << "\n==========================================" << std::endl;
     std::cout << "  Lesson Complete!" << std::endl;
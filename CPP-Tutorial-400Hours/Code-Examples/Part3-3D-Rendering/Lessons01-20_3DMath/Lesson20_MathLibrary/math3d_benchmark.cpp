@@ -0,0 +1,143 @@
+/*
+ * Math3D Micro-Benchmarks
+ * Times each Matrix4 and Quaternion operation over 1000 inputs. CMake
+ * builds this file twice: Lesson20_Math3DBenchmark with the SSE code and
+ * Lesson20_Math3DBenchmark_Scalar with MATH3D_NO_SIMD. Compare the two:
+ *
+ *   Lesson20_Math3DBenchmark_Scalar --json=scalar.json
+ *   Lesson20_Math3DBenchmark --baseline=scalar.json
+ *
+ * The regression table then shows the change per operation (negative is
+ * faster than the scalar build).
+ */
+
+#include <iostream>
+#include <random>
+#include <vector>
+#include "../../Common/Math3D/Math3D.h"
+#include "../../../Part4-Optimization-Advanced/Lesson02_Benchmarking/benchmark.h"
+#include "../../../Part4-Optimization-Advanced/Lesson02_Benchmarking/benchmark_report.h"
+
+using namespace Math3D;
+using namespace perf;
+
+constexpr size_t COUNT = 1000;
+
+struct Inputs {
+    std::vector<Matrix4> matrices;
+    std::vector<Matrix4> others;
+    std::vector<Vector3> vectors;
+    std::vector<Quaternion> rotations;
+    std::vector<Quaternion> otherRotations;
+};
+
+Inputs MakeInputs() {
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    auto randomVector = [&]() { return Vector3(dist(rng), dist(rng), dist(rng)); };
+    auto randomMatrix = [&]() {
+        return Matrix4::Translation(randomVector() * 10.0f) *
+               Matrix4::RotationAxis(randomVector() + Vector3(0.0f, 2.0f, 0.0f), dist(rng) * PI) *
+               Matrix4::Scale(1.5f + dist(rng));
+    };
+    auto randomRotation = [&]() {
+        return Quaternion(randomVector() + Vector3(2.0f, 0.0f, 0.0f), dist(rng) * PI);
+    };
+
+    Inputs in;
+    for (size_t i = 0; i < COUNT; i++) {
+        in.matrices.push_back(randomMatrix());
+        in.others.push_back(randomMatrix());
+        in.vectors.push_back(randomVector() * 50.0f);
+        in.rotations.push_back(randomRotation());
+        in.otherRotations.push_back(randomRotation());
+    }
+    return in;
+}
+
+void BenchmarkMatrix4(BenchmarkSession& session, const Inputs& in) {
+    BenchmarkSuite suite("Matrix4 x1000", 200, 20);
+    suite.set_counters(session.counters());
+
+    std::vector<Matrix4> matrixOut(COUNT);
+    std::vector<Vector3> vectorOut(COUNT);
+
+    suite.add("Matrix4 * Matrix4", [&]() {
+        for (size_t i = 0; i < COUNT; i++) {
+            matrixOut[i] = in.matrices[i] * in.others[i];
+        }
+        clobber_memory();
+    });
+    suite.add("Matrix4 * Vector3", [&]() {
+        for (size_t i = 0; i < COUNT; i++) {
+            vectorOut[i] = in.matrices[i] * in.vectors[i];
+        }
+        clobber_memory();
+    });
+    suite.add("TransformVector", [&]() {
+        for (size_t i = 0; i < COUNT; i++) {
+            vectorOut[i] = in.matrices[i].TransformVector(in.vectors[i]);
+        }
+        clobber_memory();
+    });
+    suite.add("Transpose", [&]() {
+        for (size_t i = 0; i < COUNT; i++) {
+            matrixOut[i] = in.matrices[i].Transpose();
+        }
+        clobber_memory();
+    });
+    suite.add("Inverse", [&]() {
+        for (size_t i = 0; i < COUNT; i++) {
+            matrixOut[i] = in.matrices[i].Inverse();
+        }
+        clobber_memory();
+    });
+
+    suite.print_results();
+    session.record(suite);
+}
+
+void BenchmarkQuaternion(BenchmarkSession& session, const Inputs& in) {
+    BenchmarkSuite suite("Quaternion x1000", 200, 20);
+    suite.set_counters(session.counters());
+
+    std::vector<Quaternion> rotationOut(COUNT);
+    std::vector<Vector3> vectorOut(COUNT);
+
+    suite.add("Quaternion * Quaternion", [&]() {
+        for (size_t i = 0; i < COUNT; i++) {
+            rotationOut[i] = in.rotations[i] * in.otherRotations[i];
+        }
+        clobber_memory();
+    });
+    suite.add("Quaternion * Vector3", [&]() {
+        for (size_t i = 0; i < COUNT; i++) {
+            vectorOut[i] = in.rotations[i] * in.vectors[i];
+        }
+        clobber_memory();
+    });
+
+    suite.print_results();
+    session.record(suite);
+}
+
+int main(int argc, char** argv) {
+    // --json=FILE saves the results, --baseline=FILE compares against them
+    // (see Part4 Lesson02_Benchmarking/benchmark_report.h)
+    BenchmarkSession session(argc, argv);
+    if (!session.ok()) {
+        return 2;
+    }
+
+    std::cout << "Math3D Micro-Benchmarks\n";
+    std::cout << "=======================\n";
+    std::cout << "SIMD level: " << Simd::LevelName() << "\n";
+    std::cout << "Times are per 1000 operations.\n\n";
+    session.environment().print();
+
+    Inputs in = MakeInputs();
+    BenchmarkMatrix4(session, in);
+    BenchmarkQuaternion(session, in);
+
+    return session.finish();
+}
@@ -1,65 +1,154 @@
 /*
  * Ray Tracing Basics
- * Advanced 3D Rendering Techniques
+ * Headless Whitted-style ray tracer on Math3D: primary rays, hard shadows
+ * and mirror reflections over spheres and a ground plane, written as PPM.
+ * Lesson 90 extends this into a multithreaded path tracer.
  */
 
 #include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <string>
 #include <vector>
-#include <glad/glad.h>
-#include <GLFW/glfw3.h>
 #include "../../Common/Math3D/Math3D.h"
-#include "../../Common/Utils/Camera.h"
-#include "../../Common/Utils/ShaderLoader.h"
 
 using namespace Math3D;
-using namespace Utils;
 
-const unsigned int SCR_WIDTH = 1280;
-const unsigned int SCR_HEIGHT = 720;
+const int SCR_WIDTH = 640;
+const int SCR_HEIGHT = 360;
+const int MAX_DEPTH = 4;              // reflection bounces
+const float SURFACE_OFFSET = 1e-3f;   // lifts secondary rays off the surface they leave
 
-Camera camera(Vector3(0.0f, 0.0f, 3.0f));
-float lastX = SCR_WIDTH / 2.0f;
-float lastY = SCR_HEIGHT / 2.0f;
-bool firstMouse = true;
-float deltaTime = 0.0f;
-float lastFrame = 0.0f;
+void PrintHeader(const std::string& title) {
+    std::cout << "\n" << std::string(60, '=') << std::endl;
+    std::cout << "  " << title << std::endl;
+    std::cout << std::string(60, '=') << std::endl;
+}
 
-void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
-    glViewport(0, 0, width, height);
+struct Material {
+    Vector3 color;
+    float reflectivity = 0.0f;
+    float shininess = 32.0f;
+};
+
+struct Scene {
+    std::vector<Sphere> spheres;
+    std::vector<Material> sphereMaterials;
+    Plane ground = Plane(Vector3::Up(), 0.0f);
+    Vector3 lightPosition = Vector3(-4.0f, 6.0f, 4.0f);
+    Vector3 lightColor = Vector3(1.0f, 0.95f, 0.9f);
+    Vector3 skyColor = Vector3(0.55f, 0.7f, 0.9f);
+    float ambient = 0.08f;
+};
+
+Scene MakeScene() {
+    Scene scene;
+    scene.spheres.emplace_back(Vector3(0.0f, 1.0f, -4.0f), 1.0f);
+    scene.sphereMaterials.push_back({Vector3(0.9f, 0.9f, 0.9f), 0.8f, 128.0f});
+    scene.spheres.emplace_back(Vector3(-2.2f, 0.7f, -3.2f), 0.7f);
+    scene.sphereMaterials.push_back({Vector3(0.85f, 0.2f, 0.15f), 0.1f, 32.0f});
+    scene.spheres.emplace_back(Vector3(2.0f, 0.5f, -2.8f), 0.5f);
+    scene.sphereMaterials.push_back({Vector3(0.2f, 0.5f, 0.9f), 0.3f, 64.0f});
+    return scene;
 }
 
-void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
-    if (firstMouse) {
-        lastX = xpos;
-        lastY = ypos;
-        firstMouse = false;
+struct SurfaceHit {
+    float t = 0.0f;
+    Vector3 point;
+    Vector3 normal;
+    Material material;
+};
+
+// Closest of the spheres and the ground plane, using the Math3D tests
+bool Trace(const Scene& scene, const Ray& ray, SurfaceHit& surface) {
+    float closest = std::numeric_limits<float>::infinity();
+    int sphereIndex = -1;
+    for (size_t i = 0; i < scene.spheres.size(); i++) {
+        float t;
+        if (scene.spheres[i].RayIntersection(ray, t) && t < closest) {
+            closest = t;
+            sphereIndex = static_cast<int>(i);
+        }
     }
 
-    float xoffset = xpos - lastX;
-    float yoffset = lastY - ypos;
+    float groundT;
+    bool groundHit = scene.ground.RayIntersection(ray, groundT) && groundT > 0.0f && groundT < closest;
+    if (!groundHit && sphereIndex < 0) {
+        return false;
+    }
 
-    lastX = xpos;
-    lastY = ypos;
+    if (groundHit) {
+        surface.t = groundT;
+        surface.point = ray.GetPoint(groundT);
+        surface.normal = scene.ground.normal;
+        // Checkerboard floor
+        int checker = static_cast<int>(std::floor(surface.point.x) + std::floor(surface.point.z)) & 1;
+        surface.material = {checker ? Vector3(0.8f, 0.8f, 0.8f) : Vector3(0.25f, 0.25f, 0.25f), 0.15f, 16.0f};
+    } else {
+        const Sphere& sphere = scene.spheres[sphereIndex];
+        surface.t = closest;
+        surface.point = ray.GetPoint(closest);
+        surface.normal = (surface.point - sphere.center) / sphere.radius;
+        surface.material = scene.sphereMaterials[sphereIndex];
+    }
+    return true;
+}
 
-    camera.ProcessMouseMovement(xoffset, yoffset);
+bool InShadow(const Scene& scene, const Vector3& point, const Vector3& toLight, float distance) {
+    Ray shadowRay(point, toLight);
+    for (const Sphere& sphere : scene.spheres) {
+        float t;
+        if (sphere.RayIntersection(shadowRay, t) && t < distance) {
+            return true;
+        }
+    }
+    return false;
 }
 
-void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
-    camera.ProcessMouseScroll(yoffset);
+// Blinn-Phong with a hard shadow, plus a recursive mirror ray
+Vector3 Shade(const Scene& scene, const Ray& ray, int depth) {
+    SurfaceHit surface;
+    if (!Trace(scene, ray, surface)) {
+        return scene.skyColor * (0.6f + 0.4f * ray.direction.y);
+    }
+
+    const Material& material = surface.material;
+    const Vector3 origin = surface.point + surface.normal * SURFACE_OFFSET;
+    Vector3 toLight = scene.lightPosition - surface.point;
+    float lightDistance = toLight.Length();
+    toLight = toLight / lightDistance;
+
+    Vector3 color = material.color * scene.ambient;
+    float diffuse = surface.normal.Dot(toLight);
+    if (diffuse > 0.0f && !InShadow(scene, origin, toLight, lightDistance)) {
+        Vector3 halfway = (toLight - ray.direction).Normalized();
+        float specular = std::pow(std::max(0.0f, surface.normal.Dot(halfway)), material.shininess);
+        color += (material.color * diffuse + Vector3::One() * specular) * scene.lightColor;
+    }
+
+    if (material.reflectivity > 0.0f && depth < MAX_DEPTH) {
+        Ray reflected(origin, ray.direction.Reflect(surface.normal));
+        color = Vector3::Lerp(color, Shade(scene, reflected, depth + 1), material.reflectivity);
+    }
+    return color;
 }
 
-void process_input(GLFWwindow* window) {
-    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
-        glfwSetWindowShouldClose(window, true);
-
-    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
-        camera.ProcessKeyboard(Camera::FORWARD, deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
-        camera.ProcessKeyboard(Camera::BACKWARD, deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
-        camera.ProcessKeyboard(Camera::LEFT, deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
-        camera.ProcessKeyboard(Camera::RIGHT, deltaTime);
+bool WritePPM(const std::string& path, const std::vector<Vector3>& pixels, int width, int height) {
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    file << "P6\n" << width << " " << height << "\n255\n";
+    for (const Vector3& pixel : pixels) {
+        for (int i = 0; i < 3; i++) {
+            float encoded = std::pow(Clamp(pixel[i], 0.0f, 1.0f), 1.0f / 2.2f);
+            file.put(static_cast<char>(static_cast<unsigned char>(encoded * 255.0f + 0.5f)));
+        }
+    }
+    return static_cast<bool>(file);
 }
 
 int main() {
@@ -67,65 +156,37 @@ int main() {
     std::cout << "  Ray Tracing Basics" << std::endl;
     std::cout << "==========================================" << std::endl;
 
-    // Initialize GLFW
-    glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-    glfwWindowHint(GLFW_SAMPLES, 4); // MSAA
-
-    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Ray Tracing Basics", nullptr, nullptr);
-    if (!window) {
-        std::cerr << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
-        return -1;
+    PrintHeader("Rendering");
+
+    Scene scene = MakeScene();
+    const Vector3 cameraPosition(0.0f, 1.2f, 1.5f);
+    const float scale = std::tan(Radians(50.0f) * 0.5f);
+    const float aspect = static_cast<float>(SCR_WIDTH) / static_cast<float>(SCR_HEIGHT);
+    std::vector<Vector3> pixels(static_cast<size_t>(SCR_WIDTH) * SCR_HEIGHT);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int y = 0; y < SCR_HEIGHT; y++) {
+        for (int x = 0; x < SCR_WIDTH; x++) {
+            // Ray through the pixel center
+            float px = (2.0f * (x + 0.5f) / SCR_WIDTH - 1.0f) * scale * aspect;
+            float py = (1.0f - 2.0f * (y + 0.5f) / SCR_HEIGHT) * scale;
+            Ray ray(cameraPosition, Vector3(px, py - 0.15f, -1.0f));
+            pixels[static_cast<size_t>(y) * SCR_WIDTH + x] = Shade(scene, ray, 0);
+        }
     }
-
-    glfwMakeContextCurrent(window);
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-    glfwSetCursorPosCallback(window, mouse_callback);
-    glfwSetScrollCallback(window, scroll_callback);
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-        std::cerr << "Failed to initialize GLAD" << std::endl;
-        return -1;
-    }
-
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_MULTISAMPLE);
-
-    std::cout << "OpenGL " << glGetString(GL_VERSION) << std::endl;
-    std::cout << "GLSL " << glGetString(GL_SHADING_LANGUAGE_VERSION) << std::endl;
-    std::cout << "\nControls:" << std::endl;
-    std::cout << "  WASD - Move camera" << std::endl;
-    std::cout << "  Mouse - Look around" << std::endl;
-    std::cout << "  Scroll - Zoom" << std::endl;
-    std::cout << "  ESC - Exit\n" << std::endl;
-
-    // Main render loop
-    while (!glfwWindowShouldClose(window)) {
-        float currentFrame = glfwGetTime();
-        deltaTime = currentFrame - lastFrame;
-        lastFrame = currentFrame;
-
-        process_input(window);
-
-        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        // Get matrices
-        Matrix4 view = camera.GetViewMatrix();
-        Matrix4 projection = camera.GetProjectionMatrix((float)SCR_WIDTH / (float)SCR_HEIGHT);
-
-        // TODO: Add advanced rendering code here
-
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+    auto end = std::chrono::high_resolution_clock::now();
+    double ms = std::chrono::duration<double, std::milli>(end - start).count();
+
+    std::cout << SCR_WIDTH << "x" << SCR_HEIGHT << ", " << scene.spheres.size()
+              << " spheres + ground plane, up to " << MAX_DEPTH << " reflections" << std::endl;
+    std::cout << "Traced in " << std::fixed << std::setprecision(1) << ms << " ms ("
+              << std::setprecision(2) << SCR_WIDTH * SCR_HEIGHT / ms / 1000.0 << " Mpixels/s)" << std::endl;
+    if (WritePPM("ray_tracing.ppm", pixels, SCR_WIDTH, SCR_HEIGHT)) {
+        std::cout << "Wrote ray_tracing.ppm" << std::endl;
+    } else {
+        std::cerr << "Could not write ray_tracing.ppm" << std::endl;
     }
 
-    glfwTerminate();
-
     std::cout << "\n==========================================" << std::endl;
     std::cout << "  Lesson Complete!" << std::endl;
     std::cout << "==========================================" << std::endl;
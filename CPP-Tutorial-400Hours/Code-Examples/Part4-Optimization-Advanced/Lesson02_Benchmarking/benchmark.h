@@ -14,32 +14,201 @@
 #include <algorithm>
 #include <numeric>
 #include <iomanip>
-#include <map>
 #include <cmath>
+#include <cstdint>
+#include <optional>
+#include <random>
+
+#include "perf_counters.h"
+
+#if defined(_MSC_VER)
+#include <malloc.h>
+#define PERF_NOINLINE __declspec(noinline)
+#define PERF_ALLOCA _alloca
+#else
+#include <alloca.h>
+#define PERF_NOINLINE __attribute__((noinline))
+#define PERF_ALLOCA alloca
+#endif
 
 namespace perf {
 
-// Statistics for benchmark runs
+// Statistics for benchmark runs. Every sample times a batch of calls and
+// is stored as nanoseconds per call, so sub-microsecond functions are not
+// swamped by clock overhead.
 struct BenchmarkStats {
-    double min_ns;
-    double max_ns;
-    double mean_ns;
-    double median_ns;
-    double stddev_ns;
-    size_t iterations;
+    double min_ns = 0.0;
+    double max_ns = 0.0;
+    double mean_ns = 0.0;
+    double median_ns = 0.0;
+    double stddev_ns = 0.0;
+    size_t iterations = 0;        // samples kept after outlier rejection
+    size_t batch_size = 1;        // calls per sample
+    size_t outliers = 0;          // samples rejected by Tukey's fences
+    double confidence = 0.95;
+    double ci_low_ns = 0.0;       // bootstrap confidence interval of the median
+    double ci_high_ns = 0.0;
+    std::vector<double> samples_ns;
+    std::vector<double> run_medians_ns;   // median of each run, in order
+    CounterStats counters;        // per-call hardware counters, if enabled
+
+    // Half-width of the confidence interval relative to the median
+    double relative_error() const {
+        return median_ns > 0.0 ? (ci_high_ns - ci_low_ns) / (2.0 * median_ns) : 0.0;
+    }
 
     void print(const std::string& name) const {
         std::cout << "\nBenchmark: " << name << "\n";
-        std::cout << "  Iterations: " << iterations << "\n";
+        std::cout << "  Samples:    " << iterations << " x " << batch_size << " calls";
+        if (outliers) std::cout << " (" << outliers << " outliers removed)";
+        std::cout << "\n";
         std::cout << "  Min:        " << std::fixed << std::setprecision(2) << min_ns << " ns\n";
         std::cout << "  Max:        " << max_ns << " ns\n";
         std::cout << "  Mean:       " << mean_ns << " ns\n";
         std::cout << "  Median:     " << median_ns << " ns\n";
         std::cout << "  Std Dev:    " << stddev_ns << " ns\n";
+        std::cout << "  " << std::setprecision(0) << confidence * 100 << "% CI:     ["
+                  << std::setprecision(2) << ci_low_ns << ", " << ci_high_ns << "] ns (+/- "
+                  << relative_error() * 100.0 << "%)\n";
+        if (run_medians_ns.size() > 1) {
+            auto [low, high] = std::minmax_element(run_medians_ns.begin(), run_medians_ns.end());
+            std::cout << "  Runs:       " << run_medians_ns.size() << " (medians " << *low
+                      << " .. " << *high << " ns)\n";
+        }
         std::cout << "  Mean (ms):  " << mean_ns / 1e6 << " ms\n";
+        counters.print();
+    }
+};
+
+// Result of comparing two benchmarks on their medians
+struct BenchmarkComparison {
+    double speedup = 1.0;         // baseline median / candidate median
+    double ci_low = 1.0;          // bootstrap confidence interval of the speedup
+    double ci_high = 1.0;
+    double confidence = 0.95;
+    double noise_threshold = 0.02;
+    size_t runs = 1;              // runs per side the interval was resampled from
+    bool significant = false;     // whole interval lies outside the noise band
+
+    void print(const std::string& candidate, const std::string& baseline) const {
+        std::cout << candidate << " vs " << baseline << ": " << std::fixed << std::setprecision(2);
+        if (speedup >= 1.0) {
+            std::cout << speedup << "x faster";
+        } else {
+            std::cout << (1.0 / speedup) << "x slower";
+        }
+        std::cout << "  [" << std::setprecision(3) << ci_low << ", " << ci_high << "] over "
+                  << runs << (runs == 1 ? " run, " : " runs, ")
+                  << (significant ? "significant" : "within noise") << "\n";
     }
 };
 
+namespace detail {
+
+// Linear-interpolated quantile of an ascending range
+inline double quantile(const std::vector<double>& sorted, double q) {
+    if (sorted.empty()) return 0.0;
+    double pos = q * (sorted.size() - 1);
+    size_t lower = static_cast<size_t>(pos);
+    size_t upper = std::min(lower + 1, sorted.size() - 1);
+    return sorted[lower] + (pos - lower) * (sorted[upper] - sorted[lower]);
+}
+
+inline double median_of(std::vector<double>& values) {
+    size_t mid = values.size() / 2;
+    std::nth_element(values.begin(), values.begin() + mid, values.end());
+    double upper = values[mid];
+    if (values.size() % 2 != 0) return upper;
+    double lower = *std::max_element(values.begin(), values.begin() + mid);
+    return (lower + upper) / 2.0;
+}
+
+// Median of a resample drawn with replacement
+inline double resampled_median(const std::vector<double>& samples, std::vector<double>& scratch,
+                               std::mt19937_64& rng) {
+    std::uniform_int_distribution<size_t> pick(0, samples.size() - 1);
+    scratch.resize(samples.size());
+    for (double& value : scratch) {
+        value = samples[pick(rng)];
+    }
+    return median_of(scratch);
+}
+
+constexpr size_t kBootstrapResamples = 2000;
+constexpr uint64_t kBootstrapSeed = 0x5eed5eedULL;   // fixed: reruns print the same interval
+
+// Runs body with the stack pushed down by `bytes`
+template<typename Body>
+PERF_NOINLINE void at_stack_offset(size_t bytes, Body&& body) {
+    volatile char* pad = static_cast<volatile char*>(PERF_ALLOCA(bytes + 1));
+    pad[0] = 0;
+    body();
+}
+
+} // namespace detail
+
+namespace detail {
+
+inline void set_interval(BenchmarkComparison& result, std::vector<double>& ratios) {
+    std::sort(ratios.begin(), ratios.end());
+    double tail = (1.0 - result.confidence) / 2.0;
+    result.ci_low = quantile(ratios, tail);
+    result.ci_high = quantile(ratios, 1.0 - tail);
+    result.significant = result.ci_low > 1.0 + result.noise_threshold ||
+                         result.ci_high < 1.0 / (1.0 + result.noise_threshold);
+}
+
+} // namespace detail
+
+// Bootstraps the ratio of medians. Samples within one run share the
+// machine state of that run (frequency, cache and heap layout, neighbours),
+// so resampling them only measures how steady that run was. The interval
+// is therefore built from run medians: each resample draws whole runs of
+// both sides, and a side measured in a single run contributes its median
+// unchanged. Only when neither side has repeated runs does it fall back to
+// resampling samples.
+//
+// The change is significant only when the whole interval lies outside the
+// noise band [1/(1+t), 1+t]: statistically real but tiny shifts (code
+// alignment, turbo state) are reported as noise.
+inline BenchmarkComparison compare(const BenchmarkStats& baseline, const BenchmarkStats& candidate,
+                                   double confidence = 0.95, double noise_threshold = 0.02) {
+    BenchmarkComparison result;
+    result.confidence = confidence;
+    result.noise_threshold = noise_threshold;
+    if (baseline.samples_ns.empty() || candidate.samples_ns.empty() || candidate.median_ns <= 0.0) {
+        return result;
+    }
+
+    bool by_runs = baseline.run_medians_ns.size() > 1 || candidate.run_medians_ns.size() > 1;
+    const std::vector<double> base_single{baseline.median_ns};
+    const std::vector<double> cand_single{candidate.median_ns};
+    const std::vector<double>& base_values =
+        !by_runs ? baseline.samples_ns
+                 : baseline.run_medians_ns.empty() ? base_single : baseline.run_medians_ns;
+    const std::vector<double>& cand_values =
+        !by_runs ? candidate.samples_ns
+                 : candidate.run_medians_ns.empty() ? cand_single : candidate.run_medians_ns;
+    result.runs = by_runs ? std::min(base_values.size(), cand_values.size()) : 1;
+
+    std::vector<double> scratch(base_values);
+    double base_median = detail::median_of(scratch);
+    scratch = cand_values;
+    double cand_median = detail::median_of(scratch);
+    result.speedup = cand_median > 0.0 ? base_median / cand_median : 1.0;
+
+    std::mt19937_64 rng(detail::kBootstrapSeed);
+    std::vector<double> ratios;
+    ratios.reserve(detail::kBootstrapResamples);
+    for (size_t i = 0; i < detail::kBootstrapResamples; ++i) {
+        double base = detail::resampled_median(base_values, scratch, rng);
+        double cand = detail::resampled_median(cand_values, scratch, rng);
+        if (cand > 0.0) ratios.push_back(base / cand);
+    }
+    detail::set_interval(result, ratios);
+    return result;
+}
+
 // High-resolution timer
 class Timer {
 private:
@@ -75,20 +244,43 @@ public:
     double elapsed_s() const { return elapsed_ns() / 1000000000.0; }
 };
 
-// Benchmark runner
+// Benchmark runner. `iterations` is the number of samples; each sample
+// runs a batch of calls sized so it lasts at least min_sample_time. The
+// samples are split into consecutive runs (5 by default) whose medians
+// show how far the result moves between runs; compare() resamples those.
 class Benchmark {
 private:
     std::string name_;
     size_t iterations_;
     size_t warmup_iterations_;
+    std::chrono::nanoseconds min_sample_time_;
+    size_t batch_size_;            // 0 = calibrate automatically
+    size_t runs_;
+    bool reject_outliers_;
+    double confidence_;
+    bool counters_;
     std::vector<double> results_ns_;
 
+    static constexpr size_t kMaxBatch = size_t(1) << 30;
+
 public:
     Benchmark(const std::string& name, size_t iterations = 100, size_t warmup = 10)
-        : name_(name), iterations_(iterations), warmup_iterations_(warmup) {
+        : name_(name), iterations_(iterations), warmup_iterations_(warmup),
+          min_sample_time_(std::chrono::milliseconds(1)), batch_size_(0), runs_(5),
+          reject_outliers_(true), confidence_(0.95), counters_(false) {
         results_ns_.reserve(iterations);
     }
 
+    Benchmark& set_min_sample_time(std::chrono::nanoseconds t) { min_sample_time_ = t; return *this; }
+    Benchmark& set_batch_size(size_t calls) { batch_size_ = calls; return *this; }
+    Benchmark& set_runs(size_t runs) { runs_ = std::max<size_t>(1, runs); return *this; }
+    Benchmark& set_outlier_rejection(bool enabled) { reject_outliers_ = enabled; return *this; }
+    Benchmark& set_confidence(double level) { confidence_ = level; return *this; }
+
+    // Collect hardware counters (see perf_counters.h) around every sample;
+    // reported per call, or as unavailable where the kernel refuses
+    Benchmark& set_counters(bool enabled) { counters_ = enabled; return *this; }
+
     template<typename Func>
     BenchmarkStats run(Func&& func) {
         results_ns_.clear();
@@ -98,17 +290,31 @@ public:
             func();
         }
 
+        const size_t batch = batch_size_ ? batch_size_ : calibrate(func);
+        std::optional<PerfCounters> counters;
+        open_counters(counters);
+
         // Actual benchmark runs
-        for (size_t i = 0; i < iterations_; ++i) {
+        sample_runs([&]() {
+            if (counters) counters->start();
             Timer timer;
-            func();
+            for (size_t b = 0; b < batch; ++b) {
+                func();
+            }
             timer.stop();
-            results_ns_.push_back(timer.elapsed_ns());
-        }
+            if (counters) counters->stop();
+            results_ns_.push_back(timer.elapsed_ns() / batch);
+        });
 
-        return calculate_stats();
+        BenchmarkStats stats = calculate_stats(batch);
+        if (counters) stats.counters = counters->result(iterations_ * batch);
+        return stats;
     }
 
+    // Setup and teardown run outside the timed region, so calls cannot be
+    // batched under one timer. Each call is timed on its own with the clock
+    // overhead subtracted, and calls are accumulated into a sample until it
+    // reaches min_sample_time (or ten times that in wall time).
     template<typename Func, typename Setup, typename Teardown>
     BenchmarkStats run_with_setup(Func&& func, Setup&& setup, Teardown&& teardown) {
         results_ns_.clear();
@@ -120,77 +326,314 @@ public:
             teardown();
         }
 
+        const double overhead = timer_overhead_ns();
+        const double target = static_cast<double>(min_sample_time_.count());
+        size_t total_calls = 0;
+        std::optional<PerfCounters> counters;
+        open_counters(counters);
+
         // Benchmark
-        for (size_t i = 0; i < iterations_; ++i) {
-            setup();
+        sample_runs([&]() {
+            Timer wall;
+            double timed = 0.0;
+            size_t calls = 0;
+            do {
+                setup();
+
+                if (counters) counters->start();
+                Timer timer;
+                func();
+                timer.stop();
+                if (counters) counters->stop();
+
+                teardown();
+                timed += std::max(0.0, timer.elapsed_ns() - overhead);
+                ++calls;
+            } while (batch_size_ ? calls < batch_size_
+                                 : timed < target && wall.elapsed_ns() < 10.0 * target);
+
+            results_ns_.push_back(timed / calls);
+            total_calls += calls;
+        });
+
+        BenchmarkStats stats = calculate_stats(iterations_ ? total_calls / iterations_ : 1);
+        if (counters) stats.counters = counters->result(total_calls);
+        return stats;
+    }
 
+    // Median cost of one start/stop pair of Timer
+    static double timer_overhead_ns() {
+        std::vector<double> deltas(1001);
+        for (double& d : deltas) {
             Timer timer;
-            func();
             timer.stop();
+            d = timer.elapsed_ns();
+        }
+        return detail::median_of(deltas);
+    }
 
-            teardown();
-            results_ns_.push_back(timer.elapsed_ns());
+private:
+    // Takes iterations_ samples in runs_ consecutive runs. Each run starts
+    // at a different stack depth, spread over a page: where the stack sits
+    // relative to heap data changes with ASLR on every launch and can move
+    // a result by 10-15% (4K aliasing), so the runs of one process show the
+    // layout noise a rerun of the program would.
+    template<typename Sample>
+    void sample_runs(Sample&& sample) {
+        const size_t runs = std::max<size_t>(1, std::min(runs_, iterations_));
+        for (size_t r = 0; r < runs; ++r) {
+            size_t first = r * iterations_ / runs;
+            size_t last = (r + 1) * iterations_ / runs;
+            detail::at_stack_offset((r * 4096 / runs) & ~size_t(63), [&]() {
+                for (size_t i = first; i < last; ++i) {
+                    sample();
+                }
+            });
         }
+    }
 
-        return calculate_stats();
+    // Counters for one run, with the cost of reading them around an empty
+    // timed region measured so it can be subtracted per sample
+    void open_counters(std::optional<PerfCounters>& counters) const {
+        if (counters_) {
+            counters.emplace();
+            counters->calibrate_overhead([] {
+                Timer timer;
+                timer.stop();
+            });
+        }
     }
 
-private:
-    BenchmarkStats calculate_stats() {
-        if (results_ns_.empty()) {
-            return {0, 0, 0, 0, 0, 0};
+    // Grows the batch tenfold until a run is long enough to extrapolate
+    // from, then scales it to reach min_sample_time with 10% headroom
+    template<typename Func>
+    size_t calibrate(Func& func) const {
+        const double target = static_cast<double>(min_sample_time_.count());
+        size_t batch = 1;
+
+        for (;;) {
+            Timer timer;
+            for (size_t b = 0; b < batch; ++b) {
+                func();
+            }
+            timer.stop();
+            double elapsed = timer.elapsed_ns();
+
+            if (elapsed >= target || batch >= kMaxBatch) {
+                return batch;
+            }
+            if (elapsed < target / 10.0) {
+                batch = std::min(kMaxBatch, batch * 10);
+                continue;
+            }
+            double scaled = std::ceil(batch * target * 1.1 / elapsed);
+            return std::min(kMaxBatch, static_cast<size_t>(scaled));
         }
+    }
 
+    BenchmarkStats calculate_stats(size_t batch) {
         BenchmarkStats stats;
-        stats.iterations = results_ns_.size();
+        stats.batch_size = batch;
+        stats.confidence = confidence_;
+        if (results_ns_.empty()) {
+            return stats;
+        }
+
+        // Run medians come from the raw samples in time order, before
+        // outlier rejection; the median already ignores a few stragglers
+        const size_t runs = std::min(runs_, results_ns_.size());
+        for (size_t r = 0; r < runs; ++r) {
+            std::vector<double> run(results_ns_.begin() + r * results_ns_.size() / runs,
+                                    results_ns_.begin() + (r + 1) * results_ns_.size() / runs);
+            stats.run_medians_ns.push_back(detail::median_of(run));
+        }
+
+        std::vector<double> sorted = results_ns_;
+        std::sort(sorted.begin(), sorted.end());
+
+        // Tukey's fences: drop samples beyond 1.5 IQR outside the quartiles
+        // (preemption, page faults, frequency changes)
+        if (reject_outliers_ && sorted.size() >= 4) {
+            double q1 = detail::quantile(sorted, 0.25);
+            double q3 = detail::quantile(sorted, 0.75);
+            double fence = 1.5 * (q3 - q1);
+            auto first = std::lower_bound(sorted.begin(), sorted.end(), q1 - fence);
+            auto last = std::upper_bound(sorted.begin(), sorted.end(), q3 + fence);
+            stats.outliers = sorted.size() - static_cast<size_t>(last - first);
+            sorted = std::vector<double>(first, last);
+        }
+
+        stats.iterations = sorted.size();
 
         // Min and Max
-        stats.min_ns = *std::min_element(results_ns_.begin(), results_ns_.end());
-        stats.max_ns = *std::max_element(results_ns_.begin(), results_ns_.end());
+        stats.min_ns = sorted.front();
+        stats.max_ns = sorted.back();
 
         // Mean
-        double sum = std::accumulate(results_ns_.begin(), results_ns_.end(), 0.0);
-        stats.mean_ns = sum / results_ns_.size();
+        double sum = std::accumulate(sorted.begin(), sorted.end(), 0.0);
+        stats.mean_ns = sum / sorted.size();
 
         // Median
-        std::vector<double> sorted = results_ns_;
-        std::sort(sorted.begin(), sorted.end());
-        size_t mid = sorted.size() / 2;
-        if (sorted.size() % 2 == 0) {
-            stats.median_ns = (sorted[mid - 1] + sorted[mid]) / 2.0;
-        } else {
-            stats.median_ns = sorted[mid];
-        }
+        stats.median_ns = detail::quantile(sorted, 0.5);
 
-        // Standard Deviation
+        // Standard Deviation (sample)
         double variance = 0.0;
-        for (double val : results_ns_) {
+        for (double val : sorted) {
             double diff = val - stats.mean_ns;
             variance += diff * diff;
         }
-        variance /= results_ns_.size();
+        variance /= sorted.size() > 1 ? sorted.size() - 1 : 1;
         stats.stddev_ns = std::sqrt(variance);
 
+        // Bootstrap percentile interval of the median
+        std::mt19937_64 rng(detail::kBootstrapSeed);
+        std::vector<double> scratch;
+        std::vector<double> medians(detail::kBootstrapResamples);
+        for (double& m : medians) {
+            m = detail::resampled_median(sorted, scratch, rng);
+        }
+        std::sort(medians.begin(), medians.end());
+        double tail = (1.0 - confidence_) / 2.0;
+        stats.ci_low_ns = detail::quantile(medians, tail);
+        stats.ci_high_ns = detail::quantile(medians, 1.0 - tail);
+
+        stats.samples_ns = std::move(sorted);
         return stats;
     }
 };
 
-// Benchmark suite for comparing multiple functions
+namespace detail {
+
+// Out of line so that timing the same callable on both sides runs the very
+// same machine code. Inlined at two call sites, identical loops can land on
+// different alignments and differ by tens of percent.
+template<typename Func>
+PERF_NOINLINE double time_batch(Func& func, size_t batch) {
+    Timer timer;
+    for (size_t b = 0; b < batch; ++b) {
+        func();
+    }
+    timer.stop();
+    return timer.elapsed_ns() / batch;
+}
+
+} // namespace detail
+
+// Times baseline and candidate in alternating samples, flipping which goes
+// first every pair, and bootstraps the median of the per-round ratios of
+// medians. A slow spell on the machine hits both sides of a pair alike
+// instead of landing on whichever benchmark happened to run during it, so
+// this is the test for small differences. Comparing a function with itself
+// should give an interval that straddles 1.0.
+template<typename Baseline, typename Candidate>
+BenchmarkComparison compare_interleaved(Baseline&& baseline, Candidate&& candidate,
+                                        size_t rounds = 10, size_t samples = 10,
+                                        double confidence = 0.95, double noise_threshold = 0.02) {
+    BenchmarkComparison result;
+    result.confidence = confidence;
+    result.noise_threshold = noise_threshold;
+    if (rounds == 0 || samples == 0) return result;
+
+    // One short run each to warm up and calibrate the batch sizes
+    const size_t base_batch = Benchmark("baseline", 1, 10).set_runs(1).run(baseline).batch_size;
+    const size_t cand_batch = Benchmark("candidate", 1, 10).set_runs(1).run(candidate).batch_size;
+
+    std::vector<double> ratios_by_round;
+    std::vector<double> base(samples);
+    std::vector<double> cand(samples);
+    for (size_t r = 0; r < rounds; ++r) {
+        for (size_t i = 0; i < samples; ++i) {
+            if ((r + i) % 2 == 0) {
+                base[i] = detail::time_batch(baseline, base_batch);
+                cand[i] = detail::time_batch(candidate, cand_batch);
+            } else {
+                cand[i] = detail::time_batch(candidate, cand_batch);
+                base[i] = detail::time_batch(baseline, base_batch);
+            }
+        }
+        double cand_median = detail::median_of(cand);
+        if (cand_median > 0.0) ratios_by_round.push_back(detail::median_of(base) / cand_median);
+    }
+    if (ratios_by_round.empty()) return result;
+
+    result.runs = ratios_by_round.size();
+    std::vector<double> scratch(ratios_by_round);
+    result.speedup = detail::median_of(scratch);
+
+    std::mt19937_64 rng(detail::kBootstrapSeed);
+    std::vector<double> ratios(detail::kBootstrapResamples);
+    for (double& ratio : ratios) {
+        ratio = detail::resampled_median(ratios_by_round, scratch, rng);
+    }
+    detail::set_interval(result, ratios);
+    return result;
+}
+
+// Benchmark suite for comparing multiple functions. Results keep the order
+// in which they were added; the baseline is the first one unless chosen
+// explicitly with set_baseline().
 class BenchmarkSuite {
+public:
+    using Result = std::pair<std::string, BenchmarkStats>;
+
 private:
     std::string suite_name_;
-    std::map<std::string, BenchmarkStats> results_;
+    std::vector<Result> results_;
+    std::string baseline_;
     size_t iterations_;
     size_t warmup_;
+    bool counters_;
 
 public:
     BenchmarkSuite(const std::string& name, size_t iterations = 100, size_t warmup = 10)
-        : suite_name_(name), iterations_(iterations), warmup_(warmup) {}
+        : suite_name_(name), iterations_(iterations), warmup_(warmup), counters_(false) {}
+
+    // Hardware counters for every benchmark added after this call
+    void set_counters(bool enabled) {
+        counters_ = enabled;
+    }
 
     template<typename Func>
     void add(const std::string& name, Func&& func) {
         Benchmark bench(name, iterations_, warmup_);
-        results_[name] = bench.run(std::forward<Func>(func));
+        bench.set_counters(counters_);
+        add_result(name, bench.run(std::forward<Func>(func)));
+    }
+
+    // Records stats measured elsewhere (e.g. run_with_setup); replaces an
+    // existing result with the same name
+    void add_result(const std::string& name, BenchmarkStats stats) {
+        for (Result& result : results_) {
+            if (result.first == name) {
+                result.second = std::move(stats);
+                return;
+            }
+        }
+        results_.emplace_back(name, std::move(stats));
+    }
+
+    // Reference implementation the others are compared against
+    void set_baseline(const std::string& name) {
+        baseline_ = name;
+    }
+
+    const std::string& name() const { return suite_name_; }
+    const std::vector<Result>& results() const { return results_; }
+
+    const BenchmarkStats* find(const std::string& name) const {
+        for (const Result& result : results_) {
+            if (result.first == name) return &result.second;
+        }
+        return nullptr;
+    }
+
+    // Explicit baseline if it was measured, otherwise the first result
+    const Result* baseline() const {
+        if (results_.empty()) return nullptr;
+        for (const Result& result : results_) {
+            if (result.first == baseline_) return &result;
+        }
+        return &results_.front();
     }
 
     void print_results() const {
@@ -214,31 +657,39 @@ private:
     void print_comparison() const {
         std::cout << "\n--- Performance Comparison ---\n";
 
-        double baseline_mean = results_.begin()->second.mean_ns;
-        std::string baseline_name = results_.begin()->first;
+        const Result& reference = *baseline();
+        const BenchmarkStats& baseline_stats = reference.second;
+        const std::string& baseline_name = reference.first;
 
-        std::cout << "Baseline: " << baseline_name << "\n\n";
+        std::cout << "Baseline: " << baseline_name << " (medians, "
+                  << std::setprecision(0) << baseline_stats.confidence * 100 << "% bootstrap CI)\n\n";
 
         for (const auto& [name, stats] : results_) {
             if (name == baseline_name) continue;
-
-            double speedup = baseline_mean / stats.mean_ns;
-            std::cout << name << " vs " << baseline_name << ": ";
-
-            if (speedup > 1.0) {
-                std::cout << std::fixed << std::setprecision(2)
-                         << speedup << "x faster\n";
-            } else {
-                std::cout << std::fixed << std::setprecision(2)
-                         << (1.0 / speedup) << "x slower\n";
-            }
+            compare(baseline_stats, stats, baseline_stats.confidence).print(name, baseline_name);
         }
     }
 };
 
-// Prevent compiler optimizations from eliminating code
+// Prevent compiler optimizations from eliminating code. A mutable lvalue
+// is also treated as modified, so a loop-invariant input cannot be hoisted
+// out of a batched benchmark loop.
+template<typename T>
+inline void do_not_optimize(T& value) {
+#if defined(__clang__)
+    asm volatile("" : "+r,m"(value) : : "memory");
+#elif defined(__GNUC__)
+    // GCC rejects "+r,m" for some operands ("impossible constraint")
+    asm volatile("" : "+m,r"(value) : : "memory");
+#elif defined(_MSC_VER)
+    // For MSVC, use a volatile read
+    static volatile T sink;
+    sink = value;
+#endif
+}
+
 template<typename T>
-inline void do_not_optimize(T&& value) {
+inline void do_not_optimize(const T& value) {
 #if defined(__clang__)
     asm volatile("" : : "r,m"(value) : "memory");
 #elif defined(__GNUC__)
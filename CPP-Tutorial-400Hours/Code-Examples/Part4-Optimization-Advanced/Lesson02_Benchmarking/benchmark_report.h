@@ -0,0 +1,923 @@
+/*
+ * Benchmark Reporting and Regression Baselines
+ * JSON/CSV export of BenchmarkSuite results with the machine they ran on,
+ * saved baselines, and a command-line session that exits non-zero when a
+ * benchmark regresses so lessons can run as a nightly perf check.
+ */
+
+#ifndef BENCHMARK_REPORT_H
+#define BENCHMARK_REPORT_H
+
+#include "benchmark.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+#if !defined(_WIN32)
+#include <sys/utsname.h>
+#endif
+
+namespace perf {
+
+// ========== Minimal JSON ==========
+// Just enough JSON to write result files and read them back as baselines
+namespace json {
+
+struct Value {
+    enum class Type { Null, Bool, Number, String, Array, Object };
+
+    Type type = Type::Null;
+    bool boolean = false;
+    double number = 0.0;
+    std::string string;
+    std::vector<Value> array;
+    std::vector<std::pair<std::string, Value>> object;
+
+    const Value* find(const std::string& key) const {
+        for (const auto& member : object) {
+            if (member.first == key) return &member.second;
+        }
+        return nullptr;
+    }
+
+    double number_or(const std::string& key, double fallback) const {
+        const Value* v = find(key);
+        return v && v->type == Type::Number ? v->number : fallback;
+    }
+
+    std::string string_or(const std::string& key, const std::string& fallback) const {
+        const Value* v = find(key);
+        return v && v->type == Type::String ? v->string : fallback;
+    }
+};
+
+inline std::string escape(const std::string& text) {
+    std::string out;
+    out.reserve(text.size() + 2);
+    for (char c : text) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char buf[8];
+                    std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    out += buf;
+                } else {
+                    out += c;
+                }
+        }
+    }
+    return out;
+}
+
+inline std::string quote(const std::string& text) {
+    return "\"" + escape(text) + "\"";
+}
+
+inline std::string number(double value) {
+    if (!std::isfinite(value)) return "null";
+    std::ostringstream out;
+    out << std::setprecision(10) << value;
+    return out.str();
+}
+
+class Parser {
+public:
+    explicit Parser(const std::string& text) : text_(text), pos_(0) {}
+
+    Value parse() {
+        Value value = parse_value();
+        skip_whitespace();
+        if (pos_ != text_.size()) fail("trailing characters");
+        return value;
+    }
+
+private:
+    const std::string& text_;
+    size_t pos_;
+
+    [[noreturn]] void fail(const std::string& what) const {
+        throw std::runtime_error("JSON parse error at offset " + std::to_string(pos_) + ": " + what);
+    }
+
+    void skip_whitespace() {
+        while (pos_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[pos_]))) {
+            ++pos_;
+        }
+    }
+
+    bool consume(char c) {
+        skip_whitespace();
+        if (pos_ < text_.size() && text_[pos_] == c) {
+            ++pos_;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(char c) {
+        if (!consume(c)) fail(std::string("expected '") + c + "'");
+    }
+
+    bool consume_word(const char* word) {
+        size_t len = std::char_traits<char>::length(word);
+        if (text_.compare(pos_, len, word) == 0) {
+            pos_ += len;
+            return true;
+        }
+        return false;
+    }
+
+    Value parse_value() {
+        skip_whitespace();
+        if (pos_ >= text_.size()) fail("unexpected end of input");
+
+        Value value;
+        char c = text_[pos_];
+        if (c == '{') {
+            value.type = Value::Type::Object;
+            ++pos_;
+            if (consume('}')) return value;
+            do {
+                skip_whitespace();
+                std::string key = parse_string();
+                expect(':');
+                value.object.emplace_back(std::move(key), parse_value());
+            } while (consume(','));
+            expect('}');
+        } else if (c == '[') {
+            value.type = Value::Type::Array;
+            ++pos_;
+            if (consume(']')) return value;
+            do {
+                value.array.push_back(parse_value());
+            } while (consume(','));
+            expect(']');
+        } else if (c == '"') {
+            value.type = Value::Type::String;
+            value.string = parse_string();
+        } else if (consume_word("true")) {
+            value.type = Value::Type::Bool;
+            value.boolean = true;
+        } else if (consume_word("false")) {
+            value.type = Value::Type::Bool;
+        } else if (consume_word("null")) {
+            value.type = Value::Type::Null;
+        } else {
+            value.type = Value::Type::Number;
+            const char* begin = text_.c_str() + pos_;
+            char* end = nullptr;
+            value.number = std::strtod(begin, &end);
+            if (end == begin) fail("unexpected character");
+            pos_ += static_cast<size_t>(end - begin);
+        }
+        return value;
+    }
+
+    std::string parse_string() {
+        if (pos_ >= text_.size() || text_[pos_] != '"') fail("expected string");
+        ++pos_;
+
+        std::string out;
+        while (pos_ < text_.size() && text_[pos_] != '"') {
+            char c = text_[pos_++];
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (pos_ >= text_.size()) break;
+            char e = text_[pos_++];
+            switch (e) {
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'u': {
+                    // Only the control characters escape() emits are expected
+                    if (pos_ + 4 > text_.size()) fail("bad \\u escape");
+                    unsigned code = static_cast<unsigned>(std::stoul(text_.substr(pos_, 4), nullptr, 16));
+                    out += code < 0x80 ? static_cast<char>(code) : '?';
+                    pos_ += 4;
+                    break;
+                }
+                default: out += e; break;
+            }
+        }
+        if (pos_ >= text_.size()) fail("unterminated string");
+        ++pos_;
+        return out;
+    }
+};
+
+inline Value parse(const std::string& text) {
+    return Parser(text).parse();
+}
+
+} // namespace json
+
+// ========== Environment Capture ==========
+
+// What the numbers were measured on; stored with every result file so a
+// baseline from a different machine or build is easy to spot
+struct Environment {
+    std::string cpu_model = "unknown";
+    unsigned logical_cpus = 0;
+    std::string governor = "unavailable";
+    std::string os = "unknown";
+    std::string compiler = "unknown";
+    std::string build_type = "unknown";
+    std::string build_flags = "unknown";
+    std::string timestamp;
+
+    void print() const {
+        std::cout << "Environment:\n";
+        std::cout << "  CPU:        " << cpu_model << " (" << logical_cpus << " logical)\n";
+        std::cout << "  Governor:   " << governor << "\n";
+        std::cout << "  OS:         " << os << "\n";
+        std::cout << "  Compiler:   " << compiler << "\n";
+        std::cout << "  Build:      " << build_type << " [" << build_flags << "]\n";
+        std::cout << "  Timestamp:  " << timestamp << "\n";
+    }
+
+    // Fields that make timings incomparable when they differ
+    std::vector<std::string> differences(const Environment& other) const {
+        std::vector<std::string> diffs;
+        if (cpu_model != other.cpu_model) diffs.push_back("CPU: " + other.cpu_model + " -> " + cpu_model);
+        if (governor != other.governor) diffs.push_back("governor: " + other.governor + " -> " + governor);
+        if (compiler != other.compiler) diffs.push_back("compiler: " + other.compiler + " -> " + compiler);
+        if (build_flags != other.build_flags) diffs.push_back("flags: " + other.build_flags + " -> " + build_flags);
+        return diffs;
+    }
+};
+
+namespace detail {
+
+inline std::string trim(const std::string& text) {
+    size_t begin = text.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos) return "";
+    size_t end = text.find_last_not_of(" \t\r\n");
+    return text.substr(begin, end - begin + 1);
+}
+
+inline std::string read_first_line(const char* path) {
+    std::ifstream in(path);
+    std::string line;
+    if (in && std::getline(in, line)) return trim(line);
+    return "";
+}
+
+inline std::string cpu_brand_string() {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+    unsigned regs[12] = {};
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0x80000000);
+    if (static_cast<unsigned>(info[0]) < 0x80000004) return "";
+    for (int leaf = 0; leaf < 3; ++leaf) {
+        __cpuid(info, 0x80000002 + leaf);
+        for (int r = 0; r < 4; ++r) regs[leaf * 4 + r] = static_cast<unsigned>(info[r]);
+    }
+#else
+    if (__get_cpuid_max(0x80000000, nullptr) < 0x80000004) return "";
+    for (unsigned leaf = 0; leaf < 3; ++leaf) {
+        __get_cpuid(0x80000002 + leaf, &regs[leaf * 4], &regs[leaf * 4 + 1],
+                    &regs[leaf * 4 + 2], &regs[leaf * 4 + 3]);
+    }
+#endif
+    char brand[49] = {};
+    std::memcpy(brand, regs, 48);
+    return trim(brand);
+#else
+    // Non-x86: fall back to what the kernel reports
+    std::ifstream in("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.rfind("model name", 0) == 0 || line.rfind("Hardware", 0) == 0) {
+            size_t colon = line.find(':');
+            if (colon != std::string::npos) return trim(line.substr(colon + 1));
+        }
+    }
+    return "";
+#endif
+}
+
+} // namespace detail
+
+inline Environment capture_environment() {
+    Environment env;
+
+    std::string brand = detail::cpu_brand_string();
+    if (!brand.empty()) env.cpu_model = brand;
+    env.logical_cpus = std::thread::hardware_concurrency();
+
+#if defined(__linux__)
+    std::string governor =
+        detail::read_first_line("/sys/devices/system/cpu/cpu0/cpufreq/scaling_governor");
+    if (!governor.empty()) env.governor = governor;
+#endif
+
+#if defined(_WIN32)
+    env.os = "Windows";
+#else
+    utsname name;
+    if (uname(&name) == 0) {
+        env.os = std::string(name.sysname) + " " + name.release + " " + name.machine;
+    }
+#endif
+
+#if defined(__clang__)
+    env.compiler = "Clang " __clang_version__;
+#elif defined(__GNUC__)
+    env.compiler = "GCC " __VERSION__;
+#elif defined(_MSC_VER)
+    env.compiler = "MSVC " + std::to_string(_MSC_FULL_VER);
+#endif
+
+    // The build system passes these in; see CMakeLists.txt
+#if defined(PERF_BUILD_TYPE)
+    env.build_type = PERF_BUILD_TYPE;
+#endif
+#if defined(PERF_BUILD_FLAGS)
+    env.build_flags = detail::trim(PERF_BUILD_FLAGS);
+#endif
+
+    std::time_t now = std::time(nullptr);
+    char stamp[32];
+    std::strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+    env.timestamp = stamp;
+
+    return env;
+}
+
+// ========== Result Files ==========
+
+struct RecordedResult {
+    std::string suite;
+    std::string name;
+    BenchmarkStats stats;
+    bool is_baseline = false;       // the suite's reference implementation
+    double speedup = 1.0;           // vs the suite's reference, by median
+    std::vector<double> launch_medians_ns;  // one per program launch; stats are the first's
+
+    std::string key() const { return suite + "/" + name; }
+};
+
+inline std::vector<RecordedResult> collect_results(const BenchmarkSuite& suite) {
+    std::vector<RecordedResult> out;
+    const BenchmarkSuite::Result* reference = suite.baseline();
+    for (const auto& [name, stats] : suite.results()) {
+        RecordedResult r;
+        r.suite = suite.name();
+        r.name = name;
+        r.stats = stats;
+        r.is_baseline = reference && reference->first == name;
+        r.launch_medians_ns.push_back(stats.median_ns);
+        if (reference && stats.median_ns > 0.0) {
+            r.speedup = reference->second.median_ns / stats.median_ns;
+        }
+        out.push_back(std::move(r));
+    }
+    return out;
+}
+
+inline void write_json(std::ostream& out, const Environment& env,
+                       const std::vector<RecordedResult>& results) {
+    using json::number;
+    using json::quote;
+
+    out << "{\n  \"environment\": {\n"
+        << "    \"cpu_model\": " << quote(env.cpu_model) << ",\n"
+        << "    \"logical_cpus\": " << env.logical_cpus << ",\n"
+        << "    \"governor\": " << quote(env.governor) << ",\n"
+        << "    \"os\": " << quote(env.os) << ",\n"
+        << "    \"compiler\": " << quote(env.compiler) << ",\n"
+        << "    \"build_type\": " << quote(env.build_type) << ",\n"
+        << "    \"build_flags\": " << quote(env.build_flags) << ",\n"
+        << "    \"timestamp\": " << quote(env.timestamp) << "\n  },\n"
+        << "  \"benchmarks\": [";
+
+    for (size_t i = 0; i < results.size(); ++i) {
+        const RecordedResult& r = results[i];
+        const BenchmarkStats& s = r.stats;
+        out << (i ? ",\n" : "\n")
+            << "    {\"suite\": " << quote(r.suite) << ", \"name\": " << quote(r.name)
+            << ", \"baseline\": " << (r.is_baseline ? "true" : "false")
+            << ", \"speedup\": " << number(r.speedup) << ",\n"
+            << "     \"median_ns\": " << number(s.median_ns)
+            << ", \"mean_ns\": " << number(s.mean_ns)
+            << ", \"min_ns\": " << number(s.min_ns)
+            << ", \"max_ns\": " << number(s.max_ns)
+            << ", \"stddev_ns\": " << number(s.stddev_ns) << ",\n"
+            << "     \"ci_low_ns\": " << number(s.ci_low_ns)
+            << ", \"ci_high_ns\": " << number(s.ci_high_ns)
+            << ", \"confidence\": " << number(s.confidence)
+            << ", \"samples\": " << s.iterations
+            << ", \"batch_size\": " << s.batch_size
+            << ", \"outliers\": " << s.outliers << ",\n";
+        if (s.counters.any()) {
+            out << "     \"counters\": {";
+            bool first = true;
+            for (size_t e = 0; e < kPerfEventCount; ++e) {
+                PerfEvent event = static_cast<PerfEvent>(e);
+                if (!s.counters.has(event)) continue;
+                out << (first ? "" : ", ") << quote(perf_event_name(event)) << ": "
+                    << number(s.counters.get(event));
+                first = false;
+            }
+            out << "},\n";
+        }
+        out << "     \"launch_medians_ns\": [";
+        for (size_t k = 0; k < r.launch_medians_ns.size(); ++k) {
+            out << (k ? ", " : "") << number(r.launch_medians_ns[k]);
+        }
+        out << "],\n     \"run_medians_ns\": [";
+        for (size_t k = 0; k < s.run_medians_ns.size(); ++k) {
+            out << (k ? ", " : "") << number(s.run_medians_ns[k]);
+        }
+        out << "],\n     \"samples_ns\": [";
+        for (size_t k = 0; k < s.samples_ns.size(); ++k) {
+            out << (k ? ", " : "") << number(s.samples_ns[k]);
+        }
+        out << "]}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+inline std::string csv_field(const std::string& text) {
+    if (text.find_first_of(",\"\n") == std::string::npos) return text;
+    std::string out = "\"";
+    for (char c : text) {
+        if (c == '"') out += '"';
+        out += c;
+    }
+    return out + "\"";
+}
+
+inline void write_csv(std::ostream& out, const std::vector<RecordedResult>& results) {
+    out << "suite,name,baseline,speedup,median_ns,mean_ns,min_ns,max_ns,stddev_ns,"
+           "ci_low_ns,ci_high_ns,samples,batch_size,outliers,runs,launches";
+    for (size_t e = 0; e < kPerfEventCount; ++e) {
+        out << ',' << perf_event_name(static_cast<PerfEvent>(e));
+    }
+    out << ",ipc\n";
+    for (const RecordedResult& r : results) {
+        const BenchmarkStats& s = r.stats;
+        out << csv_field(r.suite) << ',' << csv_field(r.name) << ','
+            << (r.is_baseline ? 1 : 0) << ',' << json::number(r.speedup) << ','
+            << json::number(s.median_ns) << ',' << json::number(s.mean_ns) << ','
+            << json::number(s.min_ns) << ',' << json::number(s.max_ns) << ','
+            << json::number(s.stddev_ns) << ',' << json::number(s.ci_low_ns) << ','
+            << json::number(s.ci_high_ns) << ',' << s.iterations << ','
+            << s.batch_size << ',' << s.outliers << ',' << s.run_medians_ns.size() << ','
+            << r.launch_medians_ns.size();
+        // Unavailable counters stay empty rather than reading as zero
+        for (size_t e = 0; e < kPerfEventCount; ++e) {
+            PerfEvent event = static_cast<PerfEvent>(e);
+            out << ',';
+            if (s.counters.has(event)) out << json::number(s.counters.get(event));
+        }
+        out << ',';
+        if (s.counters.ipc() > 0.0) out << json::number(s.counters.ipc());
+        out << '\n';
+    }
+}
+
+// A result file read back for comparison
+struct BaselineFile {
+    Environment environment;
+    std::vector<RecordedResult> results;
+
+    const RecordedResult* find(const std::string& key) const {
+        for (const RecordedResult& r : results) {
+            if (r.key() == key) return &r;
+        }
+        return nullptr;
+    }
+};
+
+// Throws std::runtime_error if the file is missing or malformed
+inline BaselineFile load_baseline(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) throw std::runtime_error("cannot open baseline file " + path);
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    json::Value root = json::parse(buffer.str());
+
+    BaselineFile file;
+    if (const json::Value* env = root.find("environment")) {
+        file.environment.cpu_model = env->string_or("cpu_model", "unknown");
+        file.environment.logical_cpus = static_cast<unsigned>(env->number_or("logical_cpus", 0));
+        file.environment.governor = env->string_or("governor", "unavailable");
+        file.environment.os = env->string_or("os", "unknown");
+        file.environment.compiler = env->string_or("compiler", "unknown");
+        file.environment.build_type = env->string_or("build_type", "unknown");
+        file.environment.build_flags = env->string_or("build_flags", "unknown");
+        file.environment.timestamp = env->string_or("timestamp", "");
+    }
+
+    const json::Value* benchmarks = root.find("benchmarks");
+    if (!benchmarks || benchmarks->type != json::Value::Type::Array) {
+        throw std::runtime_error(path + ": no \"benchmarks\" array");
+    }
+
+    for (const json::Value& b : benchmarks->array) {
+        RecordedResult r;
+        r.suite = b.string_or("suite", "");
+        r.name = b.string_or("name", "");
+        const json::Value* is_base = b.find("baseline");
+        r.is_baseline = is_base && is_base->boolean;
+        r.speedup = b.number_or("speedup", 1.0);
+
+        BenchmarkStats& s = r.stats;
+        s.median_ns = b.number_or("median_ns", 0.0);
+        s.mean_ns = b.number_or("mean_ns", 0.0);
+        s.min_ns = b.number_or("min_ns", 0.0);
+        s.max_ns = b.number_or("max_ns", 0.0);
+        s.stddev_ns = b.number_or("stddev_ns", 0.0);
+        s.ci_low_ns = b.number_or("ci_low_ns", 0.0);
+        s.ci_high_ns = b.number_or("ci_high_ns", 0.0);
+        s.confidence = b.number_or("confidence", 0.95);
+        s.iterations = static_cast<size_t>(b.number_or("samples", 0));
+        s.batch_size = static_cast<size_t>(b.number_or("batch_size", 1));
+        s.outliers = static_cast<size_t>(b.number_or("outliers", 0));
+        if (const json::Value* samples = b.find("samples_ns")) {
+            for (const json::Value& v : samples->array) s.samples_ns.push_back(v.number);
+        }
+        if (const json::Value* runs = b.find("run_medians_ns")) {
+            for (const json::Value& v : runs->array) s.run_medians_ns.push_back(v.number);
+        }
+        if (const json::Value* launches = b.find("launch_medians_ns")) {
+            for (const json::Value& v : launches->array) r.launch_medians_ns.push_back(v.number);
+        }
+        if (r.launch_medians_ns.empty()) r.launch_medians_ns.push_back(s.median_ns);
+        if (const json::Value* counters = b.find("counters")) {
+            for (size_t e = 0; e < kPerfEventCount; ++e) {
+                PerfEvent event = static_cast<PerfEvent>(e);
+                if (const json::Value* v = counters->find(perf_event_name(event))) {
+                    s.counters.set(event, v->number);
+                }
+            }
+        }
+        file.results.push_back(std::move(r));
+    }
+    return file;
+}
+
+// ========== Command-Line Session ==========
+
+// Collects suite results for a whole program run and handles:
+//   --json=FILE       write all results (and the environment) as JSON
+//   --csv=FILE        write all results as CSV
+//   --baseline=FILE   compare against a saved JSON file; finish() returns 1
+//                     if any benchmark regressed. Repeat the option with
+//                     files from several launches so the check knows how
+//                     much a result moves between launches
+//   --threshold=PCT   regression threshold in percent (default 5)
+//   --launches=N      run the whole program N times (the extra launches as
+//                     child processes) and record every launch's median;
+//                     defaults to 3 when writing or checking files, else 1
+//   --counters        collect hardware counters (suites opt in through
+//                     counters()); regressed rows show which ones moved
+// A JSON file written with --json is a valid baseline for a later run.
+class BenchmarkSession {
+public:
+    BenchmarkSession(int argc, char** argv)
+        : program_(argc > 0 ? argv[0] : ""), threshold_(0.05), launches_(0), counters_(false),
+          ok_(true), environment_(capture_environment()) {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (starts_with(arg, "--json=")) json_path_ = arg.substr(7);
+            else if (starts_with(arg, "--csv=")) csv_path_ = arg.substr(6);
+            else if (starts_with(arg, "--baseline=")) baseline_paths_.push_back(arg.substr(11));
+            else if (starts_with(arg, "--threshold=")) threshold_ = std::atof(arg.c_str() + 12) / 100.0;
+            else if (starts_with(arg, "--launches=")) launches_ = std::max(1, std::atoi(arg.c_str() + 11));
+            else if (arg == "--counters") counters_ = true;
+            else {
+                std::cerr << "Unknown argument: " << arg << "\n";
+                print_usage(argv[0]);
+                ok_ = false;
+            }
+        }
+    }
+
+    // False when the command line was invalid; main should exit with 2
+    bool ok() const { return ok_; }
+
+    const Environment& environment() const { return environment_; }
+
+    // Whether --counters was given; pass to BenchmarkSuite::set_counters
+    bool counters() const { return counters_; }
+
+    void record(const BenchmarkSuite& suite) {
+        for (RecordedResult& r : collect_results(suite)) {
+            results_.push_back(std::move(r));
+        }
+    }
+
+    // Writes the requested outputs and runs the regression check.
+    // Returns the process exit code: 0 ok, 1 regression, 2 I/O error.
+    int finish() {
+        int status = 0;
+        if (!run_extra_launches()) {
+            return 2;
+        }
+
+        if (!json_path_.empty()) {
+            std::ofstream out(json_path_);
+            write_json(out, environment_, results_);
+            status = close_report(out, json_path_) ? status : 2;
+        }
+        if (!csv_path_.empty()) {
+            std::ofstream out(csv_path_);
+            write_csv(out, results_);
+            status = close_report(out, csv_path_) ? status : 2;
+        }
+        if (!baseline_paths_.empty()) {
+            try {
+                std::vector<BaselineFile> files;
+                for (const std::string& path : baseline_paths_) {
+                    files.push_back(load_baseline(path));
+                }
+                if (check_regressions(files) && status == 0) {
+                    status = 1;
+                }
+            } catch (const std::exception& e) {
+                std::cerr << e.what() << "\n";
+                status = 2;
+            }
+        }
+        return status;
+    }
+
+    // Prints a table against the saved results; true if anything regressed.
+    //
+    // Runs inside one launch cannot show everything that moves between
+    // launches (frequency state, physical pages, neighbours on the host),
+    // so with several launches on either side compare() resamples launch
+    // medians, and a result must also be slower than the slowest saved
+    // launch by the threshold. With a single launch on each side only the
+    // runs within them are resampled.
+    bool check_regressions(const std::vector<BaselineFile>& files) const {
+        std::cout << "\n" << std::string(70, '=') << "\n";
+        std::cout << "Regression check (threshold " << std::fixed << std::setprecision(1)
+                  << threshold_ * 100.0 << "%) vs ";
+        for (size_t i = 0; i < baseline_paths_.size(); ++i) {
+            std::cout << (i ? ", " : "") << baseline_paths_[i];
+        }
+        std::cout << "\n" << std::string(70, '=') << "\n";
+        if (files.empty()) return false;
+
+        for (const std::string& diff : environment_.differences(files.front().environment)) {
+            std::cout << "  warning: environment changed, " << diff << "\n";
+        }
+
+        bool regressed = false;
+        bool single_launch = false;
+        for (const RecordedResult& current : results_) {
+            std::cout << "  " << std::left << std::setw(48) << current.key() << std::right;
+
+            std::vector<double> saved_launches;
+            const RecordedResult* saved = nullptr;
+            for (const BaselineFile& file : files) {
+                if (const RecordedResult* r = file.find(current.key())) {
+                    saved_launches.insert(saved_launches.end(), r->launch_medians_ns.begin(),
+                                          r->launch_medians_ns.end());
+                    saved = r;
+                }
+            }
+            if (!saved) {
+                std::cout << std::setw(10) << "" << "   new\n";
+                continue;
+            }
+
+            const std::vector<double>& current_launches = current.launch_medians_ns;
+            bool by_launch = saved_launches.size() > 1 || current_launches.size() > 1;
+            BenchmarkComparison c = by_launch
+                ? compare(launch_stats(saved_launches), launch_stats(current_launches), 0.95, threshold_)
+                : compare(saved->stats, current.stats, 0.95, threshold_);
+            single_launch = single_launch || !by_launch;
+
+            double limit = 1.0 + threshold_;
+            double current_median = launch_stats(current_launches).median_ns;
+            auto [fastest, slowest] = std::minmax_element(saved_launches.begin(), saved_launches.end());
+            bool envelope = saved_launches.size() < 2;
+            bool slower = c.significant && c.speedup < 1.0 &&
+                          (envelope || current_median > *slowest * limit);
+            bool faster = c.significant && c.speedup > 1.0 &&
+                          (envelope || current_median * limit < *fastest);
+
+            double change = (1.0 / c.speedup - 1.0) * 100.0;   // + means slower
+            std::cout << std::setw(9) << std::showpos << std::setprecision(1) << change << "%"
+                      << std::noshowpos;
+            if (slower) {
+                std::cout << "   REGRESSION\n";
+                print_counter_changes(saved->stats.counters, current.stats.counters);
+                regressed = true;
+            } else if (faster) {
+                std::cout << "   improved\n";
+                print_counter_changes(saved->stats.counters, current.stats.counters);
+            } else {
+                std::cout << "   ok\n";
+            }
+        }
+        if (single_launch) {
+            std::cout << "  note: single launch on both sides, so launch-to-launch noise is\n"
+                      << "        unknown; use --launches=N or several --baseline files\n";
+        }
+
+        // Renamed or deleted benchmarks would otherwise pass unnoticed
+        std::vector<std::string> missing;
+        for (const BaselineFile& file : files) {
+            for (const RecordedResult& saved : file.results) {
+                if (find(saved.key()) ||
+                    std::find(missing.begin(), missing.end(), saved.key()) != missing.end()) {
+                    continue;
+                }
+                std::cout << "  " << std::left << std::setw(48) << saved.key() << std::right
+                          << std::setw(10) << "" << "   missing\n";
+                missing.push_back(saved.key());
+            }
+        }
+
+        std::cout << (regressed ? "FAILED: performance regressed" : "PASSED");
+        if (!missing.empty()) {
+            std::cout << " (" << missing.size() << " baseline benchmark"
+                      << (missing.size() == 1 ? "" : "s") << " not run)";
+        }
+        std::cout << "\n";
+        return regressed;
+    }
+
+    bool check_regressions(const BaselineFile& baseline) const {
+        return check_regressions(std::vector<BaselineFile>{baseline});
+    }
+
+    static void print_usage(const char* program) {
+        std::cerr << "Usage: " << program
+                  << " [--json=FILE] [--csv=FILE] [--baseline=FILE]... [--threshold=PCT]"
+                     " [--launches=N] [--counters]\n";
+    }
+
+private:
+    size_t launch_count() const {
+        if (launches_ > 0) return static_cast<size_t>(launches_);
+        bool files = !json_path_.empty() || !csv_path_.empty() || !baseline_paths_.empty();
+        return files ? 3 : 1;
+    }
+
+    // Runs the program again in child processes that write JSON to a
+    // temporary file, and appends each launch's medians to the results
+    bool run_extra_launches() {
+        const size_t launches = launch_count();
+        if (launches < 2 || results_.empty()) return true;
+
+        std::cout << "\nRepeating the run in " << launches - 1 << " more launch"
+                  << (launches == 2 ? "" : "es") << " to measure launch-to-launch noise...\n";
+        std::random_device seed;
+        for (size_t k = 1; k < launches; ++k) {
+            std::filesystem::path path = std::filesystem::temp_directory_path() /
+                ("benchmark_launch_" + std::to_string(seed()) + ".json");
+            std::string command = shell_quote(program_) + " --launches=1 --json=" +
+                                  shell_quote(path.string()) + (counters_ ? " --counters" : "");
+#if defined(_WIN32)
+            command = "\"" + command + " >NUL\"";   // cmd strips the outer quotes
+#else
+            command += " >/dev/null";
+#endif
+            int code = std::system(command.c_str());
+
+            BaselineFile launch;
+            try {
+                launch = load_baseline(path.string());
+            } catch (const std::exception& e) {
+                std::cerr << e.what() << "\n";
+                code = code ? code : -1;
+            }
+            std::error_code ignored;
+            std::filesystem::remove(path, ignored);
+            if (code != 0) {
+                std::cerr << "Launch " << k + 1 << " failed: " << command << "\n";
+                return false;
+            }
+
+            for (RecordedResult& r : results_) {
+                if (const RecordedResult* other = launch.find(r.key())) {
+                    r.launch_medians_ns.push_back(other->stats.median_ns);
+                }
+            }
+        }
+        return true;
+    }
+
+    static std::string shell_quote(const std::string& text) {
+#if defined(_WIN32)
+        return "\"" + text + "\"";
+#else
+        std::string out = "'";
+        for (char c : text) {
+            if (c == '\'') out += "'\\''";
+            else out += c;
+        }
+        return out + "'";
+#endif
+    }
+
+    // Launch medians as stats for compare(), one run per launch
+    static BenchmarkStats launch_stats(const std::vector<double>& medians) {
+        BenchmarkStats stats;
+        stats.samples_ns = medians;
+        stats.run_medians_ns = medians;
+        std::vector<double> scratch = medians;
+        stats.median_ns = scratch.empty() ? 0.0 : detail::median_of(scratch);
+        return stats;
+    }
+
+    const RecordedResult* find(const std::string& key) const {
+        for (const RecordedResult& r : results_) {
+            if (r.key() == key) return &r;
+        }
+        return nullptr;
+    }
+
+    // Per-call counters before -> after, for events recorded in both runs,
+    // so a changed result says whether cache, branch or TLB behaviour moved
+    static void print_counter_changes(const CounterStats& before, const CounterStats& after) {
+        std::vector<std::string> changes;
+        for (size_t e = 0; e < kPerfEventCount; ++e) {
+            PerfEvent event = static_cast<PerfEvent>(e);
+            if (!before.has(event) || !after.has(event)) continue;
+            std::ostringstream text;
+            text << perf_event_name(event) << " " << std::fixed << std::setprecision(2)
+                 << before.get(event) << " -> " << after.get(event);
+            changes.push_back(text.str());
+        }
+        if (before.ipc() > 0.0 && after.ipc() > 0.0) {
+            std::ostringstream text;
+            text << "IPC " << std::fixed << std::setprecision(2) << before.ipc() << " -> " << after.ipc();
+            changes.push_back(text.str());
+        }
+
+        for (size_t i = 0; i < changes.size(); ++i) {
+            std::cout << (i % 3 == 0 ? "      " : ", ") << changes[i];
+            if (i % 3 == 2 || i + 1 == changes.size()) std::cout << "\n";
+        }
+    }
+
+    static bool starts_with(const std::string& text, const char* prefix) {
+        return text.rfind(prefix, 0) == 0;
+    }
+
+    // Buffered output only reaches the disk on flush, so a full disk or a
+    // lost mount shows up when the file is closed, not while writing
+    static bool close_report(std::ofstream& out, const std::string& path) {
+        out.close();
+        if (!out) {
+            std::cerr << "Failed to write " << path << "\n";
+            return false;
+        }
+        std::cout << "Wrote " << path << "\n";
+        return true;
+    }
+
+    std::string json_path_;
+    std::string csv_path_;
+    std::vector<std::string> baseline_paths_;
+    std::string program_;
+    double threshold_;
+    int launches_;                 // 0 = automatic
+    bool counters_;
+    bool ok_;
+    Environment environment_;
+    std::vector<RecordedResult> results_;
+};
+
+} // namespace perf
+
+#endif // BENCHMARK_REPORT_H
@@ -4,6 +4,7 @@
  */
 
 #include "benchmark.h"
+#include "benchmark_report.h"
 #include <vector>
 #include <algorithm>
 #include <random>
@@ -85,6 +86,7 @@ std::string concat_strings_reserve(const std::vector<std::string>& strings) {
 void allocate_small_objects() {
     for (int i = 0; i < 1000; ++i) {
         auto* p = new int(i);
+        do_not_optimize(p);  // otherwise the new/delete pair is elided
         delete p;
     }
 }
@@ -95,6 +97,7 @@ void allocate_pooled_objects() {
     for (int i = 0; i < 1000; ++i) {
         pool[i] = i;
     }
+    do_not_optimize(pool);
 }
 
 } // namespace test_functions
@@ -102,7 +105,7 @@ void allocate_pooled_objects() {
 void demo_basic_benchmark() {
     std::cout << "\n=== Basic Benchmark Demo ===\n";
 
-    Benchmark bench("Vector Sum", 1000, 50);
+    Benchmark bench("Vector Sum", 100, 50);
 
     auto vec = test_functions::create_vector(10000);
 
@@ -114,8 +117,9 @@ void demo_basic_benchmark() {
     stats.print("Vector Sum (10,000 elements)");
 }
 
-void demo_benchmark_suite_vector_sum() {
-    BenchmarkSuite suite("Vector Summation Comparison", 1000, 50);
+void demo_benchmark_suite_vector_sum(BenchmarkSession& session) {
+    BenchmarkSuite suite("Vector Summation Comparison", 100, 50);
+    suite.set_counters(session.counters());
 
     auto vec = test_functions::create_vector(10000);
 
@@ -135,28 +139,37 @@ void demo_benchmark_suite_vector_sum() {
     });
 
     suite.print_results();
+    session.record(suite);
 }
 
-void demo_benchmark_suite_sqrt() {
-    BenchmarkSuite suite("Square Root Comparison", 10000, 100);
+void demo_benchmark_suite_sqrt(BenchmarkSession& session) {
+    BenchmarkSuite suite("Square Root Comparison", 100, 100);
+    suite.set_counters(session.counters());
 
     double x = 123.456;
 
     suite.add("Custom Newton-Raphson", [&]() {
+        do_not_optimize(x);  // keep the input opaque so calls are not hoisted
         double result = test_functions::slow_sqrt(x);
         do_not_optimize(result);
     });
 
     suite.add("std::sqrt", [&]() {
+        do_not_optimize(x);
         double result = test_functions::fast_sqrt(x);
         do_not_optimize(result);
     });
 
+    // Compare against the library implementation, not whichever ran first
+    suite.set_baseline("std::sqrt");
+
     suite.print_results();
+    session.record(suite);
 }
 
-void demo_benchmark_suite_string_concat() {
-    BenchmarkSuite suite("String Concatenation", 1000, 50);
+void demo_benchmark_suite_string_concat(BenchmarkSession& session) {
+    BenchmarkSuite suite("String Concatenation", 100, 50);
+    suite.set_counters(session.counters());
 
     std::vector<std::string> strings;
     for (int i = 0; i < 100; ++i) {
@@ -174,10 +187,12 @@ void demo_benchmark_suite_string_concat() {
     });
 
     suite.print_results();
+    session.record(suite);
 }
 
-void demo_benchmark_suite_allocation() {
+void demo_benchmark_suite_allocation(BenchmarkSession& session) {
     BenchmarkSuite suite("Memory Allocation", 100, 10);
+    suite.set_counters(session.counters());
 
     suite.add("Individual Allocations", []() {
         test_functions::allocate_small_objects();
@@ -188,6 +203,7 @@ void demo_benchmark_suite_allocation() {
     });
 
     suite.print_results();
+    session.record(suite);
 }
 
 void demo_benchmark_with_setup() {
@@ -247,7 +263,7 @@ void demo_scaling_analysis() {
     for (size_t size : sizes) {
         auto vec = test_functions::create_vector(size);
 
-        Benchmark bench("Sum " + std::to_string(size) + " elements", 100, 10);
+        Benchmark bench("Sum " + std::to_string(size) + " elements", 50, 10);
 
         auto stats = bench.run([&]() {
             int sum = test_functions::sum_vector_accumulate(vec);
@@ -260,7 +276,53 @@ void demo_scaling_analysis() {
     }
 }
 
-int main() {
+void demo_statistical_comparison() {
+    std::cout << "\n=== Statistical Comparison ===\n";
+
+    std::cout << "Clock overhead per Timer start/stop: " << std::fixed << std::setprecision(1)
+              << Benchmark::timer_overhead_ns() << " ns\n";
+
+    // A call far cheaper than the clock itself is only measurable in batches
+    double x = 123.456;
+    auto sqrt_stats = Benchmark("std::sqrt", 50, 100).run([&]() {
+        do_not_optimize(x);
+        double result = test_functions::fast_sqrt(x);
+        do_not_optimize(result);
+    });
+    std::cout << "std::sqrt: " << std::setprecision(2) << sqrt_stats.median_ns
+              << " ns/call (batches of " << sqrt_stats.batch_size << " calls)\n";
+
+    // The same function against itself, sample by sample in alternating
+    // order so drift in machine state lands on both sides: the interval
+    // should straddle 1.0. Timing two copies of the loop one after the
+    // other instead reports "significant" differences in either direction.
+    auto vec = test_functions::create_vector(10000);
+    auto sum_range = [&]() {
+        int sum = test_functions::sum_vector_range(vec);
+        do_not_optimize(sum);
+    };
+
+    // Genuinely different work: the interval should exclude 1.0
+    auto slow = Benchmark("Newton-Raphson", 100, 50).run([&]() {
+        do_not_optimize(x);
+        double result = test_functions::slow_sqrt(x);
+        do_not_optimize(result);
+    });
+
+    std::cout << "\n";
+    compare_interleaved(sum_range, sum_range).print("Range-based For (again)", "Range-based For");
+    compare(slow, sqrt_stats).print("std::sqrt", "Newton-Raphson");
+}
+
+int main(int argc, char** argv) {
+    // --json/--csv export results, --baseline=FILE turns the run into a
+    // regression check, --counters adds perf_event counters to each result
+    // (see benchmark_report.h)
+    BenchmarkSession session(argc, argv);
+    if (!session.ok()) {
+        return 2;
+    }
+
     std::cout << "Complete Benchmarking Framework\n";
     std::cout << "================================\n";
     std::cout << "\nThis lesson demonstrates:\n";
@@ -269,24 +331,32 @@ int main() {
     std::cout << "3. Setup/teardown support\n";
     std::cout << "4. Statistical analysis\n";
     std::cout << "5. Scaling analysis\n";
+    std::cout << "6. Confidence intervals and significance testing\n";
+    std::cout << "7. JSON/CSV export and regression baselines\n";
+    std::cout << "8. Hardware counters per call (--counters, Linux)\n\n";
+    session.environment().print();
 
     demo_basic_benchmark();
     demo_timer();
-    demo_benchmark_suite_vector_sum();
-    demo_benchmark_suite_sqrt();
-    demo_benchmark_suite_string_concat();
-    demo_benchmark_suite_allocation();
+    demo_benchmark_suite_vector_sum(session);
+    demo_benchmark_suite_sqrt(session);
+    demo_benchmark_suite_string_concat(session);
+    demo_benchmark_suite_allocation(session);
     demo_benchmark_with_setup();
     demo_scaling_analysis();
+    demo_statistical_comparison();
 
     std::cout << "\n" << std::string(70, '=') << "\n";
     std::cout << "Key Takeaways:\n";
     std::cout << "- Always use warmup iterations\n";
     std::cout << "- Run multiple iterations for statistical significance\n";
+    std::cout << "- Batch tiny calls so each sample outlasts the clock overhead\n";
+    std::cout << "- Trust a speedup only when its confidence interval excludes 1.0\n";
     std::cout << "- Use do_not_optimize() to prevent compiler optimizations\n";
     std::cout << "- Compare multiple implementations\n";
     std::cout << "- Analyze scaling behavior\n";
+    std::cout << "- Check counters (IPC, cache/branch misses) to explain a slowdown\n";
     std::cout << std::string(70, '=') << "\n";
 
-    return 0;
+    return session.finish();
 }
@@ -0,0 +1,306 @@
+/*
+ * Hardware Performance Counters
+ * Thin wrapper over Linux perf_event_open: counts cycles, instructions,
+ * cache, branch and TLB misses of the calling thread in user mode.
+ * Elsewhere, or when the kernel refuses (containers, perf_event_paranoid,
+ * VMs without a virtual PMU), every event reports as unavailable and
+ * benchmarks run with timing only.
+ */
+
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace perf {
+
+enum class PerfEvent : size_t {
+    Cycles,
+    Instructions,
+    L1DMisses,
+    LLCMisses,
+    BranchMisses,
+    DTLBMisses
+};
+
+constexpr size_t kPerfEventCount = 6;
+
+inline const char* perf_event_name(PerfEvent event) {
+    switch (event) {
+        case PerfEvent::Cycles: return "cycles";
+        case PerfEvent::Instructions: return "instructions";
+        case PerfEvent::L1DMisses: return "l1d_misses";
+        case PerfEvent::LLCMisses: return "llc_misses";
+        case PerfEvent::BranchMisses: return "branch_misses";
+        case PerfEvent::DTLBMisses: return "dtlb_misses";
+    }
+    return "unknown";
+}
+
+// Per-call event counts of one benchmark
+struct CounterStats {
+    std::array<double, kPerfEventCount> per_call{};
+    std::array<bool, kPerfEventCount> available{};
+    std::string unavailable_reason;   // set when counters were requested but none opened
+
+    bool any() const {
+        return std::find(available.begin(), available.end(), true) != available.end();
+    }
+
+    bool has(PerfEvent event) const { return available[static_cast<size_t>(event)]; }
+    double get(PerfEvent event) const { return per_call[static_cast<size_t>(event)]; }
+
+    void set(PerfEvent event, double value) {
+        per_call[static_cast<size_t>(event)] = value;
+        available[static_cast<size_t>(event)] = true;
+    }
+
+    // Instructions per cycle; 0 when either count is missing
+    double ipc() const {
+        if (!has(PerfEvent::Cycles) || !has(PerfEvent::Instructions)) return 0.0;
+        double cycles = get(PerfEvent::Cycles);
+        return cycles > 0.0 ? get(PerfEvent::Instructions) / cycles : 0.0;
+    }
+
+    void print() const {
+        if (!any()) {
+            if (!unavailable_reason.empty()) {
+                std::cout << "  Counters:   unavailable (" << unavailable_reason << ")\n";
+            }
+            return;
+        }
+
+        auto field = [this](PerfEvent event) {
+            std::ostringstream out;
+            if (has(event)) out << std::fixed << std::setprecision(2) << get(event);
+            else out << "n/a";
+            return out.str();
+        };
+
+        std::cout << "  Counters:   " << field(PerfEvent::Cycles) << " cycles, "
+                  << field(PerfEvent::Instructions) << " instructions";
+        if (ipc() > 0.0) {
+            std::cout << " (IPC " << std::fixed << std::setprecision(2) << ipc() << ")";
+        }
+        std::cout << " per call\n";
+        std::cout << "  Misses:     L1D " << field(PerfEvent::L1DMisses)
+                  << ", LLC " << field(PerfEvent::LLCMisses)
+                  << ", branch " << field(PerfEvent::BranchMisses)
+                  << ", dTLB " << field(PerfEvent::DTLBMisses) << " per call\n";
+    }
+};
+
+// One counter group per event (not a single perf group) so the kernel can
+// multiplex them on PMUs with few general-purpose counters; counts are
+// scaled by time_enabled / time_running. Only the calling thread is
+// counted, so start() and stop() must run on the thread doing the work.
+class PerfCounters {
+public:
+    PerfCounters() {
+        fds_.fill(-1);
+        open_all();
+    }
+
+    ~PerfCounters() {
+        close_all();
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool available() const {
+        return std::any_of(fds_.begin(), fds_.end(), [](int fd) { return fd >= 0; });
+    }
+
+    bool available(PerfEvent event) const { return fds_[static_cast<size_t>(event)] >= 0; }
+
+    // Why the first unavailable event could not be opened
+    const std::string& error() const { return error_; }
+
+    // Clears accumulated counts and the interval count
+    void reset() {
+        totals_ = {};
+        intervals_ = 0;
+    }
+
+    void start() {
+        read_all(begin_);
+    }
+
+    // Adds the counts since start() to the running totals
+    void stop() {
+        Reading end;
+        read_all(end);
+        for (size_t i = 0; i < kPerfEventCount; ++i) {
+            totals_.value[i] += end.value[i] - begin_.value[i];
+            totals_.enabled[i] += end.enabled[i] - begin_.enabled[i];
+            totals_.running[i] += end.running[i] - begin_.running[i];
+        }
+        ++intervals_;
+    }
+
+    // Measures the events that one start()/stop() pair around `probe` adds
+    // by itself (the read syscalls return to user mode inside the window),
+    // and subtracts that from every interval in later results
+    template<typename Probe>
+    void calibrate_overhead(Probe&& probe) {
+        overhead_ = {};
+        if (!available()) return;
+
+        std::array<std::vector<double>, kPerfEventCount> deltas;
+        for (int round = 0; round < 101; ++round) {
+            reset();
+            start();
+            probe();
+            stop();
+            for (size_t i = 0; i < kPerfEventCount; ++i) {
+                deltas[i].push_back(scaled(i));
+            }
+        }
+        for (size_t i = 0; i < kPerfEventCount; ++i) {
+            std::vector<double>& d = deltas[i];
+            std::nth_element(d.begin(), d.begin() + d.size() / 2, d.end());
+            overhead_[i] = d[d.size() / 2];
+        }
+        reset();
+    }
+
+    // Accumulated counts divided by `calls`, minus the calibrated overhead
+    CounterStats result(size_t calls) const {
+        CounterStats stats;
+        if (!available()) {
+            stats.unavailable_reason = error_;
+            return stats;
+        }
+        if (calls == 0) return stats;
+
+        for (size_t i = 0; i < kPerfEventCount; ++i) {
+            if (fds_[i] < 0 || totals_.running[i] == 0) continue;
+            double net = scaled(i) - overhead_[i] * static_cast<double>(intervals_);
+            stats.set(static_cast<PerfEvent>(i), std::max(0.0, net) / static_cast<double>(calls));
+        }
+        return stats;
+    }
+
+    void print_status() const {
+        for (size_t i = 0; i < kPerfEventCount; ++i) {
+            std::cout << "  " << std::left << std::setw(15) << perf_event_name(static_cast<PerfEvent>(i))
+                      << std::right << (fds_[i] >= 0 ? "available" : "unavailable") << "\n";
+        }
+        if (!error_.empty()) {
+            std::cout << "  (" << error_ << ")\n";
+        }
+    }
+
+private:
+    struct Reading {
+        std::array<uint64_t, kPerfEventCount> value{};
+        std::array<uint64_t, kPerfEventCount> enabled{};
+        std::array<uint64_t, kPerfEventCount> running{};
+    };
+
+    double scaled(size_t i) const {
+        if (totals_.running[i] == 0) return 0.0;
+        return static_cast<double>(totals_.value[i]) *
+               (static_cast<double>(totals_.enabled[i]) / static_cast<double>(totals_.running[i]));
+    }
+
+#if defined(__linux__)
+    static int open_event(uint32_t type, uint64_t config) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+    }
+
+    static constexpr uint64_t cache_miss(uint64_t cache) {
+        return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    }
+
+    void open_all() {
+        struct Config { PerfEvent event; uint32_t type; uint64_t config; };
+        const Config configs[] = {
+            {PerfEvent::Cycles, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+            {PerfEvent::Instructions, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+            {PerfEvent::L1DMisses, PERF_TYPE_HW_CACHE, cache_miss(PERF_COUNT_HW_CACHE_L1D)},
+            {PerfEvent::LLCMisses, PERF_TYPE_HW_CACHE, cache_miss(PERF_COUNT_HW_CACHE_LL)},
+            {PerfEvent::BranchMisses, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+            {PerfEvent::DTLBMisses, PERF_TYPE_HW_CACHE, cache_miss(PERF_COUNT_HW_CACHE_DTLB)},
+        };
+
+        for (const Config& c : configs) {
+            int fd = open_event(c.type, c.config);
+            // Some PMUs (e.g. AMD) have no LLC read-miss event; the generic
+            // cache-misses event is the kernel's closest equivalent
+            if (fd < 0 && c.event == PerfEvent::LLCMisses && errno == ENOENT) {
+                fd = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+            }
+            if (fd < 0 && error_.empty()) {
+                error_ = std::string(perf_event_name(c.event)) + ": perf_event_open: " +
+                         std::strerror(errno);
+                if (errno == EACCES || errno == EPERM) {
+                    error_ += " (check /proc/sys/kernel/perf_event_paranoid)";
+                }
+            }
+            fds_[static_cast<size_t>(c.event)] = fd;
+        }
+    }
+
+    void close_all() {
+        for (int fd : fds_) {
+            if (fd >= 0) close(fd);
+        }
+    }
+
+    void read_all(Reading& reading) const {
+        for (size_t i = 0; i < kPerfEventCount; ++i) {
+            uint64_t data[3] = {0, 0, 0};
+            if (fds_[i] >= 0 && ::read(fds_[i], data, sizeof(data)) == sizeof(data)) {
+                reading.value[i] = data[0];
+                reading.enabled[i] = data[1];
+                reading.running[i] = data[2];
+            }
+        }
+    }
+#else
+    void open_all() {
+        error_ = "hardware counters need Linux perf_event_open";
+    }
+
+    void close_all() {}
+
+    void read_all(Reading&) const {}
+#endif
+
+    std::array<int, kPerfEventCount> fds_;
+    std::string error_;
+    Reading begin_;
+    Reading totals_;
+    size_t intervals_ = 0;
+    std::array<double, kPerfEventCount> overhead_{};
+};
+
+} // namespace perf
+
+#endif // PERF_COUNTERS_H
@@ -1,6 +1,9 @@
 /*
  * Lesson 05: CPU Performance Counters
- * Demonstrates hardware counters
+ * Demonstrates hardware counters: the same wall-clock slowdown can come
+ * from cache misses, TLB misses, branch mispredictions or a long
+ * dependency chain, and the counters tell them apart.
+ * Uses perf::Benchmark from Lesson 02 with counters enabled (Linux).
  */
 
 #include <iostream>
@@ -8,6 +11,12 @@
 #include <chrono>
 #include <iomanip>
 #include <string>
+#include <numeric>
+#include <random>
+#include <algorithm>
+#include <cstdint>
+
+#include "../Lesson02_Benchmarking/benchmark.h"
 
 class Timer {
     std::chrono::high_resolution_clock::time_point start_;
@@ -26,44 +35,209 @@ void print_header(const std::string& title) {
     std::cout << std::string(60, '=') << "\n";
 }
 
-// Example demonstration function
-void demonstrate_perfcounters() {
-    print_header("CPU Performance Counters");
+// Runs `func` with counters and prints one row, scaled per element
+template<typename Func>
+perf::BenchmarkStats measure(const std::string& name, size_t elements, Func&& func) {
+    perf::BenchmarkStats stats = perf::Benchmark(name, 20, 2).set_counters(true).run(func);
+    const perf::CounterStats& c = stats.counters;
+    const double n = static_cast<double>(elements);
+
+    auto cell = [&](perf::PerfEvent event) {
+        std::ostringstream out;
+        if (c.has(event)) out << std::fixed << std::setprecision(3) << c.get(event) / n;
+        else out << "n/a";
+        return out.str();
+    };
 
-    std::cout << "This lesson demonstrates hardware counters.\n";
-    std::cout << "\nKey concepts:\n";
-    std::cout << "  - Practical implementation examples\n";
-    std::cout << "  - Performance benchmarks\n";
-    std::cout << "  - Best practices\n";
-    std::cout << "  - Real-world applications\n";
+    std::cout << std::left << std::setw(22) << name << std::right << std::fixed
+              << std::setprecision(2) << std::setw(9) << stats.median_ns / n
+              << std::setw(7) << c.ipc()
+              << std::setw(9) << cell(perf::PerfEvent::L1DMisses)
+              << std::setw(9) << cell(perf::PerfEvent::LLCMisses)
+              << std::setw(9) << cell(perf::PerfEvent::DTLBMisses)
+              << std::setw(9) << cell(perf::PerfEvent::BranchMisses) << "\n";
+    return stats;
+}
+
+void print_table_header(const std::string& unit) {
+    std::cout << std::left << std::setw(22) << "Variant" << std::right
+              << std::setw(9) << "ns/" + unit << std::setw(7) << "IPC"
+              << std::setw(9) << "L1D" << std::setw(9) << "LLC"
+              << std::setw(9) << "dTLB" << std::setw(9) << "branch" << "\n";
+    std::cout << std::string(74, '-') << "\n";
+}
 
-    Timer t;
+// ========== Counter Availability ==========
 
-    // Example computation
-    const size_t iterations = 1000000;
-    long long sum = 0;
+void demonstrate_availability() {
+    print_header("Counter Availability");
 
-    for (size_t i = 0; i < iterations; ++i) {
-        sum += i;
+    perf::PerfCounters counters;
+    counters.print_status();
+    if (!counters.available()) {
+        std::cout << "\nNo hardware counters: the tables below show timing only.\n";
+        std::cout << "Run on bare-metal Linux, or lower perf_event_paranoid to 2 or less.\n";
     }
+}
+
+// ========== Memory Access Patterns ==========
+// Same instructions, same data; only the order of the loads changes
+
+void demonstrate_cache_misses() {
+    print_header("Access Pattern: Cache and TLB Misses");
+
+    const size_t count = 8 * 1024 * 1024;   // 32 MB of ints, larger than the LLC
+    std::vector<int> data(count, 1);
 
-    double elapsed = t.elapsed_ms();
+    std::vector<uint32_t> sequential(count);
+    std::iota(sequential.begin(), sequential.end(), 0u);
 
-    std::cout << "\nBenchmark results:\n";
-    std::cout << "  Iterations: " << iterations << "\n";
-    std::cout << "  Sum: " << sum << "\n";
-    std::cout << "  Time: " << std::fixed << std::setprecision(2) << elapsed << " ms\n";
+    // Every 16th int: one load per 64-byte line
+    std::vector<uint32_t> strided(count);
+    for (size_t i = 0; i < count; ++i) {
+        strided[i] = static_cast<uint32_t>((i * 16) % count + (i * 16) / count);
+    }
+
+    std::vector<uint32_t> shuffled = sequential;
+    std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(42));
+
+    auto gather = [&](const std::vector<uint32_t>& order) {
+        return [&data, &order]() {
+            long long sum = 0;
+            for (uint32_t index : order) {
+                sum += data[index];
+            }
+            perf::do_not_optimize(sum);
+        };
+    };
+
+    std::cout << "Summing " << count << " ints through an index array (per element):\n\n";
+    print_table_header("elem");
+    measure("Sequential", count, gather(sequential));
+    measure("Stride 64 bytes", count, gather(strided));
+    measure("Random", count, gather(shuffled));
+
+    std::cout << "\nSequential loads hit lines the prefetcher already fetched.\n";
+    std::cout << "A 64-byte stride misses L1 on every load but stays prefetchable.\n";
+    std::cout << "Random order misses the LLC on almost every load. dTLB misses show up\n";
+    std::cout << "with 4 KB pages; transparent huge pages (2 MB) mostly hide them.\n";
+}
+
+// ========== Branch Prediction ==========
+
+void demonstrate_branch_misses() {
+    print_header("Branch Prediction: Sorted vs Random Data");
+
+    const size_t count = 1024 * 1024;
+    std::vector<uint8_t> random_bytes(count);
+    std::mt19937 rng(7);
+    for (uint8_t& b : random_bytes) {
+        b = static_cast<uint8_t>(rng());
+    }
+    std::vector<uint8_t> sorted_bytes = random_bytes;
+    std::sort(sorted_bytes.begin(), sorted_bytes.end());
+
+    // The compiler barrier in the taken path keeps GCC from turning the branch
+    // into a conditional move or a vectorized select
+    auto branchy = [](const std::vector<uint8_t>& bytes) {
+        return [&bytes]() {
+            long long sum = 0;
+            for (uint8_t b : bytes) {
+                if (b >= 128) {
+                    sum += b;
+                    perf::clobber_memory();
+                }
+            }
+            perf::do_not_optimize(sum);
+        };
+    };
+
+    auto branchless = [](const std::vector<uint8_t>& bytes) {
+        return [&bytes]() {
+            long long sum = 0;
+            for (uint8_t b : bytes) {
+                sum += b & -static_cast<int>(b >= 128);
+            }
+            perf::do_not_optimize(sum);
+        };
+    };
+
+    std::cout << "Summing bytes >= 128 over " << count << " bytes (per element):\n\n";
+    print_table_header("elem");
+    measure("Branch, random", count, branchy(random_bytes));
+    measure("Branch, sorted", count, branchy(sorted_bytes));
+    measure("Branchless, random", count, branchless(random_bytes));
+
+    std::cout << "\nRandom data mispredicts about every other branch (0.5 per element);\n";
+    std::cout << "sorted data or a branchless select brings that close to zero.\n";
+}
+
+// ========== Instruction-Level Parallelism ==========
+
+void demonstrate_ipc() {
+    print_header("IPC: Dependency Chains");
+
+    const size_t count = 4096;   // fits in L1: no memory effects
+    std::vector<double> values(count);
+    std::iota(values.begin(), values.end(), 1.0);
+
+    // Without -ffast-math the compiler may not reorder FP adds, so one
+    // accumulator is one long chain of dependent additions
+    auto one_chain = [&]() {
+        double sum = 0.0;
+        for (size_t i = 0; i < count; ++i) {
+            sum += values[i];
+        }
+        perf::do_not_optimize(sum);
+    };
+
+    auto four_chains = [&]() {
+        double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+        for (size_t i = 0; i < count; i += 4) {
+            s0 += values[i];
+            s1 += values[i + 1];
+            s2 += values[i + 2];
+            s3 += values[i + 3];
+        }
+        double sum = (s0 + s1) + (s2 + s3);
+        perf::do_not_optimize(sum);
+    };
+
+    std::cout << "Summing " << count << " doubles (per element):\n\n";
+    print_table_header("elem");
+    auto one = measure("1 accumulator", count, one_chain);
+    auto four = measure("4 accumulators", count, four_chains);
+
+    std::cout << "\nNo misses in either case; the difference is all in IPC.\n";
+    const perf::PerfEvent instructions = perf::PerfEvent::Instructions;
+    if (one.counters.has(instructions) && four.counters.has(instructions)) {
+        std::cout << "Instructions per element: "
+                  << std::setprecision(2)
+                  << one.counters.get(instructions) / count << " vs "
+                  << four.counters.get(instructions) / count
+                  << " (more instructions, yet faster: only the IPC improved)\n";
+    } else {
+        std::cout << "Instructions per element: n/a (instruction counter unavailable)\n";
+    }
 }
 
 int main() {
     std::cout << "Lesson 05: CPU Performance Counters\n";
     std::cout << std::string(60, '=') << "\n";
 
-    demonstrate_perfcounters();
+    Timer total;
+
+    demonstrate_availability();
+    demonstrate_cache_misses();
+    demonstrate_branch_misses();
+    demonstrate_ipc();
 
     print_header("Conclusion");
-    std::cout << "Successfully demonstrated hardware counters.\n";
-    std::cout << "Review the code and experiment with modifications.\n";
+    std::cout << "Time alone says *that* code is slow; counters say *why*:\n";
+    std::cout << "  - Low IPC with many LLC/dTLB misses: memory bound, fix the layout\n";
+    std::cout << "  - Branch misses near 0.5 per element: unpredictable data, go branchless\n";
+    std::cout << "  - Low IPC with no misses: dependency chains, add independent work\n";
+    std::cout << "Total time: " << std::fixed << std::setprecision(0) << total.elapsed_ms() << " ms\n";
     std::cout << std::string(60, '=') << "\n";
 
     return 0;
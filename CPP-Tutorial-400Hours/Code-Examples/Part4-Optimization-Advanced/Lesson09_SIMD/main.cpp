@@ -1,6 +1,9 @@
 /*
  * Lesson 09: SIMD (Single Instruction Multiple Data)
- * Demonstrates SSE and AVX vectorization for performance
+ * Demonstrates SSE and AVX vectorization for performance, with runtime
+ * CPU dispatch: one binary picks SSE2, AVX2+FMA or AVX-512 kernels from
+ * CPUID at startup (see simd_kernels.h), and accurate reductions that
+ * trade a little speed for much smaller rounding error (simd_reductions.h)
  */
 
 #include <iostream>
@@ -9,12 +12,11 @@
 #include <random>
 #include <iomanip>
 #include <cstring>
+#include <cmath>
+#include <string>
 
-#ifdef _MSC_VER
-    #include <intrin.h>
-#else
-    #include <x86intrin.h>
-#endif
+#include "simd_kernels.h"
+#include "simd_reductions.h"
 
 class Timer {
     std::chrono::high_resolution_clock::time_point start_;
@@ -27,323 +29,357 @@ public:
     }
 };
 
-// ========== Scalar (No SIMD) Implementations ==========
+using simd::IsaLevel;
+using simd::KernelTable;
+using simd::ReductionTable;
+using simd::Accumulation;
 
-void add_arrays_scalar(const float* a, const float* b, float* result, size_t n) {
-    for (size_t i = 0; i < n; ++i) {
-        result[i] = a[i] + b[i];
-    }
-}
+const IsaLevel kAllLevels[] = {IsaLevel::Scalar, IsaLevel::SSE2, IsaLevel::AVX2, IsaLevel::AVX512};
+const Accumulation kAllModes[] = {Accumulation::Fast, Accumulation::Pairwise,
+                                  Accumulation::Compensated, Accumulation::Double};
 
-float dot_product_scalar(const float* a, const float* b, size_t n) {
-    float sum = 0.0f;
-    for (size_t i = 0; i < n; ++i) {
-        sum += a[i] * b[i];
-    }
-    return sum;
-}
+// ========== CPU Feature Detection ==========
 
-void multiply_scalar(const float* a, float scalar, float* result, size_t n) {
-    for (size_t i = 0; i < n; ++i) {
-        result[i] = a[i] * scalar;
+void print_cpu_features() {
+    std::cout << "\n=== CPU SIMD Support (CPUID at runtime) ===\n";
+
+    const simd::CpuFeatures& f = simd::cpu_features();
+    auto yes_no = [](bool b) { return b ? "YES" : "NO"; };
+
+    std::cout << "SSE2:    " << yes_no(f.sse2) << "\n";
+    std::cout << "SSE4.1:  " << yes_no(f.sse41) << "\n";
+    std::cout << "AVX:     " << yes_no(f.avx && f.os_avx) << "\n";
+    std::cout << "AVX2:    " << yes_no(f.avx2 && f.os_avx) << "\n";
+    std::cout << "FMA:     " << yes_no(f.fma && f.os_avx) << "\n";
+    std::cout << "AVX512F: " << yes_no(f.avx512f && f.os_avx512) << "\n";
+
+    std::cout << "\nBest level:     " << simd::isa_name(f.best_level()) << "\n";
+    std::cout << "Dispatching to: " << simd::isa_name(simd::active_kernels().level);
+    if (simd::active_kernels().level != f.best_level()) {
+        std::cout << " (capped by SIMD_ISA)";
     }
+    std::cout << "\n";
+
+    // What the compiler may use outside the dispatched kernels
+    std::cout << "Compiled for:   ";
+#if defined(__AVX512F__)
+    std::cout << "AVX-512 (this binary needs an AVX-512 host)\n";
+#elif defined(__AVX2__)
+    std::cout << "AVX2 (this binary needs an AVX2 host)\n";
+#elif defined(__SSE2__) || defined(_M_X64)
+    std::cout << "SSE2 baseline (portable)\n";
+#else
+    std::cout << "generic\n";
+#endif
 }
 
-// ========== SSE Implementations (128-bit, 4 floats) ==========
+// ========== Correctness ==========
 
-void add_arrays_sse(const float* a, const float* b, float* result, size_t n) {
-    size_t i = 0;
+// Every size from 0 to 3 vectors plus one, aligned and misaligned, against
+// the scalar kernels: exercises the main loops, the unrolled loops and
+// every tail length
+bool verify_level(const KernelTable& k) {
+    const KernelTable ref = simd::kernels_for(IsaLevel::Scalar);
+    const size_t max_n = 3 * 64 + 1;
 
-    // Process 4 floats at a time
-    for (; i + 4 <= n; i += 4) {
-        __m128 va = _mm_loadu_ps(&a[i]);
-        __m128 vb = _mm_loadu_ps(&b[i]);
-        __m128 vresult = _mm_add_ps(va, vb);
-        _mm_storeu_ps(&result[i], vresult);
+    simd::aligned_vector<float> a(max_n + 1), b(max_n + 1), out(max_n + 1), expected(max_n + 1);
+    std::mt19937 gen(1);
+    std::uniform_real_distribution<float> dis(-1.0f, 1.0f);
+    for (size_t i = 0; i <= max_n; ++i) {
+        a[i] = dis(gen);
+        b[i] = dis(gen);
     }
 
-    // Handle remainder
-    for (; i < n; ++i) {
-        result[i] = a[i] + b[i];
+    for (size_t offset = 0; offset <= 1; ++offset) {
+        const float* pa = a.data() + offset;
+        const float* pb = b.data() + offset;
+        float* po = out.data() + offset;
+        float* pe = expected.data() + offset;
+        const bool aligned = offset == 0;
+
+        for (size_t n = 0; n < max_n; ++n) {
+            // add and scale are exact in every ISA
+            out.assign(out.size(), -7.0f);
+            expected.assign(expected.size(), -7.0f);
+            (aligned ? k.add_aligned : k.add)(pa, pb, po, n);
+            ref.add(pa, pb, pe, n);
+            if (out != expected) return false;     // also catches writes past n
+
+            (aligned ? k.scale_aligned : k.scale)(pa, 2.5f, po, n);
+            ref.scale(pa, 2.5f, pe, n);
+            if (out != expected) return false;
+
+            // FMA rounds once, so axpy and dot may differ in the last bits
+            std::memcpy(po, pb, n * sizeof(float));
+            std::memcpy(pe, pb, n * sizeof(float));
+            (aligned ? k.axpy_aligned : k.axpy)(0.5f, pa, po, n);
+            ref.axpy(0.5f, pa, pe, n);
+            for (size_t i = 0; i < n; ++i) {
+                if (std::fabs(po[i] - pe[i]) > 1e-6f) return false;
+            }
+            if (po[n] != -7.0f && n < max_n) return false;
+
+            double exact = 0.0;
+            for (size_t i = 0; i < n; ++i) exact += static_cast<double>(pa[i]) * pb[i];
+            float dot = (aligned ? k.dot_aligned : k.dot)(pa, pb, n);
+            if (std::fabs(dot - exact) > 1e-4 * (1.0 + n)) return false;
+        }
     }
+    return true;
 }
 
-float dot_product_sse(const float* a, const float* b, size_t n) {
-    __m128 vsum = _mm_setzero_ps();
-    size_t i = 0;
-
-    // Process 4 floats at a time
-    for (; i + 4 <= n; i += 4) {
-        __m128 va = _mm_loadu_ps(&a[i]);
-        __m128 vb = _mm_loadu_ps(&b[i]);
-        __m128 vmul = _mm_mul_ps(va, vb);
-        vsum = _mm_add_ps(vsum, vmul);
+// Every reduction mode against a double reference. Sizes up to a few
+// pairwise blocks so the tree recursion runs too.
+bool verify_reductions(const ReductionTable& k) {
+    const size_t max_n = 3 * simd::detail::kPairwiseBlock + 37;
+    std::vector<float> a(max_n + 1), b(max_n + 1);
+    std::mt19937 gen(2);
+    std::uniform_real_distribution<float> dis(-1.0f, 1.0f);
+    for (size_t i = 0; i <= max_n; ++i) {
+        a[i] = dis(gen);
+        b[i] = dis(gen);
     }
 
-    // Horizontal add to get final sum
-    alignas(16) float temp[4];
-    _mm_store_ps(temp, vsum);
-    float sum = temp[0] + temp[1] + temp[2] + temp[3];
-
-    // Handle remainder
-    for (; i < n; ++i) {
-        sum += a[i] * b[i];
+    for (size_t offset = 0; offset <= 1; ++offset) {
+        const float* pa = a.data() + offset;
+        const float* pb = b.data() + offset;
+        for (size_t n = 0; n < max_n; n += (n < 200 ? 1 : 97)) {
+            double exact_sum = 0.0, exact_dot = 0.0;
+            for (size_t i = 0; i < n; ++i) {
+                exact_sum += pa[i];
+                exact_dot += static_cast<double>(pa[i]) * pb[i];
+            }
+            for (Accumulation mode : kAllModes) {
+                const double tolerance = 1e-5 * (1.0 + n);
+                if (std::fabs(simd::sum(k, pa, n, mode) - exact_sum) > tolerance) return false;
+                if (std::fabs(simd::dot(k, pa, pb, n, mode) - exact_dot) > tolerance) return false;
+            }
+        }
     }
-
-    return sum;
+    return true;
 }
 
-void multiply_scalar_sse(const float* a, float scalar, float* result, size_t n) {
-    __m128 vscalar = _mm_set1_ps(scalar);
-    size_t i = 0;
-
-    for (; i + 4 <= n; i += 4) {
-        __m128 va = _mm_loadu_ps(&a[i]);
-        __m128 vresult = _mm_mul_ps(va, vscalar);
-        _mm_storeu_ps(&result[i], vresult);
-    }
-
-    for (; i < n; ++i) {
-        result[i] = a[i] * scalar;
+void verify_kernels() {
+    std::cout << "\n=== Correctness (all tail lengths, aligned and unaligned) ===\n";
+    for (IsaLevel level : kAllLevels) {
+        std::cout << std::left << std::setw(10) << simd::isa_name(level) << std::right;
+        if (!simd::cpu_features().supports(level) && level != IsaLevel::Scalar) {
+            std::cout << "not supported by this CPU\n";
+            continue;
+        }
+        bool ok = verify_level(simd::kernels_for(level)) && verify_reductions(simd::reductions_for(level));
+        std::cout << (ok ? "OK" : "MISMATCH") << "\n";
     }
 }
 
-// ========== AVX Implementations (256-bit, 8 floats) ==========
-
-#if defined(__AVX__) || defined(__AVX2__)
-
-void add_arrays_avx(const float* a, const float* b, float* result, size_t n) {
-    size_t i = 0;
+// ========== Benchmarking Functions ==========
 
-    // Process 8 floats at a time
-    for (; i + 8 <= n; i += 8) {
-        __m256 va = _mm256_loadu_ps(&a[i]);
-        __m256 vb = _mm256_loadu_ps(&b[i]);
-        __m256 vresult = _mm256_add_ps(va, vb);
-        _mm256_storeu_ps(&result[i], vresult);
+// Times `iterations` calls of one kernel, in ms
+template<typename Func>
+double time_kernel(size_t iterations, Func&& func) {
+    func();   // warmup
+    Timer t;
+    for (size_t i = 0; i < iterations; ++i) {
+        func();
     }
+    return t.elapsed_ms();
+}
 
-    // Handle remainder
-    for (; i < n; ++i) {
-        result[i] = a[i] + b[i];
-    }
+void print_benchmark_header(const std::string& kernel) {
+    std::cout << "\n=== " << kernel << " ===\n";
+    std::cout << std::left << std::setw(10) << "ISA" << std::right
+              << std::setw(12) << "Aligned" << std::setw(12) << "Unaligned"
+              << std::setw(10) << "GFLOP/s" << std::setw(10) << "Speedup" << "\n";
+    std::cout << std::string(54, '-') << "\n";
 }
 
-float dot_product_avx(const float* a, const float* b, size_t n) {
-    __m256 vsum = _mm256_setzero_ps();
-    size_t i = 0;
+void print_benchmark_row(IsaLevel level, double aligned_ms, double unaligned_ms,
+                         double flops, double scalar_ms) {
+    std::cout << std::left << std::setw(10) << simd::isa_name(level) << std::right
+              << std::fixed << std::setprecision(2)
+              << std::setw(10) << aligned_ms << "ms"
+              << std::setw(10) << unaligned_ms << "ms"
+              << std::setw(10) << flops / (aligned_ms * 1e6)
+              << std::setw(9) << scalar_ms / aligned_ms << "x\n";
+}
 
-    for (; i + 8 <= n; i += 8) {
-        __m256 va = _mm256_loadu_ps(&a[i]);
-        __m256 vb = _mm256_loadu_ps(&b[i]);
-        __m256 vmul = _mm256_mul_ps(va, vb);
-        vsum = _mm256_add_ps(vsum, vmul);
-    }
+// One kernel across every ISA the CPU supports. Unaligned runs shift all
+// pointers by one float so every vector load/store splits cache lines.
+template<typename Run>
+void benchmark_kernel(const std::string& name, size_t n, size_t iterations,
+                      double flops_per_element, Run&& run) {
+    print_benchmark_header(name);
+    const double flops = flops_per_element * n * iterations;
+    double scalar_ms = 0.0;
 
-    // Horizontal add
-    alignas(32) float temp[8];
-    _mm256_store_ps(temp, vsum);
-    float sum = 0.0f;
-    for (int j = 0; j < 8; ++j) {
-        sum += temp[j];
-    }
+    for (IsaLevel level : kAllLevels) {
+        if (!simd::cpu_features().supports(level) && level != IsaLevel::Scalar) continue;
+        KernelTable k = simd::kernels_for(level);
 
-    // Handle remainder
-    for (; i < n; ++i) {
-        sum += a[i] * b[i];
-    }
+        double aligned_ms = time_kernel(iterations, [&]() { run(k, true); });
+        double unaligned_ms = time_kernel(iterations, [&]() { run(k, false); });
+        if (level == IsaLevel::Scalar) scalar_ms = aligned_ms;
 
-    return sum;
+        print_benchmark_row(level, aligned_ms, unaligned_ms, flops, scalar_ms);
+    }
 }
 
-void multiply_scalar_avx(const float* a, float scalar, float* result, size_t n) {
-    __m256 vscalar = _mm256_set1_ps(scalar);
-    size_t i = 0;
-
-    for (; i + 8 <= n; i += 8) {
-        __m256 va = _mm256_loadu_ps(&a[i]);
-        __m256 vresult = _mm256_mul_ps(va, vscalar);
-        _mm256_storeu_ps(&result[i], vresult);
-    }
+void run_benchmarks(size_t n, size_t iterations) {
+    // One spare element so the unaligned view (offset by 1) stays in bounds
+    simd::aligned_vector<float> a(n + 1), b(n + 1), result(n + 1), y(n + 1);
 
-    for (; i < n; ++i) {
-        result[i] = a[i] * scalar;
+    std::mt19937 gen(42);  // Fixed seed for reproducibility
+    std::uniform_real_distribution<float> dis(-100.0f, 100.0f);
+    for (size_t i = 0; i <= n; ++i) {
+        a[i] = dis(gen);
+        b[i] = dis(gen);
+        y[i] = 0.0f;
     }
-}
 
-#endif
-
-// ========== Benchmarking Functions ==========
+    auto view = [](auto& v, bool aligned) { return v.data() + (aligned ? 0 : 1); };
+    volatile float sink = 0.0f;
 
-void benchmark_add_arrays(const std::vector<float>& a, const std::vector<float>& b, size_t iterations) {
-    std::cout << "\n=== Array Addition Benchmark ===\n";
+    benchmark_kernel("add_arrays (r = a + b)", n, iterations, 1.0, [&](const KernelTable& k, bool al) {
+        (al ? k.add_aligned : k.add)(view(a, al), view(b, al), view(result, al), n);
+    });
 
-    const size_t n = a.size();
-    std::vector<float> result(n);
+    benchmark_kernel("dot_product (sum a * b)", n, iterations, 2.0, [&](const KernelTable& k, bool al) {
+        sink = (al ? k.dot_aligned : k.dot)(view(a, al), view(b, al), n);
+    });
 
-    // Scalar
-    {
-        Timer t;
-        for (size_t i = 0; i < iterations; ++i) {
-            add_arrays_scalar(a.data(), b.data(), result.data(), n);
-        }
-        double ms = t.elapsed_ms();
-        std::cout << "Scalar: " << std::fixed << std::setprecision(2) << ms << " ms\n";
-    }
+    benchmark_kernel("multiply_scalar (r = a * s)", n, iterations, 1.0, [&](const KernelTable& k, bool al) {
+        (al ? k.scale_aligned : k.scale)(view(a, al), 2.5f, view(result, al), n);
+    });
 
-    // SSE
-    {
-        Timer t;
-        for (size_t i = 0; i < iterations; ++i) {
-            add_arrays_sse(a.data(), b.data(), result.data(), n);
-        }
-        double ms = t.elapsed_ms();
-        std::cout << "SSE:    " << std::fixed << std::setprecision(2) << ms << " ms";
-        std::cout << " (4x parallelism)\n";
-    }
+    // Tiny alpha keeps y bounded over thousands of repetitions
+    benchmark_kernel("axpy (y = alpha * x + y)", n, iterations, 2.0, [&](const KernelTable& k, bool al) {
+        (al ? k.axpy_aligned : k.axpy)(1e-6f, view(a, al), view(y, al), n);
+    });
 
-#if defined(__AVX__) || defined(__AVX2__)
-    // AVX
-    {
-        Timer t;
-        for (size_t i = 0; i < iterations; ++i) {
-            add_arrays_avx(a.data(), b.data(), result.data(), n);
-        }
-        double ms = t.elapsed_ms();
-        std::cout << "AVX:    " << std::fixed << std::setprecision(2) << ms << " ms";
-        std::cout << " (8x parallelism)\n";
-    }
-#endif
+    (void)sink;
 }
 
-void benchmark_dot_product(const std::vector<float>& a, const std::vector<float>& b, size_t iterations) {
-    std::cout << "\n=== Dot Product Benchmark ===\n";
+// ========== Reductions: Speed and Accuracy ==========
 
-    const size_t n = a.size();
-    float result;
-
-    // Scalar
-    {
-        Timer t;
-        for (size_t i = 0; i < iterations; ++i) {
-            result = dot_product_scalar(a.data(), b.data(), n);
-        }
-        double ms = t.elapsed_ms();
-        std::cout << "Scalar: " << std::fixed << std::setprecision(2) << ms << " ms";
-        std::cout << " (result: " << result << ")\n";
-    }
-
-    // SSE
-    {
-        Timer t;
-        for (size_t i = 0; i < iterations; ++i) {
-            result = dot_product_sse(a.data(), b.data(), n);
-        }
-        double ms = t.elapsed_ms();
-        std::cout << "SSE:    " << std::fixed << std::setprecision(2) << ms << " ms";
-        std::cout << " (result: " << result << ")\n";
+// Sum and dot in every accumulation mode on every ISA, L1-resident data.
+// Cells are billions of elements per second.
+void benchmark_reduction_throughput(size_t n, size_t iterations) {
+    std::vector<float> a(n), b(n);
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<float> dis(0.0f, 1.0f);
+    for (size_t i = 0; i < n; ++i) {
+        a[i] = dis(gen);
+        b[i] = dis(gen);
     }
-
-#if defined(__AVX__) || defined(__AVX2__)
-    // AVX
-    {
-        Timer t;
-        for (size_t i = 0; i < iterations; ++i) {
-            result = dot_product_avx(a.data(), b.data(), n);
+    volatile double sink = 0.0;
+    const double elements = static_cast<double>(n) * iterations;
+
+    // One float accumulator: every add waits for the previous one
+    double naive_ms = time_kernel(iterations, [&]() {
+        float s = 0.0f;
+        for (size_t i = 0; i < n; ++i) s += a[i];
+        sink = s;
+    });
+    std::cout << "\nNaive sum, 1 scalar accumulator: " << std::fixed << std::setprecision(2)
+              << elements / (naive_ms * 1e6) << " Gelem/s\n";
+
+    for (const char* kernel : {"sum", "dot"}) {
+        const bool is_dot = kernel[0] == 'd';
+        std::cout << "\n=== " << kernel << " (" << n << " floats, Gelem/s) ===\n";
+        std::cout << std::left << std::setw(10) << "ISA" << std::right;
+        for (Accumulation mode : kAllModes) std::cout << std::setw(13) << simd::accumulation_name(mode);
+        std::cout << "\n" << std::string(62, '-') << "\n";
+
+        for (IsaLevel level : kAllLevels) {
+            if (!simd::cpu_features().supports(level) && level != IsaLevel::Scalar) continue;
+            ReductionTable k = simd::reductions_for(level);
+            std::cout << std::left << std::setw(10) << simd::isa_name(level) << std::right;
+            for (Accumulation mode : kAllModes) {
+                double ms = time_kernel(iterations, [&]() {
+                    sink = is_dot ? simd::dot(k, a.data(), b.data(), n, mode) : simd::sum(k, a.data(), n, mode);
+                });
+                std::cout << std::setw(13) << std::fixed << std::setprecision(2) << elements / (ms * 1e6);
+            }
+            std::cout << "\n";
         }
-        double ms = t.elapsed_ms();
-        std::cout << "AVX:    " << std::fixed << std::setprecision(2) << ms << " ms";
-        std::cout << " (result: " << result << ")\n";
     }
-#endif
+    (void)sink;
 }
 
-void benchmark_scalar_multiply(const std::vector<float>& a, size_t iterations) {
-    std::cout << "\n=== Scalar Multiplication Benchmark ===\n";
-
-    const size_t n = a.size();
-    std::vector<float> result(n);
-    const float scalar = 2.5f;
+double relative_error(double value, long double reference) {
+    return static_cast<double>(std::fabs((static_cast<long double>(value) - reference) / reference));
+}
 
-    // Scalar
-    {
-        Timer t;
-        for (size_t i = 0; i < iterations; ++i) {
-            multiply_scalar(a.data(), scalar, result.data(), n);
-        }
-        double ms = t.elapsed_ms();
-        std::cout << "Scalar: " << std::fixed << std::setprecision(2) << ms << " ms\n";
+// Relative error against a long double reference at growing sizes, using
+// the dispatched kernels. Values in [0, 1): the running sum grows with n,
+// so every float add loses more of the incoming value.
+void benchmark_reduction_accuracy() {
+    std::cout << "\n=== Relative error vs long double reference ("
+              << simd::isa_name(simd::active_reductions().level) << ") ===\n";
+    std::cout << std::left << std::setw(14) << "Reduction" << std::right << std::setw(10) << "Naive";
+    for (Accumulation mode : kAllModes) std::cout << std::setw(12) << simd::accumulation_name(mode);
+    std::cout << "\n" << std::string(72, '-') << "\n";
+
+    const size_t max_n = 16 * 1024 * 1024;
+    std::vector<float> a(max_n), b(max_n);
+    std::mt19937 gen(3);
+    std::uniform_real_distribution<float> dis(0.0f, 1.0f);
+    for (size_t i = 0; i < max_n; ++i) {
+        a[i] = dis(gen);
+        b[i] = dis(gen);
     }
 
-    // SSE
-    {
-        Timer t;
-        for (size_t i = 0; i < iterations; ++i) {
-            multiply_scalar_sse(a.data(), scalar, result.data(), n);
+    auto print_row = [](const std::string& label, double naive, long double reference, auto&& reduce) {
+        std::cout << std::left << std::setw(14) << label << std::right << std::scientific
+                  << std::setprecision(1) << std::setw(10) << relative_error(naive, reference);
+        for (Accumulation mode : kAllModes) {
+            std::cout << std::setw(12) << relative_error(reduce(mode), reference);
         }
-        double ms = t.elapsed_ms();
-        std::cout << "SSE:    " << std::fixed << std::setprecision(2) << ms << " ms\n";
+        std::cout << "\n";
+    };
+
+    for (size_t n : {size_t(1000), size_t(100000), size_t(1000000), max_n}) {
+        long double ref_sum = 0.0L, ref_dot = 0.0L;
+        float naive_sum = 0.0f, naive_dot = 0.0f;
+        for (size_t i = 0; i < n; ++i) {
+            ref_sum += a[i];
+            ref_dot += static_cast<long double>(a[i]) * b[i];
+            naive_sum += a[i];
+            naive_dot += a[i] * b[i];
+        }
+        const std::string size = std::to_string(n);
+        print_row("sum " + size, naive_sum, ref_sum, [&](Accumulation m) { return simd::sum(a.data(), n, m); });
+        print_row("dot " + size, naive_dot, ref_dot, [&](Accumulation m) { return simd::dot(a.data(), b.data(), n, m); });
     }
 
-#if defined(__AVX__) || defined(__AVX2__)
-    // AVX
-    {
-        Timer t;
-        for (size_t i = 0; i < iterations; ++i) {
-            multiply_scalar_avx(a.data(), scalar, result.data(), n);
-        }
-        double ms = t.elapsed_ms();
-        std::cout << "AVX:    " << std::fixed << std::setprecision(2) << ms << " ms\n";
+    long double ref_norm = 0.0L;
+    float naive_norm = 0.0f;
+    for (size_t i = 0; i < max_n; ++i) {
+        ref_norm += static_cast<long double>(a[i]) * a[i];
+        naive_norm += a[i] * a[i];
     }
-#endif
+    print_row("norm " + std::to_string(max_n), std::sqrt(naive_norm), std::sqrt(ref_norm),
+              [&](Accumulation m) { return simd::norm(a.data(), max_n, m); });
+    std::cout << std::fixed;
 }
 
-// ========== CPU Feature Detection ==========
+// ========== Dispatched API ==========
 
-void print_cpu_features() {
-    std::cout << "\n=== CPU SIMD Support ===\n";
+void demo_dispatched_api() {
+    std::cout << "\n=== Dispatched API ===\n";
 
-#ifdef __SSE__
-    std::cout << "SSE:   YES\n";
-#else
-    std::cout << "SSE:   NO\n";
-#endif
-
-#ifdef __SSE2__
-    std::cout << "SSE2:  YES\n";
-#else
-    std::cout << "SSE2:  NO\n";
-#endif
-
-#ifdef __SSE3__
-    std::cout << "SSE3:  YES\n";
-#else
-    std::cout << "SSE3:  NO\n";
-#endif
-
-#ifdef __SSE4_1__
-    std::cout << "SSE4.1: YES\n";
-#else
-    std::cout << "SSE4.1: NO\n";
-#endif
-
-#ifdef __AVX__
-    std::cout << "AVX:   YES\n";
-#else
-    std::cout << "AVX:   NO\n";
-#endif
+    // Odd length: the tail goes through the masked / scalar path
+    const size_t n = 1003;
+    std::vector<float> a(n, 1.5f), b(n, 2.0f), r(n);
 
-#ifdef __AVX2__
-    std::cout << "AVX2:  YES\n";
-#else
-    std::cout << "AVX2:  NO\n";
-#endif
+    simd::add_arrays(a.data(), b.data(), r.data(), n);
+    float dot = simd::dot_product(a.data(), b.data(), n);
+    simd::axpy(2.0f, a.data(), r.data(), n);
 
-#ifdef __AVX512F__
-    std::cout << "AVX512: YES\n";
-#else
-    std::cout << "AVX512: NO\n";
-#endif
+    std::cout << "simd::add_arrays / dot_product / axpy on " << n << " floats via "
+              << simd::isa_name(simd::active_kernels().level) << "\n";
+    std::cout << "  r[0] = " << r[0] << ", r[" << n - 1 << "] = " << r[n - 1]
+              << " (expected 6.5), dot = " << dot << " (expected " << 3.0 * n << ")\n";
 }
 
 int main() {
@@ -351,40 +387,35 @@ int main() {
     std::cout << "===================================\n";
 
     print_cpu_features();
+    verify_kernels();
+    demo_dispatched_api();
 
-    // Create test data
-    const size_t array_size = 1000000;  // 1 million floats
-    const size_t iterations = 1000;
+    // L1-resident arrays so the kernels are compute bound rather than
+    // memory bound; the odd length exercises the tail paths on every call
+    const size_t array_size = 2003;
+    const size_t iterations = 200000;
 
     std::cout << "\nArray size: " << array_size << " floats ("
-              << (array_size * sizeof(float) / 1024 / 1024) << " MB)\n";
+              << (array_size * sizeof(float)) << " bytes per array)\n";
     std::cout << "Iterations: " << iterations << "\n";
 
-    std::vector<float> a(array_size);
-    std::vector<float> b(array_size);
-
-    // Initialize with random data
-    std::random_device rd;
-    std::mt19937 gen(42);  // Fixed seed for reproducibility
-    std::uniform_real_distribution<float> dis(-100.0f, 100.0f);
-
-    for (size_t i = 0; i < array_size; ++i) {
-        a[i] = dis(gen);
-        b[i] = dis(gen);
-    }
+    run_benchmarks(array_size, iterations);
 
-    // Run benchmarks
-    benchmark_add_arrays(a, b, iterations);
-    benchmark_dot_product(a, b, iterations);
-    benchmark_scalar_multiply(a, iterations);
+    benchmark_reduction_throughput(array_size, iterations / 4);
+    benchmark_reduction_accuracy();
 
     std::cout << "\n" << std::string(60, '=') << "\n";
     std::cout << "Key Takeaways:\n";
     std::cout << "- SSE provides ~4x speedup (4 floats per instruction)\n";
     std::cout << "- AVX provides ~8x speedup (8 floats per instruction)\n";
-    std::cout << "- SIMD is crucial for performance-critical code\n";
-    std::cout << "- Handle remainder elements after SIMD loop\n";
+    std::cout << "- Detect the CPU at runtime: one binary, best kernels on every host\n";
+    std::cout << "- Resolve function pointers once; the per-call cost is one indirect call\n";
+    std::cout << "- Handle remainder elements after SIMD loop (masks on AVX2/AVX-512)\n";
+    std::cout << "- FMA fuses multiply and add: fewer instructions, one rounding\n";
     std::cout << "- Ensure data alignment for best performance\n";
+    std::cout << "- Independent accumulators hide add latency in reductions\n";
+    std::cout << "- Pairwise, compensated or double accumulation keep large sums accurate\n";
+    std::cout << "- Set SIMD_ISA=sse2|avx2|avx512 to cap the dispatched level\n";
     std::cout << std::string(60, '=') << "\n";
 
     return 0;
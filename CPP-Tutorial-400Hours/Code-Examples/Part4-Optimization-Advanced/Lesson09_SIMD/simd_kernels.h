@@ -0,0 +1,612 @@
+/*
+ * SIMD Kernels
+ * Small vector-math library with runtime CPU dispatch: every kernel is
+ * built for scalar, SSE2, AVX2+FMA and AVX-512, each ISA's code is
+ * compiled with a per-function target attribute, and CPUID picks the best
+ * table of function pointers once at startup. The binary itself needs no
+ * -mavx2/-march=native, so one artifact runs on old and new hosts alike.
+ */
+
+#ifndef SIMD_KERNELS_H
+#define SIMD_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define SIMD_X86 1
+    #ifdef _MSC_VER
+        #include <intrin.h>
+    #else
+        #include <cpuid.h>
+        #include <immintrin.h>
+    #endif
+#endif
+
+// GCC/Clang compile each kernel for its own ISA; MSVC allows intrinsics
+// for any ISA without flags
+#if defined(__GNUC__) || defined(__clang__)
+    #define SIMD_TARGET(isa) __attribute__((target(isa)))
+#else
+    #define SIMD_TARGET(isa)
+#endif
+
+// The scalar kernels are the one-float-at-a-time reference every speedup
+// is measured against. Left alone, -O3 auto-vectorizes them with SSE2 and
+// the "scalar" column is really a second SSE2 build.
+#if defined(__clang__)
+    #define SIMD_SCALAR_FUNCTION
+    #define SIMD_SCALAR_LOOP _Pragma("clang loop vectorize(disable) interleave(disable)")
+#elif defined(__GNUC__)
+    #define SIMD_SCALAR_FUNCTION __attribute__((optimize("no-tree-vectorize")))
+    #define SIMD_SCALAR_LOOP
+#elif defined(_MSC_VER)
+    #define SIMD_SCALAR_FUNCTION
+    #define SIMD_SCALAR_LOOP __pragma(loop(no_vector))
+#else
+    #define SIMD_SCALAR_FUNCTION
+    #define SIMD_SCALAR_LOOP
+#endif
+
+namespace simd {
+
+// Dispatch levels, each a superset of the one before
+enum class IsaLevel {
+    Scalar,
+    SSE2,       // x86-64 baseline
+    AVX2,       // AVX2 + FMA (x86-64-v3)
+    AVX512      // AVX-512F (x86-64-v4)
+};
+
+inline const char* isa_name(IsaLevel level) {
+    switch (level) {
+        case IsaLevel::Scalar: return "Scalar";
+        case IsaLevel::SSE2: return "SSE2";
+        case IsaLevel::AVX2: return "AVX2+FMA";
+        case IsaLevel::AVX512: return "AVX-512";
+    }
+    return "unknown";
+}
+
+// ========== CPU Feature Detection ==========
+
+struct CpuFeatures {
+    bool sse2 = false;
+    bool sse41 = false;
+    bool avx = false;
+    bool avx2 = false;
+    bool fma = false;
+    bool avx512f = false;
+    bool os_avx = false;       // OS saves YMM state (XCR0)
+    bool os_avx512 = false;    // OS saves ZMM and mask state
+
+    IsaLevel best_level() const {
+        if (avx512f && os_avx512 && avx2 && fma) return IsaLevel::AVX512;
+        if (avx2 && fma && os_avx) return IsaLevel::AVX2;
+        if (sse2) return IsaLevel::SSE2;
+        return IsaLevel::Scalar;
+    }
+
+    bool supports(IsaLevel level) const {
+        return static_cast<int>(level) <= static_cast<int>(best_level());
+    }
+};
+
+#ifdef SIMD_X86
+namespace detail {
+
+inline void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4]) {
+#ifdef _MSC_VER
+    int out[4];
+    __cpuidex(out, static_cast<int>(leaf), static_cast<int>(subleaf));
+    for (int i = 0; i < 4; ++i) regs[i] = static_cast<uint32_t>(out[i]);
+#else
+    if (!__get_cpuid_count(leaf, subleaf, &regs[0], &regs[1], &regs[2], &regs[3])) {
+        regs[0] = regs[1] = regs[2] = regs[3] = 0;
+    }
+#endif
+}
+
+// XCR0: which register states the OS saves on a context switch
+inline uint64_t xgetbv0() {
+#ifdef _MSC_VER
+    return _xgetbv(0);
+#else
+    uint32_t eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+}
+
+} // namespace detail
+#endif
+
+inline CpuFeatures detect_cpu_features() {
+    CpuFeatures f;
+#ifdef SIMD_X86
+    uint32_t regs[4];
+    detail::cpuid(0, 0, regs);
+    const uint32_t max_leaf = regs[0];
+
+    detail::cpuid(1, 0, regs);
+    f.sse2 = (regs[3] >> 26) & 1;
+    f.sse41 = (regs[2] >> 19) & 1;
+    f.fma = (regs[2] >> 12) & 1;
+    f.avx = (regs[2] >> 28) & 1;
+    const bool osxsave = (regs[2] >> 27) & 1;
+
+    if (max_leaf >= 7) {
+        detail::cpuid(7, 0, regs);
+        f.avx2 = (regs[1] >> 5) & 1;
+        f.avx512f = (regs[1] >> 16) & 1;
+    }
+
+    if (osxsave) {
+        uint64_t xcr0 = detail::xgetbv0();
+        f.os_avx = (xcr0 & 0x6) == 0x6;          // XMM | YMM
+        f.os_avx512 = (xcr0 & 0xE6) == 0xE6;     // + opmask, ZMM_Hi256, Hi16_ZMM
+    }
+#endif
+    return f;
+}
+
+// ========== Kernels ==========
+// Each ISA provides the same four kernels, templated on whether all
+// pointers are aligned to the vector width. Tails shorter than a vector
+// are finished with a scalar loop (SSE2) or masked loads/stores (AVX2,
+// AVX-512), so any n is valid.
+
+namespace detail {
+
+// ---- Scalar ----
+
+SIMD_SCALAR_FUNCTION inline void add_scalar(const float* a, const float* b, float* result, size_t n) {
+    SIMD_SCALAR_LOOP
+    for (size_t i = 0; i < n; ++i) {
+        result[i] = a[i] + b[i];
+    }
+}
+
+SIMD_SCALAR_FUNCTION inline float dot_scalar(const float* a, const float* b, size_t n) {
+    float sum = 0.0f;
+    SIMD_SCALAR_LOOP
+    for (size_t i = 0; i < n; ++i) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+SIMD_SCALAR_FUNCTION inline void scale_scalar(const float* a, float scalar, float* result, size_t n) {
+    SIMD_SCALAR_LOOP
+    for (size_t i = 0; i < n; ++i) {
+        result[i] = a[i] * scalar;
+    }
+}
+
+SIMD_SCALAR_FUNCTION inline void axpy_scalar(float alpha, const float* x, float* y, size_t n) {
+    SIMD_SCALAR_LOOP
+    for (size_t i = 0; i < n; ++i) {
+        y[i] = alpha * x[i] + y[i];
+    }
+}
+
+#ifdef SIMD_X86
+
+// ---- SSE2 (128-bit, 4 floats) ----
+
+template<bool Aligned>
+SIMD_TARGET("sse2") inline __m128 load_sse(const float* p) {
+    if constexpr (Aligned) return _mm_load_ps(p);
+    else return _mm_loadu_ps(p);
+}
+
+template<bool Aligned>
+SIMD_TARGET("sse2") inline void store_sse(float* p, __m128 v) {
+    if constexpr (Aligned) _mm_store_ps(p, v);
+    else _mm_storeu_ps(p, v);
+}
+
+template<bool Aligned>
+SIMD_TARGET("sse2") void add_sse2(const float* a, const float* b, float* result, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        store_sse<Aligned>(result + i, _mm_add_ps(load_sse<Aligned>(a + i), load_sse<Aligned>(b + i)));
+    }
+    for (; i < n; ++i) {
+        result[i] = a[i] + b[i];
+    }
+}
+
+template<bool Aligned>
+SIMD_TARGET("sse2") float dot_sse2(const float* a, const float* b, size_t n) {
+    // Two accumulators hide part of the add latency
+    __m128 sum0 = _mm_setzero_ps();
+    __m128 sum1 = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        sum0 = _mm_add_ps(sum0, _mm_mul_ps(load_sse<Aligned>(a + i), load_sse<Aligned>(b + i)));
+        sum1 = _mm_add_ps(sum1, _mm_mul_ps(load_sse<Aligned>(a + i + 4), load_sse<Aligned>(b + i + 4)));
+    }
+    for (; i + 4 <= n; i += 4) {
+        sum0 = _mm_add_ps(sum0, _mm_mul_ps(load_sse<Aligned>(a + i), load_sse<Aligned>(b + i)));
+    }
+
+    __m128 v = _mm_add_ps(sum0, sum1);
+    v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 0x55));
+    float sum = _mm_cvtss_f32(v);
+
+    for (; i < n; ++i) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+template<bool Aligned>
+SIMD_TARGET("sse2") void scale_sse2(const float* a, float scalar, float* result, size_t n) {
+    const __m128 vscalar = _mm_set1_ps(scalar);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        store_sse<Aligned>(result + i, _mm_mul_ps(load_sse<Aligned>(a + i), vscalar));
+    }
+    for (; i < n; ++i) {
+        result[i] = a[i] * scalar;
+    }
+}
+
+template<bool Aligned>
+SIMD_TARGET("sse2") void axpy_sse2(float alpha, const float* x, float* y, size_t n) {
+    const __m128 valpha = _mm_set1_ps(alpha);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 v = _mm_add_ps(_mm_mul_ps(valpha, load_sse<Aligned>(x + i)), load_sse<Aligned>(y + i));
+        store_sse<Aligned>(y + i, v);
+    }
+    for (; i < n; ++i) {
+        y[i] = alpha * x[i] + y[i];
+    }
+}
+
+// ---- AVX2 + FMA (256-bit, 8 floats) ----
+
+template<bool Aligned>
+SIMD_TARGET("avx2,fma") inline __m256 load_avx(const float* p) {
+    if constexpr (Aligned) return _mm256_load_ps(p);
+    else return _mm256_loadu_ps(p);
+}
+
+template<bool Aligned>
+SIMD_TARGET("avx2,fma") inline void store_avx(float* p, __m256 v) {
+    if constexpr (Aligned) _mm256_store_ps(p, v);
+    else _mm256_storeu_ps(p, v);
+}
+
+// Lane mask with the first `count` (0..8) lanes enabled
+SIMD_TARGET("avx2,fma") inline __m256i tail_mask_avx(size_t count) {
+    static const int32_t table[16] = {-1, -1, -1, -1, -1, -1, -1, -1, 0, 0, 0, 0, 0, 0, 0, 0};
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(table + 8 - count));
+}
+
+SIMD_TARGET("avx2,fma") inline float horizontal_sum_avx(__m256 v) {
+    __m128 lo = _mm256_castps256_ps128(v);
+    __m128 hi = _mm256_extractf128_ps(v, 1);
+    lo = _mm_add_ps(lo, hi);
+    lo = _mm_add_ps(lo, _mm_movehl_ps(lo, lo));
+    lo = _mm_add_ss(lo, _mm_movehdup_ps(lo));
+    return _mm_cvtss_f32(lo);
+}
+
+template<bool Aligned>
+SIMD_TARGET("avx2,fma") void add_avx2(const float* a, const float* b, float* result, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        store_avx<Aligned>(result + i, _mm256_add_ps(load_avx<Aligned>(a + i), load_avx<Aligned>(b + i)));
+    }
+    if (i < n) {
+        __m256i mask = tail_mask_avx(n - i);
+        __m256 v = _mm256_add_ps(_mm256_maskload_ps(a + i, mask), _mm256_maskload_ps(b + i, mask));
+        _mm256_maskstore_ps(result + i, mask, v);
+    }
+}
+
+template<bool Aligned>
+SIMD_TARGET("avx2,fma") float dot_avx2(const float* a, const float* b, size_t n) {
+    // FMA latency is 4-5 cycles at 2 per cycle: four chains keep it busy
+    __m256 sum0 = _mm256_setzero_ps();
+    __m256 sum1 = _mm256_setzero_ps();
+    __m256 sum2 = _mm256_setzero_ps();
+    __m256 sum3 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        sum0 = _mm256_fmadd_ps(load_avx<Aligned>(a + i), load_avx<Aligned>(b + i), sum0);
+        sum1 = _mm256_fmadd_ps(load_avx<Aligned>(a + i + 8), load_avx<Aligned>(b + i + 8), sum1);
+        sum2 = _mm256_fmadd_ps(load_avx<Aligned>(a + i + 16), load_avx<Aligned>(b + i + 16), sum2);
+        sum3 = _mm256_fmadd_ps(load_avx<Aligned>(a + i + 24), load_avx<Aligned>(b + i + 24), sum3);
+    }
+    for (; i + 8 <= n; i += 8) {
+        sum0 = _mm256_fmadd_ps(load_avx<Aligned>(a + i), load_avx<Aligned>(b + i), sum0);
+    }
+    if (i < n) {
+        __m256i mask = tail_mask_avx(n - i);
+        sum1 = _mm256_fmadd_ps(_mm256_maskload_ps(a + i, mask), _mm256_maskload_ps(b + i, mask), sum1);
+    }
+    return horizontal_sum_avx(_mm256_add_ps(_mm256_add_ps(sum0, sum1), _mm256_add_ps(sum2, sum3)));
+}
+
+template<bool Aligned>
+SIMD_TARGET("avx2,fma") void scale_avx2(const float* a, float scalar, float* result, size_t n) {
+    const __m256 vscalar = _mm256_set1_ps(scalar);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        store_avx<Aligned>(result + i, _mm256_mul_ps(load_avx<Aligned>(a + i), vscalar));
+    }
+    if (i < n) {
+        __m256i mask = tail_mask_avx(n - i);
+        _mm256_maskstore_ps(result + i, mask, _mm256_mul_ps(_mm256_maskload_ps(a + i, mask), vscalar));
+    }
+}
+
+template<bool Aligned>
+SIMD_TARGET("avx2,fma") void axpy_avx2(float alpha, const float* x, float* y, size_t n) {
+    const __m256 valpha = _mm256_set1_ps(alpha);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        store_avx<Aligned>(y + i, _mm256_fmadd_ps(valpha, load_avx<Aligned>(x + i), load_avx<Aligned>(y + i)));
+    }
+    if (i < n) {
+        __m256i mask = tail_mask_avx(n - i);
+        __m256 v = _mm256_fmadd_ps(valpha, _mm256_maskload_ps(x + i, mask), _mm256_maskload_ps(y + i, mask));
+        _mm256_maskstore_ps(y + i, mask, v);
+    }
+}
+
+// ---- AVX-512F (512-bit, 16 floats) ----
+
+template<bool Aligned>
+SIMD_TARGET("avx512f") inline __m512 load_avx512(const float* p) {
+    if constexpr (Aligned) return _mm512_load_ps(p);
+    else return _mm512_loadu_ps(p);
+}
+
+template<bool Aligned>
+SIMD_TARGET("avx512f") inline void store_avx512(float* p, __m512 v) {
+    if constexpr (Aligned) _mm512_store_ps(p, v);
+    else _mm512_storeu_ps(p, v);
+}
+
+SIMD_TARGET("avx512f") inline __mmask16 tail_mask_avx512(size_t count) {
+    return static_cast<__mmask16>((1u << count) - 1);
+}
+
+// Through memory: GCC 12's 512-bit extract/cast intrinsics (and
+// _mm512_reduce_add_ps) trip a bogus -Wuninitialized in its own headers
+SIMD_TARGET("avx512f") inline float horizontal_sum_avx512(__m512 v) {
+    alignas(64) float lanes[16];
+    _mm512_store_ps(lanes, v);
+    float sum = 0.0f;
+    for (int i = 0; i < 16; ++i) {
+        sum += lanes[i];
+    }
+    return sum;
+}
+
+template<bool Aligned>
+SIMD_TARGET("avx512f") void add_avx512(const float* a, const float* b, float* result, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        store_avx512<Aligned>(result + i, _mm512_add_ps(load_avx512<Aligned>(a + i), load_avx512<Aligned>(b + i)));
+    }
+    if (i < n) {
+        __mmask16 mask = tail_mask_avx512(n - i);
+        __m512 v = _mm512_add_ps(_mm512_maskz_loadu_ps(mask, a + i), _mm512_maskz_loadu_ps(mask, b + i));
+        _mm512_mask_storeu_ps(result + i, mask, v);
+    }
+}
+
+template<bool Aligned>
+SIMD_TARGET("avx512f") float dot_avx512(const float* a, const float* b, size_t n) {
+    __m512 sum0 = _mm512_setzero_ps();
+    __m512 sum1 = _mm512_setzero_ps();
+    __m512 sum2 = _mm512_setzero_ps();
+    __m512 sum3 = _mm512_setzero_ps();
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        sum0 = _mm512_fmadd_ps(load_avx512<Aligned>(a + i), load_avx512<Aligned>(b + i), sum0);
+        sum1 = _mm512_fmadd_ps(load_avx512<Aligned>(a + i + 16), load_avx512<Aligned>(b + i + 16), sum1);
+        sum2 = _mm512_fmadd_ps(load_avx512<Aligned>(a + i + 32), load_avx512<Aligned>(b + i + 32), sum2);
+        sum3 = _mm512_fmadd_ps(load_avx512<Aligned>(a + i + 48), load_avx512<Aligned>(b + i + 48), sum3);
+    }
+    for (; i + 16 <= n; i += 16) {
+        sum0 = _mm512_fmadd_ps(load_avx512<Aligned>(a + i), load_avx512<Aligned>(b + i), sum0);
+    }
+    if (i < n) {
+        __mmask16 mask = tail_mask_avx512(n - i);
+        sum1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, a + i), _mm512_maskz_loadu_ps(mask, b + i), sum1);
+    }
+    return horizontal_sum_avx512(_mm512_add_ps(_mm512_add_ps(sum0, sum1), _mm512_add_ps(sum2, sum3)));
+}
+
+template<bool Aligned>
+SIMD_TARGET("avx512f") void scale_avx512(const float* a, float scalar, float* result, size_t n) {
+    const __m512 vscalar = _mm512_set1_ps(scalar);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        store_avx512<Aligned>(result + i, _mm512_mul_ps(load_avx512<Aligned>(a + i), vscalar));
+    }
+    if (i < n) {
+        __mmask16 mask = tail_mask_avx512(n - i);
+        _mm512_mask_storeu_ps(result + i, mask, _mm512_mul_ps(_mm512_maskz_loadu_ps(mask, a + i), vscalar));
+    }
+}
+
+template<bool Aligned>
+SIMD_TARGET("avx512f") void axpy_avx512(float alpha, const float* x, float* y, size_t n) {
+    const __m512 valpha = _mm512_set1_ps(alpha);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        store_avx512<Aligned>(y + i, _mm512_fmadd_ps(valpha, load_avx512<Aligned>(x + i), load_avx512<Aligned>(y + i)));
+    }
+    if (i < n) {
+        __mmask16 mask = tail_mask_avx512(n - i);
+        __m512 v = _mm512_fmadd_ps(valpha, _mm512_maskz_loadu_ps(mask, x + i), _mm512_maskz_loadu_ps(mask, y + i));
+        _mm512_mask_storeu_ps(y + i, mask, v);
+    }
+}
+
+#endif // SIMD_X86
+
+} // namespace detail
+
+// ========== Dispatch ==========
+
+// One ISA's kernels. The *_aligned entries require every pointer to be
+// aligned to `alignment` bytes.
+struct KernelTable {
+    IsaLevel level;
+    size_t alignment;
+
+    void (*add)(const float* a, const float* b, float* result, size_t n);
+    void (*add_aligned)(const float* a, const float* b, float* result, size_t n);
+    float (*dot)(const float* a, const float* b, size_t n);
+    float (*dot_aligned)(const float* a, const float* b, size_t n);
+    void (*scale)(const float* a, float scalar, float* result, size_t n);
+    void (*scale_aligned)(const float* a, float scalar, float* result, size_t n);
+    void (*axpy)(float alpha, const float* x, float* y, size_t n);
+    void (*axpy_aligned)(float alpha, const float* x, float* y, size_t n);
+};
+
+// Kernels of a specific level; the caller must check the CPU supports it
+inline KernelTable kernels_for(IsaLevel level) {
+    using namespace detail;
+    switch (level) {
+#ifdef SIMD_X86
+        case IsaLevel::AVX512:
+            return {level, 64,
+                    add_avx512<false>, add_avx512<true>,
+                    dot_avx512<false>, dot_avx512<true>,
+                    scale_avx512<false>, scale_avx512<true>,
+                    axpy_avx512<false>, axpy_avx512<true>};
+        case IsaLevel::AVX2:
+            return {level, 32,
+                    add_avx2<false>, add_avx2<true>,
+                    dot_avx2<false>, dot_avx2<true>,
+                    scale_avx2<false>, scale_avx2<true>,
+                    axpy_avx2<false>, axpy_avx2<true>};
+        case IsaLevel::SSE2:
+            return {level, 16,
+                    add_sse2<false>, add_sse2<true>,
+                    dot_sse2<false>, dot_sse2<true>,
+                    scale_sse2<false>, scale_sse2<true>,
+                    axpy_sse2<false>, axpy_sse2<true>};
+#endif
+        default:
+            return {IsaLevel::Scalar, alignof(float),
+                    add_scalar, add_scalar, dot_scalar, dot_scalar,
+                    scale_scalar, scale_scalar, axpy_scalar, axpy_scalar};
+    }
+}
+
+inline const CpuFeatures& cpu_features() {
+    static const CpuFeatures features = detect_cpu_features();
+    return features;
+}
+
+// Level the dispatcher uses: the best the CPU supports, capped by the
+// SIMD_ISA environment variable (scalar, sse2, avx2, avx512) so a fleet
+// can pin a lower level, e.g. to rule out AVX-512 frequency drops
+inline IsaLevel selected_level() {
+    IsaLevel level = cpu_features().best_level();
+    if (const char* env = std::getenv("SIMD_ISA")) {
+        IsaLevel requested = level;
+        if (std::strcmp(env, "scalar") == 0) requested = IsaLevel::Scalar;
+        else if (std::strcmp(env, "sse2") == 0) requested = IsaLevel::SSE2;
+        else if (std::strcmp(env, "avx2") == 0) requested = IsaLevel::AVX2;
+        else if (std::strcmp(env, "avx512") == 0) requested = IsaLevel::AVX512;
+        if (static_cast<int>(requested) < static_cast<int>(level)) level = requested;
+    }
+    return level;
+}
+
+// Resolved once, on first use (thread-safe static initialization)
+inline const KernelTable& active_kernels() {
+    static const KernelTable table = kernels_for(selected_level());
+    return table;
+}
+
+namespace detail {
+
+inline bool all_aligned(size_t alignment, const void* a, const void* b = nullptr,
+                        const void* c = nullptr) {
+    uintptr_t bits = reinterpret_cast<uintptr_t>(a) | reinterpret_cast<uintptr_t>(b) |
+                     reinterpret_cast<uintptr_t>(c);
+    return (bits & (alignment - 1)) == 0;
+}
+
+} // namespace detail
+
+// ========== Public API ==========
+// Dispatch through the active table, taking the aligned variant whenever
+// the pointers allow it
+
+inline void add_arrays(const float* a, const float* b, float* result, size_t n) {
+    const KernelTable& k = active_kernels();
+    if (detail::all_aligned(k.alignment, a, b, result)) k.add_aligned(a, b, result, n);
+    else k.add(a, b, result, n);
+}
+
+inline float dot_product(const float* a, const float* b, size_t n) {
+    const KernelTable& k = active_kernels();
+    return detail::all_aligned(k.alignment, a, b) ? k.dot_aligned(a, b, n) : k.dot(a, b, n);
+}
+
+inline void multiply_scalar(const float* a, float scalar, float* result, size_t n) {
+    const KernelTable& k = active_kernels();
+    if (detail::all_aligned(k.alignment, a, result)) k.scale_aligned(a, scalar, result, n);
+    else k.scale(a, scalar, result, n);
+}
+
+// y = alpha * x + y (fused on AVX2 and AVX-512)
+inline void axpy(float alpha, const float* x, float* y, size_t n) {
+    const KernelTable& k = active_kernels();
+    if (detail::all_aligned(k.alignment, x, y)) k.axpy_aligned(alpha, x, y, n);
+    else k.axpy(alpha, x, y, n);
+}
+
+// ========== Aligned Storage ==========
+
+// 64-byte alignment suits every level (and a cache line)
+template<typename T, size_t Alignment = 64>
+struct AlignedAllocator {
+    using value_type = T;
+
+    template<typename U>
+    struct rebind { using other = AlignedAllocator<U, Alignment>; };
+
+    AlignedAllocator() = default;
+    template<typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+    }
+
+    void deallocate(T* p, size_t) {
+        ::operator delete(p, std::align_val_t(Alignment));
+    }
+
+    template<typename U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const { return true; }
+    template<typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment>&) const { return false; }
+};
+
+template<typename T>
+using aligned_vector = std::vector<T, AlignedAllocator<T>>;
+
+} // namespace simd
+
+#endif // SIMD_KERNELS_H
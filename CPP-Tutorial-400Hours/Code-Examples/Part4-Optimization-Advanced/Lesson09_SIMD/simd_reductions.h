@@ -0,0 +1,602 @@
+/*
+ * SIMD Reductions
+ * sum, dot and norm over float arrays with a choice of accuracy:
+ *   Fast         several independent vector accumulators (hides add/FMA
+ *                latency), error grows with n
+ *   Pairwise     Fast on blocks, blocks combined in a binary tree: error
+ *                grows with log n at almost the same speed
+ *   Compensated  Neumaier (improved Kahan) summation in every lane; with
+ *                FMA the rounding error of each product is captured too
+ *   Double       float inputs, double accumulators (mixed precision)
+ * Dispatched per ISA like simd_kernels.h.
+ */
+
+#ifndef SIMD_REDUCTIONS_H
+#define SIMD_REDUCTIONS_H
+
+#include <cmath>
+#include <cstddef>
+
+#include "simd_kernels.h"
+
+namespace simd {
+
+enum class Accumulation {
+    Fast,
+    Pairwise,
+    Compensated,
+    Double
+};
+
+inline const char* accumulation_name(Accumulation mode) {
+    switch (mode) {
+        case Accumulation::Fast: return "Fast";
+        case Accumulation::Pairwise: return "Pairwise";
+        case Accumulation::Compensated: return "Compensated";
+        case Accumulation::Double: return "Double";
+    }
+    return "unknown";
+}
+
+namespace detail {
+
+// Independent accumulators in the fast sum: add latency (4 cycles) times
+// two adds per cycle. The dot product is load bound at two loads per FMA,
+// so the four in simd_kernels.h already saturate it.
+constexpr int kSumAccumulators = 8;
+
+// ---- Scalar ----
+
+inline double sum_fast_scalar(const float* x, size_t n) {
+    float acc[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        for (int k = 0; k < 4; ++k) acc[k] += x[i + k];
+    }
+    for (; i < n; ++i) {
+        acc[0] += x[i];
+    }
+    return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+}
+
+inline void neumaier_add(float& sum, float& compensation, float x) {
+    float t = sum + x;
+    if (std::fabs(sum) >= std::fabs(x)) compensation += (sum - t) + x;
+    else compensation += (x - t) + sum;
+    sum = t;
+}
+
+inline double sum_compensated_scalar(const float* x, size_t n) {
+    float sum = 0.0f, c = 0.0f;
+    for (size_t i = 0; i < n; ++i) {
+        neumaier_add(sum, c, x[i]);
+    }
+    return static_cast<double>(sum) + c;
+}
+
+inline double dot_compensated_scalar(const float* a, const float* b, size_t n) {
+    float sum = 0.0f, c = 0.0f;
+    for (size_t i = 0; i < n; ++i) {
+        float p = a[i] * b[i];
+        neumaier_add(sum, c, p);
+        c += std::fma(a[i], b[i], -p);    // exact rounding error of the product
+    }
+    return static_cast<double>(sum) + c;
+}
+
+inline double sum_double_scalar(const float* x, size_t n) {
+    double sum = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        sum += x[i];
+    }
+    return sum;
+}
+
+inline double dot_double_scalar(const float* a, const float* b, size_t n) {
+    double sum = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        sum += static_cast<double>(a[i]) * b[i];
+    }
+    return sum;
+}
+
+#ifdef SIMD_X86
+
+// ---- SSE2 ----
+
+// One Neumaier step per lane: whichever of sum and x is larger keeps its
+// low-order bits in the compensation
+SIMD_TARGET("sse2") inline void neumaier_sse(__m128& sum, __m128& c, __m128 x) {
+    const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    __m128 t = _mm_add_ps(sum, x);
+    __m128 sum_bigger = _mm_cmpge_ps(_mm_and_ps(sum, abs_mask), _mm_and_ps(x, abs_mask));
+    __m128 if_sum = _mm_add_ps(_mm_sub_ps(sum, t), x);
+    __m128 if_x = _mm_add_ps(_mm_sub_ps(x, t), sum);
+    c = _mm_add_ps(c, _mm_or_ps(_mm_and_ps(sum_bigger, if_sum), _mm_andnot_ps(sum_bigger, if_x)));
+    sum = t;
+}
+
+SIMD_TARGET("sse2") inline double lanes_to_double(__m128 sum, __m128 c) {
+    alignas(16) float s[4], e[4];
+    _mm_store_ps(s, sum);
+    _mm_store_ps(e, c);
+    return ((double(s[0]) + s[1]) + (double(s[2]) + s[3])) + ((double(e[0]) + e[1]) + (double(e[2]) + e[3]));
+}
+
+SIMD_TARGET("sse2") double sum_fast_sse2(const float* x, size_t n) {
+    __m128 acc[kSumAccumulators];
+    for (__m128& a : acc) a = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 4 * kSumAccumulators <= n; i += 4 * kSumAccumulators) {
+        for (int k = 0; k < kSumAccumulators; ++k) {
+            acc[k] = _mm_add_ps(acc[k], _mm_loadu_ps(x + i + 4 * k));
+        }
+    }
+    for (; i + 4 <= n; i += 4) {
+        acc[0] = _mm_add_ps(acc[0], _mm_loadu_ps(x + i));
+    }
+    for (int width = kSumAccumulators / 2; width > 0; width /= 2) {
+        for (int k = 0; k < width; ++k) acc[k] = _mm_add_ps(acc[k], acc[k + width]);
+    }
+    __m128 v = _mm_add_ps(acc[0], _mm_movehl_ps(acc[0], acc[0]));
+    v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 0x55));
+    float sum = _mm_cvtss_f32(v);
+    for (; i < n; ++i) {
+        sum += x[i];
+    }
+    return sum;
+}
+
+SIMD_TARGET("sse2") double sum_compensated_sse2(const float* x, size_t n) {
+    __m128 s0 = _mm_setzero_ps(), c0 = _mm_setzero_ps();
+    __m128 s1 = _mm_setzero_ps(), c1 = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        neumaier_sse(s0, c0, _mm_loadu_ps(x + i));
+        neumaier_sse(s1, c1, _mm_loadu_ps(x + i + 4));
+    }
+    for (; i + 4 <= n; i += 4) {
+        neumaier_sse(s0, c0, _mm_loadu_ps(x + i));
+    }
+    float sum = 0.0f, c = 0.0f;
+    for (; i < n; ++i) {
+        neumaier_add(sum, c, x[i]);
+    }
+    return lanes_to_double(s0, c0) + lanes_to_double(s1, c1) + sum + c;
+}
+
+// No FMA on SSE2: only the summation is compensated, not the products
+SIMD_TARGET("sse2") double dot_compensated_sse2(const float* a, const float* b, size_t n) {
+    __m128 s0 = _mm_setzero_ps(), c0 = _mm_setzero_ps();
+    __m128 s1 = _mm_setzero_ps(), c1 = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        neumaier_sse(s0, c0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        neumaier_sse(s1, c1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    for (; i + 4 <= n; i += 4) {
+        neumaier_sse(s0, c0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    }
+    float sum = 0.0f, c = 0.0f;
+    for (; i < n; ++i) {
+        neumaier_add(sum, c, a[i] * b[i]);
+    }
+    return lanes_to_double(s0, c0) + lanes_to_double(s1, c1) + sum + c;
+}
+
+SIMD_TARGET("sse2") inline double horizontal_sum_pd(__m128d v) {
+    return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+SIMD_TARGET("sse2") double sum_double_sse2(const float* x, size_t n) {
+    __m128d acc[4] = {_mm_setzero_pd(), _mm_setzero_pd(), _mm_setzero_pd(), _mm_setzero_pd()};
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128 v0 = _mm_loadu_ps(x + i);
+        __m128 v1 = _mm_loadu_ps(x + i + 4);
+        acc[0] = _mm_add_pd(acc[0], _mm_cvtps_pd(v0));
+        acc[1] = _mm_add_pd(acc[1], _mm_cvtps_pd(_mm_movehl_ps(v0, v0)));
+        acc[2] = _mm_add_pd(acc[2], _mm_cvtps_pd(v1));
+        acc[3] = _mm_add_pd(acc[3], _mm_cvtps_pd(_mm_movehl_ps(v1, v1)));
+    }
+    double sum = horizontal_sum_pd(_mm_add_pd(_mm_add_pd(acc[0], acc[1]), _mm_add_pd(acc[2], acc[3])));
+    for (; i < n; ++i) {
+        sum += x[i];
+    }
+    return sum;
+}
+
+// Widens 4 floats to two pairs of doubles and accumulates their products
+SIMD_TARGET("sse2") inline void dot_double_step_sse2(__m128d& lo_acc, __m128d& hi_acc, __m128 a, __m128 b) {
+    lo_acc = _mm_add_pd(lo_acc, _mm_mul_pd(_mm_cvtps_pd(a), _mm_cvtps_pd(b)));
+    hi_acc = _mm_add_pd(hi_acc, _mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(a, a)), _mm_cvtps_pd(_mm_movehl_ps(b, b))));
+}
+
+SIMD_TARGET("sse2") double dot_double_sse2(const float* a, const float* b, size_t n) {
+    __m128d acc[4] = {_mm_setzero_pd(), _mm_setzero_pd(), _mm_setzero_pd(), _mm_setzero_pd()};
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        dot_double_step_sse2(acc[0], acc[1], _mm_loadu_ps(a + i), _mm_loadu_ps(b + i));
+        dot_double_step_sse2(acc[2], acc[3], _mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4));
+    }
+    for (; i + 4 <= n; i += 4) {
+        dot_double_step_sse2(acc[0], acc[1], _mm_loadu_ps(a + i), _mm_loadu_ps(b + i));
+    }
+    double sum = horizontal_sum_pd(_mm_add_pd(_mm_add_pd(acc[0], acc[1]), _mm_add_pd(acc[2], acc[3])));
+    for (; i < n; ++i) {
+        sum += static_cast<double>(a[i]) * b[i];
+    }
+    return sum;
+}
+
+// ---- AVX2 + FMA ----
+
+SIMD_TARGET("avx2,fma") inline void neumaier_avx(__m256& sum, __m256& c, __m256 x) {
+    const __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    __m256 t = _mm256_add_ps(sum, x);
+    __m256 sum_bigger = _mm256_cmp_ps(_mm256_and_ps(sum, abs_mask), _mm256_and_ps(x, abs_mask), _CMP_GE_OQ);
+    __m256 if_sum = _mm256_add_ps(_mm256_sub_ps(sum, t), x);
+    __m256 if_x = _mm256_add_ps(_mm256_sub_ps(x, t), sum);
+    c = _mm256_add_ps(c, _mm256_blendv_ps(if_x, if_sum, sum_bigger));
+    sum = t;
+}
+
+SIMD_TARGET("avx2,fma") inline double lanes_to_double(__m256 sum, __m256 c) {
+    alignas(32) float s[8], e[8];
+    _mm256_store_ps(s, sum);
+    _mm256_store_ps(e, c);
+    double total = 0.0;
+    for (int k = 0; k < 8; ++k) total += double(s[k]) + double(e[k]);
+    return total;
+}
+
+SIMD_TARGET("avx2,fma") double sum_fast_avx2(const float* x, size_t n) {
+    __m256 acc[kSumAccumulators];
+    for (__m256& a : acc) a = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 * kSumAccumulators <= n; i += 8 * kSumAccumulators) {
+        for (int k = 0; k < kSumAccumulators; ++k) {
+            acc[k] = _mm256_add_ps(acc[k], _mm256_loadu_ps(x + i + 8 * k));
+        }
+    }
+    for (; i + 8 <= n; i += 8) {
+        acc[0] = _mm256_add_ps(acc[0], _mm256_loadu_ps(x + i));
+    }
+    if (i < n) {
+        acc[1] = _mm256_add_ps(acc[1], _mm256_maskload_ps(x + i, tail_mask_avx(n - i)));
+    }
+    for (int width = kSumAccumulators / 2; width > 0; width /= 2) {
+        for (int k = 0; k < width; ++k) acc[k] = _mm256_add_ps(acc[k], acc[k + width]);
+    }
+    return horizontal_sum_avx(acc[0]);
+}
+
+SIMD_TARGET("avx2,fma") double sum_compensated_avx2(const float* x, size_t n) {
+    __m256 s0 = _mm256_setzero_ps(), c0 = _mm256_setzero_ps();
+    __m256 s1 = _mm256_setzero_ps(), c1 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        neumaier_avx(s0, c0, _mm256_loadu_ps(x + i));
+        neumaier_avx(s1, c1, _mm256_loadu_ps(x + i + 8));
+    }
+    for (; i + 8 <= n; i += 8) {
+        neumaier_avx(s0, c0, _mm256_loadu_ps(x + i));
+    }
+    if (i < n) {
+        neumaier_avx(s1, c1, _mm256_maskload_ps(x + i, tail_mask_avx(n - i)));
+    }
+    return lanes_to_double(s0, c0) + lanes_to_double(s1, c1);
+}
+
+// Dot2 (Ogita, Rump, Oishi): fmsub recovers each product's rounding error
+// exactly, and the compensated sum absorbs it
+SIMD_TARGET("avx2,fma") inline void dot2_step_avx(__m256& sum, __m256& c, __m256 a, __m256 b) {
+    __m256 p = _mm256_mul_ps(a, b);
+    c = _mm256_add_ps(c, _mm256_fmsub_ps(a, b, p));
+    neumaier_avx(sum, c, p);
+}
+
+SIMD_TARGET("avx2,fma") double dot_compensated_avx2(const float* a, const float* b, size_t n) {
+    __m256 s0 = _mm256_setzero_ps(), c0 = _mm256_setzero_ps();
+    __m256 s1 = _mm256_setzero_ps(), c1 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        dot2_step_avx(s0, c0, _mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+        dot2_step_avx(s1, c1, _mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8));
+    }
+    for (; i + 8 <= n; i += 8) {
+        dot2_step_avx(s0, c0, _mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+    }
+    if (i < n) {
+        __m256i mask = tail_mask_avx(n - i);
+        dot2_step_avx(s1, c1, _mm256_maskload_ps(a + i, mask), _mm256_maskload_ps(b + i, mask));
+    }
+    return lanes_to_double(s0, c0) + lanes_to_double(s1, c1);
+}
+
+SIMD_TARGET("avx2,fma") inline double horizontal_sum_avx_pd(__m256d v) {
+    __m128d lo = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(lo, _mm_unpackhi_pd(lo, lo)));
+}
+
+SIMD_TARGET("avx2,fma") double sum_double_avx2(const float* x, size_t n) {
+    __m256d acc[4] = {_mm256_setzero_pd(), _mm256_setzero_pd(), _mm256_setzero_pd(), _mm256_setzero_pd()};
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        for (int k = 0; k < 4; ++k) {
+            acc[k] = _mm256_add_pd(acc[k], _mm256_cvtps_pd(_mm_loadu_ps(x + i + 4 * k)));
+        }
+    }
+    for (; i + 4 <= n; i += 4) {
+        acc[0] = _mm256_add_pd(acc[0], _mm256_cvtps_pd(_mm_loadu_ps(x + i)));
+    }
+    double sum = horizontal_sum_avx_pd(_mm256_add_pd(_mm256_add_pd(acc[0], acc[1]), _mm256_add_pd(acc[2], acc[3])));
+    for (; i < n; ++i) {
+        sum += x[i];
+    }
+    return sum;
+}
+
+SIMD_TARGET("avx2,fma") double dot_double_avx2(const float* a, const float* b, size_t n) {
+    __m256d acc[4] = {_mm256_setzero_pd(), _mm256_setzero_pd(), _mm256_setzero_pd(), _mm256_setzero_pd()};
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        for (int k = 0; k < 4; ++k) {
+            __m256d va = _mm256_cvtps_pd(_mm_loadu_ps(a + i + 4 * k));
+            __m256d vb = _mm256_cvtps_pd(_mm_loadu_ps(b + i + 4 * k));
+            acc[k] = _mm256_fmadd_pd(va, vb, acc[k]);
+        }
+    }
+    for (; i + 4 <= n; i += 4) {
+        acc[0] = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm_loadu_ps(a + i)), _mm256_cvtps_pd(_mm_loadu_ps(b + i)), acc[0]);
+    }
+    double sum = horizontal_sum_avx_pd(_mm256_add_pd(_mm256_add_pd(acc[0], acc[1]), _mm256_add_pd(acc[2], acc[3])));
+    for (; i < n; ++i) {
+        sum += static_cast<double>(a[i]) * b[i];
+    }
+    return sum;
+}
+
+// ---- AVX-512F ----
+
+SIMD_TARGET("avx512f") inline void neumaier_avx512(__m512& sum, __m512& c, __m512 x) {
+    __m512 t = _mm512_add_ps(sum, x);
+    __mmask16 sum_bigger = _mm512_cmp_ps_mask(_mm512_abs_ps(sum), _mm512_abs_ps(x), _CMP_GE_OQ);
+    __m512 if_sum = _mm512_add_ps(_mm512_sub_ps(sum, t), x);
+    __m512 if_x = _mm512_add_ps(_mm512_sub_ps(x, t), sum);
+    c = _mm512_add_ps(c, _mm512_mask_blend_ps(sum_bigger, if_x, if_sum));
+    sum = t;
+}
+
+SIMD_TARGET("avx512f") inline double lanes_to_double(__m512 sum, __m512 c) {
+    alignas(64) float s[16], e[16];
+    _mm512_store_ps(s, sum);
+    _mm512_store_ps(e, c);
+    double total = 0.0;
+    for (int k = 0; k < 16; ++k) total += double(s[k]) + double(e[k]);
+    return total;
+}
+
+SIMD_TARGET("avx512f") double sum_fast_avx512(const float* x, size_t n) {
+    __m512 acc[kSumAccumulators];
+    for (__m512& a : acc) a = _mm512_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 * kSumAccumulators <= n; i += 16 * kSumAccumulators) {
+        for (int k = 0; k < kSumAccumulators; ++k) {
+            acc[k] = _mm512_add_ps(acc[k], _mm512_loadu_ps(x + i + 16 * k));
+        }
+    }
+    for (; i + 16 <= n; i += 16) {
+        acc[0] = _mm512_add_ps(acc[0], _mm512_loadu_ps(x + i));
+    }
+    if (i < n) {
+        acc[1] = _mm512_add_ps(acc[1], _mm512_maskz_loadu_ps(tail_mask_avx512(n - i), x + i));
+    }
+    for (int width = kSumAccumulators / 2; width > 0; width /= 2) {
+        for (int k = 0; k < width; ++k) acc[k] = _mm512_add_ps(acc[k], acc[k + width]);
+    }
+    return horizontal_sum_avx512(acc[0]);
+}
+
+SIMD_TARGET("avx512f") double sum_compensated_avx512(const float* x, size_t n) {
+    __m512 s0 = _mm512_setzero_ps(), c0 = _mm512_setzero_ps();
+    __m512 s1 = _mm512_setzero_ps(), c1 = _mm512_setzero_ps();
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        neumaier_avx512(s0, c0, _mm512_loadu_ps(x + i));
+        neumaier_avx512(s1, c1, _mm512_loadu_ps(x + i + 16));
+    }
+    for (; i + 16 <= n; i += 16) {
+        neumaier_avx512(s0, c0, _mm512_loadu_ps(x + i));
+    }
+    if (i < n) {
+        neumaier_avx512(s1, c1, _mm512_maskz_loadu_ps(tail_mask_avx512(n - i), x + i));
+    }
+    return lanes_to_double(s0, c0) + lanes_to_double(s1, c1);
+}
+
+SIMD_TARGET("avx512f") inline void dot2_step_avx512(__m512& sum, __m512& c, __m512 a, __m512 b) {
+    __m512 p = _mm512_mul_ps(a, b);
+    c = _mm512_add_ps(c, _mm512_fmsub_ps(a, b, p));
+    neumaier_avx512(sum, c, p);
+}
+
+SIMD_TARGET("avx512f") double dot_compensated_avx512(const float* a, const float* b, size_t n) {
+    __m512 s0 = _mm512_setzero_ps(), c0 = _mm512_setzero_ps();
+    __m512 s1 = _mm512_setzero_ps(), c1 = _mm512_setzero_ps();
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        dot2_step_avx512(s0, c0, _mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i));
+        dot2_step_avx512(s1, c1, _mm512_loadu_ps(a + i + 16), _mm512_loadu_ps(b + i + 16));
+    }
+    for (; i + 16 <= n; i += 16) {
+        dot2_step_avx512(s0, c0, _mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i));
+    }
+    if (i < n) {
+        __mmask16 mask = tail_mask_avx512(n - i);
+        dot2_step_avx512(s1, c1, _mm512_maskz_loadu_ps(mask, a + i), _mm512_maskz_loadu_ps(mask, b + i));
+    }
+    return lanes_to_double(s0, c0) + lanes_to_double(s1, c1);
+}
+
+SIMD_TARGET("avx512f") inline double horizontal_sum_avx512_pd(__m512d v) {
+    alignas(64) double lanes[8];
+    _mm512_store_pd(lanes, v);
+    return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+}
+
+// 8 floats to 8 doubles. The zero-masked form is the same instruction;
+// GCC 12 warns about the undefined source operand of the plain one.
+SIMD_TARGET("avx512f") inline __m512d widen_avx512(const float* p) {
+    return _mm512_maskz_cvtps_pd(0xFF, _mm256_loadu_ps(p));
+}
+
+SIMD_TARGET("avx512f") double sum_double_avx512(const float* x, size_t n) {
+    __m512d acc[4] = {_mm512_setzero_pd(), _mm512_setzero_pd(), _mm512_setzero_pd(), _mm512_setzero_pd()};
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        for (int k = 0; k < 4; ++k) {
+            acc[k] = _mm512_add_pd(acc[k], widen_avx512(x + i + 8 * k));
+        }
+    }
+    for (; i + 8 <= n; i += 8) {
+        acc[0] = _mm512_add_pd(acc[0], widen_avx512(x + i));
+    }
+    double sum = horizontal_sum_avx512_pd(_mm512_add_pd(_mm512_add_pd(acc[0], acc[1]), _mm512_add_pd(acc[2], acc[3])));
+    for (; i < n; ++i) {
+        sum += x[i];
+    }
+    return sum;
+}
+
+SIMD_TARGET("avx512f") double dot_double_avx512(const float* a, const float* b, size_t n) {
+    __m512d acc[4] = {_mm512_setzero_pd(), _mm512_setzero_pd(), _mm512_setzero_pd(), _mm512_setzero_pd()};
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        for (int k = 0; k < 4; ++k) {
+            __m512d va = widen_avx512(a + i + 8 * k);
+            __m512d vb = widen_avx512(b + i + 8 * k);
+            acc[k] = _mm512_fmadd_pd(va, vb, acc[k]);
+        }
+    }
+    for (; i + 8 <= n; i += 8) {
+        acc[0] = _mm512_fmadd_pd(widen_avx512(a + i), widen_avx512(b + i), acc[0]);
+    }
+    double sum = horizontal_sum_avx512_pd(_mm512_add_pd(_mm512_add_pd(acc[0], acc[1]), _mm512_add_pd(acc[2], acc[3])));
+    for (; i < n; ++i) {
+        sum += static_cast<double>(a[i]) * b[i];
+    }
+    return sum;
+}
+
+#endif // SIMD_X86
+
+} // namespace detail
+
+// ========== Dispatch ==========
+
+// One ISA's reduction kernels; unaligned loads throughout (as fast as
+// aligned ones on data that happens to be aligned)
+struct ReductionTable {
+    IsaLevel level;
+
+    double (*sum_fast)(const float* x, size_t n);
+    double (*sum_compensated)(const float* x, size_t n);
+    double (*sum_double)(const float* x, size_t n);
+    float (*dot_fast)(const float* a, const float* b, size_t n);
+    double (*dot_compensated)(const float* a, const float* b, size_t n);
+    double (*dot_double)(const float* a, const float* b, size_t n);
+};
+
+// Reductions of a specific level; the caller must check the CPU supports it
+inline ReductionTable reductions_for(IsaLevel level) {
+    using namespace detail;
+    const KernelTable kernels = kernels_for(level);
+    switch (level) {
+#ifdef SIMD_X86
+        case IsaLevel::AVX512:
+            return {level, sum_fast_avx512, sum_compensated_avx512, sum_double_avx512,
+                    kernels.dot, dot_compensated_avx512, dot_double_avx512};
+        case IsaLevel::AVX2:
+            return {level, sum_fast_avx2, sum_compensated_avx2, sum_double_avx2,
+                    kernels.dot, dot_compensated_avx2, dot_double_avx2};
+        case IsaLevel::SSE2:
+            return {level, sum_fast_sse2, sum_compensated_sse2, sum_double_sse2,
+                    kernels.dot, dot_compensated_sse2, dot_double_sse2};
+#endif
+        default:
+            return {IsaLevel::Scalar, sum_fast_scalar, sum_compensated_scalar, sum_double_scalar,
+                    kernels.dot, dot_compensated_scalar, dot_double_scalar};
+    }
+}
+
+// Resolved once, at the same level as active_kernels()
+inline const ReductionTable& active_reductions() {
+    static const ReductionTable table = reductions_for(selected_level());
+    return table;
+}
+
+namespace detail {
+
+// Block size of the pairwise tree: large enough that the fast kernel runs
+// at full speed, small enough that its float error stays tiny
+constexpr size_t kPairwiseBlock = 2048;
+
+inline float pairwise_sum(const ReductionTable& k, const float* x, size_t n) {
+    if (n <= kPairwiseBlock) return static_cast<float>(k.sum_fast(x, n));
+    size_t half = (n / 2 + 63) & ~size_t(63);    // keep blocks vector-multiple
+    return pairwise_sum(k, x, half) + pairwise_sum(k, x + half, n - half);
+}
+
+inline float pairwise_dot(const ReductionTable& k, const float* a, const float* b, size_t n) {
+    if (n <= kPairwiseBlock) return k.dot_fast(a, b, n);
+    size_t half = (n / 2 + 63) & ~size_t(63);
+    return pairwise_dot(k, a, b, half) + pairwise_dot(k, a + half, b + half, n - half);
+}
+
+} // namespace detail
+
+// ========== Public API ==========
+// Results are returned as double so the Compensated and Double modes keep
+// their extra precision; Fast and Pairwise results are float values.
+
+inline double sum(const ReductionTable& k, const float* x, size_t n, Accumulation mode) {
+    switch (mode) {
+        case Accumulation::Fast: return k.sum_fast(x, n);
+        case Accumulation::Pairwise: return detail::pairwise_sum(k, x, n);
+        case Accumulation::Compensated: return k.sum_compensated(x, n);
+        case Accumulation::Double: return k.sum_double(x, n);
+    }
+    return 0.0;
+}
+
+inline double dot(const ReductionTable& k, const float* a, const float* b, size_t n, Accumulation mode) {
+    switch (mode) {
+        case Accumulation::Fast: return k.dot_fast(a, b, n);
+        case Accumulation::Pairwise: return detail::pairwise_dot(k, a, b, n);
+        case Accumulation::Compensated: return k.dot_compensated(a, b, n);
+        case Accumulation::Double: return k.dot_double(a, b, n);
+    }
+    return 0.0;
+}
+
+// Euclidean norm, sqrt(x . x)
+inline double norm(const ReductionTable& k, const float* x, size_t n, Accumulation mode) {
+    return std::sqrt(dot(k, x, x, n, mode));
+}
+
+inline double sum(const float* x, size_t n, Accumulation mode = Accumulation::Fast) {
+    return sum(active_reductions(), x, n, mode);
+}
+
+inline double dot(const float* a, const float* b, size_t n, Accumulation mode = Accumulation::Fast) {
+    return dot(active_reductions(), a, b, n, mode);
+}
+
+inline double norm(const float* x, size_t n, Accumulation mode = Accumulation::Fast) {
+    return norm(active_reductions(), x, n, mode);
+}
+
+} // namespace simd
+
+#endif // SIMD_REDUCTIONS_H
@@ -147,12 +147,14 @@ public:
     }
 
     void* allocate(size_t size, size_t alignment = alignof(std::max_align_t)) {
-        // Align offset
+        // Align the address, not the offset: malloc only guarantees
+        // max_align_t for the buffer itself
         size_t padding = 0;
         size_t aligned_offset = offset_;
+        uintptr_t address = reinterpret_cast<uintptr_t>(buffer_) + offset_;
 
-        if (alignment > 0 && (aligned_offset % alignment) != 0) {
-            padding = alignment - (aligned_offset % alignment);
+        if (alignment > 0 && (address % alignment) != 0) {
+            padding = alignment - (address % alignment);
             aligned_offset += padding;
         }
 
@@ -191,10 +193,11 @@ private:
     size_t capacity_;
     FreeBlock* free_list_;
     size_t used_memory_;
+    size_t peak_used_;
 
 public:
     FreeListAllocator(size_t capacity)
-        : capacity_(capacity), used_memory_(0) {
+        : capacity_(capacity), used_memory_(0), peak_used_(0) {
 
         buffer_ = std::malloc(capacity);
         if (!buffer_) throw std::bad_alloc();
@@ -221,7 +224,9 @@ public:
                 padding = alignment - (address % alignment);
             }
 
+            // Round up so the block after this one stays suitably aligned
             size_t required_size = sizeof(Header) + padding + size;
+            required_size = (required_size + alignof(FreeBlock) - 1) & ~(alignof(FreeBlock) - 1);
 
             if (current->size >= required_size) {
                 // Found a suitable block
@@ -240,6 +245,7 @@ public:
                     }
                 } else {
                     // Use entire block
+                    required_size = current->size;
                     if (prev) {
                         prev->next = current->next;
                     } else {
@@ -247,12 +253,14 @@ public:
                     }
                 }
 
-                // Set header
-                Header* header = reinterpret_cast<Header*>(current);
+                // Header sits right before the returned pointer; padding
+                // leads back to the start of the block
+                Header* header = reinterpret_cast<Header*>(address + padding - sizeof(Header));
                 header->size = required_size;
                 header->padding = padding;
 
                 used_memory_ += required_size;
+                if (used_memory_ > peak_used_) peak_used_ = used_memory_;
 
                 return reinterpret_cast<void*>(address + padding);
             }
@@ -271,17 +279,31 @@ public:
         Header* header = reinterpret_cast<Header*>(
             static_cast<char*>(ptr) - sizeof(Header)
         );
+        size_t size = header->size;
 
-        FreeBlock* block = reinterpret_cast<FreeBlock*>(header);
-        block->size = header->size;
+        FreeBlock* block = reinterpret_cast<FreeBlock*>(
+            reinterpret_cast<char*>(header) - header->padding
+        );
+        block->size = size;
         block->next = free_list_;
         free_list_ = block;
 
-        used_memory_ -= header->size;
+        used_memory_ -= size;
     }
 
     size_t bytes_used() const { return used_memory_; }
     size_t bytes_available() const { return capacity_ - used_memory_; }
+    size_t peak_bytes_used() const { return peak_used_; }
+
+    // Freed blocks are never merged, so this can stay small even when
+    // most of the buffer is free
+    size_t largest_free_block() const {
+        size_t largest = 0;
+        for (FreeBlock* b = free_list_; b; b = b->next) {
+            if (b->size > largest) largest = b->size;
+        }
+        return largest;
+    }
 };
 
 // ========== STL-Compatible Allocator Wrapper ==========
@@ -0,0 +1,537 @@
+/*
+ * Concurrent Pool Allocator
+ * Fixed-size object pool shared by many threads: per-thread magazines serve
+ * the hot path without atomics, full batches travel through a lock-free
+ * depot, and slabs whose objects are all free can be handed back to the OS.
+ */
+
+#ifndef CONCURRENT_POOL_H
+#define CONCURRENT_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace detail {
+
+// Maps `size` bytes straight from the OS at an address aligned to
+// `alignment` (a power of two, at least a page), so the owning slab of
+// any object can be found by masking its address
+inline void* os_allocate_aligned(size_t size, size_t alignment) {
+#ifdef _WIN32
+    for (;;) {
+        char* probe = static_cast<char*>(
+            VirtualAlloc(nullptr, size + alignment, MEM_RESERVE, PAGE_NOACCESS));
+        if (!probe) return nullptr;
+
+        uintptr_t aligned = (reinterpret_cast<uintptr_t>(probe) + alignment - 1) &
+                            ~static_cast<uintptr_t>(alignment - 1);
+        VirtualFree(probe, 0, MEM_RELEASE);
+
+        void* ptr = VirtualAlloc(reinterpret_cast<void*>(aligned), size,
+                                 MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+        if (ptr) return ptr;
+        // Another thread mapped the range in between; try again
+    }
+#else
+    void* raw = mmap(nullptr, size + alignment, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) return nullptr;
+
+    uintptr_t begin = reinterpret_cast<uintptr_t>(raw);
+    uintptr_t aligned = (begin + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+    size_t head = aligned - begin;
+    size_t tail = alignment - head;
+
+    // Unmap the over-allocation on both sides of the aligned range
+    if (head) munmap(raw, head);
+    if (tail) munmap(reinterpret_cast<void*>(aligned + size), tail);
+    return reinterpret_cast<void*>(aligned);
+#endif
+}
+
+inline void os_free(void* ptr, size_t size) {
+#ifdef _WIN32
+    (void)size;
+    VirtualFree(ptr, 0, MEM_RELEASE);
+#else
+    munmap(ptr, size);
+#endif
+}
+
+// Small dense index per live thread, shared by every concurrent pool.
+// Indices of exited threads are recycled, so a pool can keep its thread
+// caches in a flat array. Threads beyond kMaxSlots get kMaxSlots.
+class ThreadSlot {
+public:
+    static constexpr size_t kMaxSlots = 128;
+
+    static size_t index() {
+        static thread_local Holder holder;
+        return holder.index;
+    }
+
+    // Calls fn(index) for every slot no live thread holds. The slots stay
+    // unassigned until fn returns, so their per-pool caches can be touched.
+    template<typename F>
+    static void for_each_unused(F&& fn) {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        for (size_t index : r.free) {
+            fn(index);
+        }
+    }
+
+private:
+    struct Registry {
+        std::mutex mutex;
+        std::vector<size_t> free;
+        size_t next = 0;
+    };
+
+    static Registry& registry() {
+        // Intentionally leaked: thread_local holders may release after
+        // static destructors have started
+        static Registry* instance = new Registry();
+        return *instance;
+    }
+
+    struct Holder {
+        size_t index;
+
+        Holder() {
+            Registry& r = registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            if (!r.free.empty()) {
+                index = r.free.back();
+                r.free.pop_back();
+            } else if (r.next < kMaxSlots) {
+                index = r.next++;
+            } else {
+                index = kMaxSlots;
+            }
+        }
+
+        ~Holder() {
+            if (index < kMaxSlots) {
+                Registry& r = registry();
+                std::lock_guard<std::mutex> lock(r.mutex);
+                r.free.push_back(index);
+            }
+        }
+    };
+};
+
+} // namespace detail
+
+// Thread-safe counterpart of PoolAllocator. allocate() and deallocate() may
+// be called from any thread, and an object may be freed on a different
+// thread than the one that allocated it: the freeing thread keeps the node
+// in its own magazine, and surplus batches flow back through the depot.
+//
+// Memory comes in BlockSize slabs mapped directly from the OS. trim()
+// unmaps every slab whose objects are all sitting in the depot; with
+// release_empty_blocks set, trim runs automatically as the depot grows.
+template<typename T, size_t BlockSize = 64 * 1024>
+class ConcurrentPoolAllocator {
+    static_assert(BlockSize >= 4096 && (BlockSize & (BlockSize - 1)) == 0,
+                  "BlockSize must be a power of two of at least one page");
+    static_assert(sizeof(void*) == 8, "depot tagging assumes 64-bit pointers");
+
+public:
+    static constexpr size_t kBatchSize = 64;
+
+    explicit ConcurrentPoolAllocator(bool release_empty_blocks = false)
+        : magazines_(new Magazine[detail::ThreadSlot::kMaxSlots + 1]),
+          depot_head_(0), depot_batches_(0), depot_readers_(0),
+          slabs_(nullptr), slab_count_(0), released_slabs_(0),
+          release_empty_blocks_(release_empty_blocks),
+          next_trim_batches_(kMinTrimBatches) {}
+
+    ~ConcurrentPoolAllocator() {
+        while (slabs_) {
+            Slab* next = slabs_->next;
+            detail::os_free(slabs_, BlockSize);
+            slabs_ = next;
+        }
+    }
+
+    ConcurrentPoolAllocator(const ConcurrentPoolAllocator&) = delete;
+    ConcurrentPoolAllocator& operator=(const ConcurrentPoolAllocator&) = delete;
+
+    T* allocate() {
+        const size_t slot = detail::ThreadSlot::index();
+        if (slot == detail::ThreadSlot::kMaxSlots) {
+            std::lock_guard<std::mutex> lock(overflow_mutex_);
+            return allocate_from(magazines_[slot]);
+        }
+        return allocate_from(magazines_[slot]);
+    }
+
+    void deallocate(T* ptr) {
+        const size_t slot = detail::ThreadSlot::index();
+        if (slot == detail::ThreadSlot::kMaxSlots) {
+            std::lock_guard<std::mutex> lock(overflow_mutex_);
+            deallocate_to(magazines_[slot], ptr);
+        } else {
+            deallocate_to(magazines_[slot], ptr);
+        }
+        maybe_trim();
+    }
+
+    // Unmaps every slab whose objects are all free and reachable: in the
+    // depot, the calling thread's magazine, or the magazine of a thread that
+    // has exited. Returns the number of slabs released.
+    size_t trim() {
+        std::lock_guard<std::mutex> lock(slab_mutex_);
+        return trim_locked();
+    }
+
+    size_t allocation_count() const {
+        return sum_counters(&Magazine::allocations);
+    }
+
+    size_t deallocation_count() const {
+        return sum_counters(&Magazine::deallocations);
+    }
+
+    size_t slab_count() const {
+        return slab_count_.load(std::memory_order_relaxed);
+    }
+
+    size_t released_slab_count() const {
+        return released_slabs_.load(std::memory_order_relaxed);
+    }
+
+    size_t bytes_reserved() const {
+        return slab_count() * BlockSize;
+    }
+
+    static constexpr size_t objects_per_slab() {
+        return kNodesPerSlab;
+    }
+
+private:
+    union Node {
+        struct Link {
+            Node* next;                      // within a magazine or batch
+            std::atomic<Node*> next_batch;   // depot stack, batch heads only
+            size_t batch_count;              // batch heads only
+        } link;
+        alignas(T) char data[sizeof(T)];
+    };
+
+    // Header at the start of every slab; found by masking a node address
+    struct Slab {
+        Slab* next;
+        Slab* prev;
+        size_t trim_free;   // scratch for trim(), guarded by slab_mutex_
+    };
+
+    struct alignas(64) Magazine {
+        Node* head = nullptr;
+        size_t count = 0;
+        // Written only by the slot owner; atomic so stats can read them
+        std::atomic<size_t> allocations{0};
+        std::atomic<size_t> deallocations{0};
+    };
+
+    static constexpr size_t kHeaderSize =
+        (sizeof(Slab) + alignof(Node) - 1) / alignof(Node) * alignof(Node);
+    static constexpr size_t kNodesPerSlab = (BlockSize - kHeaderSize) / sizeof(Node);
+    static_assert(kNodesPerSlab >= kBatchSize, "BlockSize too small for one batch");
+
+    // Automatic trims wait for at least this many idle batches
+    static constexpr size_t kMinTrimBatches = 4 * ((kNodesPerSlab + kBatchSize - 1) / kBatchSize);
+
+    // The depot head packs a 48-bit pointer with a 16-bit version tag that
+    // changes on every update, so a stale head cannot win a CAS (ABA)
+    static constexpr int kPointerBits = 48;
+    static constexpr uint64_t kPointerMask = (uint64_t(1) << kPointerBits) - 1;
+
+    static Node* unpack(uint64_t word) {
+        return reinterpret_cast<Node*>(static_cast<uintptr_t>(word & kPointerMask));
+    }
+
+    static uint64_t pack(Node* node, uint64_t previous) {
+        uint64_t tag = (previous >> kPointerBits) + 1;
+        return (tag << kPointerBits) | (reinterpret_cast<uintptr_t>(node) & kPointerMask);
+    }
+
+    static Slab* slab_of(Node* node) {
+        return reinterpret_cast<Slab*>(reinterpret_cast<uintptr_t>(node) &
+                                       ~static_cast<uintptr_t>(BlockSize - 1));
+    }
+
+    static void bump(std::atomic<size_t>& counter) {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    T* allocate_from(Magazine& magazine) {
+        if (magazine.head == nullptr) {
+            refill(magazine);
+        }
+
+        Node* node = magazine.head;
+        magazine.head = node->link.next;
+        --magazine.count;
+        bump(magazine.allocations);
+        return reinterpret_cast<T*>(node);
+    }
+
+    void deallocate_to(Magazine& magazine, T* ptr) {
+        Node* node = reinterpret_cast<Node*>(ptr);
+        node->link.next = magazine.head;
+        magazine.head = node;
+        ++magazine.count;
+        bump(magazine.deallocations);
+
+        // Keep one batch in hand so alloc/free at a boundary does not bounce
+        if (magazine.count >= 2 * kBatchSize) {
+            push_batch(take_batch(magazine, kBatchSize));
+        }
+    }
+
+    void refill(Magazine& magazine) {
+        Node* batch = pop_batch();
+        if (!batch) {
+            batch = carve_slab();
+        }
+        magazine.head = batch;
+        magazine.count = batch->link.batch_count;
+    }
+
+    // Detaches up to `count` nodes from the front of a magazine as a batch
+    static Node* take_batch(Magazine& magazine, size_t count) {
+        Node* batch = magazine.head;
+        Node* tail = batch;
+        size_t taken = 1;
+        for (; taken < count && tail->link.next; ++taken) {
+            tail = tail->link.next;
+        }
+        magazine.head = tail->link.next;
+        magazine.count -= taken;
+        tail->link.next = nullptr;
+        batch->link.batch_count = taken;
+        return batch;
+    }
+
+    // ---- Lock-free depot (Treiber stack of batches) ----
+
+    void push_batch(Node* batch) {
+        // Count first so a racing pop can never drive the counter below zero
+        depot_batches_.fetch_add(1, std::memory_order_relaxed);
+        uint64_t head = depot_head_.load(std::memory_order_relaxed);
+        do {
+            batch->link.next_batch.store(unpack(head), std::memory_order_relaxed);
+        } while (!depot_head_.compare_exchange_weak(head, pack(batch, head),
+                                                    std::memory_order_release,
+                                                    std::memory_order_relaxed));
+    }
+
+    Node* pop_batch() {
+        // Registered readers keep trim() from unmapping a slab while we may
+        // still dereference a head that another thread has just taken
+        depot_readers_.fetch_add(1, std::memory_order_seq_cst);
+        uint64_t head = depot_head_.load(std::memory_order_seq_cst);
+        Node* batch = unpack(head);
+        while (batch) {
+            Node* next = batch->link.next_batch.load(std::memory_order_relaxed);
+            if (depot_head_.compare_exchange_weak(head, pack(next, head),
+                                                  std::memory_order_acquire,
+                                                  std::memory_order_acquire)) {
+                break;
+            }
+            batch = unpack(head);
+        }
+        depot_readers_.fetch_sub(1, std::memory_order_release);
+
+        if (batch) {
+            depot_batches_.fetch_sub(1, std::memory_order_relaxed);
+        }
+        return batch;
+    }
+
+    // Detaches the whole depot; returns a list of batches
+    Node* take_depot() {
+        uint64_t head = depot_head_.load(std::memory_order_relaxed);
+        while (!depot_head_.compare_exchange_weak(head, pack(nullptr, head),
+                                                  std::memory_order_seq_cst)) {
+        }
+        while (depot_readers_.load(std::memory_order_seq_cst) != 0) {
+            std::this_thread::yield();
+        }
+
+        Node* batches = unpack(head);
+        for (Node* b = batches; b; b = b->link.next_batch.load(std::memory_order_relaxed)) {
+            depot_batches_.fetch_sub(1, std::memory_order_relaxed);
+        }
+        return batches;
+    }
+
+    // ---- Slabs ----
+
+    // Maps a new slab, keeps one batch for the caller and publishes the rest
+    Node* carve_slab() {
+        void* memory = detail::os_allocate_aligned(BlockSize, BlockSize);
+        if (!memory) throw std::bad_alloc();
+
+        Slab* slab = static_cast<Slab*>(memory);
+        slab->trim_free = 0;
+        {
+            std::lock_guard<std::mutex> lock(slab_mutex_);
+            slab->prev = nullptr;
+            slab->next = slabs_;
+            if (slabs_) slabs_->prev = slab;
+            slabs_ = slab;
+        }
+        slab_count_.fetch_add(1, std::memory_order_relaxed);
+
+        char* base = static_cast<char*>(memory) + kHeaderSize;
+        Magazine scratch;
+        for (size_t i = kNodesPerSlab; i-- > 0;) {
+            Node* node = reinterpret_cast<Node*>(base + i * sizeof(Node));
+            node->link.next = scratch.head;
+            scratch.head = node;
+        }
+        scratch.count = kNodesPerSlab;
+
+        Node* mine = take_batch(scratch, kBatchSize);
+        while (scratch.head) {
+            push_batch(take_batch(scratch, kBatchSize));
+        }
+        return mine;
+    }
+
+    void maybe_trim() {
+        if (!release_empty_blocks_ ||
+            depot_batches_.load(std::memory_order_relaxed) <
+                next_trim_batches_.load(std::memory_order_relaxed)) {
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock(slab_mutex_, std::try_to_lock);
+        if (lock.owns_lock()) {
+            trim_locked();
+            // Geometric back-off keeps the cost amortised O(1) per free when
+            // fragmentation leaves little to release
+            size_t idle = depot_batches_.load(std::memory_order_relaxed);
+            next_trim_batches_.store(std::max(2 * idle, kMinTrimBatches),
+                                     std::memory_order_relaxed);
+        }
+    }
+
+    size_t trim_locked() {
+        // Gather every free node we can safely reach into one list
+        Magazine gathered;
+        auto absorb = [&gathered](Magazine& magazine) {
+            while (magazine.head) {
+                Node* node = magazine.head;
+                magazine.head = node->link.next;
+                node->link.next = gathered.head;
+                gathered.head = node;
+            }
+            magazine.count = 0;
+        };
+
+        for (Node* batch = take_depot(); batch;) {
+            Node* next_batch = batch->link.next_batch.load(std::memory_order_relaxed);
+            Magazine list;
+            list.head = batch;
+            absorb(list);
+            batch = next_batch;
+        }
+
+        const size_t slot = detail::ThreadSlot::index();
+        if (slot < detail::ThreadSlot::kMaxSlots) {
+            absorb(magazines_[slot]);
+        }
+        detail::ThreadSlot::for_each_unused([&](size_t index) {
+            if (index != slot) absorb(magazines_[index]);
+        });
+        {
+            std::lock_guard<std::mutex> lock(overflow_mutex_);
+            absorb(magazines_[detail::ThreadSlot::kMaxSlots]);
+        }
+
+        // A slab is empty when all of its nodes turned up in the list
+        for (Slab* s = slabs_; s; s = s->next) {
+            s->trim_free = 0;
+        }
+        for (Node* node = gathered.head; node; node = node->link.next) {
+            ++slab_of(node)->trim_free;
+        }
+
+        // Re-batch the survivors and hand them back to the depot
+        Magazine survivors;
+        while (gathered.head) {
+            Node* node = gathered.head;
+            gathered.head = node->link.next;
+            if (slab_of(node)->trim_free != kNodesPerSlab) {
+                node->link.next = survivors.head;
+                survivors.head = node;
+                ++survivors.count;
+            }
+        }
+        while (survivors.head) {
+            push_batch(take_batch(survivors, kBatchSize));
+        }
+
+        size_t released = 0;
+        for (Slab* s = slabs_; s;) {
+            Slab* next = s->next;
+            if (s->trim_free == kNodesPerSlab) {
+                if (s->prev) s->prev->next = s->next;
+                else slabs_ = s->next;
+                if (s->next) s->next->prev = s->prev;
+                detail::os_free(s, BlockSize);
+                ++released;
+            }
+            s = next;
+        }
+
+        slab_count_.fetch_sub(released, std::memory_order_relaxed);
+        released_slabs_.fetch_add(released, std::memory_order_relaxed);
+        return released;
+    }
+
+    size_t sum_counters(std::atomic<size_t> Magazine::*counter) const {
+        size_t total = 0;
+        for (size_t i = 0; i <= detail::ThreadSlot::kMaxSlots; ++i) {
+            total += (magazines_[i].*counter).load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    std::unique_ptr<Magazine[]> magazines_;   // indexed by ThreadSlot; last one shared
+    std::mutex overflow_mutex_;
+
+    alignas(64) std::atomic<uint64_t> depot_head_;
+    alignas(64) std::atomic<size_t> depot_batches_;
+    alignas(64) std::atomic<size_t> depot_readers_;
+
+    alignas(64) std::mutex slab_mutex_;      // slab list, carving and trim
+    Slab* slabs_;
+    std::atomic<size_t> slab_count_;
+    std::atomic<size_t> released_slabs_;
+
+    const bool release_empty_blocks_;
+    std::atomic<size_t> next_trim_batches_;
+};
+
+#endif // CONCURRENT_POOL_H
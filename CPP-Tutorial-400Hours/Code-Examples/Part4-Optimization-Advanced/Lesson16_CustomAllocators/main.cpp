@@ -4,11 +4,26 @@
  */
 
 #include "allocators.h"
+#include "concurrent_pool.h"
+#include "tlsf_allocator.h"
+#include "pmr_resources.h"
 #include <iostream>
 #include <chrono>
 #include <vector>
 #include <iomanip>
 #include <random>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <cstdlib>
+#include <algorithm>
+#include <numeric>
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <string>
+#include <memory_resource>
 
 class Timer {
     std::chrono::high_resolution_clock::time_point start_;
@@ -162,18 +177,19 @@ void benchmark_allocators() {
 
     // Stack allocator (no individual deallocation)
     {
-        StackAllocator<64 * 1024 * 1024> stack;  // 64 MB
+        // 64 MB buffer is far larger than a thread stack; keep it on the heap
+        auto stack = std::make_unique<StackAllocator<64 * 1024 * 1024>>();
         Timer t;
 
         for (int i = 0; i < iterations; ++i) {
             TestObject* obj = static_cast<TestObject*>(
-                stack.allocate(sizeof(TestObject), alignof(TestObject))
+                stack->allocate(sizeof(TestObject), alignof(TestObject))
             );
             new (obj) TestObject(i);
         }
 
         // Reset all at once
-        stack.reset();
+        stack->reset();
 
         std::cout << "Stack allocator:     " << std::fixed << std::setprecision(2)
                   << t.elapsed_ms() << " ms\n";
@@ -243,6 +259,539 @@ void demo_freelist_allocator() {
     allocator.deallocate(p4);
 }
 
+// ========== Concurrent Pool ==========
+
+// Runs body(thread_index) on `threads` threads and returns wall time in ms
+template<typename Body>
+double run_threads(int threads, const Body& body) {
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    Timer t;
+    for (int i = 0; i < threads; ++i) {
+        workers.emplace_back([&body, i] { body(i); });
+    }
+    for (auto& w : workers) {
+        w.join();
+    }
+    return t.elapsed_ms();
+}
+
+// Every thread keeps a ring of live objects and replaces one per step, so
+// each step is one free plus one allocation from the same thread
+template<typename Alloc, typename Free>
+double churn_local(int threads, size_t ops_per_thread, const Alloc& alloc, const Free& release) {
+    const size_t live = 512;
+    return run_threads(threads, [&](int) {
+        std::vector<TestObject*> ring(live);
+        for (auto& p : ring) p = alloc();
+
+        uint32_t x = 2463534242u;
+        for (size_t i = 0; i < ops_per_thread; ++i) {
+            x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+            TestObject*& slot = ring[x & (live - 1)];
+            release(slot);
+            slot = alloc();
+            slot->id = static_cast<int>(i);
+        }
+
+        for (auto* p : ring) release(p);
+    });
+}
+
+// Threads swap freshly allocated objects into a shared table and free
+// whatever they displace, so most frees hit another thread's allocation
+template<typename Alloc, typename Free>
+double churn_cross_thread(int threads, size_t ops_per_thread, const Alloc& alloc, const Free& release) {
+    const size_t table_size = 4096;
+    std::vector<std::atomic<TestObject*>> table(table_size);
+    for (auto& slot : table) slot.store(nullptr, std::memory_order_relaxed);
+
+    double ms = run_threads(threads, [&](int index) {
+        uint32_t x = 2463534242u + static_cast<uint32_t>(index) * 7919u;
+        for (size_t i = 0; i < ops_per_thread; ++i) {
+            x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+            TestObject* p = alloc();
+            p->id = index;
+            TestObject* old = table[x & (table_size - 1)].exchange(p, std::memory_order_acq_rel);
+            if (old) release(old);
+        }
+    });
+
+    for (auto& slot : table) {
+        if (TestObject* p = slot.load(std::memory_order_relaxed)) release(p);
+    }
+    return ms;
+}
+
+void demo_concurrent_pool() {
+    print_header("Concurrent Pool Allocator Demo");
+
+    ConcurrentPoolAllocator<TestObject> pool;
+    const int threads = 4;
+    const size_t per_thread = 50000;
+
+    // Allocate on four threads, free everything from the main thread
+    std::vector<std::vector<TestObject*>> objects(threads);
+    run_threads(threads, [&](int index) {
+        objects[index].reserve(per_thread);
+        for (size_t i = 0; i < per_thread; ++i) {
+            objects[index].push_back(new (pool.allocate()) TestObject(static_cast<int>(i)));
+        }
+    });
+
+    std::cout << "After " << threads * per_thread << " allocations on " << threads << " threads:\n";
+    std::cout << "  Slabs reserved: " << pool.slab_count() << " ("
+              << pool.bytes_reserved() / 1024 << " KB, "
+              << ConcurrentPoolAllocator<TestObject>::objects_per_slab() << " objects each)\n\n";
+
+    for (auto& list : objects) {
+        for (auto* obj : list) {
+            obj->~TestObject();
+            pool.deallocate(obj);
+        }
+    }
+
+    std::cout << "After freeing all of them on the main thread:\n";
+    std::cout << "  Total allocations: " << pool.allocation_count() << "\n";
+    std::cout << "  Total deallocations: " << pool.deallocation_count() << "\n";
+    std::cout << "  Slabs reserved: " << pool.slab_count() << "\n\n";
+
+    size_t released = pool.trim();
+    std::cout << "After trim():\n";
+    std::cout << "  Slabs returned to the OS: " << released << "\n";
+    std::cout << "  Slabs reserved: " << pool.slab_count() << " ("
+              << pool.bytes_reserved() / 1024 << " KB)\n";
+}
+
+void benchmark_concurrent_pool() {
+    print_header("Concurrent Pool Scaling (Mops/s, higher is better)");
+
+    const size_t total_ops = 4000000;
+    const int thread_counts[] = {1, 2, 4, 8, 16, 32, 64};
+
+    std::cout << "Hardware threads: " << std::thread::hardware_concurrency()
+              << ", " << total_ops << " alloc+free pairs per run\n";
+
+    auto malloc_alloc = [] { return static_cast<TestObject*>(std::malloc(sizeof(TestObject))); };
+    auto malloc_free = [](TestObject* p) { std::free(p); };
+
+    // The existing single-threaded pool needs a lock to be shared at all
+    PoolAllocator<TestObject> locked_pool;
+    std::mutex pool_mutex;
+    auto locked_alloc = [&] {
+        std::lock_guard<std::mutex> lock(pool_mutex);
+        return locked_pool.allocate();
+    };
+    auto locked_free = [&](TestObject* p) {
+        std::lock_guard<std::mutex> lock(pool_mutex);
+        locked_pool.deallocate(p);
+    };
+
+    ConcurrentPoolAllocator<TestObject> concurrent_pool;
+    auto concurrent_alloc = [&] { return concurrent_pool.allocate(); };
+    auto concurrent_free = [&](TestObject* p) { concurrent_pool.deallocate(p); };
+
+    auto mops = [total_ops](double ms) { return total_ops / (ms * 1000.0); };
+
+    const char* workloads[] = {"Thread-local churn", "Cross-thread free"};
+    for (int w = 0; w < 2; ++w) {
+        std::cout << "\n" << workloads[w] << ":\n";
+        std::cout << std::setw(10) << "Threads"
+                  << std::setw(14) << "malloc"
+                  << std::setw(16) << "Pool + mutex"
+                  << std::setw(14) << "Concurrent"
+                  << std::setw(12) << "vs malloc" << "\n";
+        std::cout << std::string(66, '-') << "\n";
+
+        for (int threads : thread_counts) {
+            size_t per_thread = total_ops / threads;
+            double t_malloc, t_locked, t_concurrent;
+            if (w == 0) {
+                t_malloc = churn_local(threads, per_thread, malloc_alloc, malloc_free);
+                t_locked = churn_local(threads, per_thread, locked_alloc, locked_free);
+                t_concurrent = churn_local(threads, per_thread, concurrent_alloc, concurrent_free);
+            } else {
+                t_malloc = churn_cross_thread(threads, per_thread, malloc_alloc, malloc_free);
+                t_locked = churn_cross_thread(threads, per_thread, locked_alloc, locked_free);
+                t_concurrent = churn_cross_thread(threads, per_thread, concurrent_alloc, concurrent_free);
+            }
+
+            std::cout << std::setw(10) << threads << std::fixed << std::setprecision(1)
+                      << std::setw(14) << mops(t_malloc)
+                      << std::setw(16) << mops(t_locked)
+                      << std::setw(14) << mops(t_concurrent)
+                      << std::setw(11) << std::setprecision(2) << t_malloc / t_concurrent << "x\n";
+        }
+    }
+
+    std::cout << "\nConcurrent pool: " << concurrent_pool.slab_count() << " slabs reserved, "
+              << concurrent_pool.allocation_count() << " allocations served\n";
+}
+
+// ========== TLSF vs First-Fit ==========
+
+void demo_tlsf_allocator() {
+    print_header("TLSF Allocator Demo");
+
+    TLSFAllocator allocator(1024 * 1024);  // 1 MB
+
+    std::cout << "Initial largest free block: " << allocator.largest_free_block() << " bytes\n\n";
+
+    void* p1 = allocator.allocate(1000);
+    void* p2 = allocator.allocate(2000);
+    void* p3 = allocator.allocate(500, 64);
+
+    std::cout << "After 3 allocations (third one 64-byte aligned):\n";
+    std::cout << "  Used: " << allocator.bytes_used() << " bytes\n";
+    std::cout << "  Third block aligned: "
+              << (reinterpret_cast<uintptr_t>(p3) % 64 == 0 ? "yes" : "no") << "\n";
+    std::cout << "  Largest free block: " << allocator.largest_free_block() << " bytes\n\n";
+
+    allocator.deallocate(p2);
+    std::cout << "After freeing the middle block:\n";
+    std::cout << "  Free bytes: " << allocator.free_bytes() << "\n";
+    std::cout << "  Fragmentation: " << std::fixed << std::setprecision(4)
+              << allocator.fragmentation() << "\n\n";
+
+    allocator.deallocate(p1);
+    allocator.deallocate(p3);
+    std::cout << "After freeing the rest (neighbours coalesce immediately):\n";
+    std::cout << "  Largest free block: " << allocator.largest_free_block() << " bytes\n";
+    std::cout << "  Fragmentation: " << allocator.fragmentation() << "\n";
+    std::cout << "  Peak used: " << allocator.peak_bytes_used() << " bytes\n";
+}
+
+struct TraceEvent {
+    uint32_t id;
+    uint32_t size;        // 0 marks a free
+    uint32_t alignment;
+};
+
+// Records the allocation stream of a long-running heap: mixed request
+// sizes, mostly short-lived objects with a tail of long-lived ones
+std::vector<TraceEvent> record_allocation_trace(size_t steps, size_t target_live) {
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+    std::vector<TraceEvent> trace;
+    std::vector<uint32_t> live;
+    uint32_t next_id = 0;
+
+    auto random_size = [&]() -> uint32_t {
+        double r = uniform(rng);
+        if (r < 0.60) return 16 + static_cast<uint32_t>(rng() % 112);
+        if (r < 0.90) return 128 + static_cast<uint32_t>(rng() % 896);
+        if (r < 0.99) return 1024 + static_cast<uint32_t>(rng() % 15360);
+        return 16384 + static_cast<uint32_t>(rng() % 114688);
+    };
+
+    for (size_t step = 0; step < steps; ++step) {
+        double alloc_bias = live.size() < target_live ? 0.75 : 0.5;
+        if (live.empty() || uniform(rng) < alloc_bias) {
+            uint32_t alignment = uniform(rng) < 0.05 ? 64 : 16;
+            trace.push_back({next_id, random_size(), alignment});
+            live.push_back(next_id++);
+        } else {
+            // Most frees hit something recent; the rest age out at random
+            size_t recent = std::min<size_t>(live.size(), 32);
+            size_t index = uniform(rng) < 0.8
+                ? live.size() - 1 - rng() % recent
+                : rng() % live.size();
+            trace.push_back({live[index], 0, 0});
+            live[index] = live.back();
+            live.pop_back();
+        }
+    }
+    return trace;
+}
+
+struct ReplayResult {
+    size_t completed = 0;
+    bool out_of_memory = false;
+    std::vector<uint32_t> alloc_ns;
+    std::vector<uint32_t> free_ns;
+    size_t peak_used = 0;
+    size_t free_bytes = 0;
+    size_t largest_free = 0;
+};
+
+template<typename Allocator>
+void replay_trace(Allocator& allocator, const std::vector<TraceEvent>& trace, ReplayResult& result) {
+    using clock = std::chrono::steady_clock;
+    std::vector<void*> pointers(trace.size(), nullptr);
+    result.alloc_ns.reserve(trace.size());
+    result.free_ns.reserve(trace.size());
+
+    for (const TraceEvent& e : trace) {
+        if (e.size) {
+            auto start = clock::now();
+            try {
+                pointers[e.id] = allocator.allocate(e.size, e.alignment);
+            } catch (const std::bad_alloc&) {
+                result.out_of_memory = true;
+                break;
+            }
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start);
+            result.alloc_ns.push_back(static_cast<uint32_t>(ns.count()));
+        } else {
+            auto start = clock::now();
+            allocator.deallocate(pointers[e.id]);
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start);
+            result.free_ns.push_back(static_cast<uint32_t>(ns.count()));
+            pointers[e.id] = nullptr;
+        }
+        ++result.completed;
+    }
+
+    result.peak_used = allocator.peak_bytes_used();
+    result.free_bytes = allocator.bytes_available();
+    result.largest_free = allocator.largest_free_block();
+
+    for (void* p : pointers) {
+        if (p) allocator.deallocate(p);
+    }
+}
+
+uint32_t percentile(std::vector<uint32_t>& samples, double q) {
+    if (samples.empty()) return 0;
+    size_t index = static_cast<size_t>(q * (samples.size() - 1));
+    std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+    return samples[index];
+}
+
+void benchmark_trace_replay() {
+    print_header("Trace Replay: First-Fit Free List vs TLSF");
+
+    const size_t steps = 400000;
+    const size_t capacity = 64 * 1024 * 1024;
+    std::vector<TraceEvent> trace = record_allocation_trace(steps, 4000);
+
+    size_t live_bytes = 0, peak_live = 0;
+    {
+        std::vector<uint32_t> sizes(trace.size(), 0);
+        for (const TraceEvent& e : trace) {
+            if (e.size) { sizes[e.id] = e.size; live_bytes += e.size; }
+            else live_bytes -= sizes[e.id];
+            peak_live = std::max(peak_live, live_bytes);
+        }
+    }
+
+    std::cout << "Trace: " << trace.size() << " events, peak live payload "
+              << peak_live / 1024 << " KB, arena " << capacity / (1024 * 1024) << " MB\n";
+    std::cout << "(latencies include ~20 ns of clock overhead)\n\n";
+
+    ReplayResult results[2];
+    const char* names[2] = {"First-fit", "TLSF"};
+    {
+        auto freelist = std::make_unique<FreeListAllocator>(capacity);
+        replay_trace(*freelist, trace, results[0]);
+    }
+    {
+        auto tlsf = std::make_unique<TLSFAllocator>(capacity);
+        replay_trace(*tlsf, trace, results[1]);
+    }
+
+    std::cout << std::setw(12) << "Allocator"
+              << std::setw(10) << "alloc p50"
+              << std::setw(10) << "p99"
+              << std::setw(10) << "p99.9"
+              << std::setw(12) << "max"
+              << std::setw(10) << "free p50"
+              << std::setw(10) << "p99" << "  (ns)\n";
+    std::cout << std::string(74, '-') << "\n";
+
+    for (int i = 0; i < 2; ++i) {
+        ReplayResult& r = results[i];
+        uint32_t alloc_max = r.alloc_ns.empty() ? 0
+            : *std::max_element(r.alloc_ns.begin(), r.alloc_ns.end());
+        std::cout << std::setw(12) << names[i]
+                  << std::setw(10) << percentile(r.alloc_ns, 0.50)
+                  << std::setw(10) << percentile(r.alloc_ns, 0.99)
+                  << std::setw(10) << percentile(r.alloc_ns, 0.999)
+                  << std::setw(12) << alloc_max
+                  << std::setw(10) << percentile(r.free_ns, 0.50)
+                  << std::setw(10) << percentile(r.free_ns, 0.99) << "\n";
+    }
+
+    std::cout << "\n" << std::setw(12) << "Allocator"
+              << std::setw(12) << "events"
+              << std::setw(14) << "peak used KB"
+              << std::setw(16) << "largest free KB"
+              << std::setw(16) << "fragmentation" << "\n";
+    std::cout << std::string(70, '-') << "\n";
+
+    for (int i = 0; i < 2; ++i) {
+        const ReplayResult& r = results[i];
+        double fragmentation = r.free_bytes
+            ? 1.0 - static_cast<double>(r.largest_free) / r.free_bytes : 0.0;
+        std::cout << std::setw(12) << names[i]
+                  << std::setw(12) << r.completed
+                  << std::setw(14) << r.peak_used / 1024
+                  << std::setw(16) << r.largest_free / 1024
+                  << std::setw(16) << std::fixed << std::setprecision(4) << fragmentation;
+        if (r.out_of_memory) std::cout << "  (out of memory)";
+        std::cout << "\n";
+    }
+}
+
+// ========== PMR Resources ==========
+
+// One request of a map-building service: build two maps from scratch,
+// query them and throw them away. The container types are fixed; only
+// the resource changes, so one copy of this code serves every arena.
+size_t handle_request_pmr(std::pmr::memory_resource* resource,
+                          const std::vector<std::string>& keys, size_t ints) {
+    std::pmr::map<int, int> by_id(resource);
+    for (size_t i = 0; i < ints; ++i) {
+        by_id.emplace(static_cast<int>((i * 7919) % ints), static_cast<int>(i));
+    }
+
+    std::pmr::unordered_map<std::pmr::string, int> by_name(resource);
+    by_name.reserve(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+        by_name.emplace(keys[i].c_str(), static_cast<int>(i));
+    }
+
+    size_t checksum = by_id.size() + by_id.begin()->second;
+    for (size_t i = 0; i < keys.size(); i += 7) {
+        checksum += by_name.find(std::pmr::string(keys[i].c_str(), resource))->second;
+    }
+    return checksum;
+}
+
+size_t handle_request_std(const std::vector<std::string>& keys, size_t ints) {
+    std::map<int, int> by_id;
+    for (size_t i = 0; i < ints; ++i) {
+        by_id.emplace(static_cast<int>((i * 7919) % ints), static_cast<int>(i));
+    }
+
+    std::unordered_map<std::string, int> by_name;
+    by_name.reserve(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+        by_name.emplace(keys[i].c_str(), static_cast<int>(i));
+    }
+
+    size_t checksum = by_id.size() + by_id.begin()->second;
+    for (size_t i = 0; i < keys.size(); i += 7) {
+        checksum += by_name.find(keys[i])->second;
+    }
+    return checksum;
+}
+
+void demo_pmr_resources() {
+    print_header("PMR Resource Demo");
+
+    // The same pmr::vector type on three different allocators
+    MonotonicAllocator monotonic(64 * 1024);
+    TLSFAllocator tlsf(64 * 1024);
+    UnsynchronizedPoolResource pool;
+    MonotonicResource monotonic_resource(monotonic);
+    TLSFResource tlsf_resource(tlsf);
+
+    std::pmr::memory_resource* resources[] = {&monotonic_resource, &tlsf_resource, &pool};
+    const char* names[] = {"MonotonicResource", "TLSFResource", "UnsynchronizedPoolResource"};
+
+    for (int i = 0; i < 3; ++i) {
+        std::pmr::vector<int> values(resources[i]);
+        for (int v = 0; v < 1000; ++v) values.push_back(v);
+        std::cout << std::left << std::setw(28) << names[i] << std::right
+                  << "1000 ints pushed, sum = " << std::accumulate(values.begin(), values.end(), 0)
+                  << "\n";
+    }
+
+    std::cout << "\nMonotonic arena used: " << monotonic.bytes_used()
+              << " bytes (growth copies are never reclaimed)\n";
+    std::cout << "TLSF arena used after the vector died: " << tlsf.bytes_used() << " bytes\n";
+}
+
+void benchmark_pmr_requests() {
+    print_header("Per-Request Arenas with std::pmr (us/request, lower is better)");
+
+    const size_t requests = 2000;
+    const size_t ints = 1000;
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < 500; ++i) {
+        keys.push_back("customer-record-" + std::to_string(i * 2654435761u) + "-segment");
+    }
+
+    std::cout << "Each request builds a " << ints << "-entry std::map and a "
+              << keys.size() << "-entry unordered_map of long string keys\n\n";
+
+    size_t checksum = 0;
+    auto report = [&](const char* name, double ms, double baseline_ms) {
+        std::cout << std::left << std::setw(40) << name << std::right
+                  << std::fixed << std::setprecision(2)
+                  << std::setw(10) << ms * 1000.0 / requests
+                  << std::setw(10) << baseline_ms / ms << "x\n";
+    };
+
+    std::cout << std::left << std::setw(40) << "Resource" << std::right
+              << std::setw(10) << "us/req" << std::setw(11) << "speedup\n";
+    std::cout << std::string(61, '-') << "\n";
+
+    double heap_ms;
+    {
+        Timer t;
+        for (size_t r = 0; r < requests; ++r) checksum += handle_request_std(keys, ints);
+        heap_ms = t.elapsed_ms();
+        report("std containers, global heap", heap_ms, heap_ms);
+    }
+    {
+        Timer t;
+        for (size_t r = 0; r < requests; ++r) {
+            checksum += handle_request_pmr(std::pmr::new_delete_resource(), keys, ints);
+        }
+        report("pmr, new_delete_resource", t.elapsed_ms(), heap_ms);
+    }
+    {
+        // Fresh monotonic_buffer_resource per request over a reused buffer
+        std::vector<char> buffer(256 * 1024);
+        Timer t;
+        for (size_t r = 0; r < requests; ++r) {
+            std::pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size());
+            checksum += handle_request_pmr(&arena, keys, ints);
+        }
+        report("pmr, monotonic_buffer_resource/request", t.elapsed_ms(), heap_ms);
+    }
+    {
+        MonotonicAllocator monotonic(256 * 1024);
+        MonotonicResource resource(monotonic);
+        Timer t;
+        for (size_t r = 0; r < requests; ++r) {
+            checksum += handle_request_pmr(&resource, keys, ints);
+            monotonic.reset();
+        }
+        report("pmr, MonotonicResource + reset", t.elapsed_ms(), heap_ms);
+    }
+    {
+        TLSFAllocator tlsf(4 * 1024 * 1024);
+        TLSFResource resource(tlsf);
+        Timer t;
+        for (size_t r = 0; r < requests; ++r) checksum += handle_request_pmr(&resource, keys, ints);
+        report("pmr, TLSFResource", t.elapsed_ms(), heap_ms);
+    }
+    {
+        UnsynchronizedPoolResource resource;
+        Timer t;
+        for (size_t r = 0; r < requests; ++r) checksum += handle_request_pmr(&resource, keys, ints);
+        report("pmr, UnsynchronizedPoolResource", t.elapsed_ms(), heap_ms);
+    }
+    {
+        SynchronizedPoolResource resource;
+        Timer t;
+        for (size_t r = 0; r < requests; ++r) checksum += handle_request_pmr(&resource, keys, ints);
+        report("pmr, SynchronizedPoolResource", t.elapsed_ms(), heap_ms);
+    }
+    {
+        std::pmr::unsynchronized_pool_resource resource;
+        Timer t;
+        for (size_t r = 0; r < requests; ++r) checksum += handle_request_pmr(&resource, keys, ints);
+        report("pmr, std unsynchronized_pool_resource", t.elapsed_ms(), heap_ms);
+    }
+
+    std::cout << "\n(checksum " << checksum << ")\n";
+}
+
 int main() {
     std::cout << "Custom Memory Allocators\n";
     std::cout << "========================\n";
@@ -251,12 +800,21 @@ int main() {
     std::cout << "2. Pool (Fixed-Size) Allocator\n";
     std::cout << "3. Monotonic (Bump) Allocator\n";
     std::cout << "4. Free List Allocator\n";
+    std::cout << "5. Concurrent (Per-Thread Cached) Pool Allocator\n";
+    std::cout << "6. TLSF (Two-Level Segregated Fit) Allocator\n";
+    std::cout << "7. std::pmr Memory Resources\n";
 
     demo_stack_allocator();
     demo_pool_allocator();
     demo_monotonic_allocator();
     demo_freelist_allocator();
     benchmark_allocators();
+    demo_concurrent_pool();
+    benchmark_concurrent_pool();
+    demo_tlsf_allocator();
+    benchmark_trace_replay();
+    demo_pmr_resources();
+    benchmark_pmr_requests();
 
     print_header("Summary");
     std::cout << "Allocator Trade-offs:\n\n";
@@ -284,7 +842,19 @@ int main() {
     std::cout << "  + Individual deallocation\n";
     std::cout << "  + Memory reuse\n";
     std::cout << "  - Can fragment\n";
-    std::cout << "  - Slower than specialized allocators\n";
+    std::cout << "  - Slower than specialized allocators\n\n";
+
+    std::cout << "Concurrent Pool Allocator:\n";
+    std::cout << "  + Lock-free, atomic-free hot path via per-thread magazines\n";
+    std::cout << "  + Objects may be freed on any thread\n";
+    std::cout << "  + Empty slabs can be returned to the OS\n";
+    std::cout << "  - Per-thread caches hold memory other threads cannot see\n\n";
+
+    std::cout << "TLSF Allocator:\n";
+    std::cout << "  + O(1) allocation and deallocation\n";
+    std::cout << "  + Immediate coalescing keeps fragmentation low\n";
+    std::cout << "  + Bounded latency, suitable for real-time code\n";
+    std::cout << "  - 16-byte header and minimum block per allocation\n";
 
     std::cout << std::string(60, '=') << "\n";
 
@@ -0,0 +1,173 @@
+/*
+ * std::pmr Memory Resources for the Lesson Allocators
+ * Lets std::pmr containers draw from the custom allocators. The resource
+ * is picked at runtime and the container type stays the same.
+ */
+
+#ifndef PMR_RESOURCES_H
+#define PMR_RESOURCES_H
+
+#include <cstddef>
+#include <memory_resource>
+#include <type_traits>
+#include <utility>
+
+#include "allocators.h"
+#include "concurrent_pool.h"
+#include "tlsf_allocator.h"
+
+namespace detail {
+
+template<typename Allocator, typename = void>
+struct has_deallocate : std::false_type {};
+
+template<typename Allocator>
+struct has_deallocate<Allocator,
+    std::void_t<decltype(std::declval<Allocator&>().deallocate(std::declval<void*>()))>>
+    : std::true_type {};
+
+} // namespace detail
+
+// ========== Adaptor for allocate(size, alignment) allocators ==========
+// Wraps an allocator owned elsewhere; the allocator must outlive every
+// container using the resource. Frees are forwarded when the allocator
+// has deallocate(void*), and ignored otherwise (arenas release on reset).
+template<typename Allocator>
+class AllocatorResource : public std::pmr::memory_resource {
+public:
+    explicit AllocatorResource(Allocator& allocator) : allocator_(allocator) {}
+
+    Allocator& allocator() const { return allocator_; }
+
+protected:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        return allocator_.allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* ptr, size_t /*bytes*/, size_t /*alignment*/) override {
+        if constexpr (detail::has_deallocate<Allocator>::value) {
+            allocator_.deallocate(ptr);
+        }
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+private:
+    Allocator& allocator_;
+};
+
+template<size_t Size>
+using StackResource = AllocatorResource<StackAllocator<Size>>;
+using MonotonicResource = AllocatorResource<MonotonicAllocator>;
+using FreeListResource = AllocatorResource<FreeListAllocator>;
+using TLSFResource = AllocatorResource<TLSFAllocator>;
+
+// ========== Pool Resources ==========
+
+namespace detail {
+
+// Raw storage for one pooled request; alignment follows the natural
+// alignment of the size, capped at max_align_t
+template<size_t N>
+struct alignas(N < alignof(std::max_align_t) ? N : alignof(std::max_align_t)) PoolChunk {
+    unsigned char bytes[N];
+};
+
+struct UnsynchronizedPools {
+    template<typename Chunk>
+    using pool = PoolAllocator<Chunk, 16 * 1024>;
+};
+
+struct SynchronizedPools {
+    template<typename Chunk>
+    using pool = ConcurrentPoolAllocator<Chunk>;
+};
+
+} // namespace detail
+
+// Serves requests up to kMaxPooledSize bytes from fixed-size pools with
+// power-of-two size classes (16..512). Larger or over-aligned requests go
+// to the upstream resource. Memory stays in the pools until the resource
+// is destroyed, like std::pmr::unsynchronized_pool_resource.
+template<typename Policy>
+class BasicPoolResource : public std::pmr::memory_resource {
+public:
+    static constexpr size_t kMaxPooledSize = 512;
+
+    explicit BasicPoolResource(
+        std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+        : upstream_(upstream) {}
+
+    BasicPoolResource(const BasicPoolResource&) = delete;
+    BasicPoolResource& operator=(const BasicPoolResource&) = delete;
+
+    std::pmr::memory_resource* upstream_resource() const { return upstream_; }
+
+protected:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        switch (size_class(bytes, alignment)) {
+            case 0: return pool16_.allocate();
+            case 1: return pool32_.allocate();
+            case 2: return pool64_.allocate();
+            case 3: return pool128_.allocate();
+            case 4: return pool256_.allocate();
+            case 5: return pool512_.allocate();
+            default: return upstream_->allocate(bytes, alignment);
+        }
+    }
+
+    void do_deallocate(void* ptr, size_t bytes, size_t alignment) override {
+        switch (size_class(bytes, alignment)) {
+            case 0: pool16_.deallocate(static_cast<Chunk<16>*>(ptr)); break;
+            case 1: pool32_.deallocate(static_cast<Chunk<32>*>(ptr)); break;
+            case 2: pool64_.deallocate(static_cast<Chunk<64>*>(ptr)); break;
+            case 3: pool128_.deallocate(static_cast<Chunk<128>*>(ptr)); break;
+            case 4: pool256_.deallocate(static_cast<Chunk<256>*>(ptr)); break;
+            case 5: pool512_.deallocate(static_cast<Chunk<512>*>(ptr)); break;
+            default: upstream_->deallocate(ptr, bytes, alignment); break;
+        }
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+private:
+    template<size_t N>
+    using Chunk = detail::PoolChunk<N>;
+
+    template<size_t N>
+    using Pool = typename Policy::template pool<Chunk<N>>;
+
+    // Index of the smallest class holding `bytes`, or -1 for upstream
+    static int size_class(size_t bytes, size_t alignment) {
+        if (bytes > kMaxPooledSize || alignment > alignof(std::max_align_t)) {
+            return -1;
+        }
+        size_t need = bytes > alignment ? bytes : alignment;
+        int index = 0;
+        for (size_t size = 16; size < need; size <<= 1) {
+            ++index;
+        }
+        return index;
+    }
+
+    std::pmr::memory_resource* upstream_;
+    Pool<16> pool16_;
+    Pool<32> pool32_;
+    Pool<64> pool64_;
+    Pool<128> pool128_;
+    Pool<256> pool256_;
+    Pool<512> pool512_;
+};
+
+// Single-threaded: each size class is a plain PoolAllocator
+using UnsynchronizedPoolResource = BasicPoolResource<detail::UnsynchronizedPools>;
+
+// Safe to share between threads: each size class is a ConcurrentPoolAllocator,
+// so there is no resource-wide lock and blocks may be freed on any thread
+using SynchronizedPoolResource = BasicPoolResource<detail::SynchronizedPools>;
+
+#endif // PMR_RESOURCES_H
@@ -0,0 +1,333 @@
+/*
+ * TLSF (Two-Level Segregated Fit) Allocator
+ * Variable-size allocator with O(1) allocate and free: free blocks are
+ * binned by size class, two bitmaps locate a fitting class in a couple of
+ * bit scans, and neighbours are coalesced immediately on free.
+ * Based on Masmano et al., "TLSF: a New Dynamic Memory Allocator for
+ * Real-Time Systems" (ECRTS 2004).
+ */
+
+#ifndef TLSF_ALLOCATOR_H
+#define TLSF_ALLOCATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace detail {
+
+// Index of the lowest set bit; x must be non-zero
+inline int find_first_set(uint32_t x) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, x);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctz(x);
+#endif
+}
+
+// Index of the highest set bit; x must be non-zero
+inline int find_last_set(uint64_t x) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, x);
+    return static_cast<int>(index);
+#else
+    return 63 - __builtin_clzll(x);
+#endif
+}
+
+} // namespace detail
+
+class TLSFAllocator {
+private:
+    // Every block starts with this header; free blocks also link into their
+    // size class list through the first 16 bytes of their payload
+    struct Block {
+        Block* prev_physical;     // neighbour below, nullptr for the first block
+        size_t size;              // payload bytes, low bit = free flag
+        Block* next_free;
+        Block* prev_free;
+    };
+
+    static constexpr size_t kAlignment = alignof(std::max_align_t);
+    static constexpr size_t kHeaderSize = 2 * sizeof(void*);
+    static constexpr size_t kMinPayload = sizeof(Block) - kHeaderSize;
+    static constexpr size_t kFreeBit = 1;
+
+    static_assert(kHeaderSize % kAlignment == 0, "payload must stay max-aligned");
+
+    // First level: power-of-two ranges. Second level: 32 linear steps
+    // inside each range. Sizes below kSmallBlock share first level 0.
+    static constexpr int kSecondLevelLog2 = 5;
+    static constexpr int kSecondLevelCount = 1 << kSecondLevelLog2;
+    static constexpr int kFirstLevelShift = kSecondLevelLog2 + 4;   // log2(kAlignment)
+    static constexpr size_t kSmallBlock = size_t(1) << kFirstLevelShift;
+    static constexpr int kFirstLevelMax = 40;                        // blocks up to 1 TB
+    static constexpr int kFirstLevelCount = kFirstLevelMax - kFirstLevelShift + 1;
+
+    static_assert(kAlignment == 16, "size class layout assumes 16-byte alignment");
+    static_assert(kFirstLevelCount <= 32, "first-level bitmap is 32 bits");
+
+    char* buffer_;
+    size_t capacity_;
+    uint32_t fl_bitmap_;
+    uint32_t sl_bitmap_[kFirstLevelCount];
+    Block* free_lists_[kFirstLevelCount][kSecondLevelCount];
+
+    size_t used_memory_;       // allocated blocks, headers included
+    size_t peak_used_;
+    size_t free_payload_;      // sum of free block payloads
+    size_t allocations_;
+    size_t deallocations_;
+
+    // ---- Block helpers ----
+
+    static size_t block_size(const Block* block) { return block->size & ~kFreeBit; }
+    static bool is_free(const Block* block) { return (block->size & kFreeBit) != 0; }
+
+    static void* payload(Block* block) {
+        return reinterpret_cast<char*>(block) + kHeaderSize;
+    }
+
+    static Block* from_payload(void* ptr) {
+        return reinterpret_cast<Block*>(static_cast<char*>(ptr) - kHeaderSize);
+    }
+
+    static Block* next_physical(Block* block) {
+        return reinterpret_cast<Block*>(
+            reinterpret_cast<char*>(block) + kHeaderSize + block_size(block));
+    }
+
+    static size_t align_up(size_t value, size_t alignment) {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    // ---- Size class mapping ----
+
+    static void mapping_insert(size_t size, int& fl, int& sl) {
+        if (size < kSmallBlock) {
+            fl = 0;
+            sl = static_cast<int>(size / (kSmallBlock / kSecondLevelCount));
+        } else {
+            int top = detail::find_last_set(size);
+            sl = static_cast<int>(size >> (top - kSecondLevelLog2)) ^ kSecondLevelCount;
+            fl = top - (kFirstLevelShift - 1);
+        }
+    }
+
+    // Rounds up to the next class boundary, so any block in the returned
+    // class is large enough (good fit instead of an exhaustive best fit)
+    static void mapping_search(size_t size, int& fl, int& sl) {
+        if (size >= kSmallBlock) {
+            size += (size_t(1) << (detail::find_last_set(size) - kSecondLevelLog2)) - 1;
+        }
+        mapping_insert(size, fl, sl);
+    }
+
+    Block* search_suitable_block(int fl, int sl) {
+        if (fl >= kFirstLevelCount) return nullptr;
+
+        uint32_t sl_map = sl_bitmap_[fl] & (~0u << sl);
+        if (!sl_map) {
+            uint32_t fl_map = fl + 1 < 32 ? fl_bitmap_ & (~0u << (fl + 1)) : 0;
+            if (!fl_map) return nullptr;
+            fl = detail::find_first_set(fl_map);
+            sl_map = sl_bitmap_[fl];
+        }
+        sl = detail::find_first_set(sl_map);
+        return free_lists_[fl][sl];
+    }
+
+    // ---- Free lists ----
+
+    void insert_free(Block* block) {
+        int fl, sl;
+        mapping_insert(block_size(block), fl, sl);
+
+        Block* head = free_lists_[fl][sl];
+        block->next_free = head;
+        block->prev_free = nullptr;
+        if (head) head->prev_free = block;
+        free_lists_[fl][sl] = block;
+
+        fl_bitmap_ |= 1u << fl;
+        sl_bitmap_[fl] |= 1u << sl;
+        block->size |= kFreeBit;
+        free_payload_ += block_size(block);
+    }
+
+    void remove_free(Block* block) {
+        int fl, sl;
+        mapping_insert(block_size(block), fl, sl);
+
+        if (block->prev_free) block->prev_free->next_free = block->next_free;
+        else free_lists_[fl][sl] = block->next_free;
+        if (block->next_free) block->next_free->prev_free = block->prev_free;
+
+        if (!free_lists_[fl][sl]) {
+            sl_bitmap_[fl] &= ~(1u << sl);
+            if (!sl_bitmap_[fl]) fl_bitmap_ &= ~(1u << fl);
+        }
+        block->size &= ~kFreeBit;
+        free_payload_ -= block_size(block);
+    }
+
+    // Cuts `block` (not in any list) down to `size` payload bytes and
+    // returns the tail to the free lists if it can hold a block
+    void split(Block* block, size_t size) {
+        size_t total = block_size(block);
+        if (total < size + kHeaderSize + kMinPayload) return;
+
+        Block* rest = reinterpret_cast<Block*>(static_cast<char*>(payload(block)) + size);
+        rest->prev_physical = block;
+        rest->size = total - size - kHeaderSize;
+        next_physical(rest)->prev_physical = rest;
+        block->size = size;
+        insert_free(rest);
+    }
+
+    // Merges a block (not in any list) with free physical neighbours
+    Block* coalesce(Block* block) {
+        Block* prev = block->prev_physical;
+        if (prev && is_free(prev)) {
+            remove_free(prev);
+            prev->size = block_size(prev) + kHeaderSize + block_size(block);
+            block = prev;
+            next_physical(block)->prev_physical = block;
+        }
+
+        Block* next = next_physical(block);
+        if (is_free(next)) {
+            remove_free(next);
+            block->size = block_size(block) + kHeaderSize + block_size(next);
+            next_physical(block)->prev_physical = block;
+        }
+        return block;
+    }
+
+public:
+    TLSFAllocator(size_t capacity)
+        : fl_bitmap_(0), used_memory_(0), peak_used_(0), free_payload_(0),
+          allocations_(0), deallocations_(0) {
+        capacity_ = capacity & ~(kAlignment - 1);
+        if (capacity_ < 2 * kHeaderSize + kMinPayload) throw std::bad_alloc();
+
+        buffer_ = static_cast<char*>(std::malloc(capacity_));
+        if (!buffer_) throw std::bad_alloc();
+
+        for (int fl = 0; fl < kFirstLevelCount; ++fl) {
+            sl_bitmap_[fl] = 0;
+            for (int sl = 0; sl < kSecondLevelCount; ++sl) {
+                free_lists_[fl][sl] = nullptr;
+            }
+        }
+
+        // One free block spanning the pool, then a zero-size used sentinel
+        // so coalescing never has to bounds-check the upper neighbour
+        Block* block = reinterpret_cast<Block*>(buffer_);
+        block->prev_physical = nullptr;
+        block->size = capacity_ - 2 * kHeaderSize;
+
+        Block* sentinel = next_physical(block);
+        sentinel->prev_physical = block;
+        sentinel->size = 0;
+
+        insert_free(block);
+    }
+
+    ~TLSFAllocator() {
+        std::free(buffer_);
+    }
+
+    TLSFAllocator(const TLSFAllocator&) = delete;
+    TLSFAllocator& operator=(const TLSFAllocator&) = delete;
+
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t)) {
+        size_t adjusted = align_up(size ? size : 1, kAlignment);
+        if (adjusted < kMinPayload) adjusted = kMinPayload;
+
+        // Over-aligned requests reserve room for a leading gap large enough
+        // to stand as a free block of its own
+        const bool over_aligned = alignment > kAlignment;
+        const size_t min_gap = kHeaderSize + kMinPayload;
+        size_t request = over_aligned ? adjusted + alignment + min_gap : adjusted;
+
+        int fl, sl;
+        mapping_search(request, fl, sl);
+        Block* block = search_suitable_block(fl, sl);
+        if (!block) throw std::bad_alloc();
+        remove_free(block);
+
+        if (over_aligned) {
+            uintptr_t start = reinterpret_cast<uintptr_t>(payload(block));
+            uintptr_t aligned = align_up(start, alignment);
+            if (aligned != start && aligned - start < min_gap) {
+                aligned = align_up(start + min_gap, alignment);
+            }
+
+            size_t gap = aligned - start;
+            if (gap) {
+                // The gap becomes a free block; its lower neighbour is in use
+                // because free neighbours are always merged already
+                Block* moved = from_payload(reinterpret_cast<void*>(aligned));
+                moved->prev_physical = block;
+                moved->size = block_size(block) - gap;
+                next_physical(moved)->prev_physical = moved;
+                block->size = gap - kHeaderSize;
+                insert_free(block);
+                block = moved;
+            }
+        }
+
+        split(block, adjusted);
+
+        used_memory_ += block_size(block) + kHeaderSize;
+        if (used_memory_ > peak_used_) peak_used_ = used_memory_;
+        ++allocations_;
+        return payload(block);
+    }
+
+    void deallocate(void* ptr) {
+        if (!ptr) return;
+
+        Block* block = from_payload(ptr);
+        used_memory_ -= block_size(block) + kHeaderSize;
+        ++deallocations_;
+        insert_free(coalesce(block));
+    }
+
+    size_t bytes_used() const { return used_memory_; }
+    size_t bytes_available() const { return capacity_ - used_memory_; }
+    size_t peak_bytes_used() const { return peak_used_; }
+    size_t free_bytes() const { return free_payload_; }
+    size_t allocation_count() const { return allocations_; }
+    size_t deallocation_count() const { return deallocations_; }
+
+    // Largest single request that could currently succeed (payload bytes)
+    size_t largest_free_block() const {
+        if (!fl_bitmap_) return 0;
+
+        int fl = detail::find_last_set(fl_bitmap_);
+        int sl = detail::find_last_set(sl_bitmap_[fl]);
+        size_t largest = 0;
+        for (Block* b = free_lists_[fl][sl]; b; b = b->next_free) {
+            if (block_size(b) > largest) largest = block_size(b);
+        }
+        return largest;
+    }
+
+    // 0 when all free memory is one block, approaching 1 as it splinters
+    double fragmentation() const {
+        if (free_payload_ == 0) return 0.0;
+        return 1.0 - static_cast<double>(largest_free_block()) / free_payload_;
+    }
+};
+
+#endif // TLSF_ALLOCATOR_H
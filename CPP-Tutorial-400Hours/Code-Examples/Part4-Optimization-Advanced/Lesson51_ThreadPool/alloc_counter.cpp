@@ -0,0 +1,32 @@
+/*
+ * Global operator new/delete replacement that counts heap allocations.
+ * Kept in its own translation unit so the replacements are never inlined
+ * into callers.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<size_t> g_allocation_count{0};
+
+size_t allocation_count() {
+    return g_allocation_count.load(std::memory_order_relaxed);
+}
+
+void* operator new(size_t size) {
+    g_allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
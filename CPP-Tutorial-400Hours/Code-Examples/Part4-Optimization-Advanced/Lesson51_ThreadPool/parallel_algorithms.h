@@ -0,0 +1,248 @@
+/*
+ * Bulk Parallel Algorithms on ThreadPool
+ * parallel_for / parallel_reduce / parallel_transform with lazy binary
+ * splitting and a grain size measured from the loop body itself.
+ */
+
+#ifndef PARALLEL_ALGORITHMS_H
+#define PARALLEL_ALGORITHMS_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "thread_pool.h"
+
+namespace detail {
+
+// Chunks are sized to cost roughly this much, long enough to hide the
+// ~1 us of scheduling overhead per task and short enough to balance load
+constexpr std::chrono::nanoseconds kTargetChunkTime{20000};
+
+// Probe batches shorter than this are too noisy to extrapolate from
+constexpr std::chrono::nanoseconds kMinProbeTime{2000};
+
+// Shared state for one parallel loop. Lives on the caller's stack; the
+// caller does not return until every spawned chunk has finished.
+template<typename Body>
+struct LoopState {
+    LoopState(ThreadPool& p, const Body& b, size_t g)
+        : pool(p), body(b), grain(g),
+          split_threshold(p.thread_count()), outstanding(0), unstarted(0), failed(false) {}
+
+    ThreadPool& pool;
+    const Body& body;
+    const size_t grain;
+    const size_t split_threshold;
+
+    std::atomic<size_t> outstanding;  // spawned chunks not yet finished
+    std::atomic<size_t> unstarted;    // spawned chunks still sitting in the pool
+    std::atomic<bool> failed;
+    std::exception_ptr error;
+    std::mutex error_mutex;
+
+    void record_error() {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if (!error) {
+            error = std::current_exception();
+        }
+        failed.store(true, std::memory_order_relaxed);
+    }
+};
+
+template<typename Body>
+void run_range(LoopState<Body>& state, size_t begin, size_t end);
+
+template<typename Body>
+void spawn_range(LoopState<Body>& state, size_t begin, size_t end) {
+    state.outstanding.fetch_add(1, std::memory_order_relaxed);
+    state.unstarted.fetch_add(1, std::memory_order_relaxed);
+
+    LoopState<Body>* s = &state;
+    auto chunk = [s, begin, end]() {
+        s->unstarted.fetch_sub(1, std::memory_order_relaxed);
+        try {
+            run_range(*s, begin, end);
+        } catch (...) {
+            s->record_error();
+        }
+        // Last touch of *s: the caller may destroy it right after this
+        s->outstanding.fetch_sub(1, std::memory_order_acq_rel);
+    };
+
+    try {
+        state.pool.submit_detached(std::move(chunk));
+    } catch (...) {
+        state.unstarted.fetch_sub(1, std::memory_order_relaxed);
+        state.outstanding.fetch_sub(1, std::memory_order_relaxed);
+        throw;
+    }
+}
+
+// Lazy binary splitting: keep halving the range only while the pool has
+// run out of stealable chunks from this loop, otherwise just execute the
+// next grain-sized piece. Splits therefore track actual idleness instead
+// of being fixed up front.
+template<typename Body>
+void run_range(LoopState<Body>& state, size_t begin, size_t end) {
+    while (end - begin > state.grain) {
+        if (state.failed.load(std::memory_order_relaxed)) {
+            return;
+        }
+
+        if (state.unstarted.load(std::memory_order_relaxed) < state.split_threshold) {
+            size_t mid = begin + (end - begin) / 2;
+            spawn_range(state, mid, end);
+            end = mid;
+        } else {
+            state.body(begin, begin + state.grain);
+            begin += state.grain;
+        }
+    }
+
+    if (begin < end && !state.failed.load(std::memory_order_relaxed)) {
+        state.body(begin, end);
+    }
+}
+
+// Runs the body on doubling batches from the front of the range until one
+// takes long enough to time, then scales that batch to kTargetChunkTime.
+// The probed elements are real work; returns the first unprocessed index.
+template<typename Body>
+size_t probe_grain(const Body& body, size_t begin, size_t end, size_t& grain) {
+    using clock = std::chrono::steady_clock;
+
+    size_t batch = 1;
+    while (begin < end) {
+        size_t n = std::min(batch, end - begin);
+
+        auto start = clock::now();
+        body(begin, begin + n);
+        auto elapsed = clock::now() - start;
+        begin += n;
+
+        if (elapsed >= kMinProbeTime) {
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+            grain = std::max<size_t>(1, static_cast<size_t>(
+                static_cast<double>(n) * kTargetChunkTime.count() / ns));
+            return begin;
+        }
+        batch *= 2;
+    }
+
+    grain = batch;
+    return begin;
+}
+
+} // namespace detail
+
+// Calls body(chunk_begin, chunk_end) over disjoint sub-ranges covering
+// [begin, end). Pass grain = 0 to size chunks from observed body cost.
+// The calling thread takes part and helps run pool tasks while it waits.
+// The first exception thrown by the body is rethrown here.
+template<typename RangeBody>
+void parallel_for_range(ThreadPool& pool, size_t begin, size_t end,
+                        const RangeBody& body, size_t grain = 0) {
+    if (begin >= end) {
+        return;
+    }
+
+    if (grain == 0) {
+        begin = detail::probe_grain(body, begin, end, grain);
+        if (begin >= end) {
+            return;
+        }
+    }
+
+    // Keep at least a few chunks per worker so the tail can still balance
+    const size_t max_grain = (end - begin) / (4 * pool.thread_count()) + 1;
+    grain = std::min(grain, max_grain);
+
+    detail::LoopState<RangeBody> state(pool, body, grain);
+    try {
+        detail::run_range(state, begin, end);
+    } catch (...) {
+        state.record_error();
+    }
+
+    while (state.outstanding.load(std::memory_order_acquire) != 0) {
+        if (!pool.try_run_pending_task()) {
+            std::this_thread::yield();
+        }
+    }
+
+    if (state.error) {
+        std::rethrow_exception(state.error);
+    }
+}
+
+// Calls fn(i) for every i in [begin, end)
+template<typename Index, typename F>
+void parallel_for(ThreadPool& pool, Index begin, Index end, const F& fn, size_t grain = 0) {
+    if (!(begin < end)) {
+        return;
+    }
+
+    const size_t count = static_cast<size_t>(end - begin);
+    parallel_for_range(pool, 0, count, [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; ++i) {
+            fn(static_cast<Index>(begin + i));
+        }
+    }, grain);
+}
+
+// Reduces [begin, end): reduce_range(b, e) returns the partial for one chunk,
+// combine(x, y) merges two partials and must be associative. Partials are
+// combined in index order, so a non-commutative combine is fine.
+template<typename T, typename ReduceRange, typename Combine>
+T parallel_reduce(ThreadPool& pool, size_t begin, size_t end, T identity,
+                  const ReduceRange& reduce_range, const Combine& combine,
+                  size_t grain = 0) {
+    std::vector<std::pair<size_t, T>> partials;
+    std::mutex partials_mutex;
+
+    parallel_for_range(pool, begin, end, [&](size_t b, size_t e) {
+        T partial = reduce_range(b, e);
+        std::lock_guard<std::mutex> lock(partials_mutex);
+        partials.emplace_back(b, std::move(partial));
+    }, grain);
+
+    std::sort(partials.begin(), partials.end(),
+              [](const auto& x, const auto& y) { return x.first < y.first; });
+
+    T result = std::move(identity);
+    for (auto& partial : partials) {
+        result = combine(std::move(result), std::move(partial.second));
+    }
+    return result;
+}
+
+// Element-wise std::transform over random-access iterators
+template<typename InputIt, typename OutputIt, typename UnaryOp>
+OutputIt parallel_transform(ThreadPool& pool, InputIt first, InputIt last,
+                            OutputIt d_first, UnaryOp op) {
+    const size_t count = static_cast<size_t>(std::distance(first, last));
+    parallel_for_range(pool, 0, count, [&](size_t b, size_t e) {
+        std::transform(first + b, first + e, d_first + b, op);
+    });
+    return d_first + count;
+}
+
+template<typename InputIt1, typename InputIt2, typename OutputIt, typename BinaryOp>
+OutputIt parallel_transform(ThreadPool& pool, InputIt1 first1, InputIt1 last1,
+                            InputIt2 first2, OutputIt d_first, BinaryOp op) {
+    const size_t count = static_cast<size_t>(std::distance(first1, last1));
+    parallel_for_range(pool, 0, count, [&](size_t b, size_t e) {
+        std::transform(first1 + b, first1 + e, first2 + b, d_first + b, op);
+    });
+    return d_first + count;
+}
+
+#endif // PARALLEL_ALGORITHMS_H
@@ -0,0 +1,288 @@
+/*
+ * Allocation-Free Task Storage
+ * Move-only callable with an inline small buffer, plus a recycling
+ * allocator backed by per-thread free lists for queue nodes and
+ * promise/future shared state.
+ */
+
+#ifndef TASK_H
+#define TASK_H
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace detail {
+
+// Fixed-size block cache: each thread keeps a magazine (singly linked free
+// list); full batches move to and from a shared depot under a mutex, so a
+// block freed on a worker can be reused by the submitting thread.
+// Blocks are carved from slabs that are kept for the life of the process.
+template<size_t BlockSize>
+class BlockCache {
+    static_assert(BlockSize >= sizeof(void*), "block must hold a free-list link");
+    static_assert(BlockSize % alignof(std::max_align_t) == 0,
+                  "block size must preserve max alignment");
+
+public:
+    static void* allocate() {
+        Magazine& magazine = local();
+        if (magazine.head == nullptr) {
+            magazine.refill();
+        }
+
+        FreeBlock* block = magazine.head;
+        magazine.head = block->next;
+        --magazine.count;
+        return block;
+    }
+
+    static void deallocate(void* ptr) noexcept {
+        Magazine& magazine = local();
+        FreeBlock* block = static_cast<FreeBlock*>(ptr);
+        block->next = magazine.head;
+        magazine.head = block;
+        ++magazine.count;
+
+        if (magazine.count >= 2 * kBatchSize) {
+            magazine.release_batch();
+        }
+    }
+
+private:
+    static constexpr size_t kBatchSize = 32;
+
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    struct Depot {
+        std::mutex mutex;
+        std::vector<FreeBlock*> batches;   // each entry: list of kBatchSize blocks
+        std::vector<void*> slabs;
+    };
+
+    struct Magazine {
+        FreeBlock* head = nullptr;
+        size_t count = 0;
+
+        ~Magazine() {
+            while (count >= kBatchSize) {
+                release_batch();
+            }
+            // A partial batch is simply dropped; its slab stays owned by the depot
+        }
+
+        void refill() {
+            Depot& d = depot();
+            std::lock_guard<std::mutex> lock(d.mutex);
+
+            if (!d.batches.empty()) {
+                head = d.batches.back();
+                d.batches.pop_back();
+                count = kBatchSize;
+                return;
+            }
+
+            char* slab = static_cast<char*>(::operator new(BlockSize * kBatchSize));
+            d.slabs.push_back(slab);
+            for (size_t i = 0; i < kBatchSize; ++i) {
+                FreeBlock* block = reinterpret_cast<FreeBlock*>(slab + i * BlockSize);
+                block->next = head;
+                head = block;
+            }
+            count = kBatchSize;
+        }
+
+        void release_batch() noexcept {
+            FreeBlock* batch = head;
+            FreeBlock* tail = head;
+            for (size_t i = 1; i < kBatchSize; ++i) {
+                tail = tail->next;
+            }
+            head = tail->next;
+            tail->next = nullptr;
+            count -= kBatchSize;
+
+            Depot& d = depot();
+            std::lock_guard<std::mutex> lock(d.mutex);
+            d.batches.push_back(batch);
+        }
+    };
+
+    static Depot& depot() {
+        // Intentionally leaked: thread-exit magazines may flush after static
+        // destructors have started
+        static Depot* instance = new Depot();
+        return *instance;
+    }
+
+    static Magazine& local() {
+        static thread_local Magazine magazine;
+        return magazine;
+    }
+};
+
+// Routes a byte count to the smallest block cache that fits, or nullptr
+inline void* allocate_small(size_t bytes) {
+    if (bytes <= 64) return BlockCache<64>::allocate();
+    if (bytes <= 128) return BlockCache<128>::allocate();
+    if (bytes <= 256) return BlockCache<256>::allocate();
+    if (bytes <= 512) return BlockCache<512>::allocate();
+    return nullptr;
+}
+
+inline void deallocate_small(void* ptr, size_t bytes) noexcept {
+    if (bytes <= 64) BlockCache<64>::deallocate(ptr);
+    else if (bytes <= 128) BlockCache<128>::deallocate(ptr);
+    else if (bytes <= 256) BlockCache<256>::deallocate(ptr);
+    else BlockCache<512>::deallocate(ptr);
+}
+
+constexpr size_t kMaxSmallBlock = 512;
+
+} // namespace detail
+
+// Standard allocator over the block caches. Used for std::promise shared
+// state (via std::allocator_arg) and for the pool's queue storage.
+template<typename T>
+class RecyclingAllocator {
+public:
+    using value_type = T;
+
+    RecyclingAllocator() noexcept = default;
+
+    template<typename U>
+    RecyclingAllocator(const RecyclingAllocator<U>&) noexcept {}
+
+    T* allocate(size_t n) {
+        const size_t bytes = n * sizeof(T);
+        if (bytes <= detail::kMaxSmallBlock && alignof(T) <= alignof(std::max_align_t)) {
+            return static_cast<T*>(detail::allocate_small(bytes));
+        }
+        return static_cast<T*>(::operator new(bytes));
+    }
+
+    void deallocate(T* ptr, size_t n) noexcept {
+        const size_t bytes = n * sizeof(T);
+        if (bytes <= detail::kMaxSmallBlock && alignof(T) <= alignof(std::max_align_t)) {
+            detail::deallocate_small(ptr, bytes);
+            return;
+        }
+        ::operator delete(ptr);
+    }
+
+    template<typename U>
+    bool operator==(const RecyclingAllocator<U>&) const noexcept { return true; }
+
+    template<typename U>
+    bool operator!=(const RecyclingAllocator<U>&) const noexcept { return false; }
+};
+
+// Move-only void() callable. Callables up to kInlineSize bytes that are
+// nothrow-movable live inside the Task itself; larger ones go to the heap.
+class Task {
+public:
+    static constexpr size_t kInlineSize = 64;
+
+    Task() noexcept = default;
+
+    template<typename F,
+             typename = std::enable_if_t<!std::is_same<std::decay_t<F>, Task>::value>>
+    Task(F&& f) {
+        using Fn = std::decay_t<F>;
+
+        if constexpr (fits_inline<Fn>()) {
+            ::new (static_cast<void*>(storage_)) Fn(std::forward<F>(f));
+            ops_ = &inline_ops<Fn>;
+        } else {
+            *reinterpret_cast<Fn**>(storage_) = new Fn(std::forward<F>(f));
+            ops_ = &heap_ops<Fn>;
+        }
+    }
+
+    Task(Task&& other) noexcept {
+        take(other);
+    }
+
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            reset();
+            take(other);
+        }
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task() {
+        reset();
+    }
+
+    void operator()() {
+        ops_->invoke(storage_);
+    }
+
+    explicit operator bool() const noexcept {
+        return ops_ != nullptr;
+    }
+
+    void reset() noexcept {
+        if (ops_) {
+            ops_->destroy(storage_);
+            ops_ = nullptr;
+        }
+    }
+
+    template<typename Fn>
+    static constexpr bool fits_inline() {
+        return sizeof(Fn) <= kInlineSize &&
+               alignof(Fn) <= alignof(std::max_align_t) &&
+               std::is_nothrow_move_constructible<Fn>::value;
+    }
+
+private:
+    struct Ops {
+        void (*invoke)(void* storage);
+        void (*relocate)(void* from, void* to) noexcept;  // move + destroy source
+        void (*destroy)(void* storage) noexcept;
+    };
+
+    template<typename Fn>
+    static constexpr Ops inline_ops = {
+        [](void* s) { (*static_cast<Fn*>(s))(); },
+        [](void* from, void* to) noexcept {
+            Fn* src = static_cast<Fn*>(from);
+            ::new (to) Fn(std::move(*src));
+            src->~Fn();
+        },
+        [](void* s) noexcept { static_cast<Fn*>(s)->~Fn(); }
+    };
+
+    template<typename Fn>
+    static constexpr Ops heap_ops = {
+        [](void* s) { (**static_cast<Fn**>(s))(); },
+        [](void* from, void* to) noexcept {
+            *static_cast<Fn**>(to) = *static_cast<Fn**>(from);
+        },
+        [](void* s) noexcept { delete *static_cast<Fn**>(s); }
+    };
+
+    void take(Task& other) noexcept {
+        if (other.ops_) {
+            other.ops_->relocate(other.storage_, storage_);
+            ops_ = other.ops_;
+            other.ops_ = nullptr;
+        }
+    }
+
+    alignas(std::max_align_t) unsigned char storage_[kInlineSize];
+    const Ops* ops_ = nullptr;
+};
+
+#endif // TASK_H
@@ -0,0 +1,289 @@
+/*
+ * Task Graph (DAG) Executor on ThreadPool
+ * Build a dependency graph once, replay it every frame/batch. Each node
+ * carries an atomic predecessor counter; the node that brings it to zero
+ * schedules it (running one ready successor inline as a continuation).
+ */
+
+#ifndef TASK_GRAPH_H
+#define TASK_GRAPH_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "thread_pool.h"
+
+// Timing summary of the most recent TaskGraph::run
+struct TaskGraphStats {
+    double wall_ms = 0.0;            // roots scheduled to run() returning
+    double total_work_ms = 0.0;      // sum of node durations (T1)
+    double critical_path_ms = 0.0;   // longest dependency chain (T-infinity)
+    std::vector<std::string> critical_path;
+
+    // Upper bound on useful speedup for this graph: T1 / T-infinity
+    double parallelism() const {
+        return critical_path_ms > 0.0 ? total_work_ms / critical_path_ms : 0.0;
+    }
+};
+
+class TaskGraph {
+public:
+    using NodeId = size_t;
+
+    TaskGraph() : remaining_(0), failed_(false), completed_(false), pool_(nullptr), dirty_(true) {}
+
+    TaskGraph(const TaskGraph&) = delete;
+    TaskGraph& operator=(const TaskGraph&) = delete;
+
+    // Add a node; work is invoked once per run()
+    template<typename F>
+    NodeId add(std::string name, F&& work) {
+        nodes_.emplace_back(std::move(name), Task(std::forward<F>(work)));
+        dirty_ = true;
+        return nodes_.size() - 1;
+    }
+
+    // `after` may start only once `before` has finished
+    void precede(NodeId before, NodeId after) {
+        if (before >= nodes_.size() || after >= nodes_.size()) {
+            throw std::out_of_range("TaskGraph::precede: unknown node");
+        }
+        nodes_[before].successors.push_back(after);
+        ++nodes_[after].num_predecessors;
+        dirty_ = true;
+    }
+
+    // `node` runs after every node in `befores`
+    void succeed(NodeId node, const std::vector<NodeId>& befores) {
+        for (NodeId before : befores) {
+            precede(before, node);
+        }
+    }
+
+    size_t size() const {
+        return nodes_.size();
+    }
+
+    const std::string& name(NodeId id) const {
+        return nodes_[id].name;
+    }
+
+    // Execute the whole graph on the pool and block until it completes.
+    // The calling thread helps run pool tasks while it waits. If a node
+    // throws, its dependents are skipped and the first exception is
+    // rethrown here once the run has drained.
+    void run(ThreadPool& pool) {
+        prepare();
+        if (nodes_.empty()) {
+            return;
+        }
+
+        pool_ = &pool;
+        failed_.store(false, std::memory_order_relaxed);
+        error_ = nullptr;
+        completed_ = false;
+        for (Node& node : nodes_) {
+            node.pending.store(node.num_predecessors, std::memory_order_relaxed);
+        }
+        remaining_.store(nodes_.size(), std::memory_order_release);
+
+        start_ = Clock::now();
+        for (NodeId root : roots_) {
+            schedule(root);
+        }
+
+        while (remaining_.load(std::memory_order_acquire) != 0) {
+            if (pool.try_run_pending_task()) {
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(done_mutex_);
+            done_condition_.wait_for(lock, std::chrono::microseconds(200), [this] {
+                return completed_;
+            });
+        }
+
+        // The finishing worker sets completed_ under the lock; waiting for it
+        // guarantees that worker is done touching this graph
+        {
+            std::unique_lock<std::mutex> lock(done_mutex_);
+            done_condition_.wait(lock, [this] { return completed_; });
+        }
+        finish_ = Clock::now();
+        pool_ = nullptr;
+
+        if (error_) {
+            std::rethrow_exception(error_);
+        }
+    }
+
+    // Work, span and critical path from the node timings of the last run
+    TaskGraphStats stats() const {
+        TaskGraphStats result;
+        result.wall_ms = to_ms(finish_ - start_);
+        if (nodes_.empty()) {
+            return result;
+        }
+
+        const NodeId none = std::numeric_limits<NodeId>::max();
+        std::vector<double> path_ms(nodes_.size(), 0.0);
+        std::vector<NodeId> parent(nodes_.size(), none);
+
+        for (NodeId id : topological_order_) {
+            const Node& node = nodes_[id];
+            double node_ms = to_ms(node.duration);
+            result.total_work_ms += node_ms;
+
+            double finish_ms = path_ms[id] + node_ms;
+            for (NodeId succ : node.successors) {
+                if (finish_ms > path_ms[succ]) {
+                    path_ms[succ] = finish_ms;
+                    parent[succ] = id;
+                }
+            }
+            path_ms[id] = finish_ms;
+        }
+
+        NodeId last = static_cast<NodeId>(
+            std::max_element(path_ms.begin(), path_ms.end()) - path_ms.begin());
+        result.critical_path_ms = path_ms[last];
+        for (NodeId id = last; id != none; id = parent[id]) {
+            result.critical_path.push_back(nodes_[id].name);
+        }
+        std::reverse(result.critical_path.begin(), result.critical_path.end());
+        return result;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Node {
+        Node(std::string n, Task w)
+            : name(std::move(n)), work(std::move(w)), num_predecessors(0),
+              pending(0), duration(0) {}
+
+        std::string name;
+        Task work;
+        std::vector<NodeId> successors;
+        size_t num_predecessors;
+        std::atomic<size_t> pending;
+        Clock::duration duration;
+    };
+
+    static double to_ms(Clock::duration d) {
+        return std::chrono::duration<double, std::milli>(d).count();
+    }
+
+    // Recompute roots and topological order after edits; rejects cycles
+    void prepare() {
+        if (!dirty_) {
+            return;
+        }
+
+        roots_.clear();
+        topological_order_.clear();
+        topological_order_.reserve(nodes_.size());
+
+        std::vector<size_t> in_degree(nodes_.size());
+        for (NodeId id = 0; id < nodes_.size(); ++id) {
+            in_degree[id] = nodes_[id].num_predecessors;
+            if (in_degree[id] == 0) {
+                roots_.push_back(id);
+                topological_order_.push_back(id);
+            }
+        }
+
+        for (size_t i = 0; i < topological_order_.size(); ++i) {
+            for (NodeId succ : nodes_[topological_order_[i]].successors) {
+                if (--in_degree[succ] == 0) {
+                    topological_order_.push_back(succ);
+                }
+            }
+        }
+
+        if (topological_order_.size() != nodes_.size()) {
+            throw std::logic_error("TaskGraph contains a cycle");
+        }
+        dirty_ = false;
+    }
+
+    void schedule(NodeId id) {
+        pool_->submit_detached([this, id]() { execute(id); });
+    }
+
+    // Runs a node, releases its successors, and keeps going with the first
+    // one that became ready so a chain stays on one warm core
+    void execute(NodeId id) {
+        const NodeId none = std::numeric_limits<NodeId>::max();
+
+        while (id != none) {
+            Node& node = nodes_[id];
+
+            auto begin = Clock::now();
+            if (!failed_.load(std::memory_order_relaxed)) {
+                try {
+                    node.work();
+                } catch (...) {
+                    record_error();
+                }
+            }
+            node.duration = Clock::now() - begin;
+
+            NodeId next = none;
+            for (NodeId succ : node.successors) {
+                if (nodes_[succ].pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    if (next == none) {
+                        next = succ;
+                    } else {
+                        schedule(succ);
+                    }
+                }
+            }
+
+            // Last touch of `this` when the graph completes: run() may return
+            if (remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                std::lock_guard<std::mutex> lock(done_mutex_);
+                completed_ = true;
+                done_condition_.notify_all();
+            }
+            id = next;
+        }
+    }
+
+    void record_error() {
+        std::lock_guard<std::mutex> lock(done_mutex_);
+        if (!error_) {
+            error_ = std::current_exception();
+        }
+        failed_.store(true, std::memory_order_relaxed);
+    }
+
+    std::deque<Node> nodes_;
+    std::vector<NodeId> roots_;
+    std::vector<NodeId> topological_order_;
+
+    std::atomic<size_t> remaining_;
+    std::atomic<bool> failed_;
+    std::exception_ptr error_;
+    std::mutex done_mutex_;
+    std::condition_variable done_condition_;
+    bool completed_;                    // guarded by done_mutex_
+
+    ThreadPool* pool_;
+    bool dirty_;
+    Clock::time_point start_;
+    Clock::time_point finish_;
+};
+
+#endif // TASK_GRAPH_H
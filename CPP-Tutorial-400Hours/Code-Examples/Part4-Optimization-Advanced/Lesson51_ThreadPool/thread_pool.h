@@ -8,6 +8,7 @@
 
 #include <vector>
 #include <queue>
+#include <deque>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
@@ -17,17 +18,77 @@
 #include <memory>
 #include <stdexcept>
 #include <iostream>
+#include <cstdint>
+#include <algorithm>
+#include <tuple>
+#include <chrono>
+
+#include "mpmc_queue.h"
+#include "task.h"
+#include "work_stealing_deque.h"
+
+namespace detail {
+
+// Binds f(args...) into a Task that fulfils a promise whose shared state
+// comes from the recycling allocator; exceptions propagate to the future.
+// Arguments are copied like std::bind would.
+template<typename F, typename... Args>
+auto package_task(F&& f, Args&&... args)
+    -> std::pair<Task, std::future<typename std::invoke_result<F, Args...>::type>> {
+
+    using return_type = typename std::invoke_result<F, Args...>::type;
+
+    std::promise<return_type> promise(std::allocator_arg, RecyclingAllocator<char>());
+    std::future<return_type> result = promise.get_future();
+
+    Task task([promise = std::move(promise),
+               fn = std::forward<F>(f),
+               bound = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+        try {
+            if constexpr (std::is_void<return_type>::value) {
+                std::apply(fn, bound);
+                promise.set_value();
+            } else {
+                promise.set_value(std::apply(fn, bound));
+            }
+        } catch (...) {
+            promise.set_exception(std::current_exception());
+        }
+    });
+
+    return {std::move(task), std::move(result)};
+}
+
+} // namespace detail
 
 class ThreadPool {
 public:
+    // SharedQueue: every worker pops from one mutex-guarded FIFO.
+    // WorkStealing: each worker owns a Chase-Lev deque; external submitters
+    // go through a global injection queue and idle workers steal from
+    // random victims.
+    enum class SchedulingMode {
+        SharedQueue,
+        WorkStealing
+    };
+
     // Constructor: create thread pool with specified number of workers
-    explicit ThreadPool(size_t num_threads = std::thread::hardware_concurrency())
-        : stop_(false), active_tasks_(0) {
+    explicit ThreadPool(size_t num_threads = std::thread::hardware_concurrency(),
+                        SchedulingMode mode = SchedulingMode::SharedQueue)
+        : mode_(mode), stop_(false), active_tasks_(0),
+          pending_(0), queued_(0), injected_(0), sleepers_(0) {
 
         if (num_threads == 0) {
             num_threads = 1;
         }
 
+        if (mode_ == SchedulingMode::WorkStealing) {
+            local_queues_.reserve(num_threads);
+            for (size_t i = 0; i < num_threads; ++i) {
+                local_queues_.push_back(std::make_unique<WorkerQueue>());
+            }
+        }
+
         workers_.reserve(num_threads);
 
         for (size_t i = 0; i < num_threads; ++i) {
@@ -53,59 +114,83 @@ public:
     auto submit(F&& f, Args&&... args)
         -> std::future<typename std::invoke_result<F, Args...>::type> {
 
-        using return_type = typename std::invoke_result<F, Args...>::type;
-
-        auto task = std::make_shared<std::packaged_task<return_type()>>(
-            std::bind(std::forward<F>(f), std::forward<Args>(args)...)
-        );
-
-        std::future<return_type> result = task->get_future();
-
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-
-            if (stop_) {
-                throw std::runtime_error("Cannot submit task to stopped thread pool");
-            }
-
-            tasks_.emplace([task]() { (*task)(); });
-        }
-
-        condition_.notify_one();
-        return result;
+        auto packaged = detail::package_task(std::forward<F>(f), std::forward<Args>(args)...);
+        enqueue(std::move(packaged.first));
+        return std::move(packaged.second);
     }
 
     // Submit a task without getting a future
     template<typename F>
     void submit_detached(F&& f) {
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-
-            if (stop_) {
-                throw std::runtime_error("Cannot submit task to stopped thread pool");
-            }
-
-            tasks_.emplace(std::forward<F>(f));
-        }
-
-        condition_.notify_one();
+        enqueue(Task(std::forward<F>(f)));
     }
 
     // Wait for all tasks to complete
     void wait_all() {
+        if (mode_ == SchedulingMode::WorkStealing) {
+            std::unique_lock<std::mutex> lock(wait_mutex_);
+            wait_condition_.wait(lock, [this] {
+                return pending_.load() == 0;
+            });
+            return;
+        }
+
         std::unique_lock<std::mutex> lock(queue_mutex_);
         wait_condition_.wait(lock, [this] {
             return tasks_.empty() && active_tasks_ == 0;
         });
     }
 
+    // Run one queued task on the calling thread, if any is available.
+    // Lets a thread that is waiting on pool work help instead of blocking,
+    // which keeps nested waits (e.g. parallel loops inside tasks) deadlock-free.
+    bool try_run_pending_task() {
+        if (mode_ == SchedulingMode::WorkStealing) {
+            static thread_local uint64_t rng = 0x2545F4914F6CDD1Dull;
+
+            WorkerContext& context = current_worker();
+            const bool is_worker = context.pool == this;
+            const size_t id = is_worker ? context.index : workers_.size();
+
+            TaskNode* node = is_worker ? find_task(context.index, rng)
+                                       : find_task_external(rng);
+            if (!node) {
+                return false;
+            }
+            run_node(node, id);
+            return true;
+        }
+
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex_);
+            if (tasks_.empty()) {
+                return false;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop();
+            ++active_tasks_;
+        }
+
+        run_shared_task(task, workers_.size());
+        return true;
+    }
+
     // Get number of worker threads
     size_t thread_count() const {
         return workers_.size();
     }
 
+    SchedulingMode scheduling_mode() const {
+        return mode_;
+    }
+
     // Get number of pending tasks
     size_t pending_tasks() const {
+        if (mode_ == SchedulingMode::WorkStealing) {
+            return queued_.load();
+        }
+
         std::unique_lock<std::mutex> lock(queue_mutex_);
         return tasks_.size();
     }
@@ -130,10 +215,101 @@ public:
     }
 
 private:
+    // Heap node for the work-stealing deques, recycled through the block cache
+    struct TaskNode {
+        explicit TaskNode(Task&& t) noexcept : task(std::move(t)) {}
+
+        static void* operator new(size_t size) {
+            return detail::allocate_small(size);
+        }
+
+        static void operator delete(void* ptr, size_t size) noexcept {
+            detail::deallocate_small(ptr, size);
+        }
+
+        Task task;
+    };
+    static_assert(sizeof(TaskNode) <= detail::kMaxSmallBlock, "TaskNode must fit a cached block");
+
+    struct alignas(64) WorkerQueue {
+        ChaseLevDeque<TaskNode*> deque;
+    };
+
+    // Identifies the pool and slot of the calling thread, if it is a worker
+    struct WorkerContext {
+        const ThreadPool* pool = nullptr;
+        size_t index = 0;
+    };
+
+    static WorkerContext& current_worker() {
+        static thread_local WorkerContext context;
+        return context;
+    }
+
+    void enqueue(Task fn) {
+        if (mode_ == SchedulingMode::WorkStealing) {
+            enqueue_stealing(std::move(fn));
+            return;
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex_);
+
+            if (stop_) {
+                throw std::runtime_error("Cannot submit task to stopped thread pool");
+            }
+
+            tasks_.emplace(std::move(fn));
+        }
+
+        condition_.notify_one();
+    }
+
+    void enqueue_stealing(Task fn) {
+        WorkerContext& context = current_worker();
+
+        if (context.pool == this) {
+            // Spawned from one of our workers: push to its own deque (LIFO,
+            // cache-hot) without touching any shared lock
+            pending_.fetch_add(1);
+            local_queues_[context.index]->deque.push(new TaskNode(std::move(fn)));
+            queued_.fetch_add(1);
+
+            if (sleepers_.load() > 0) {
+                { std::lock_guard<std::mutex> lock(queue_mutex_); }
+                condition_.notify_one();
+            }
+            return;
+        }
+
+        auto node = std::make_unique<TaskNode>(std::move(fn));
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex_);
+
+            if (stop_) {
+                throw std::runtime_error("Cannot submit task to stopped thread pool");
+            }
+
+            pending_.fetch_add(1);
+            injection_.push_back(node.release());
+            injected_.fetch_add(1);
+            queued_.fetch_add(1);
+        }
+
+        if (sleepers_.load() > 0) {
+            condition_.notify_one();
+        }
+    }
+
     // Worker thread function
     void worker_thread(size_t thread_id) {
+        if (mode_ == SchedulingMode::WorkStealing) {
+            stealing_worker_thread(thread_id);
+            return;
+        }
+
         while (true) {
-            std::function<void()> task;
+            Task task;
 
             {
                 std::unique_lock<std::mutex> lock(queue_mutex_);
@@ -154,29 +330,176 @@ private:
             }
 
             if (task) {
-                try {
-                    task();
-                } catch (const std::exception& e) {
-                    // Log exception (in production, use proper logging)
-                    std::cerr << "Thread " << thread_id
-                             << " caught exception: " << e.what() << "\n";
-                } catch (...) {
-                    std::cerr << "Thread " << thread_id
-                             << " caught unknown exception\n";
-                }
+                run_shared_task(task, thread_id);
+            }
+        }
+    }
 
-                {
-                    std::unique_lock<std::mutex> lock(queue_mutex_);
-                    --active_tasks_;
-                }
+    void run_shared_task(Task& task, size_t thread_id) {
+        run_task(task, thread_id);
+        task.reset();
+
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex_);
+            --active_tasks_;
+        }
+
+        wait_condition_.notify_all();
+    }
+
+    void stealing_worker_thread(size_t thread_id) {
+        WorkerContext& context = current_worker();
+        context.pool = this;
+        context.index = thread_id;
+
+        // xorshift state for victim selection; never zero
+        uint64_t rng = 0x9E3779B97F4A7C15ull * (thread_id + 1);
+
+        while (true) {
+            TaskNode* node = find_task(thread_id, rng);
+
+            if (node) {
+                run_node(node, thread_id);
+                continue;
+            }
 
-                wait_condition_.notify_all();
+            std::unique_lock<std::mutex> lock(queue_mutex_);
+            sleepers_.fetch_add(1);
+            condition_.wait(lock, [this] {
+                return stop_ || queued_.load() > 0;
+            });
+            sleepers_.fetch_sub(1);
+
+            if (stop_ && queued_.load() == 0) {
+                context.pool = nullptr;
+                return;
+            }
+        }
+    }
+
+    void run_node(TaskNode* node, size_t thread_id) {
+        std::unique_ptr<TaskNode> task(node);
+        run_task(task->task, thread_id);
+        task.reset();
+
+        if (pending_.fetch_sub(1) == 1) {
+            { std::lock_guard<std::mutex> lock(wait_mutex_); }
+            wait_condition_.notify_all();
+        }
+    }
+
+    static size_t next_victim(uint64_t& rng, size_t num_queues) {
+        rng ^= rng << 13;
+        rng ^= rng >> 7;
+        rng ^= rng << 17;
+        return static_cast<size_t>(rng % num_queues);
+    }
+
+    // Own deque first, then the injection queue, then random victims
+    TaskNode* find_task(size_t thread_id, uint64_t& rng) {
+        ChaseLevDeque<TaskNode*>& own = local_queues_[thread_id]->deque;
+
+        if (TaskNode* node = own.pop()) {
+            queued_.fetch_sub(1);
+            return node;
+        }
+
+        if (injected_.load(std::memory_order_relaxed) > 0) {
+            if (TaskNode* node = take_injected(own)) {
+                return node;
+            }
+        }
+
+        const size_t num_queues = local_queues_.size();
+        for (size_t attempt = 0; attempt < 2 * num_queues; ++attempt) {
+            size_t victim = next_victim(rng, num_queues);
+            if (victim == thread_id) {
+                continue;
+            }
+
+            if (TaskNode* node = local_queues_[victim]->deque.steal()) {
+                queued_.fetch_sub(1);
+                return node;
+            }
+        }
+
+        return nullptr;
+    }
+
+    // For threads outside the pool: one task from the injection queue,
+    // otherwise one stolen from a worker deque
+    TaskNode* find_task_external(uint64_t& rng) {
+        if (injected_.load(std::memory_order_relaxed) > 0) {
+            std::unique_lock<std::mutex> lock(queue_mutex_);
+            if (!injection_.empty()) {
+                TaskNode* node = injection_.front();
+                injection_.pop_front();
+                injected_.fetch_sub(1);
+                queued_.fetch_sub(1);
+                return node;
+            }
+        }
+
+        const size_t num_queues = local_queues_.size();
+        const size_t start = next_victim(rng, num_queues);
+        for (size_t i = 0; i < num_queues; ++i) {
+            size_t victim = (start + i) % num_queues;
+            if (TaskNode* node = local_queues_[victim]->deque.steal()) {
+                queued_.fetch_sub(1);
+                return node;
             }
         }
+
+        return nullptr;
+    }
+
+    // Grab a fair share of the injection queue in one lock acquisition; the
+    // surplus goes to our own deque where other workers can steal it
+    TaskNode* take_injected(ChaseLevDeque<TaskNode*>& own) {
+        std::unique_lock<std::mutex> lock(queue_mutex_);
+        if (injection_.empty()) {
+            return nullptr;
+        }
+
+        size_t batch = injection_.size() / local_queues_.size() + 1;
+        batch = std::min({batch, injection_.size(), kMaxInjectionBatch});
+
+        TaskNode* first = injection_.front();
+        injection_.pop_front();
+        for (size_t i = 1; i < batch; ++i) {
+            own.push(injection_.front());
+            injection_.pop_front();
+        }
+        injected_.fetch_sub(batch);
+        lock.unlock();
+
+        // Only the task we run leaves the queued count; the rest moved deques
+        queued_.fetch_sub(1);
+        if (batch > 1 && sleepers_.load() > 0) {
+            condition_.notify_one();
+        }
+        return first;
+    }
+
+    void run_task(Task& task, size_t thread_id) {
+        try {
+            task();
+        } catch (const std::exception& e) {
+            // Log exception (in production, use proper logging)
+            std::cerr << "Thread " << thread_id
+                     << " caught exception: " << e.what() << "\n";
+        } catch (...) {
+            std::cerr << "Thread " << thread_id
+                     << " caught unknown exception\n";
+        }
     }
 
+    static constexpr size_t kMaxInjectionBatch = 32;
+
+    const SchedulingMode mode_;
+
     std::vector<std::thread> workers_;
-    std::queue<std::function<void()>> tasks_;
+    std::queue<Task, std::deque<Task, RecyclingAllocator<Task>>> tasks_;
 
     mutable std::mutex queue_mutex_;
     std::condition_variable condition_;
@@ -184,9 +507,21 @@ private:
 
     std::atomic<bool> stop_;
     std::atomic<size_t> active_tasks_;
+
+    // Work-stealing mode state
+    std::vector<std::unique_ptr<WorkerQueue>> local_queues_;
+    std::deque<TaskNode*, RecyclingAllocator<TaskNode*>> injection_;
+    std::mutex wait_mutex_;
+    std::atomic<size_t> pending_;    // submitted but not yet finished
+    std::atomic<size_t> queued_;     // sitting in a deque or the injection queue
+    std::atomic<size_t> injected_;   // sitting in the injection queue
+    std::atomic<size_t> sleepers_;
 };
 
 // Priority Thread Pool with task priorities
+// Each priority level has its own bounded lock-free MPMC ring. Workers poll
+// the lanes in strict or weighted order, and a lane that has waited longer
+// than the aging limit is served first so LOW work cannot starve.
 class PriorityThreadPool {
 public:
     enum class Priority {
@@ -196,14 +531,27 @@ public:
         CRITICAL = 3
     };
 
-    explicit PriorityThreadPool(size_t num_threads = std::thread::hardware_concurrency())
-        : stop_(false) {
+    enum class LanePolicy {
+        Strict,    // always the highest non-empty lane
+        Weighted   // CRITICAL:HIGH:NORMAL:LOW polled 8:4:2:1, then strict
+    };
+
+    explicit PriorityThreadPool(size_t num_threads = std::thread::hardware_concurrency(),
+                                LanePolicy policy = LanePolicy::Strict,
+                                size_t lane_capacity = 1024,
+                                std::chrono::microseconds aging_limit = std::chrono::milliseconds(10))
+        : policy_(policy), aging_limit_ns_(std::chrono::nanoseconds(aging_limit).count()),
+          stop_(false), exit_(false), submitting_(0), queued_(0), sleepers_(0) {
 
         if (num_threads == 0) num_threads = 1;
 
+        for (size_t p = 0; p < kNumLanes; ++p) {
+            lanes_[p] = std::make_unique<Lane>(lane_capacity);
+        }
+
         workers_.reserve(num_threads);
         for (size_t i = 0; i < num_threads; ++i) {
-            workers_.emplace_back([this] { worker_thread(); });
+            workers_.emplace_back([this, i] { worker_thread(i); });
         }
     }
 
@@ -211,39 +559,64 @@ public:
         shutdown();
     }
 
+    // When the lane is full the caller runs queued tasks itself until there
+    // is room, which throttles producers instead of growing without bound
     template<typename F, typename... Args>
     auto submit(Priority priority, F&& f, Args&&... args)
         -> std::future<typename std::invoke_result<F, Args...>::type> {
 
-        using return_type = typename std::invoke_result<F, Args...>::type;
-
-        auto task = std::make_shared<std::packaged_task<return_type()>>(
-            std::bind(std::forward<F>(f), std::forward<Args>(args)...)
-        );
+        auto packaged = detail::package_task(std::forward<F>(f), std::forward<Args>(args)...);
 
-        std::future<return_type> result = task->get_future();
+        // Paired with shutdown(): either we see stop_, or shutdown waits for us
+        submitting_.fetch_add(1);
+        if (stop_.load()) {
+            submitting_.fetch_sub(1);
+            throw std::runtime_error("Cannot submit to stopped thread pool");
+        }
 
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
+        Lane& lane = *lanes_[static_cast<size_t>(priority)];
+        if (lane.queue.empty_approx()) {
+            // Aging measures how long the lane has been waiting, not idle
+            lane.last_served_ns.store(now_ns(), std::memory_order_relaxed);
+        }
 
-            if (stop_) {
-                throw std::runtime_error("Cannot submit to stopped thread pool");
+        // Count first so a worker popping the task never sees the counter wrap
+        queued_.fetch_add(1);
+        size_t cursor = 0;
+        while (!lane.queue.try_push(std::move(packaged.first))) {
+            if (!run_one(cursor, workers_.size())) {
+                std::this_thread::yield();
             }
+        }
+        submitting_.fetch_sub(1);
 
-            tasks_.push({static_cast<int>(priority), [task]() { (*task)(); }});
+        if (sleepers_.load() > 0) {
+            { std::lock_guard<std::mutex> lock(sleep_mutex_); }
+            condition_.notify_one();
         }
+        return std::move(packaged.second);
+    }
 
-        condition_.notify_one();
-        return result;
+    size_t pending_tasks() const {
+        return queued_.load();
+    }
+
+    size_t thread_count() const {
+        return workers_.size();
     }
 
     void shutdown() {
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            if (stop_) return;
-            stop_ = true;
+        if (stop_.exchange(true)) return;
+
+        // Let in-flight submits land so workers drain them before exiting
+        while (submitting_.load() != 0) {
+            std::this_thread::yield();
         }
 
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
+            exit_ = true;
+        }
         condition_.notify_all();
 
         for (auto& worker : workers_) {
@@ -254,52 +627,119 @@ public:
     }
 
 private:
-    struct PriorityTask {
-        int priority;
-        std::function<void()> task;
+    static constexpr size_t kNumLanes = 4;
 
-        bool operator<(const PriorityTask& other) const {
-            return priority < other.priority;  // Higher priority = larger number
-        }
+    // One weighted round: CRITICAL x8, HIGH x4, NORMAL x2, LOW x1
+    static constexpr size_t kWeightedSchedule[] = {3, 2, 3, 1, 3, 2, 3, 0, 3, 2, 3, 1, 3, 2, 3};
+    static constexpr size_t kScheduleLength = sizeof(kWeightedSchedule) / sizeof(kWeightedSchedule[0]);
+
+    struct alignas(64) Lane {
+        explicit Lane(size_t capacity) : queue(capacity), last_served_ns(0) {}
+
+        BoundedMPMCQueue<Task> queue;
+        std::atomic<int64_t> last_served_ns;
     };
 
-    void worker_thread() {
-        while (true) {
-            std::function<void()> task;
+    static int64_t now_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
 
-            {
-                std::unique_lock<std::mutex> lock(queue_mutex_);
+    bool take_from(size_t lane_index, Task& task, int64_t now) {
+        Lane& lane = *lanes_[lane_index];
+        if (!lane.queue.try_pop(task)) {
+            return false;
+        }
+        lane.last_served_ns.store(now, std::memory_order_relaxed);
+        queued_.fetch_sub(1);
+        return true;
+    }
 
-                condition_.wait(lock, [this] {
-                    return stop_ || !tasks_.empty();
-                });
+    bool pop_task(Task& task, size_t& cursor) {
+        const int64_t now = now_ns();
 
-                if (stop_ && tasks_.empty()) {
-                    return;
-                }
+        // Aging: a non-empty lower lane that has waited too long goes first
+        for (size_t p = 0; p + 1 < kNumLanes; ++p) {
+            Lane& lane = *lanes_[p];
+            if (!lane.queue.empty_approx() &&
+                now - lane.last_served_ns.load(std::memory_order_relaxed) > aging_limit_ns_ &&
+                take_from(p, task, now)) {
+                return true;
+            }
+        }
 
-                if (!tasks_.empty()) {
-                    task = std::move(tasks_.top().task);
-                    tasks_.pop();
-                }
+        if (policy_ == LanePolicy::Weighted) {
+            size_t preferred = kWeightedSchedule[cursor];
+            cursor = (cursor + 1) % kScheduleLength;
+            if (take_from(preferred, task, now)) {
+                return true;
             }
+        }
 
-            if (task) {
-                try {
-                    task();
-                } catch (...) {
-                    // Handle exception
-                }
+        for (size_t p = kNumLanes; p-- > 0;) {
+            if (take_from(p, task, now)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool run_one(size_t& cursor, size_t thread_id) {
+        Task task;
+        if (!pop_task(task, cursor)) {
+            return false;
+        }
+        run_task(task, thread_id);
+        return true;
+    }
+
+    void run_task(Task& task, size_t thread_id) {
+        try {
+            task();
+        } catch (const std::exception& e) {
+            std::cerr << "Priority worker " << thread_id
+                     << " caught exception: " << e.what() << "\n";
+        } catch (...) {
+            std::cerr << "Priority worker " << thread_id
+                     << " caught unknown exception\n";
+        }
+    }
+
+    void worker_thread(size_t thread_id) {
+        // Stagger weighted cursors so workers do not poll lanes in lockstep
+        size_t cursor = thread_id % kScheduleLength;
+
+        while (true) {
+            if (run_one(cursor, thread_id)) {
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(sleep_mutex_);
+            sleepers_.fetch_add(1);
+            condition_.wait(lock, [this] {
+                return exit_ || queued_.load() > 0;
+            });
+            sleepers_.fetch_sub(1);
+
+            if (exit_ && queued_.load() == 0) {
+                return;
             }
         }
     }
 
+    const LanePolicy policy_;
+    const int64_t aging_limit_ns_;
+
+    std::unique_ptr<Lane> lanes_[kNumLanes];
     std::vector<std::thread> workers_;
-    std::priority_queue<PriorityTask> tasks_;
 
-    std::mutex queue_mutex_;
+    std::mutex sleep_mutex_;
     std::condition_variable condition_;
     std::atomic<bool> stop_;
+    bool exit_;                         // guarded by sleep_mutex_
+    std::atomic<size_t> submitting_;
+    std::atomic<size_t> queued_;
+    std::atomic<size_t> sleepers_;
 };
 
 #endif // THREAD_POOL_H
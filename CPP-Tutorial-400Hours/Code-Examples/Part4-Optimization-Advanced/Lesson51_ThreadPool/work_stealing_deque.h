@@ -0,0 +1,146 @@
+/*
+ * Chase-Lev Work-Stealing Deque
+ * Single owner pushes/pops at the bottom, any thread steals from the top.
+ * Memory orderings follow Le, Pop, Cohen, Zappa Nardelli (PPoPP 2013).
+ */
+
+#ifndef WORK_STEALING_DEQUE_H
+#define WORK_STEALING_DEQUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+template<typename T>
+class ChaseLevDeque {
+    static_assert(std::is_pointer<T>::value,
+                  "ChaseLevDeque stores pointers so slots can be read atomically");
+
+public:
+    explicit ChaseLevDeque(size_t initial_capacity = 256)
+        : top_(0), bottom_(0) {
+        size_t capacity = 1;
+        while (capacity < initial_capacity) {
+            capacity <<= 1;
+        }
+        array_.store(new Array(capacity), std::memory_order_relaxed);
+    }
+
+    ~ChaseLevDeque() {
+        delete array_.load(std::memory_order_relaxed);
+    }
+
+    ChaseLevDeque(const ChaseLevDeque&) = delete;
+    ChaseLevDeque& operator=(const ChaseLevDeque&) = delete;
+
+    // Owner only: push to the bottom, growing the ring if it is full
+    void push(T item) {
+        int64_t b = bottom_.load(std::memory_order_relaxed);
+        int64_t t = top_.load(std::memory_order_acquire);
+        Array* a = array_.load(std::memory_order_relaxed);
+
+        if (b - t > static_cast<int64_t>(a->capacity) - 1) {
+            Array* bigger = a->grow(t, b);
+            // Thieves may still be reading the old ring; keep it until we die
+            retired_.emplace_back(a);
+            array_.store(bigger, std::memory_order_release);
+            a = bigger;
+        }
+
+        a->store(b, item);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+
+    // Owner only: pop from the bottom (LIFO), nullptr when empty
+    T pop() {
+        int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+        Array* a = array_.load(std::memory_order_relaxed);
+        bottom_.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top_.load(std::memory_order_relaxed);
+
+        T item = nullptr;
+        if (t <= b) {
+            item = a->load(b);
+            if (t == b) {
+                // Last element: race against thieves for it
+                if (!top_.compare_exchange_strong(t, t + 1,
+                                                  std::memory_order_seq_cst,
+                                                  std::memory_order_relaxed)) {
+                    item = nullptr;
+                }
+                bottom_.store(b + 1, std::memory_order_relaxed);
+            }
+        } else {
+            bottom_.store(b + 1, std::memory_order_relaxed);
+        }
+        return item;
+    }
+
+    // Any thread: steal from the top (FIFO), nullptr when empty or lost the race
+    T steal() {
+        int64_t t = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom_.load(std::memory_order_acquire);
+
+        if (t < b) {
+            Array* a = array_.load(std::memory_order_acquire);
+            T item = a->load(t);
+            if (!top_.compare_exchange_strong(t, t + 1,
+                                              std::memory_order_seq_cst,
+                                              std::memory_order_relaxed)) {
+                return nullptr;
+            }
+            return item;
+        }
+        return nullptr;
+    }
+
+    // Approximate number of items (exact only when called by the owner at rest)
+    size_t size() const {
+        int64_t b = bottom_.load(std::memory_order_relaxed);
+        int64_t t = top_.load(std::memory_order_relaxed);
+        return b > t ? static_cast<size_t>(b - t) : 0;
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+private:
+    struct Array {
+        explicit Array(size_t cap)
+            : capacity(cap), mask(cap - 1), slots(new std::atomic<T>[cap]) {}
+
+        T load(int64_t i) const {
+            return slots[static_cast<size_t>(i) & mask].load(std::memory_order_relaxed);
+        }
+
+        void store(int64_t i, T item) {
+            slots[static_cast<size_t>(i) & mask].store(item, std::memory_order_relaxed);
+        }
+
+        Array* grow(int64_t top, int64_t bottom) const {
+            Array* bigger = new Array(capacity * 2);
+            for (int64_t i = top; i < bottom; ++i) {
+                bigger->store(i, load(i));
+            }
+            return bigger;
+        }
+
+        size_t capacity;
+        size_t mask;
+        std::unique_ptr<std::atomic<T>[]> slots;
+    };
+
+    alignas(64) std::atomic<int64_t> top_;
+    alignas(64) std::atomic<int64_t> bottom_;
+    alignas(64) std::atomic<Array*> array_;
+    std::vector<std::unique_ptr<Array>> retired_;
+};
+
+#endif // WORK_STEALING_DEQUE_H
@@ -8,6 +8,20 @@
 #include <chrono>
 #include <iomanip>
 #include <string>
+#include <numeric>
+#include <random>
+#include <cmath>
+#include <cstdlib>
+
+#include "../Lesson51_ThreadPool/parallel_algorithms.h"
+#include "../Lesson09_SIMD/simd_kernels.h"
+
+// libstdc++ needs TBB for its parallel backend; CMake defines
+// HAVE_PARALLEL_STL when it found and linked it. MSVC ships its own.
+#if defined(_MSC_VER) || defined(HAVE_PARALLEL_STL)
+    #include <execution>
+    #define LESSON_HAS_EXECUTION_POLICIES 1
+#endif
 
 class Timer {
     std::chrono::high_resolution_clock::time_point start_;
@@ -26,44 +40,191 @@ void print_header(const std::string& title) {
     std::cout << std::string(60, '=') << "\n";
 }
 
-// Example demonstration function
-void demonstrate_parallelalgorithms() {
-    print_header("C++17 Parallel Algorithms");
+// Widest kernels the CPU supports, picked at runtime by simd_kernels.h
+inline void add_arrays_best(const float* a, const float* b, float* result, size_t n) {
+    simd::add_arrays(a, b, result, n);
+}
+
+inline float dot_product_best(const float* a, const float* b, size_t n) {
+    return simd::dot_product(a, b, n);
+}
 
-    std::cout << "This lesson demonstrates parallel STL.\n";
-    std::cout << "\nKey concepts:\n";
-    std::cout << "  - Practical implementation examples\n";
-    std::cout << "  - Performance benchmarks\n";
-    std::cout << "  - Best practices\n";
-    std::cout << "  - Real-world applications\n";
+// Hand-picked chunk size for the std::execution baseline, the way call
+// sites tune it today
+constexpr size_t kFixedChunk = 16384;
 
+// Average milliseconds per call of fn over enough repetitions to be stable
+template<typename F>
+double time_per_call(size_t n, F&& fn) {
+    const size_t reps = std::max<size_t>(3, 20000000 / n);
+    fn();  // warm up caches, pages and the pool
     Timer t;
+    for (size_t r = 0; r < reps; ++r) {
+        fn();
+    }
+    return t.elapsed_ms() / reps;
+}
+
+void print_row(size_t n, double serial_ms, double stl_ms, double pool_ms) {
+    std::cout << std::right << std::setw(11) << n
+              << std::setw(13) << std::fixed << std::setprecision(4) << serial_ms;
+    if (stl_ms > 0.0) {
+        std::cout << std::setw(15) << stl_ms;
+    } else {
+        std::cout << std::setw(15) << "n/a";
+    }
+    std::cout << std::setw(15) << pool_ms
+              << std::setw(10) << std::setprecision(2) << serial_ms / pool_ms << "x\n";
+}
 
-    // Example computation
-    const size_t iterations = 1000000;
-    long long sum = 0;
+void print_table_header(const char* title) {
+    std::cout << "\n" << title << " (ms per call)\n";
+    std::cout << std::right << std::setw(11) << "Elements"
+              << std::setw(13) << "Serial SIMD"
+              << std::setw(15) << "for_each(par)"
+              << std::setw(15) << "parallel_for"
+              << std::setw(11) << "Speedup" << "\n";
+    std::cout << std::string(65, '-') << "\n";
+}
 
-    for (size_t i = 0; i < iterations; ++i) {
-        sum += i;
+std::vector<size_t> benchmark_sizes(size_t max_elements) {
+    std::vector<size_t> sizes;
+    for (size_t n = 1000; n <= max_elements; n *= 10) {
+        sizes.push_back(n);
     }
+    return sizes;
+}
+
+void benchmark_add_arrays(ThreadPool& pool, size_t max_elements) {
+    print_table_header("add_arrays");
+
+    for (size_t n : benchmark_sizes(max_elements)) {
+        std::vector<float> a(n, 1.5f), b(n, 2.5f), result(n);
 
-    double elapsed = t.elapsed_ms();
+        double serial_ms = time_per_call(n, [&] {
+            add_arrays_best(a.data(), b.data(), result.data(), n);
+        });
 
-    std::cout << "\nBenchmark results:\n";
-    std::cout << "  Iterations: " << iterations << "\n";
-    std::cout << "  Sum: " << sum << "\n";
-    std::cout << "  Time: " << std::fixed << std::setprecision(2) << elapsed << " ms\n";
+        double stl_ms = 0.0;
+#ifdef LESSON_HAS_EXECUTION_POLICIES
+        std::vector<size_t> chunks((n + kFixedChunk - 1) / kFixedChunk);
+        std::iota(chunks.begin(), chunks.end(), size_t{0});
+        stl_ms = time_per_call(n, [&] {
+            std::for_each(std::execution::par, chunks.begin(), chunks.end(), [&](size_t c) {
+                size_t begin = c * kFixedChunk;
+                size_t count = std::min(kFixedChunk, n - begin);
+                add_arrays_best(a.data() + begin, b.data() + begin, result.data() + begin, count);
+            });
+        });
+#endif
+
+        double pool_ms = time_per_call(n, [&] {
+            parallel_for_range(pool, 0, n, [&](size_t begin, size_t end) {
+                add_arrays_best(a.data() + begin, b.data() + begin, result.data() + begin, end - begin);
+            });
+        });
+
+        if (result[n - 1] != 4.0f) {
+            std::cout << "add_arrays produced a wrong result\n";
+        }
+        print_row(n, serial_ms, stl_ms, pool_ms);
+    }
 }
 
-int main() {
+void benchmark_dot_product(ThreadPool& pool, size_t max_elements) {
+    print_table_header("dot_product");
+
+    for (size_t n : benchmark_sizes(max_elements)) {
+        std::vector<float> a(n, 0.5f), b(n, 2.0f);
+        volatile float sink = 0.0f;
+
+        double serial_ms = time_per_call(n, [&] {
+            sink = dot_product_best(a.data(), b.data(), n);
+        });
+
+        double stl_ms = 0.0;
+#ifdef LESSON_HAS_EXECUTION_POLICIES
+        std::vector<size_t> chunks((n + kFixedChunk - 1) / kFixedChunk);
+        std::iota(chunks.begin(), chunks.end(), size_t{0});
+        std::vector<float> chunk_sums(chunks.size());
+        stl_ms = time_per_call(n, [&] {
+            std::for_each(std::execution::par, chunks.begin(), chunks.end(), [&](size_t c) {
+                size_t begin = c * kFixedChunk;
+                size_t count = std::min(kFixedChunk, n - begin);
+                chunk_sums[c] = dot_product_best(a.data() + begin, b.data() + begin, count);
+            });
+            sink = std::accumulate(chunk_sums.begin(), chunk_sums.end(), 0.0f);
+        });
+#endif
+
+        float pooled = 0.0f;
+        double pool_ms = time_per_call(n, [&] {
+            pooled = parallel_reduce(pool, 0, n, 0.0f,
+                [&](size_t begin, size_t end) {
+                    return dot_product_best(a.data() + begin, b.data() + begin, end - begin);
+                },
+                [](float x, float y) { return x + y; });
+        });
+
+        if (std::fabs(pooled - static_cast<float>(n)) > 1e-3f * n) {
+            std::cout << "parallel_reduce produced a wrong result: " << pooled << "\n";
+        }
+        (void)sink;
+        print_row(n, serial_ms, stl_ms, pool_ms);
+    }
+}
+
+void demonstrate_parallel_transform(ThreadPool& pool) {
+    print_header("parallel_transform / parallel_for");
+
+    const size_t n = 1000000;
+    std::vector<double> input(n);
+    std::iota(input.begin(), input.end(), 0.0);
+    std::vector<double> output(n);
+
+    parallel_transform(pool, input.begin(), input.end(), output.begin(),
+                       [](double x) { return std::sqrt(x); });
+    std::cout << "sqrt(999999) = " << output[n - 1] << "\n";
+
+    std::vector<int> squares(1000);
+    parallel_for(pool, 0, 1000, [&](int i) { squares[i] = i * i; });
+    std::cout << "squares[999] = " << squares[999] << "\n";
+
+    long long total = parallel_reduce(pool, 0, squares.size(), 0LL,
+        [&](size_t begin, size_t end) {
+            return std::accumulate(squares.begin() + begin, squares.begin() + end, 0LL);
+        },
+        [](long long x, long long y) { return x + y; });
+    std::cout << "sum of squares below 1000 = " << total << "\n";
+}
+
+int main(int argc, char* argv[]) {
     std::cout << "Lesson 57: C++17 Parallel Algorithms\n";
     std::cout << std::string(60, '=') << "\n";
 
-    demonstrate_parallelalgorithms();
+    // Largest size defaults to 100M floats (~1.2 GB for add_arrays);
+    // pass a smaller limit on memory-constrained machines
+    size_t max_elements = 100000000;
+    if (argc > 1) {
+        max_elements = std::strtoull(argv[1], nullptr, 10);
+    }
+
+    ThreadPool pool(std::thread::hardware_concurrency(),
+                    ThreadPool::SchedulingMode::WorkStealing);
+    std::cout << "Worker threads: " << pool.thread_count() << "\n";
+#ifndef LESSON_HAS_EXECUTION_POLICIES
+    std::cout << "std::execution::par unavailable in this build (no TBB); column shows n/a\n";
+#endif
+
+    demonstrate_parallel_transform(pool);
+
+    print_header("Parallel SIMD kernels vs std::execution::par");
+    benchmark_add_arrays(pool, max_elements);
+    benchmark_dot_product(pool, max_elements);
 
     print_header("Conclusion");
-    std::cout << "Successfully demonstrated parallel STL.\n";
-    std::cout << "Review the code and experiment with modifications.\n";
+    std::cout << "parallel_for splits lazily and sizes chunks from measured cost,\n";
+    std::cout << "so no call site needs a hand-tuned chunk size.\n";
     std::cout << std::string(60, '=') << "\n";
 
     return 0;
@@ -8,6 +8,11 @@
 #include <chrono>
 #include <iomanip>
 #include <string>
+#include <cmath>
+#include <cstdint>
+#include <future>
+
+#include "../Lesson51_ThreadPool/task_graph.h"
 
 class Timer {
     std::chrono::high_resolution_clock::time_point start_;
@@ -26,44 +31,262 @@ void print_header(const std::string& title) {
     std::cout << std::string(60, '=') << "\n";
 }
 
-// Example demonstration function
-void demonstrate_taskparallelism() {
-    print_header("Task-Based Parallelism");
+// ========== Pipeline Stages ==========
+// Each batch goes decode -> transform (split into parts) -> reduce -> write.
+// Writes are ordered: batch i is written after batch i-1.
+
+constexpr size_t kBatches = 8;
+constexpr size_t kBatchSize = 1 << 17;
+constexpr size_t kTransformParts = 4;
+constexpr size_t kPartSize = kBatchSize / kTransformParts;
+
+struct Batch {
+    std::vector<float> samples = std::vector<float>(kBatchSize);
+    double partial_sums[kTransformParts] = {};
+    double total = 0.0;
+};
+
+void decode(Batch& batch, uint32_t seed) {
+    uint32_t state = seed * 2654435761u + 1;
+    for (float& s : batch.samples) {
+        state = state * 1664525u + 1013904223u;
+        s = static_cast<float>(state >> 8) / static_cast<float>(1 << 24);
+    }
+}
+
+void transform(Batch& batch, size_t part) {
+    double sum = 0.0;
+    float* data = batch.samples.data() + part * kPartSize;
+    for (size_t i = 0; i < kPartSize; ++i) {
+        data[i] = std::sqrt(data[i]) * std::sin(data[i] * 3.14159f);
+        sum += data[i];
+    }
+    batch.partial_sums[part] = sum;
+}
+
+void reduce(Batch& batch) {
+    batch.total = 0.0;
+    for (double partial : batch.partial_sums) {
+        batch.total += partial;
+    }
+}
+
+void write(const Batch& batch, double& checksum) {
+    // Order-dependent so out-of-order writes would change the result
+    checksum = checksum * 0.5 + batch.total;
+}
+
+// ========== Three Ways to Run One Frame ==========
+
+double run_sequential(std::vector<Batch>& batches) {
+    double checksum = 0.0;
+    for (size_t b = 0; b < kBatches; ++b) {
+        decode(batches[b], static_cast<uint32_t>(b));
+        for (size_t p = 0; p < kTransformParts; ++p) {
+            transform(batches[b], p);
+        }
+        reduce(batches[b]);
+        write(batches[b], checksum);
+    }
+    return checksum;
+}
+
+// The pattern this lesson replaces: dependencies expressed as future::get()
+// inside pool tasks, so a worker sits blocked until its inputs exist
+double run_future_chains(ThreadPool& pool, std::vector<Batch>& batches) {
+    double checksum = 0.0;
+    std::vector<std::shared_future<void>> decoded(kBatches);
+    std::vector<std::shared_future<void>> reduced(kBatches);
+    std::shared_future<void> previous_write;
+
+    for (size_t b = 0; b < kBatches; ++b) {
+        Batch& batch = batches[b];
+        decoded[b] = pool.submit([&batch, b] { decode(batch, static_cast<uint32_t>(b)); }).share();
+
+        std::vector<std::shared_future<void>> parts;
+        for (size_t p = 0; p < kTransformParts; ++p) {
+            auto input = decoded[b];
+            parts.push_back(pool.submit([&batch, p, input] {
+                input.get();
+                transform(batch, p);
+            }).share());
+        }
+
+        reduced[b] = pool.submit([&batch, parts] {
+            for (auto& part : parts) part.get();
+            reduce(batch);
+        }).share();
+
+        auto input = reduced[b];
+        auto prior = previous_write;
+        previous_write = pool.submit([&batch, &checksum, input, prior] {
+            input.get();
+            if (prior.valid()) prior.get();
+            write(batch, checksum);
+        }).share();
+    }
+
+    previous_write.get();
+    return checksum;
+}
+
+// Built once, replayed every frame
+struct PipelineGraph {
+    TaskGraph graph;
+    double checksum = 0.0;
+
+    explicit PipelineGraph(std::vector<Batch>& batches) {
+        TaskGraph::NodeId previous_write = 0;
+
+        for (size_t b = 0; b < kBatches; ++b) {
+            Batch* batch = &batches[b];
+            std::string tag = "[" + std::to_string(b) + "]";
+
+            auto d = graph.add("decode" + tag, [batch, b] { decode(*batch, static_cast<uint32_t>(b)); });
+            auto r = graph.add("reduce" + tag, [batch] { reduce(*batch); });
+            for (size_t p = 0; p < kTransformParts; ++p) {
+                auto t = graph.add("transform" + tag + "." + std::to_string(p),
+                                   [batch, p] { transform(*batch, p); });
+                graph.precede(d, t);
+                graph.precede(t, r);
+            }
+
+            auto w = graph.add("write" + tag, [this, batch] { write(*batch, checksum); });
+            graph.precede(r, w);
+            if (b > 0) {
+                graph.precede(previous_write, w);
+            }
+            previous_write = w;
+        }
+    }
+
+    double run(ThreadPool& pool) {
+        checksum = 0.0;
+        graph.run(pool);
+        return checksum;
+    }
+};
+
+void benchmark_pipeline() {
+    print_header("Pipeline DAG: decode -> transform -> reduce -> write");
+
+    const int frames = 50;
+    const size_t threads = std::max(2u, std::thread::hardware_concurrency());
+    std::vector<Batch> batches(kBatches);
+
+    std::cout << kBatches << " batches x " << kBatchSize << " samples, "
+              << kTransformParts << " transform parts per batch, "
+              << frames << " frames, " << threads << " workers\n\n";
+
+    double reference = 0.0;
+    double sequential_ms = 0.0;
+    {
+        Timer t;
+        for (int f = 0; f < frames; ++f) {
+            reference = run_sequential(batches);
+        }
+        sequential_ms = t.elapsed_ms() / frames;
+    }
+
+    double futures_ms = 0.0;
+    double futures_checksum = 0.0;
+    {
+        ThreadPool pool(threads);
+        Timer t;
+        for (int f = 0; f < frames; ++f) {
+            futures_checksum = run_future_chains(pool, batches);
+        }
+        futures_ms = t.elapsed_ms() / frames;
+    }
 
-    std::cout << "This lesson demonstrates task graphs.\n";
-    std::cout << "\nKey concepts:\n";
-    std::cout << "  - Practical implementation examples\n";
-    std::cout << "  - Performance benchmarks\n";
-    std::cout << "  - Best practices\n";
-    std::cout << "  - Real-world applications\n";
+    double graph_ms = 0.0;
+    double graph_checksum = 0.0;
+    ThreadPool pool(threads, ThreadPool::SchedulingMode::WorkStealing);
+    PipelineGraph pipeline(batches);
+    {
+        pipeline.run(pool);  // warm up
+        Timer t;
+        for (int f = 0; f < frames; ++f) {
+            graph_checksum = pipeline.run(pool);
+        }
+        graph_ms = t.elapsed_ms() / frames;
+    }
 
-    Timer t;
+    std::cout << std::left << std::setw(34) << "Approach"
+              << std::right << std::setw(12) << "ms/frame"
+              << std::setw(10) << "Speedup" << "  Checksum\n";
+    std::cout << std::string(66, '-') << "\n";
 
-    // Example computation
-    const size_t iterations = 1000000;
-    long long sum = 0;
+    auto row = [&](const char* name, double ms, double checksum) {
+        std::cout << std::left << std::setw(34) << name
+                  << std::right << std::setw(12) << std::fixed << std::setprecision(3) << ms
+                  << std::setw(9) << std::setprecision(2) << sequential_ms / ms << "x"
+                  << "  " << std::setprecision(6) << checksum
+                  << (checksum == reference ? "" : "  MISMATCH") << "\n";
+    };
+    row("Sequential", sequential_ms, reference);
+    row("ThreadPool + future::get chains", futures_ms, futures_checksum);
+    row("TaskGraph (built once, replayed)", graph_ms, graph_checksum);
 
-    for (size_t i = 0; i < iterations; ++i) {
-        sum += i;
+    TaskGraphStats stats = pipeline.graph.stats();
+    std::cout << "\nLast replay: " << pipeline.graph.size() << " nodes\n";
+    std::cout << "  Wall time:      " << std::setprecision(3) << stats.wall_ms << " ms\n";
+    std::cout << "  Total work T1:  " << stats.total_work_ms << " ms\n";
+    std::cout << "  Critical path:  " << stats.critical_path_ms << " ms ("
+              << stats.critical_path.size() << " nodes)\n";
+    std::cout << "  Parallelism:    " << std::setprecision(2) << stats.parallelism()
+              << " (max useful speedup T1 / T-inf)\n";
+    std::cout << "  Path: ";
+    for (size_t i = 0; i < stats.critical_path.size(); ++i) {
+        std::cout << (i ? " -> " : "") << stats.critical_path[i];
+        if (i == 5 && stats.critical_path.size() > 8) {
+            std::cout << " -> ... -> " << stats.critical_path.back();
+            break;
+        }
     }
+    std::cout << "\n";
+}
 
-    double elapsed = t.elapsed_ms();
+void demonstrate_graph_replay_overhead() {
+    print_header("Replay Overhead (empty nodes)");
 
-    std::cout << "\nBenchmark results:\n";
-    std::cout << "  Iterations: " << iterations << "\n";
-    std::cout << "  Sum: " << sum << "\n";
-    std::cout << "  Time: " << std::fixed << std::setprecision(2) << elapsed << " ms\n";
+    ThreadPool pool(std::max(2u, std::thread::hardware_concurrency()),
+                    ThreadPool::SchedulingMode::WorkStealing);
+
+    // Wide fan-out/fan-in: 1 root -> N leaves -> 1 sink
+    for (size_t width : {16, 256, 4096}) {
+        TaskGraph graph;
+        auto root = graph.add("root", [] {});
+        auto sink = graph.add("sink", [] {});
+        for (size_t i = 0; i < width; ++i) {
+            auto leaf = graph.add("leaf", [] {});
+            graph.precede(root, leaf);
+            graph.precede(leaf, sink);
+        }
+
+        const int replays = 200;
+        graph.run(pool);
+        Timer t;
+        for (int r = 0; r < replays; ++r) {
+            graph.run(pool);
+        }
+        double us_per_node = t.elapsed_ms() * 1000.0 / (replays * graph.size());
+        std::cout << "  width " << std::setw(5) << width << ": "
+                  << std::fixed << std::setprecision(3) << us_per_node << " us per node\n";
+    }
 }
 
 int main() {
     std::cout << "Lesson 58: Task-Based Parallelism\n";
     std::cout << std::string(60, '=') << "\n";
 
-    demonstrate_taskparallelism();
+    benchmark_pipeline();
+    demonstrate_graph_replay_overhead();
 
     print_header("Conclusion");
     std::cout << "Successfully demonstrated task graphs.\n";
-    std::cout << "Review the code and experiment with modifications.\n";
+    std::cout << "Dependencies become counters, not blocked workers, and the\n";
+    std::cout << "critical path tells you how much parallelism the DAG has.\n";
     std::cout << std::string(60, '=') << "\n";
 
     return 0;
@@ -1,120 +1,318 @@
 /*
  * Lesson 91 - Example 11: Frame Timing for Games
  *
- * Demonstrates tracking frame times and FPS in game applications.
- * Shows moving average, min/max tracking, and FPS stability analysis.
+ * Demonstrates tracking frame times and FPS in game applications:
+ *   - A fixed-size ring buffer of recent frames. Adding a frame overwrites
+ *     the oldest one, and running sums keep average and std dev current.
+ *   - Sliding-window min/max from monotonic queues.
+ *   - A log-bucketed histogram (quantile sketch) for P50/P95/P99/P99.9 and
+ *     the "1% low" FPS, over the window and over the whole session.
+ *   - Hitch detection against a configurable frame budget, naming the
+ *     subsystem that overran its share the most.
+ *   - A per-subsystem budget breakdown (physics, render, audio, ...).
+ * Every per-frame operation is O(1): the cost does not depend on how many
+ * frames the window holds.
+ *
+ * Compilation:
+ * cl /O2 /EHsc frame_timing.cpp
+ * g++ -O2 -std=c++17 11_frame_timing.cpp -o frame_timing
  */
 
 #include <iostream>
 #include <chrono>
 #include <vector>
+#include <string>
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <iomanip>
-
-class FrameTimer {
+#include <random>
+
+// Histogram of frame times with logarithmic buckets. Every value in a
+// bucket is within 1% of the bucket's representative value, so quantiles
+// carry at most 1% relative error, whatever the distribution. Samples can
+// be removed as well as added, which lets the sketch follow a sliding
+// window. A quantile query walks the fixed bucket array: its cost depends
+// on the value range, not on the number of samples.
+class QuantileSketch {
 private:
-    std::chrono::high_resolution_clock::time_point lastFrameTime;
-    std::vector<double> frameTimes;  // Milliseconds
-    size_t maxSamples;
+    static constexpr double MIN_MS = 0.01;
+    static constexpr double MAX_MS = 10000.0;
+    static constexpr double GAMMA = 1.02;  // bucket width ratio, 2% wide = +/-1%
+
+    std::vector<uint32_t> counts;
+    uint64_t total = 0;
+    double logGamma;
+    double lastBucket;
 
 public:
-    FrameTimer(size_t maxSamples = 60) : maxSamples(maxSamples) {
-        lastFrameTime = std::chrono::high_resolution_clock::now();
-        frameTimes.reserve(maxSamples);
+    QuantileSketch()
+        : logGamma(std::log(GAMMA)), lastBucket(std::ceil(std::log(MAX_MS / MIN_MS) / std::log(GAMMA))) {
+        counts.resize(static_cast<size_t>(lastBucket) + 1, 0);
     }
 
-    void markFrame() {
-        auto currentTime = std::chrono::high_resolution_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(
-            currentTime - lastFrameTime);
+    // Bucket i holds (MIN_MS * GAMMA^(i-1), MIN_MS * GAMMA^i]; out-of-range
+    // values are clamped into the first or last bucket
+    uint16_t bucketOf(double ms) const {
+        if (ms <= MIN_MS) return 0;
+        double index = std::ceil(std::log(ms / MIN_MS) / logGamma);
+        return static_cast<uint16_t>(std::min(index, lastBucket));
+    }
 
-        double frameTimeMs = duration.count() / 1000.0;
+    void add(uint16_t bucket) {
+        counts[bucket]++;
+        total++;
+    }
 
-        frameTimes.push_back(frameTimeMs);
+    void remove(uint16_t bucket) {
+        counts[bucket]--;
+        total--;
+    }
 
-        // Keep only last N samples
-        if (frameTimes.size() > maxSamples) {
-            frameTimes.erase(frameTimes.begin());
-        }
+    uint64_t size() const {
+        return total;
+    }
 
-        lastFrameTime = currentTime;
+    // Fills result[i] with the quantile fractions[i] (ascending) in a single
+    // pass over the buckets. Nearest rank: P99 of 60 frames is the slowest.
+    void quantiles(const double* fractions, double* result, size_t count) const {
+        auto rankOf = [&](size_t i) {
+            return std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(fractions[i] * static_cast<double>(total))));
+        };
+        size_t next = 0;
+        uint64_t seen = 0;
+        uint64_t rank = total > 0 && count > 0 ? rankOf(0) : 0;
+        for (size_t bucket = 0; bucket < counts.size() && next < count && total > 0; ++bucket) {
+            seen += counts[bucket];
+            while (next < count && seen >= rank) {
+                result[next++] = representative(bucket);
+                if (next < count) rank = rankOf(next);
+            }
+        }
+        for (; next < count; ++next) {
+            result[next] = 0.0;
+        }
     }
 
-    double getLastFrameTime() const {
-        if (frameTimes.empty()) return 0.0;
-        return frameTimes.back();
+private:
+    // Point within 1% of every value in the bucket
+    double representative(size_t bucket) const {
+        if (bucket == 0) return MIN_MS;
+        return MIN_MS * std::pow(GAMMA, static_cast<double>(bucket)) * 2.0 / (1.0 + GAMMA);
     }
+};
 
-    double getAverageFrameTime() const {
-        if (frameTimes.empty()) return 0.0;
+struct FrameStats {
+    size_t frames = 0;
+    double averageMs = 0.0;
+    double minMs = 0.0;
+    double maxMs = 0.0;
+    double stdDevMs = 0.0;
+    double p50Ms = 0.0;
+    double p95Ms = 0.0;
+    double p99Ms = 0.0;
+    double p999Ms = 0.0;
+    size_t overBudget = 0;
+
+    double fps() const { return averageMs > 0.0 ? 1000.0 / averageMs : 0.0; }
+    // FPS of the slowest 1% of frames
+    double onePercentLowFps() const { return p99Ms > 0.0 ? 1000.0 / p99Ms : 0.0; }
+};
 
-        double sum = 0;
-        for (double time : frameTimes) {
-            sum += time;
-        }
-        return sum / frameTimes.size();
+struct HitchEvent {
+    uint64_t frame;
+    double frameMs;
+    int culprit;  // subsystem furthest over its budget, -1 if none was
+};
+
+class FrameTimer {
+public:
+    static constexpr int MAX_SUBSYSTEMS = 8;
+    static constexpr size_t MAX_HITCHES = 16;  // most recent ones are kept
+
+private:
+    struct FrameRecord {
+        double frameMs;
+        float subsystemMs[MAX_SUBSYSTEMS];
+        uint16_t bucket;
+    };
+
+    struct Subsystem {
+        std::string name;
+        double budgetMs;
+        double windowSumMs = 0.0;
+        size_t windowOverBudget = 0;
+        double worstMs = 0.0;
+    };
+
+    // Indices into the frame ring, oldest first. Used as a deque of at most
+    // windowSize entries whose frame times stay sorted: front is the
+    // window's min (or max).
+    struct MonotonicQueue {
+        std::vector<uint64_t> frames;
+        size_t head = 0;
+        size_t count = 0;
+    };
+
+    std::chrono::steady_clock::time_point lastFrameTime;
+    double budgetMs;
+    double hitchFactor;
+
+    std::vector<FrameRecord> ring;
+    size_t windowSize;
+    uint64_t frameCount = 0;  // frames ever added; frame n lives in ring[n % windowSize]
+    double windowSum = 0.0;
+    double windowSumSquares = 0.0;
+    size_t windowOverBudget = 0;
+    QuantileSketch windowSketch;
+    QuantileSketch sessionSketch;
+    MonotonicQueue minQueue;
+    MonotonicQueue maxQueue;
+
+    std::vector<Subsystem> subsystems;
+    float currentSubsystemMs[MAX_SUBSYSTEMS] = {};
+
+    std::vector<HitchEvent> hitches;  // ring of MAX_HITCHES
+    uint64_t hitchCount = 0;
+
+public:
+    // budgetMs: frame time to hit (16.67 = 60 FPS). A frame longer than
+    // budgetMs * hitchFactor counts as a hitch.
+    explicit FrameTimer(size_t windowSize = 60, double budgetMs = 1000.0 / 60.0, double hitchFactor = 2.0)
+        : budgetMs(budgetMs), hitchFactor(hitchFactor), ring(std::max<size_t>(windowSize, 1)),
+          windowSize(std::max<size_t>(windowSize, 1)) {
+        lastFrameTime = std::chrono::steady_clock::now();
+        minQueue.frames.resize(this->windowSize);
+        maxQueue.frames.resize(this->windowSize);
+        hitches.resize(MAX_HITCHES);
     }
 
-    double getMinFrameTime() const {
-        if (frameTimes.empty()) return 0.0;
-        return *std::min_element(frameTimes.begin(), frameTimes.end());
+    // Returns the subsystem's id, or -1 when all MAX_SUBSYSTEMS are taken
+    int addSubsystem(const std::string& name, double subsystemBudgetMs) {
+        if (subsystems.size() >= MAX_SUBSYSTEMS) return -1;
+        subsystems.push_back({name, subsystemBudgetMs});
+        return static_cast<int>(subsystems.size()) - 1;
     }
 
-    double getMaxFrameTime() const {
-        if (frameTimes.empty()) return 0.0;
-        return *std::max_element(frameTimes.begin(), frameTimes.end());
+    // Adds time to a subsystem for the frame in progress
+    void addSubsystemTime(int subsystem, double ms) {
+        currentSubsystemMs[subsystem] += static_cast<float>(ms);
     }
 
-    double getFPS() const {
-        double avgTime = getAverageFrameTime();
-        if (avgTime == 0.0) return 0.0;
-        return 1000.0 / avgTime;
+    // Ends the frame in progress, timing it from the previous markFrame
+    void markFrame() {
+        auto currentTime = std::chrono::steady_clock::now();
+        addFrame(std::chrono::duration<double, std::milli>(currentTime - lastFrameTime).count());
+        lastFrameTime = currentTime;
     }
 
-    double getStdDev() const {
-        if (frameTimes.size() < 2) return 0.0;
+    // Ends the frame in progress with a known duration (replays, tests)
+    void addFrame(double frameMs) {
+        FrameRecord& slot = ring[frameCount % windowSize];
+        if (frameCount >= windowSize) {
+            evict(slot);
+        }
 
-        double mean = getAverageFrameTime();
-        double variance = 0.0;
+        slot.frameMs = frameMs;
+        slot.bucket = windowSketch.bucketOf(frameMs);
+        windowSketch.add(slot.bucket);
+        sessionSketch.add(slot.bucket);
+        windowSum += frameMs;
+        windowSumSquares += frameMs * frameMs;
+        if (frameMs > budgetMs) windowOverBudget++;
+
+        int culprit = -1;
+        double worstRatio = 1.0;
+        for (size_t i = 0; i < subsystems.size(); ++i) {
+            Subsystem& subsystem = subsystems[i];
+            float ms = currentSubsystemMs[i];
+            slot.subsystemMs[i] = ms;
+            currentSubsystemMs[i] = 0.0f;
+            subsystem.windowSumMs += ms;
+            subsystem.worstMs = std::max(subsystem.worstMs, static_cast<double>(ms));
+            if (ms > subsystem.budgetMs) {
+                subsystem.windowOverBudget++;
+                if (ms / subsystem.budgetMs > worstRatio) {
+                    worstRatio = ms / subsystem.budgetMs;
+                    culprit = static_cast<int>(i);
+                }
+            }
+        }
 
-        for (double time : frameTimes) {
-            double diff = time - mean;
-            variance += diff * diff;
+        if (frameMs > budgetMs * hitchFactor) {
+            hitches[hitchCount % MAX_HITCHES] = {frameCount, frameMs, culprit};
+            hitchCount++;
         }
 
-        variance /= frameTimes.size();
-        return std::sqrt(variance);
+        pushMonotonic(minQueue, [&](double back) { return back >= frameMs; });
+        pushMonotonic(maxQueue, [&](double back) { return back <= frameMs; });
+        frameCount++;
+    }
+
+    double getLastFrameTime() const {
+        if (frameCount == 0) return 0.0;
+        return ring[(frameCount - 1) % windowSize].frameMs;
+    }
+
+    size_t getWindowFrames() const {
+        return static_cast<size_t>(std::min<uint64_t>(frameCount, windowSize));
+    }
+
+    // Statistics over the last windowSize frames
+    FrameStats getStats() const {
+        FrameStats stats;
+        stats.frames = getWindowFrames();
+        if (stats.frames == 0) return stats;
+
+        double n = static_cast<double>(stats.frames);
+        stats.averageMs = windowSum / n;
+        double variance = windowSumSquares / n - stats.averageMs * stats.averageMs;
+        stats.stdDevMs = std::sqrt(std::max(variance, 0.0));
+        stats.minMs = ring[minQueue.frames[minQueue.head] % windowSize].frameMs;
+        stats.maxMs = ring[maxQueue.frames[maxQueue.head] % windowSize].frameMs;
+        stats.overBudget = windowOverBudget;
+        fillPercentiles(windowSketch, stats);
+        return stats;
+    }
+
+    // Percentiles over every frame since the timer started
+    FrameStats getSessionPercentiles() const {
+        FrameStats stats;
+        stats.frames = static_cast<size_t>(sessionSketch.size());
+        fillPercentiles(sessionSketch, stats);
+        return stats;
+    }
+
+    uint64_t getHitchCount() const {
+        return hitchCount;
     }
 
     void printStats() const {
-        double avgTime = getAverageFrameTime();
-        double fps = getFPS();
-        double minTime = getMinFrameTime();
-        double maxTime = getMaxFrameTime();
-        double stdDev = getStdDev();
+        FrameStats stats = getStats();
 
         std::cout << std::fixed << std::setprecision(2);
-        std::cout << "Frame Stats (last " << frameTimes.size() << " frames):\n";
-        std::cout << "  Average: " << avgTime << " ms (" << fps << " FPS)\n";
-        std::cout << "  Min:     " << minTime << " ms (" << (1000.0/minTime) << " FPS)\n";
-        std::cout << "  Max:     " << maxTime << " ms (" << (1000.0/maxTime) << " FPS)\n";
-        std::cout << "  StdDev:  " << stdDev << " ms\n";
-
-        // Frame time budget analysis
-        double targetFPS60 = 16.67;
-        double targetFPS30 = 33.33;
-
-        if (avgTime <= targetFPS60) {
-            std::cout << "  Status:  ✓ Hitting 60 FPS target\n";
-        } else if (avgTime <= targetFPS30) {
-            std::cout << "  Status:  ~ Hitting 30 FPS, missing 60 FPS\n";
+        std::cout << "Frame Stats (last " << stats.frames << " frames):\n";
+        std::cout << "  Average: " << stats.averageMs << " ms (" << stats.fps() << " FPS)\n";
+        std::cout << "  Min:     " << stats.minMs << " ms (" << (1000.0 / stats.minMs) << " FPS)\n";
+        std::cout << "  Max:     " << stats.maxMs << " ms (" << (1000.0 / stats.maxMs) << " FPS)\n";
+        std::cout << "  StdDev:  " << stats.stdDevMs << " ms\n";
+        std::cout << "  P50 / P95 / P99 / P99.9: " << stats.p50Ms << " / " << stats.p95Ms << " / "
+                  << stats.p99Ms << " / " << stats.p999Ms << " ms\n";
+        std::cout << "  1% low:  " << stats.onePercentLowFps() << " FPS\n";
+        std::cout << "  Over budget (" << budgetMs << " ms): " << stats.overBudget << " of "
+                  << stats.frames << " frames\n";
+
+        // The tail decides how smooth the game feels, not the average
+        if (stats.p99Ms <= budgetMs) {
+            std::cout << "  Status:  ✓ 99% of frames within budget\n";
+        } else if (stats.p50Ms <= budgetMs) {
+            std::cout << "  Status:  ~ Typical frame fits, the slowest ones do not\n";
         } else {
-            std::cout << "  Status:  ✗ Below 30 FPS - optimization needed!\n";
+            std::cout << "  Status:  ✗ Median frame over budget - optimization needed!\n";
         }
 
         // Stability analysis
-        double coefficientOfVariation = (stdDev / avgTime) * 100.0;
+        double coefficientOfVariation = (stats.stdDevMs / stats.averageMs) * 100.0;
         std::cout << "  Stability: ";
         if (coefficientOfVariation < 5.0) {
             std::cout << "EXCELLENT (CV: " << coefficientOfVariation << "%)\n";
@@ -126,56 +324,277 @@ public:
             std::cout << "POOR (CV: " << coefficientOfVariation << "%) - stuttering likely!\n";
         }
     }
+
+    void printBudgetBreakdown() const {
+        size_t frames = getWindowFrames();
+        if (frames == 0 || subsystems.empty()) return;
+
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "  " << std::left << std::setw(12) << "Subsystem" << std::right << std::setw(10) << "Budget"
+                  << std::setw(10) << "Average" << std::setw(8) << "Use" << std::setw(10) << "Worst"
+                  << std::setw(8) << "Over" << "\n";
+        double totalBudget = 0.0, totalAverage = 0.0;
+        for (const Subsystem& subsystem : subsystems) {
+            double average = subsystem.windowSumMs / frames;
+            totalBudget += subsystem.budgetMs;
+            totalAverage += average;
+            std::cout << "  " << std::left << std::setw(12) << subsystem.name << std::right
+                      << std::setw(10) << subsystem.budgetMs << std::setw(10) << average
+                      << std::setw(7) << std::setprecision(0) << 100.0 * average / subsystem.budgetMs << "%"
+                      << std::setprecision(2) << std::setw(10) << subsystem.worstMs
+                      << std::setw(8) << subsystem.windowOverBudget << "\n";
+        }
+        std::cout << "  " << std::left << std::setw(12) << "(untracked)" << std::right
+                  << std::setw(10) << budgetMs - totalBudget << std::setw(10)
+                  << windowSum / frames - totalAverage << "\n";
+        std::cout << "  (ms per frame; Worst is since start, Over counts frames in the window)\n";
+    }
+
+    void printHitches() const {
+        std::cout << "Hitches (> " << std::setprecision(2) << budgetMs * hitchFactor << " ms): " << hitchCount
+                  << " in " << frameCount << " frames\n";
+        uint64_t first = hitchCount > MAX_HITCHES ? hitchCount - MAX_HITCHES : 0;
+        for (uint64_t i = first; i < hitchCount; ++i) {
+            const HitchEvent& hitch = hitches[i % MAX_HITCHES];
+            std::cout << "  frame " << std::setw(4) << hitch.frame << ": " << std::setw(7) << hitch.frameMs
+                      << " ms, " << (hitch.culprit >= 0 ? subsystems[hitch.culprit].name + " over budget"
+                                                        : std::string("no subsystem over budget"))
+                      << "\n";
+        }
+    }
+
+private:
+    // Takes the oldest frame's contribution back out of the window totals
+    void evict(const FrameRecord& oldest) {
+        windowSketch.remove(oldest.bucket);
+        windowSum -= oldest.frameMs;
+        windowSumSquares -= oldest.frameMs * oldest.frameMs;
+        if (oldest.frameMs > budgetMs) windowOverBudget--;
+        for (size_t i = 0; i < subsystems.size(); ++i) {
+            subsystems[i].windowSumMs -= oldest.subsystemMs[i];
+            if (oldest.subsystemMs[i] > subsystems[i].budgetMs) subsystems[i].windowOverBudget--;
+        }
+    }
+
+    // Appends frameCount after dropping frames that left the window from the
+    // front and frames it dominates from the back. Each frame is pushed and
+    // popped once, so this is amortized O(1).
+    template <typename Dominated>
+    void pushMonotonic(MonotonicQueue& queue, Dominated&& dominated) {
+        if (queue.count > 0 && queue.frames[queue.head] + windowSize <= frameCount) {
+            queue.head = (queue.head + 1) % windowSize;
+            queue.count--;
+        }
+        while (queue.count > 0) {
+            uint64_t back = queue.frames[(queue.head + queue.count - 1) % windowSize];
+            if (!dominated(ring[back % windowSize].frameMs)) break;
+            queue.count--;
+        }
+        queue.frames[(queue.head + queue.count) % windowSize] = frameCount;
+        queue.count++;
+    }
+
+    static void fillPercentiles(const QuantileSketch& sketch, FrameStats& stats) {
+        static const double fractions[] = {0.50, 0.95, 0.99, 0.999};
+        double values[4];
+        sketch.quantiles(fractions, values, 4);
+        stats.p50Ms = values[0];
+        stats.p95Ms = values[1];
+        stats.p99Ms = values[2];
+        stats.p999Ms = values[3];
+    }
+};
+
+// Times a scope into one of the FrameTimer's subsystems
+class SubsystemTimer {
+private:
+    FrameTimer& timer;
+    int subsystem;
+    std::chrono::steady_clock::time_point start;
+
+public:
+    SubsystemTimer(FrameTimer& timer, int subsystem)
+        : timer(timer), subsystem(subsystem), start(std::chrono::steady_clock::now()) {}
+
+    ~SubsystemTimer() {
+        auto end = std::chrono::steady_clock::now();
+        timer.addSubsystemTime(subsystem, std::chrono::duration<double, std::milli>(end - start).count());
+    }
 };
 
 // Simulate variable frame workload
-void simulateFrame(int complexity) {
+void simulateWork(int complexity) {
     volatile double result = 0;
     for (int i = 0; i < complexity; ++i) {
         result += std::sin(i * 0.001);
     }
 }
 
+// ===== Overhead Benchmark =====
+
+// The previous FrameTimer: a vector that erases its front every frame and
+// rescans the window for every statistic
+class LegacyFrameTimer {
+private:
+    std::vector<double> frameTimes;
+    size_t maxSamples;
+
+public:
+    explicit LegacyFrameTimer(size_t maxSamples) : maxSamples(maxSamples) {
+        frameTimes.reserve(maxSamples + 1);
+    }
+
+    void addFrame(double frameTimeMs) {
+        frameTimes.push_back(frameTimeMs);
+        if (frameTimes.size() > maxSamples) {
+            frameTimes.erase(frameTimes.begin());
+        }
+    }
+
+    // Average, min, max and std dev, as its printStats computed them
+    double scanStats() const {
+        double sum = 0, minTime = frameTimes[0], maxTime = frameTimes[0];
+        for (double time : frameTimes) {
+            sum += time;
+            minTime = std::min(minTime, time);
+            maxTime = std::max(maxTime, time);
+        }
+        double mean = sum / frameTimes.size();
+        double variance = 0.0;
+        for (double time : frameTimes) {
+            variance += (time - mean) * (time - mean);
+        }
+        return mean + minTime + maxTime + std::sqrt(variance / frameTimes.size());
+    }
+};
+
+// Nanoseconds per call of body(i) over `iterations` calls
+template <typename Body>
+double nanosecondsPer(size_t iterations, Body&& body) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        body(i);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+void benchmarkOverhead() {
+    std::cout << "\n=== Overhead vs Window Size ===\n";
+
+    // Synthetic frame times: ~16 ms with noise and the occasional spike
+    const size_t SAMPLES = 1 << 16;
+    std::vector<double> samples(SAMPLES);
+    std::mt19937 rng(42);
+    std::lognormal_distribution<double> frameTime(std::log(16.0), 0.15);
+    for (double& sample : samples) {
+        sample = frameTime(rng);
+    }
+
+    volatile double sink = 0.0;
+    std::cout << std::setw(10) << "Window" << std::setw(16) << "addFrame (ns)" << std::setw(16) << "getStats (ns)"
+              << std::setw(18) << "Legacy add (ns)" << std::setw(20) << "Legacy stats (ns)" << "\n";
+    std::cout << std::string(80, '-') << "\n";
+
+    for (size_t window : {60, 600, 6000, 60000}) {
+        FrameTimer timer(window);
+        timer.addSubsystem("Physics", 4.0);
+        timer.addSubsystem("Render", 10.0);
+        LegacyFrameTimer legacy(window);
+        for (size_t i = 0; i < window; ++i) {  // fill the window so every add evicts
+            timer.addFrame(samples[i % SAMPLES]);
+            legacy.addFrame(samples[i % SAMPLES]);
+        }
+
+        double add = nanosecondsPer(1000000, [&](size_t i) {
+            timer.addSubsystemTime(0, 3.0);
+            timer.addSubsystemTime(1, 9.0);
+            timer.addFrame(samples[i % SAMPLES]);
+        });
+        double stats = nanosecondsPer(20000, [&](size_t) {
+            sink = sink + timer.getStats().p99Ms;
+        });
+
+        // The legacy costs grow with the window, so fewer iterations
+        size_t legacyIterations = 20000000 / window;
+        double legacyAdd = nanosecondsPer(legacyIterations, [&](size_t i) {
+            legacy.addFrame(samples[i % SAMPLES]);
+        });
+        double legacyStats = nanosecondsPer(legacyIterations / 4, [&](size_t) {
+            sink = sink + legacy.scanStats();
+        });
+
+        std::cout << std::fixed << std::setprecision(1) << std::setw(10) << window << std::setw(16) << add
+                  << std::setw(16) << stats << std::setw(18) << legacyAdd << std::setw(20) << legacyStats << "\n";
+    }
+    std::cout << "addFrame and getStats stay flat: getStats walks the sketch's ~700 buckets\n";
+    std::cout << "and reads min/max from the queue fronts, whatever the window size.\n";
+    std::cout << "The legacy timer has no percentiles at all; sorting for them would cost more.\n";
+}
+
 int main() {
     std::cout << "=== Frame Timing Example ===\n\n";
 
-    FrameTimer frameTimer(60);  // Track last 60 frames
+    // Track last 60 frames; hitches are frames over twice the budget. The
+    // simulated frames are light, so the budget is 4 ms (250 FPS) rather
+    // than a real game's 16.67 ms.
+    FrameTimer frameTimer(60, 4.0, 2.0);
+    const int physics = frameTimer.addSubsystem("Physics", 1.0);
+    const int render = frameTimer.addSubsystem("Render", 2.5);
+    const int audio = frameTimer.addSubsystem("Audio", 0.25);
 
-    std::cout << "Simulating 200 frames with variable complexity...\n\n";
+    std::cout << "Simulating 240 frames with variable complexity...\n\n";
 
-    // Simulate 200 frames
-    for (int frame = 0; frame < 200; ++frame) {
+    for (int frame = 0; frame < 240; ++frame) {
         // Variable complexity simulating different frame workloads
-        int complexity;
+        int renderComplexity;
 
         if (frame < 60) {
             // First 60 frames: stable, light workload
-            complexity = 100000;
+            renderComplexity = 100000;
         } else if (frame < 120) {
             // Next 60 frames: stable, medium workload
-            complexity = 200000;
+            renderComplexity = 200000;
         } else if (frame < 180) {
             // Next 60 frames: heavy workload
-            complexity = 400000;
+            renderComplexity = 400000;
         } else {
-            // Last 20 frames: variable (stuttering)
-            complexity = (frame % 2 == 0) ? 100000 : 500000;
+            // Last 60 frames: variable (stuttering)
+            renderComplexity = (frame % 2 == 0) ? 100000 : 500000;
         }
 
-        simulateFrame(complexity);
+        {
+            SubsystemTimer timer(frameTimer, physics);
+            // Every 50th frame, physics rebuilds its broad-phase: a hitch
+            simulateWork(frame % 50 == 49 ? 1500000 : 50000);
+        }
+        {
+            SubsystemTimer timer(frameTimer, render);
+            simulateWork(renderComplexity);
+        }
+        {
+            SubsystemTimer timer(frameTimer, audio);
+            simulateWork(10000);
+        }
         frameTimer.markFrame();
 
         // Print stats every 60 frames
         if ((frame + 1) % 60 == 0) {
             std::cout << "After " << (frame + 1) << " frames:\n";
             frameTimer.printStats();
+            frameTimer.printBudgetBreakdown();
             std::cout << "\n";
         }
     }
 
-    // Final stats
-    std::cout << "Final statistics:\n";
-    frameTimer.printStats();
+    frameTimer.printHitches();
+
+    FrameStats session = frameTimer.getSessionPercentiles();
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Whole session (" << session.frames << " frames): P50 " << session.p50Ms << " ms, P99 "
+              << session.p99Ms << " ms, 1% low " << session.onePercentLowFps() << " FPS\n";
+
+    benchmarkOverhead();
 
     std::cout << "\n========== KEY CONCEPTS ==========\n\n";
 
@@ -184,17 +603,23 @@ int main() {
     std::cout << "  30 FPS = 33.33 ms per frame\n";
     std::cout << "  If your frame takes > 16.67ms, you drop below 60 FPS\n\n";
 
+    std::cout << "Percentiles and 1% Lows:\n";
+    std::cout << "  The average hides stutter: 99 frames at 10 ms and one at 100 ms\n";
+    std::cout << "  average 10.9 ms, yet the game visibly hitches\n";
+    std::cout << "  P99 = 99% of frames are at least this fast; 1% low = 1000 / P99\n\n";
+
     std::cout << "Coefficient of Variation (CV):\n";
     std::cout << "  CV = (StdDev / Mean) * 100%\n";
     std::cout << "  Low CV = consistent frame times = smooth gameplay\n";
     std::cout << "  High CV = variable frame times = stuttering\n\n";
 
     std::cout << "Best Practices:\n";
-    std::cout << "  1. Track frame times in a ring buffer\n";
+    std::cout << "  1. Track frame times in a ring buffer - never erase from the front\n";
     std::cout << "  2. Display average FPS (not instantaneous)\n";
-    std::cout << "  3. Monitor min/max to catch frame spikes\n";
+    std::cout << "  3. Report P99 / 1% lows to catch frame spikes\n";
     std::cout << "  4. Check std dev for frame time consistency\n";
     std::cout << "  5. Budget time for each subsystem (render, physics, etc.)\n";
+    std::cout << "  6. Log hitches with the subsystem that caused them\n";
 
     return 0;
 }
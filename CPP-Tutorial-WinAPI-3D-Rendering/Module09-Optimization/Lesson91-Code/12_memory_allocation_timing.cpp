@@ -2,14 +2,88 @@
  * Lesson 91 - Example 12: Memory Allocation Performance
  *
  * Demonstrates how memory allocation can be a performance bottleneck.
- * Compares frequent allocations vs. reusing allocated memory.
+ * Compares frequent allocations vs. reusing allocated memory, and counts
+ * the allocations each version makes by replacing the global operator new.
+ * (Lesson 92's 09_MemoryProfiling.cpp builds a sampling heap profiler on
+ * the same hook.)
  */
 
 #include <iostream>
 #include <vector>
 #include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
 #include <string>
 
+// ===== Allocation counting =====
+
+struct AllocationStats {
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+    uint64_t frees = 0;
+};
+
+// Per thread, so counting needs no lock or atomic
+thread_local AllocationStats threadAllocations;
+
+// Kept out of line: inlined into the caller, GCC would see malloc'd memory
+// reach free through delete and warn about a new/free mismatch
+#if defined(_MSC_VER)
+#define ALLOCATION_NOINLINE __declspec(noinline)
+#else
+#define ALLOCATION_NOINLINE __attribute__((noinline))
+#endif
+
+ALLOCATION_NOINLINE void* operator new(size_t size) {
+    threadAllocations.allocations++;
+    threadAllocations.bytes += size;
+    for (;;) {
+        if (void* block = std::malloc(size ? size : 1)) return block;
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+
+void* operator new[](size_t size) {
+    return ::operator new(size);
+}
+
+ALLOCATION_NOINLINE void operator delete(void* block) noexcept {
+    if (block) threadAllocations.frees++;
+    std::free(block);
+}
+
+void operator delete[](void* block) noexcept {
+    ::operator delete(block);
+}
+
+void operator delete(void* block, size_t) noexcept {
+    ::operator delete(block);
+}
+
+void operator delete[](void* block, size_t) noexcept {
+    ::operator delete(block);
+}
+
+// Allocations made on this thread since construction
+class AllocationScope {
+private:
+    AllocationStats start = threadAllocations;
+
+public:
+    AllocationStats delta() const {
+        AllocationStats now = threadAllocations;
+        return {now.allocations - start.allocations, now.bytes - start.bytes, now.frees - start.frees};
+    }
+};
+
+std::string describe(const AllocationStats& stats) {
+    return std::to_string(stats.allocations) + (stats.allocations == 1 ? " allocation, " : " allocations, ") +
+           std::to_string(stats.bytes / 1024) + " KB";
+}
+
 class Timer {
 private:
     std::chrono::high_resolution_clock::time_point start;
@@ -106,19 +180,23 @@ void runBenchmark(const std::string& name, void (*slowFunc)(), void (*fastFunc)(
     fastFunc();
 
     // Benchmark slow version
+    AllocationScope slowScope;
     timer.reset();
     slowFunc();
     double timeSlow = timer.elapsedMicroseconds();
+    AllocationStats slowAllocations = slowScope.delta();
 
     // Benchmark fast version
+    AllocationScope fastScope;
     timer.reset();
     fastFunc();
     double timeFast = timer.elapsedMicroseconds();
+    AllocationStats fastAllocations = fastScope.delta();
 
     // Report results
     std::cout << name << ":\n";
-    std::cout << "  Frequent alloc: " << timeSlow << " us\n";
-    std::cout << "  Reuse alloc:    " << timeFast << " us\n";
+    std::cout << "  Frequent alloc: " << timeSlow << " us (" << describe(slowAllocations) << ")\n";
+    std::cout << "  Reuse alloc:    " << timeFast << " us (" << describe(fastAllocations) << ")\n";
     std::cout << "  Speedup:        " << (timeSlow / timeFast) << "x\n";
     std::cout << "  Time saved:     " << (timeSlow - timeFast) << " us\n\n";
 }
@@ -138,17 +216,21 @@ int main() {
     Timer timer;
     const int STRING_SIZE = 10000;
 
+    AllocationScope stringSlowScope;
     timer.reset();
     std::string s1 = concatenateStringSlow(STRING_SIZE);
     double timeStringSlow = timer.elapsedMicroseconds();
+    AllocationStats stringSlowAllocations = stringSlowScope.delta();
 
+    AllocationScope stringFastScope;
     timer.reset();
     std::string s2 = concatenateStringFast(STRING_SIZE);
     double timeStringFast = timer.elapsedMicroseconds();
+    AllocationStats stringFastAllocations = stringFastScope.delta();
 
     std::cout << "String Concatenation:\n";
-    std::cout << "  Without reserve: " << timeStringSlow << " us\n";
-    std::cout << "  With reserve:    " << timeStringFast << " us\n";
+    std::cout << "  Without reserve: " << timeStringSlow << " us (" << describe(stringSlowAllocations) << ")\n";
+    std::cout << "  With reserve:    " << timeStringFast << " us (" << describe(stringFastAllocations) << ")\n";
     std::cout << "  Speedup:         " << (timeStringSlow / timeStringFast) << "x\n";
     std::cout << "  Results match:   " << (s1 == s2 ? "YES" : "NO") << "\n\n";
 
@@ -157,17 +239,21 @@ int main() {
 
     const int VECTOR_SIZE = 100000;
 
+    AllocationScope vectorSlowScope;
     timer.reset();
     std::vector<int> v1 = buildVectorSlow(VECTOR_SIZE);
     double timeVectorSlow = timer.elapsedMicroseconds();
+    AllocationStats vectorSlowAllocations = vectorSlowScope.delta();
 
+    AllocationScope vectorFastScope;
     timer.reset();
     std::vector<int> v2 = buildVectorFast(VECTOR_SIZE);
     double timeVectorFast = timer.elapsedMicroseconds();
+    AllocationStats vectorFastAllocations = vectorFastScope.delta();
 
     std::cout << "Vector Building (" << VECTOR_SIZE << " elements):\n";
-    std::cout << "  Without reserve: " << timeVectorSlow << " us\n";
-    std::cout << "  With reserve:    " << timeVectorFast << " us\n";
+    std::cout << "  Without reserve: " << timeVectorSlow << " us (" << describe(vectorSlowAllocations) << ")\n";
+    std::cout << "  With reserve:    " << timeVectorFast << " us (" << describe(vectorFastAllocations) << ")\n";
     std::cout << "  Speedup:         " << (timeVectorSlow / timeVectorFast) << "x\n";
     std::cout << "  Results match:   " << (v1 == v2 ? "YES" : "NO") << "\n\n";
 
@@ -189,7 +275,7 @@ int main() {
     std::cout << "  1. Use reserve() for vectors and strings\n";
     std::cout << "  2. Reuse containers instead of recreating\n";
     std::cout << "  3. Consider object pooling for frequent allocations\n";
-    std::cout << "  4. Profile to find allocation hotspots\n";
+    std::cout << "  4. Profile to find allocation hotspots (count them, as above)\n";
     std::cout << "  5. Prefer stack allocation when possible\n\n";
 
     std::cout << "Speedups Achieved:\n";
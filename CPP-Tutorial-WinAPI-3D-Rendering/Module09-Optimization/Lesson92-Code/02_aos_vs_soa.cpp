@@ -3,10 +3,30 @@
  *
  * Demonstrates SoA pattern for better cache utilization when
  * processing only specific fields of data.
+ *
+ * A hand-written SoA type drifts from its AoS twin: adding a field means
+ * editing the struct, the allocation, the cleanup and every copy. The
+ * soa_vector<Fields...> template below generates the layout instead:
+ *   - each field in its own 64-byte aligned array
+ *   - row proxies (particles[i].get<VX>()) for AoS-style code
+ *   - per-column spans (particles.column<VX>()) for vectorizable loops
+ *   - push_back, erase (keeps order) and swap_remove (O(1))
+ *
+ * Compilation:
+ * cl /O2 /EHsc /std:c++17 aos_vs_soa.cpp
+ * g++ -O3 -std=c++17 02_aos_vs_soa.cpp -o aos_vs_soa
  */
 
 #include <iostream>
 #include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <memory>
+#include <new>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 
 class Timer {
 private:
@@ -19,6 +39,238 @@ public:
     }
 };
 
+// ===== soa_vector =====
+
+// One column of a soa_vector: contiguous and aligned
+template <typename T>
+class column_span {
+public:
+    column_span(T* data, size_t size) : first(data), count(size) {}
+
+    // column_span<float> converts to column_span<const float>
+    template <typename U, typename = std::enable_if_t<std::is_same_v<const U, T>>>
+    column_span(const column_span<U>& other) : first(other.data()), count(other.size()) {}
+
+    T* data() const { return first; }
+    size_t size() const { return count; }
+    T& operator[](size_t index) const { return first[index]; }
+    T* begin() const { return first; }
+    T* end() const { return first + count; }
+
+private:
+    T* first;
+    size_t count;
+};
+
+// A vector of rows stored column by column. Fields are the column types;
+// name them with an enum (see ParticleField) and use it as the index.
+template <typename... Fields>
+class soa_vector {
+    static_assert(sizeof...(Fields) > 0, "soa_vector needs at least one field");
+    static_assert((std::is_nothrow_move_constructible_v<Fields> && ...),
+                  "columns are moved when the vector grows, which must not throw");
+
+public:
+    static constexpr size_t ALIGNMENT = 64;  // a cache line, enough for any SIMD load
+
+    template <size_t I>
+    using field_type = std::tuple_element_t<I, std::tuple<Fields...>>;
+    using value_type = std::tuple<Fields...>;
+
+    // Stands in for one row. get<I>() is a reference into column I, and
+    // assigning a value_type (or another row) copies every field.
+    template <bool Const>
+    class basic_reference {
+        using owner_type = std::conditional_t<Const, const soa_vector, soa_vector>;
+
+    public:
+        basic_reference(owner_type& owner, size_t index) : owner(&owner), index(index) {}
+        basic_reference(const basic_reference&) = default;
+
+        template <size_t I>
+        std::conditional_t<Const, const field_type<I>&, field_type<I>&> get() const {
+            return std::get<I>(owner->columns)[index];
+        }
+
+        operator value_type() const {
+            return owner->rowValues(index, std::index_sequence_for<Fields...>{});
+        }
+
+        const basic_reference& operator=(const value_type& values) const {
+            static_assert(!Const, "cannot assign through a const_reference");
+            owner->assignRow(index, values, std::index_sequence_for<Fields...>{});
+            return *this;
+        }
+
+        const basic_reference& operator=(const basic_reference& other) const {
+            return *this = static_cast<value_type>(other);
+        }
+
+    private:
+        owner_type* owner;
+        size_t index;
+    };
+
+    using reference = basic_reference<false>;
+    using const_reference = basic_reference<true>;
+
+    soa_vector() = default;
+
+    explicit soa_vector(size_t count) {
+        resize(count);
+    }
+
+    soa_vector(const soa_vector& other) {
+        reserve(other.count);
+        copyColumns(other, std::index_sequence_for<Fields...>{});
+        count = other.count;
+    }
+
+    soa_vector(soa_vector&& other) noexcept
+        : columns(std::exchange(other.columns, {})), count(std::exchange(other.count, 0)),
+          cap(std::exchange(other.cap, 0)) {}
+
+    soa_vector& operator=(soa_vector other) noexcept {
+        std::swap(columns, other.columns);
+        std::swap(count, other.count);
+        std::swap(cap, other.cap);
+        return *this;
+    }
+
+    ~soa_vector() {
+        clear();
+        forEachColumn([](auto*& column) { deallocate(column); });
+    }
+
+    size_t size() const { return count; }
+    size_t capacity() const { return cap; }
+    bool empty() const { return count == 0; }
+
+    reference operator[](size_t index) { return reference(*this, index); }
+    const_reference operator[](size_t index) const { return const_reference(*this, index); }
+
+    template <size_t I>
+    column_span<field_type<I>> column() {
+        return {std::get<I>(columns), count};
+    }
+
+    template <size_t I>
+    column_span<const field_type<I>> column() const {
+        return {std::get<I>(columns), count};
+    }
+
+    void reserve(size_t newCapacity) {
+        if (newCapacity <= cap) return;
+        forEachColumn([&](auto*& column) {
+            using T = std::remove_reference_t<decltype(*column)>;
+            T* fresh = allocate<T>(newCapacity);
+            std::uninitialized_move(column, column + count, fresh);
+            std::destroy(column, column + count);
+            deallocate(column);
+            column = fresh;
+        });
+        cap = newCapacity;
+    }
+
+    // Values are taken by value, so pushing a copy of an existing row is
+    // safe even when the columns move
+    void push_back(Fields... values) {
+        if (count == cap) {
+            reserve(cap < 16 ? 16 : cap * 2);
+        }
+        constructRow(count, std::index_sequence_for<Fields...>{}, std::move(values)...);
+        count++;
+    }
+
+    void push_back(const value_type& values) {
+        std::apply([this](const Fields&... fields) { push_back(fields...); }, values);
+    }
+
+    void pop_back() {
+        count--;
+        forEachColumn([&](auto*& column) { std::destroy_at(column + count); });
+    }
+
+    // Keeps the order of the remaining rows; moves every row after index
+    void erase(size_t index) {
+        forEachColumn([&](auto*& column) { std::move(column + index + 1, column + count, column + index); });
+        pop_back();
+    }
+
+    // Moves the last row into index: O(1), but changes the order
+    void swap_remove(size_t index) {
+        if (index + 1 != count) {
+            forEachColumn([&](auto*& column) { column[index] = std::move(column[count - 1]); });
+        }
+        pop_back();
+    }
+
+    // New rows are value-initialized
+    void resize(size_t newCount) {
+        reserve(newCount);
+        if (newCount > count) {
+            forEachColumn([&](auto*& column) { std::uninitialized_value_construct(column + count, column + newCount); });
+        } else {
+            forEachColumn([&](auto*& column) { std::destroy(column + newCount, column + count); });
+        }
+        count = newCount;
+    }
+
+    void clear() {
+        forEachColumn([&](auto*& column) { std::destroy(column, column + count); });
+        count = 0;
+    }
+
+private:
+    template <typename T>
+    static T* allocate(size_t elements) {
+        return static_cast<T*>(::operator new(elements * sizeof(T), std::align_val_t(alignmentOf<T>())));
+    }
+
+    template <typename T>
+    static void deallocate(T* column) {
+        if (column) {
+            ::operator delete(column, std::align_val_t(alignmentOf<T>()));
+        }
+    }
+
+    template <typename T>
+    static constexpr size_t alignmentOf() {
+        return alignof(T) > ALIGNMENT ? alignof(T) : ALIGNMENT;
+    }
+
+    template <typename Func>
+    void forEachColumn(Func&& func) {
+        std::apply([&](auto*&... column) { (func(column), ...); }, columns);
+    }
+
+    template <size_t... Is>
+    void constructRow(size_t index, std::index_sequence<Is...>, Fields&&... values) {
+        (::new (static_cast<void*>(std::get<Is>(columns) + index)) Fields(std::move(values)), ...);
+    }
+
+    template <size_t... Is>
+    value_type rowValues(size_t index, std::index_sequence<Is...>) const {
+        return value_type(std::get<Is>(columns)[index]...);
+    }
+
+    template <size_t... Is>
+    void assignRow(size_t index, const value_type& values, std::index_sequence<Is...>) {
+        ((std::get<Is>(columns)[index] = std::get<Is>(values)), ...);
+    }
+
+    template <size_t... Is>
+    void copyColumns(const soa_vector& other, std::index_sequence<Is...>) {
+        (std::uninitialized_copy(std::get<Is>(other.columns), std::get<Is>(other.columns) + other.count,
+                                 std::get<Is>(columns)),
+         ...);
+    }
+
+    std::tuple<Fields*...> columns{};
+    size_t count = 0;
+    size_t cap = 0;
+};
+
 // Array of Structures (AoS)
 struct ParticleAoS {
     float x, y, z;
@@ -51,50 +303,232 @@ struct ParticlesSoA {
     }
 };
 
-int main() {
-    std::cout << "=== AoS vs SoA Cache Performance ===\n\n";
+// The same particle as a soa_vector: adding a field is one line in each
+enum ParticleField { PX, PY, PZ, VX, VY, VZ, AGE, LIFETIME };
+using Particles = soa_vector<float, float, float, float, float, float, float, float>;
+
+// Starting state of particle i, shared by every layout
+ParticleAoS initialParticle(int i) {
+    float f = static_cast<float>(i % 1000) * 0.001f;
+    return {f, 2.0f * f, -f, 1.0f + f, 0.5f, -1.0f, 0.0f, 5.0f + 10.0f * f};
+}
+
+// ===== Benchmarks =====
+
+const int N = 1000000;
+const int FRAMES = 20;
+const float DT = 0.016f;
 
-    const int N = 1000000;
+// Average milliseconds per frame of update()
+template <typename Update>
+double timeFrames(Update&& update) {
+    update();  // warm up
     Timer timer;
+    timer.reset();
+    for (int frame = 0; frame < FRAMES; ++frame) {
+        update();
+    }
+    return timer.elapsedMs() / FRAMES;
+}
+
+struct LayoutResult {
+    const char* name;
+    double moveMs;
+    double ageMs;
+    double checksum;
+};
 
-    // AoS: Update positions
-    ParticleAoS* particlesAoS = new ParticleAoS[N];
+LayoutResult benchmarkAoS() {
+    ParticleAoS* particles = new ParticleAoS[N];
     for (int i = 0; i < N; ++i) {
-        particlesAoS[i] = {0,0,0, 1,1,1, 0,10};
+        particles[i] = initialParticle(i);
     }
 
-    timer.reset();
-    for (int i = 0; i < N; ++i) {
-        particlesAoS[i].x += particlesAoS[i].vx * 0.016f;
-        particlesAoS[i].y += particlesAoS[i].vy * 0.016f;
-        particlesAoS[i].z += particlesAoS[i].vz * 0.016f;
+    double moveMs = timeFrames([&]() {
+        for (int i = 0; i < N; ++i) {
+            particles[i].x += particles[i].vx * DT;
+            particles[i].y += particles[i].vy * DT;
+            particles[i].z += particles[i].vz * DT;
+        }
+    });
+    double ageMs = timeFrames([&]() {
+        for (int i = 0; i < N; ++i) {
+            particles[i].age += DT;
+        }
+    });
+
+    double checksum = 0.0;
+    for (int i = 0; i < N; i += 997) {
+        checksum += particles[i].x + particles[i].y + particles[i].z + particles[i].age;
     }
-    double timeAoS = timer.elapsedMs();
+    delete[] particles;
+    return {"AoS (hand-written)", moveMs, ageMs, checksum};
+}
 
-    // SoA: Update positions
-    ParticlesSoA particlesSoA(N);
+LayoutResult benchmarkHandSoA() {
+    ParticlesSoA particles(N);
     for (int i = 0; i < N; ++i) {
-        particlesSoA.x[i] = 0; particlesSoA.y[i] = 0; particlesSoA.z[i] = 0;
-        particlesSoA.vx[i] = 1; particlesSoA.vy[i] = 1; particlesSoA.vz[i] = 1;
+        ParticleAoS p = initialParticle(i);
+        particles.x[i] = p.x; particles.y[i] = p.y; particles.z[i] = p.z;
+        particles.vx[i] = p.vx; particles.vy[i] = p.vy; particles.vz[i] = p.vz;
+        particles.age[i] = p.age; particles.lifetime[i] = p.lifetime;
     }
 
-    timer.reset();
+    double moveMs = timeFrames([&]() {
+        for (int i = 0; i < N; ++i) {
+            particles.x[i] += particles.vx[i] * DT;
+            particles.y[i] += particles.vy[i] * DT;
+            particles.z[i] += particles.vz[i] * DT;
+        }
+    });
+    double ageMs = timeFrames([&]() {
+        for (int i = 0; i < N; ++i) {
+            particles.age[i] += DT;
+        }
+    });
+
+    double checksum = 0.0;
+    for (int i = 0; i < N; i += 997) {
+        checksum += particles.x[i] + particles.y[i] + particles.z[i] + particles.age[i];
+    }
+    return {"SoA (hand-written)", moveMs, ageMs, checksum};
+}
+
+Particles makeParticles() {
+    Particles particles;
+    particles.reserve(N);
     for (int i = 0; i < N; ++i) {
-        particlesSoA.x[i] += particlesSoA.vx[i] * 0.016f;
-        particlesSoA.y[i] += particlesSoA.vy[i] * 0.016f;
-        particlesSoA.z[i] += particlesSoA.vz[i] * 0.016f;
+        ParticleAoS p = initialParticle(i);
+        particles.push_back(p.x, p.y, p.z, p.vx, p.vy, p.vz, p.age, p.lifetime);
+    }
+    return particles;
+}
+
+double checksumOf(const Particles& particles) {
+    double checksum = 0.0;
+    for (size_t i = 0; i < particles.size(); i += 997) {
+        auto p = particles[i];
+        checksum += p.get<PX>() + p.get<PY>() + p.get<PZ>() + p.get<AGE>();
+    }
+    return checksum;
+}
+
+// target[i] += source[i] * scale. One pair of columns per loop: the
+// compiler needs a single overlap check to vectorize it, where six spans
+// in one loop make it give up.
+void addScaled(column_span<float> target, column_span<const float> source, float scale) {
+    for (size_t i = 0; i < target.size(); ++i) {
+        target[i] += source[i] * scale;
+    }
+}
+
+// Loops over column spans, the way SIMD code wants its data
+LayoutResult benchmarkColumns() {
+    Particles particles = makeParticles();
+
+    double moveMs = timeFrames([&]() {
+        addScaled(particles.column<PX>(), particles.column<VX>(), DT);
+        addScaled(particles.column<PY>(), particles.column<VY>(), DT);
+        addScaled(particles.column<PZ>(), particles.column<VZ>(), DT);
+    });
+    double ageMs = timeFrames([&]() {
+        for (float& age : particles.column<AGE>()) {
+            age += DT;
+        }
+    });
+    return {"soa_vector, column spans", moveMs, ageMs, checksumOf(particles)};
+}
+
+// The AoS loop written against row proxies. It reads the columns, but
+// with six of them in one loop the compiler keeps it scalar.
+LayoutResult benchmarkRows() {
+    Particles particles = makeParticles();
+
+    double moveMs = timeFrames([&]() {
+        for (size_t i = 0; i < particles.size(); ++i) {
+            auto p = particles[i];
+            p.get<PX>() += p.get<VX>() * DT;
+            p.get<PY>() += p.get<VY>() * DT;
+            p.get<PZ>() += p.get<VZ>() * DT;
+        }
+    });
+    double ageMs = timeFrames([&]() {
+        for (size_t i = 0; i < particles.size(); ++i) {
+            particles[i].get<AGE>() += DT;
+        }
+    });
+    return {"soa_vector, row proxies", moveMs, ageMs, checksumOf(particles)};
+}
+
+// Removes the particles whose age passed their lifetime
+template <typename Remove>
+size_t killExpired(Particles& particles, Remove&& remove) {
+    size_t removed = 0;
+    for (size_t i = 0; i < particles.size();) {
+        if (particles[i].get<AGE>() >= particles[i].get<LIFETIME>()) {
+            remove(particles, i);
+            removed++;
+        } else {
+            ++i;
+        }
     }
-    double timeSoA = timer.elapsedMs();
+    return removed;
+}
+
+void benchmarkRemoval() {
+    std::cout << "\n=== Removing Expired Particles (100K, 1% expired) ===\n";
 
-    std::cout << "AoS time: " << timeAoS << " ms\n";
-    std::cout << "SoA time: " << timeSoA << " ms\n";
-    std::cout << "Speedup:  " << (timeAoS / timeSoA) << "x\n\n";
+    const int COUNT = 100000;
+    Particles source;
+    for (int i = 0; i < COUNT; ++i) {
+        ParticleAoS p = initialParticle(i);
+        source.push_back(p.x, p.y, p.z, p.vx, p.vy, p.vz, i % 100 == 0 ? 99.0f : 0.0f, p.lifetime);
+    }
+
+    Particles byErase = source;
+    Particles bySwap = source;
+    Timer timer;
+
+    timer.reset();
+    size_t erased = killExpired(byErase, [](Particles& particles, size_t i) { particles.erase(i); });
+    double eraseMs = timer.elapsedMs();
+
+    timer.reset();
+    size_t swapped = killExpired(bySwap, [](Particles& particles, size_t i) { particles.swap_remove(i); });
+    double swapMs = timer.elapsedMs();
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "erase:       " << std::setw(8) << eraseMs << " ms (" << erased << " removed, order kept)\n";
+    std::cout << "swap_remove: " << std::setw(8) << swapMs << " ms (" << swapped << " removed, order changed)\n";
+    std::cout << "Both leave " << byErase.size() << " / " << bySwap.size() << " particles.\n";
+}
+
+int main() {
+    std::cout << "=== AoS vs SoA Cache Performance ===\n\n";
+    std::cout << N / 1000000 << "M particles, average of " << FRAMES << " frames\n";
+
+    const LayoutResult results[] = {benchmarkAoS(), benchmarkHandSoA(), benchmarkColumns(), benchmarkRows()};
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << std::left << std::setw(28) << "Layout" << std::right << std::setw(14) << "Move (ms)"
+              << std::setw(14) << "Age (ms)" << std::setw(16) << "Checksum" << "\n";
+    std::cout << std::string(72, '-') << "\n";
+    for (const LayoutResult& result : results) {
+        std::cout << std::left << std::setw(28) << result.name << std::right << std::setw(14) << result.moveMs
+                  << std::setw(14) << result.ageMs << std::setw(16) << result.checksum << "\n";
+    }
+    std::cout << "Move reads and writes 6 of the 8 fields, Age only 1.\n";
+    std::cout << "Speedup of SoA over AoS: " << std::setprecision(2) << results[0].moveMs / results[1].moveMs
+              << "x (move), " << results[0].ageMs / results[1].ageMs << "x (age)\n\n";
 
     std::cout << "Why SoA is faster:\n";
-    std::cout << "- AoS loads entire 32-byte struct, uses only 24 bytes\n";
+    std::cout << "- AoS loads entire 32-byte struct, uses only 24 bytes (or 4 for age)\n";
     std::cout << "- SoA loads only position/velocity arrays (better cache use)\n";
-    std::cout << "- Result: 1.5-3x speedup!\n";
+    std::cout << "- Contiguous columns let the compiler vectorize the loop\n";
+    std::cout << "- Hand-written SoA vectorizes here because the compiler can see the\n";
+    std::cout << "  arrays never overlap; column spans get there one pair at a time\n";
+    std::cout << "- Row proxies keep AoS-style code working on the SoA layout\n";
 
-    delete[] particlesAoS;
+    benchmarkRemoval();
     return 0;
 }
@@ -2,18 +2,54 @@
  * Lesson 92: Memory-Optimization
  * Optimization Topic: LeakDetection
  *
- * Performance optimization techniques
+ * An exact leak detector that replaces the global operator new and
+ * operator delete. Unlike the sampling profiler in 09_MemoryProfiling.cpp,
+ * it accounts for every block:
+ *   - Each block's 16-byte header holds its size and its call site, which
+ *     is the return address of operator new (the code that called new).
+ *   - Call sites are interned into a fixed table with compare-and-swap, so
+ *     no allocation ever takes a lock.
+ *   - Live blocks and bytes per site are kept in a per-thread table that
+ *     only its thread writes. A block freed on another thread is
+ *     subtracted there; the tables are summed when a report is made.
+ *   - Snapshots taken around a workload (e.g. load and unload a level)
+ *     show which sites kept memory they should have given back.
+ *   - Whatever is still live at exit is reported per call site.
  *
- * Compilation:
+ * Compilation (-rdynamic lets the report name functions on Linux):
  * cl /O2 /EHsc LeakDetection.cpp
- * g++ -O3 -std=c++17 LeakDetection.cpp -o LeakDetection
+ * g++ -O2 -g -std=c++17 -pthread -rdynamic 10_LeakDetection.cpp -o LeakDetection
  */
 
 #include <iostream>
+#include <iomanip>
 #include <chrono>
 #include <vector>
+#include <string>
 #include <algorithm>
-#include <cmath>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <thread>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#include <intrin.h>
+#define LEAK_NOINLINE __declspec(noinline)
+#define LEAK_FORCEINLINE __forceinline
+#define LEAK_CALLER() _ReturnAddress()
+#else
+#include <cxxabi.h>
+#include <dlfcn.h>
+#define LEAK_NOINLINE __attribute__((noinline))
+#define LEAK_FORCEINLINE inline __attribute__((always_inline))
+#define LEAK_CALLER() __builtin_return_address(0)
+#endif
 
 // Timing helper
 class Timer {
@@ -27,54 +63,420 @@ public:
     }
 };
 
-// Optimization demonstration for: LeakDetection
-class OptimizationDemo {
-public:
-    void RunBaseline() {
-        std::cout << "Running baseline implementation...\n";
-        Timer t;
-
-        // Baseline code (unoptimized)
-        volatile int result = 0;
-        for (int i = 0; i < 1000000; ++i) {
-            result += i * 2;
+namespace LeakDetector {
+
+constexpr size_t MAX_SITES = 2048;  // site 0 collects everything once the table is full
+
+struct alignas(16) BlockHeader {
+    uint64_t size;
+    uint32_t site;
+};
+
+// One per thread, written only by that thread (see Bump)
+struct ThreadTable {
+    std::atomic<int64_t> liveBlocks[MAX_SITES]{};
+    std::atomic<int64_t> liveBytes[MAX_SITES]{};
+    std::atomic<uint64_t> allocations[MAX_SITES]{};
+    ThreadTable* next = nullptr;
+};
+
+// Live totals per site, summed over every thread. Fixed arrays, so taking
+// a snapshot does not allocate and show up in itself.
+struct Snapshot {
+    std::array<int64_t, MAX_SITES> liveBlocks{};
+    std::array<int64_t, MAX_SITES> liveBytes{};
+    std::array<uint64_t, MAX_SITES> allocations{};
+};
+
+// Constant-initialized: usable by allocations made before main
+std::atomic<uintptr_t> siteAddresses[MAX_SITES]{};
+std::atomic<size_t> siteCount{0};
+std::atomic<ThreadTable*> tableList{nullptr};
+thread_local ThreadTable* threadTable = nullptr;
+
+// The owning thread is the only writer, so a plain load and store is
+// enough; readers on other threads may see a slightly stale value
+template <typename T>
+inline void Bump(std::atomic<T>& counter, T amount) {
+    counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+// The table is taken with malloc, not new, and never freed: blocks a
+// thread allocated can be freed after it exits
+LEAK_NOINLINE ThreadTable* RegisterThread() {
+    void* memory = std::malloc(sizeof(ThreadTable));
+    if (!memory) std::abort();
+    ThreadTable* table = new (memory) ThreadTable();
+    table->next = tableList.load(std::memory_order_relaxed);
+    while (!tableList.compare_exchange_weak(table->next, table, std::memory_order_release, std::memory_order_relaxed)) {
+    }
+    threadTable = table;
+    return table;
+}
+
+// Finds or claims the slot for a call site: open addressing, where an
+// empty slot is claimed with one compare-and-swap
+inline uint32_t InternSite(void* caller) {
+    const uintptr_t address = reinterpret_cast<uintptr_t>(caller);
+    size_t index = (address * 0x9E3779B97F4A7C15ull >> 40) % (MAX_SITES - 1) + 1;
+    for (size_t probes = 0; probes < MAX_SITES - 1; ++probes) {
+        uintptr_t current = siteAddresses[index].load(std::memory_order_acquire);
+        if (current == address) return static_cast<uint32_t>(index);
+        if (current == 0) {
+            if (siteCount.load(std::memory_order_relaxed) >= MAX_SITES * 3 / 4) break;
+            if (siteAddresses[index].compare_exchange_strong(current, address, std::memory_order_acq_rel)) {
+                siteCount.fetch_add(1, std::memory_order_relaxed);
+                return static_cast<uint32_t>(index);
+            }
+            if (current == address) return static_cast<uint32_t>(index);
         }
+        index = index + 1 < MAX_SITES ? index + 1 : 1;
+    }
+    return 0;
+}
+
+// alignment is 0 for plain new, or the requested over-alignment; the header
+// then takes a whole alignment unit
+LEAK_FORCEINLINE size_t HeaderSize(size_t alignment) {
+    return alignment > sizeof(BlockHeader) ? alignment : sizeof(BlockHeader);
+}
 
-        std::cout << "Baseline time: " << t.ElapsedMs() << " ms\n";
+LEAK_FORCEINLINE void* Allocate(size_t size, size_t alignment, void* caller) {
+    const size_t headerSize = HeaderSize(alignment);
+    if (size > SIZE_MAX - headerSize) return nullptr;   // headerSize + size would wrap
+    void* raw;
+#if defined(_WIN32)
+    raw = alignment ? _aligned_malloc(headerSize + size, alignment) : std::malloc(headerSize + size);
+#else
+    if (!alignment) {
+        raw = std::malloc(headerSize + size);
+    } else if (posix_memalign(&raw, alignment, headerSize + size) != 0) {
+        raw = nullptr;
     }
+#endif
+    if (!raw) return nullptr;
 
-    void RunOptimized() {
-        std::cout << "Running optimized implementation...\n";
-        Timer t;
+    uint32_t site = InternSite(caller);
+    BlockHeader* header = reinterpret_cast<BlockHeader*>(static_cast<char*>(raw) + headerSize) - 1;
+    header->size = size;
+    header->site = site;
 
-        // Optimized code
-        volatile int result = 0;
-        for (int i = 0; i < 1000000; ++i) {
-            result += i << 1;  // Bitshift instead of multiplication
+    ThreadTable* table = threadTable ? threadTable : RegisterThread();
+    Bump<int64_t>(table->liveBlocks[site], 1);
+    Bump<int64_t>(table->liveBytes[site], static_cast<int64_t>(size));
+    Bump<uint64_t>(table->allocations[site], 1);
+    return header + 1;
+}
+
+LEAK_FORCEINLINE void* AllocateOrThrow(size_t size, size_t alignment, void* caller) {
+    for (;;) {
+        if (void* block = Allocate(size, alignment, caller)) return block;
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+
+LEAK_FORCEINLINE void Free(void* block, size_t alignment) {
+    if (!block) return;
+    BlockHeader* header = static_cast<BlockHeader*>(block) - 1;
+    ThreadTable* table = threadTable ? threadTable : RegisterThread();
+    Bump<int64_t>(table->liveBlocks[header->site], -1);
+    Bump<int64_t>(table->liveBytes[header->site], -static_cast<int64_t>(header->size));
+
+    void* raw = static_cast<char*>(block) - HeaderSize(alignment);
+#if defined(_WIN32)
+    if (alignment) {
+        _aligned_free(raw);
+        return;
+    }
+#endif
+    std::free(raw);
+}
+
+Snapshot TakeSnapshot() {
+    Snapshot snapshot;
+    for (ThreadTable* table = tableList.load(std::memory_order_acquire); table; table = table->next) {
+        for (size_t site = 0; site < MAX_SITES; ++site) {
+            snapshot.liveBlocks[site] += table->liveBlocks[site].load(std::memory_order_relaxed);
+            snapshot.liveBytes[site] += table->liveBytes[site].load(std::memory_order_relaxed);
+            snapshot.allocations[site] += table->allocations[site].load(std::memory_order_relaxed);
         }
+    }
+    return snapshot;
+}
+
+std::string DescribeSite(size_t site) {
+    if (site == 0) return "(other sites: table full)";
+    void* address = reinterpret_cast<void*>(siteAddresses[site].load(std::memory_order_relaxed));
+    char text[64];
+    std::snprintf(text, sizeof(text), "%p", address);
+    std::string description = text;
+#if !defined(_WIN32)
+    // On Windows, resolve addresses with dbghelp's SymFromAddr instead
+    Dl_info info;
+    if (dladdr(address, &info) && info.dli_sname) {
+        int status = 0;
+        char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+        std::snprintf(text, sizeof(text), "+0x%zx",
+                      static_cast<size_t>(static_cast<char*>(address) - static_cast<char*>(info.dli_saddr)));
+        description = std::string(status == 0 ? demangled : info.dli_sname) + text;
+        std::free(demangled);
+    }
+#endif
+    if (description.size() > 70) description = description.substr(0, 67) + "...";
+    return description;
+}
 
-        std::cout << "Optimized time: " << t.ElapsedMs() << " ms\n";
+// Sites whose live blocks grew from `before` to `after`
+void PrintGrowth(const Snapshot& before, const Snapshot& after) {
+    bool any = false;
+    for (size_t site = 0; site < MAX_SITES; ++site) {
+        int64_t blocks = after.liveBlocks[site] - before.liveBlocks[site];
+        if (blocks <= 0) continue;
+        any = true;
+        std::cout << "  +" << std::setw(5) << blocks << " blocks, +" << std::setw(9)
+                  << after.liveBytes[site] - before.liveBytes[site] << " bytes  " << DescribeSite(site) << "\n";
     }
+    if (!any) {
+        std::cout << "  (nothing)\n";
+    }
+}
+
+// Registered with atexit: anything still live here was never freed
+void ReportLeaks() {
+    Snapshot snapshot = TakeSnapshot();
+    std::vector<size_t> leaking;
+    int64_t blocks = 0, bytes = 0;
+    for (size_t site = 0; site < MAX_SITES; ++site) {
+        if (snapshot.liveBlocks[site] <= 0) continue;
+        leaking.push_back(site);
+        blocks += snapshot.liveBlocks[site];
+        bytes += snapshot.liveBytes[site];
+    }
+    std::sort(leaking.begin(), leaking.end(), [&](size_t a, size_t b) {
+        return snapshot.liveBytes[a] > snapshot.liveBytes[b];
+    });
 
-    void ShowOptimizationTips() {
-        std::cout << "\nOptimization Tips for LeakDetection:\n";
-        std::cout << "1. Profile before optimizing\n";
-        std::cout << "2. Focus on hot paths\n";
-        std::cout << "3. Measure the impact\n";
-        std::cout << "4. Consider readability vs performance\n";
+    std::cout << "\n=== Leak Report (at exit) ===\n";
+    if (leaking.empty()) {
+        std::cout << "No leaks: every allocation was freed.\n";
+        return;
     }
+    std::cout << blocks << " blocks (" << bytes << " bytes) never freed, from " << leaking.size() << " site(s):\n";
+    for (size_t site : leaking) {
+        std::cout << "  " << std::setw(6) << snapshot.liveBlocks[site] << " blocks, " << std::setw(9)
+                  << snapshot.liveBytes[site] << " bytes (of " << snapshot.allocations[site]
+                  << " allocations)  " << DescribeSite(site) << "\n";
+    }
+}
+
+struct LeakReportAtExit {
+    LeakReportAtExit() {
+        std::atexit(ReportLeaks);
+    }
+} leakReportAtExit;
+
+} // namespace LeakDetector
+
+// ===== Replacement global allocation functions =====
+//
+// noinline keeps each operator new a real call, so its return address is
+// the line that said new
+
+LEAK_NOINLINE void* operator new(size_t size) {
+    return LeakDetector::AllocateOrThrow(size, 0, LEAK_CALLER());
+}
+
+LEAK_NOINLINE void* operator new[](size_t size) {
+    return LeakDetector::AllocateOrThrow(size, 0, LEAK_CALLER());
+}
+
+LEAK_NOINLINE void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return LeakDetector::Allocate(size, 0, LEAK_CALLER());
+}
+
+LEAK_NOINLINE void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return LeakDetector::Allocate(size, 0, LEAK_CALLER());
+}
+
+LEAK_NOINLINE void* operator new(size_t size, std::align_val_t alignment) {
+    return LeakDetector::AllocateOrThrow(size, static_cast<size_t>(alignment), LEAK_CALLER());
+}
+
+LEAK_NOINLINE void* operator new[](size_t size, std::align_val_t alignment) {
+    return LeakDetector::AllocateOrThrow(size, static_cast<size_t>(alignment), LEAK_CALLER());
+}
+
+LEAK_NOINLINE void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return LeakDetector::Allocate(size, static_cast<size_t>(alignment), LEAK_CALLER());
+}
+
+LEAK_NOINLINE void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return LeakDetector::Allocate(size, static_cast<size_t>(alignment), LEAK_CALLER());
+}
+
+void operator delete(void* block) noexcept { LeakDetector::Free(block, 0); }
+void operator delete[](void* block) noexcept { LeakDetector::Free(block, 0); }
+void operator delete(void* block, size_t) noexcept { LeakDetector::Free(block, 0); }
+void operator delete[](void* block, size_t) noexcept { LeakDetector::Free(block, 0); }
+void operator delete(void* block, const std::nothrow_t&) noexcept { LeakDetector::Free(block, 0); }
+void operator delete[](void* block, const std::nothrow_t&) noexcept { LeakDetector::Free(block, 0); }
+
+void operator delete(void* block, std::align_val_t alignment) noexcept {
+    LeakDetector::Free(block, static_cast<size_t>(alignment));
+}
+void operator delete[](void* block, std::align_val_t alignment) noexcept {
+    LeakDetector::Free(block, static_cast<size_t>(alignment));
+}
+void operator delete(void* block, size_t, std::align_val_t alignment) noexcept {
+    LeakDetector::Free(block, static_cast<size_t>(alignment));
+}
+void operator delete[](void* block, size_t, std::align_val_t alignment) noexcept {
+    LeakDetector::Free(block, static_cast<size_t>(alignment));
+}
+void operator delete(void* block, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    LeakDetector::Free(block, static_cast<size_t>(alignment));
+}
+void operator delete[](void* block, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    LeakDetector::Free(block, static_cast<size_t>(alignment));
+}
+
+// ===== A level that does not clean up after itself =====
+//
+// The loaders are noinline only so the report can name each of them.
+
+struct Texture {
+    std::vector<uint8_t> pixels;
+};
+
+struct Mesh {
+    std::vector<float> vertices;
+};
+
+struct EventListener {
+    int entity;
+    char callback[48];
+};
+
+struct Level {
+    std::vector<std::unique_ptr<Texture>> textures;
+    std::vector<Mesh*> meshes;
+    std::vector<EventListener*> listeners;
+};
+
+LEAK_NOINLINE Texture* LoadTexture(int size) {
+    Texture* texture = new Texture();
+    texture->pixels.resize(static_cast<size_t>(size) * size * 4);
+    return texture;
+}
+
+LEAK_NOINLINE Mesh* LoadMesh(int vertices) {
+    Mesh* mesh = new Mesh();
+    mesh->vertices.resize(static_cast<size_t>(vertices) * 8);
+    return mesh;
+}
+
+LEAK_NOINLINE EventListener* RegisterListener(int entity) {
+    EventListener* listener = new EventListener();
+    listener->entity = entity;
+    return listener;
+}
+
+// Meshes are decoded on a worker thread and freed later by the main
+// thread: cross-thread frees balance out in the summed tables
+Level* LoadLevel(int number) {
+    Level* level = new Level();
+    for (int i = 0; i < 8; ++i) {
+        level->textures.emplace_back(LoadTexture(64 << (i % 3)));
+    }
+    std::thread loader([level, number]() {
+        for (int i = 0; i < 20; ++i) {
+            level->meshes.push_back(LoadMesh(500 + 100 * number));
+        }
+    });
+    loader.join();
+    for (int entity = 0; entity < 50; ++entity) {
+        level->listeners.push_back(RegisterListener(entity));
+    }
+    return level;
+}
+
+// Bug: listeners of entities that respawn are never unregistered
+void UnloadLevel(Level* level) {
+    for (Mesh* mesh : level->meshes) {
+        delete mesh;
+    }
+    for (EventListener* listener : level->listeners) {
+        if (listener->entity % 10 != 0) {
+            delete listener;
+        }
+    }
+    delete level;
+}
+
+// ===== Detector overhead =====
+
+struct Block64 {
+    char bytes[64];
 };
 
+void* volatile escape;  // keeps the compiler from removing allocation pairs
+
+void RunOverheadBenchmark() {
+    const int ITERATIONS = 4000000;
+    std::cout << "=== Detector Overhead (64-byte allocate + free) ===\n";
+
+    Timer baselineTimer;
+    for (int i = 0; i < ITERATIONS; ++i) {
+        void* block = std::malloc(64);
+        escape = block;
+        std::free(block);
+    }
+    double baseline = baselineTimer.ElapsedMs() * 1e6 / ITERATIONS;
+
+    Timer trackedTimer;
+    for (int i = 0; i < ITERATIONS; ++i) {
+        Block64* block = new Block64;
+        escape = block;
+        delete block;
+    }
+    double tracked = trackedTimer.ElapsedMs() * 1e6 / ITERATIONS;
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "malloc + free:          " << baseline << " ns\n";
+    std::cout << "new + delete, tracked:  " << tracked << " ns (+" << tracked - baseline << ")\n";
+    std::cout << "Every block is counted; the cost is a site-table probe and five\n";
+    std::cout << "thread-local counter updates, with no lock.\n\n";
+}
+
+void ShowOptimizationTips() {
+    std::cout << "Optimization Tips for LeakDetection:\n";
+    std::cout << "1. Snapshot before and after a load/unload cycle: growth is a leak\n";
+    std::cout << "2. Own heap objects with std::unique_ptr (the textures above never leak)\n";
+    std::cout << "3. Unregister callbacks and listeners in the same place you register them\n";
+    std::cout << "4. Keep the report at exit in debug builds so new leaks show up immediately\n";
+}
+
 int main() {
     std::cout << "=== Lesson 92: Memory-Optimization ===\n";
     std::cout << "Optimization Topic: LeakDetection\n\n";
 
-    OptimizationDemo demo;
+    std::cout << "=== Load / Unload Cycles ===\n";
+    for (int cycle = 1; cycle <= 3; ++cycle) {
+        LeakDetector::Snapshot before = LeakDetector::TakeSnapshot();
+        Level* level = LoadLevel(cycle);
+        UnloadLevel(level);
+        LeakDetector::Snapshot after = LeakDetector::TakeSnapshot();
 
-    demo.RunBaseline();
-    demo.RunOptimized();
-    demo.ShowOptimizationTips();
+        std::cout << "Cycle " << cycle << ", still live after unloading:\n";
+        LeakDetector::PrintGrowth(before, after);
+    }
+    std::cout << "\n";
+
+    RunOverheadBenchmark();
+    ShowOptimizationTips();
 
     std::cout << "\n=== Benchmark Complete ===\n";
-    return 0;
+    return 0;  // the leak report prints after main returns
 }
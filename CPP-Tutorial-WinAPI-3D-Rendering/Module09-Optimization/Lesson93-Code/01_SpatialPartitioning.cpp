@@ -2,18 +2,34 @@
  * Lesson 93: Algorithm-Optimization
  * Optimization Topic: SpatialPartitioning
  *
- * Performance optimization techniques
+ * Broad-phase collision with a hashed uniform grid:
+ *   - Each object is stored in every cell its AABB overlaps. Cells are
+ *     hashed into a fixed bucket table, so the world needs no bounds.
+ *   - Move() only touches the hash table when the object's cell range
+ *     changes; small moves just update the stored box.
+ *   - AABB and sphere range queries, and a closest-hit raycast that walks
+ *     the cells along the ray (3D DDA).
+ *   - All overlapping pairs, split across threads by bucket range. A pair
+ *     that shares several cells is reported only by the cell holding the
+ *     min corner of the two boxes' overlap, so there are no duplicates.
+ * Baseline: testing all n(n-1)/2 pairs, O(n^2) per frame.
  *
  * Compilation:
  * cl /O2 /EHsc SpatialPartitioning.cpp
- * g++ -O3 -std=c++17 SpatialPartitioning.cpp -o SpatialPartitioning
+ * g++ -O3 -std=c++17 -pthread SpatialPartitioning.cpp -o SpatialPartitioning
  */
 
 #include <iostream>
+#include <iomanip>
 #include <chrono>
 #include <vector>
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <thread>
+#include <utility>
 
 // Timing helper
 class Timer {
@@ -27,52 +43,556 @@ public:
     }
 };
 
-// Optimization demonstration for: SpatialPartitioning
+struct Vec3 {
+    float x, y, z;
+    Vec3() : x(0), y(0), z(0) {}
+    Vec3(float x, float y, float z) : x(x), y(y), z(z) {}
+    Vec3 operator+(const Vec3& o) const { return Vec3(x + o.x, y + o.y, z + o.z); }
+    Vec3 operator-(const Vec3& o) const { return Vec3(x - o.x, y - o.y, z - o.z); }
+    Vec3 operator*(float s) const { return Vec3(x * s, y * s, z * s); }
+    float operator[](int i) const { return i == 0 ? x : (i == 1 ? y : z); }
+};
+
+struct AABB {
+    Vec3 min, max;
+};
+
+inline bool Overlaps(const AABB& a, const AABB& b) {
+    return a.min.x <= b.max.x && a.max.x >= b.min.x &&
+           a.min.y <= b.max.y && a.max.y >= b.min.y &&
+           a.min.z <= b.max.z && a.max.z >= b.min.z;
+}
+
+// Squared distance from the sphere center to the closest point of the box
+inline bool SphereOverlaps(const AABB& box, const Vec3& center, float radius) {
+    float d = 0.0f;
+    for (int i = 0; i < 3; ++i) {
+        float c = center[i];
+        float e = c < box.min[i] ? box.min[i] - c : (c > box.max[i] ? c - box.max[i] : 0.0f);
+        d += e * e;
+    }
+    return d <= radius * radius;
+}
+
+// Slab test; entry distance (0 if the origin is inside) or infinity
+inline float RayEntry(const AABB& box, const Vec3& origin, const Vec3& invDir, float maxT) {
+    float tx0 = (box.min.x - origin.x) * invDir.x, tx1 = (box.max.x - origin.x) * invDir.x;
+    float ty0 = (box.min.y - origin.y) * invDir.y, ty1 = (box.max.y - origin.y) * invDir.y;
+    float tz0 = (box.min.z - origin.z) * invDir.z, tz1 = (box.max.z - origin.z) * invDir.z;
+    float enter = std::max({std::min(tx0, tx1), std::min(ty0, ty1), std::min(tz0, tz1), 0.0f});
+    float exit = std::min({std::max(tx0, tx1), std::max(ty0, ty1), std::max(tz0, tz1), maxT});
+    return exit >= enter ? enter : std::numeric_limits<float>::infinity();
+}
+
+// Slab test; distance at which the ray leaves the box
+inline float RayExit(const AABB& box, const Vec3& origin, const Vec3& invDir) {
+    float tx = std::max((box.min.x - origin.x) * invDir.x, (box.max.x - origin.x) * invDir.x);
+    float ty = std::max((box.min.y - origin.y) * invDir.y, (box.max.y - origin.y) * invDir.y);
+    float tz = std::max((box.min.z - origin.z) * invDir.z, (box.max.z - origin.z) * invDir.z);
+    return std::min({tx, ty, tz});
+}
+
+struct RayHit {
+    static const uint32_t NONE = 0xFFFFFFFFu;
+    uint32_t id = NONE;
+    float t = std::numeric_limits<float>::infinity();
+};
+
+using Pair = std::pair<uint32_t, uint32_t>;  // first < second
+
+class SpatialHashGrid {
+public:
+    // cellSize around twice the typical object size keeps most objects
+    // in 1-8 cells; the table gets about two buckets per object
+    SpatialHashGrid(float cellSize, size_t expectedObjects)
+        : cellSize(cellSize), invCellSize(1.0f / cellSize) {
+        size_t size = 1024;
+        while (size < expectedObjects * 2) size *= 2;
+        buckets.resize(size);
+        mask = static_cast<uint32_t>(size - 1);
+    }
+
+    uint32_t Insert(const AABB& box) {
+        uint32_t id;
+        if (!freeIds.empty()) {
+            id = freeIds.back();
+            freeIds.pop_back();
+        } else {
+            id = static_cast<uint32_t>(objects.size());
+            objects.emplace_back();
+        }
+        Object& object = objects[id];
+        object.box = box;
+        object.cells = CellsOf(box);
+        object.alive = true;
+        AddToCells(id, object.cells);
+        return id;
+    }
+
+    // Incremental update: the hash table only changes when the box
+    // crosses into a different set of cells
+    void Move(uint32_t id, const AABB& box) {
+        Object& object = objects[id];
+        CellRange cells = CellsOf(box);
+        object.box = box;
+        if (cells == object.cells) return;
+        RemoveFromCells(id, object.cells);
+        AddToCells(id, cells);
+        object.cells = cells;
+        ++rehashedMoves;
+    }
+
+    void Remove(uint32_t id) {
+        RemoveFromCells(id, objects[id].cells);
+        objects[id].alive = false;
+        freeIds.push_back(id);
+    }
+
+    void Clear() {
+        for (std::vector<uint32_t>& bucket : buckets) bucket.clear();
+        objects.clear();
+        freeIds.clear();
+        occupiedCells = false;
+    }
+
+    // Every object overlapping the box, each reported once
+    void QueryAABB(const AABB& box, std::vector<uint32_t>& out) const {
+        CellRange range = CellsOf(box);
+        ForEachCell(range, [&](int x, int y, int z) {
+            for (uint32_t id : buckets[Hash(x, y, z)]) {
+                const AABB& other = objects[id].box;
+                if (Overlaps(box, other) && OwnsOverlap(x, y, z, box, other)) out.push_back(id);
+            }
+        });
+    }
+
+    void QuerySphere(const Vec3& center, float radius, std::vector<uint32_t>& out) const {
+        AABB box{center - Vec3(radius, radius, radius), center + Vec3(radius, radius, radius)};
+        CellRange range = CellsOf(box);
+        ForEachCell(range, [&](int x, int y, int z) {
+            for (uint32_t id : buckets[Hash(x, y, z)]) {
+                const AABB& other = objects[id].box;
+                if (SphereOverlaps(other, center, radius) && OwnsOverlap(x, y, z, box, other)) out.push_back(id);
+            }
+        });
+    }
+
+    // Closest object box hit by the ray within maxDistance. Walks the
+    // cells in ray order and stops once the best hit is inside the
+    // current cell, since anything further away starts in a later cell.
+    // The table itself is unbounded, so the walk is clipped to the cells
+    // that have held objects: a miss ends where the ray leaves them, even
+    // with maxDistance = infinity.
+    RayHit Raycast(const Vec3& origin, const Vec3& direction, float maxDistance) const {
+        RayHit hit;
+        if (!occupiedCells) return hit;
+        const Vec3 invDir(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+        const AABB bounds{Vec3(occupied.min[0], occupied.min[1], occupied.min[2]) * cellSize,
+                          Vec3(occupied.max[0] + 1, occupied.max[1] + 1, occupied.max[2] + 1) * cellSize};
+        const float tStart = RayEntry(bounds, origin, invDir, maxDistance);
+        if (tStart == std::numeric_limits<float>::infinity()) return hit;
+        const float tEnd = std::min(maxDistance, RayExit(bounds, origin, invDir));
+        const Vec3 start = origin + direction * tStart;
+
+        int cell[3], step[3];
+        float tNext[3], tDelta[3];
+        for (int a = 0; a < 3; ++a) {
+            cell[a] = std::clamp(CellCoord(start[a]), occupied.min[a], occupied.max[a]);
+            float d = direction[a];
+            step[a] = d > 0.0f ? 1 : -1;
+            float boundary = (cell[a] + (d > 0.0f ? 1 : 0)) * cellSize;
+            tNext[a] = d != 0.0f ? (boundary - origin[a]) * invDir[a] : std::numeric_limits<float>::infinity();
+            tDelta[a] = d != 0.0f ? cellSize * std::abs(invDir[a]) : std::numeric_limits<float>::infinity();
+        }
+
+        while (true) {
+            for (uint32_t id : buckets[Hash(cell[0], cell[1], cell[2])]) {
+                float t = RayEntry(objects[id].box, origin, invDir, std::min(hit.t, maxDistance));
+                if (t < hit.t) {
+                    hit.t = t;
+                    hit.id = id;
+                }
+            }
+            int axis = tNext[0] < tNext[1] ? (tNext[0] < tNext[2] ? 0 : 2) : (tNext[1] < tNext[2] ? 1 : 2);
+            float cellExit = tNext[axis];
+            if (hit.t <= cellExit || cellExit > tEnd) return hit;
+            cell[axis] += step[axis];
+            tNext[axis] += tDelta[axis];
+        }
+    }
+
+    // All overlapping pairs. Buckets are read-only here, so threads take
+    // contiguous bucket ranges and fill their own vectors.
+    void FindPairs(std::vector<Pair>& pairs, unsigned threadCount) const {
+        pairs.clear();
+        threadCount = std::max(1u, threadCount);
+        std::vector<std::vector<Pair>> local(threadCount);
+        std::vector<std::thread> workers;
+        const size_t perThread = (buckets.size() + threadCount - 1) / threadCount;
+        for (unsigned t = 0; t < threadCount; ++t) {
+            size_t first = std::min(buckets.size(), t * perThread);
+            size_t last = std::min(buckets.size(), first + perThread);
+            auto work = [this, &local, t, first, last] { PairsInBuckets(first, last, local[t]); };
+            if (t + 1 == threadCount) {
+                work();
+            } else {
+                workers.emplace_back(work);
+            }
+        }
+        for (std::thread& worker : workers) worker.join();
+        for (const std::vector<Pair>& part : local) pairs.insert(pairs.end(), part.begin(), part.end());
+    }
+
+    const AABB& Bounds(uint32_t id) const { return objects[id].box; }
+    size_t BucketCount() const { return buckets.size(); }
+    size_t RehashedMoves() const { return rehashedMoves; }
+
+private:
+    struct CellRange {
+        int min[3], max[3];
+        bool operator==(const CellRange& o) const {
+            return std::equal(min, min + 3, o.min) && std::equal(max, max + 3, o.max);
+        }
+    };
+
+    struct Object {
+        AABB box;
+        CellRange cells;
+        bool alive = false;
+    };
+
+    float cellSize, invCellSize;
+    uint32_t mask;
+    std::vector<std::vector<uint32_t>> buckets;
+    std::vector<Object> objects;
+    std::vector<uint32_t> freeIds;
+    size_t rehashedMoves = 0;
+    CellRange occupied;            // union of every range stored; never shrinks
+    bool occupiedCells = false;
+
+    int CellCoord(float v) const { return static_cast<int>(std::floor(v * invCellSize)); }
+
+    CellRange CellsOf(const AABB& box) const {
+        CellRange range;
+        for (int a = 0; a < 3; ++a) {
+            range.min[a] = CellCoord(box.min[a]);
+            range.max[a] = CellCoord(box.max[a]);
+        }
+        return range;
+    }
+
+    // Teschner et al. 2003; different cells may share a bucket
+    uint32_t Hash(int x, int y, int z) const {
+        return (static_cast<uint32_t>(x) * 73856093u ^ static_cast<uint32_t>(y) * 19349663u ^
+                static_cast<uint32_t>(z) * 83492791u) & mask;
+    }
+
+    template <typename F>
+    static void ForEachCell(const CellRange& r, F&& f) {
+        for (int z = r.min[2]; z <= r.max[2]; ++z)
+            for (int y = r.min[1]; y <= r.max[1]; ++y)
+                for (int x = r.min[0]; x <= r.max[0]; ++x) f(x, y, z);
+    }
+
+    // True for exactly one cell of each overlapping pair: the one holding
+    // the min corner of the overlap region, which both boxes touch
+    bool OwnsOverlap(int x, int y, int z, const AABB& a, const AABB& b) const {
+        return CellCoord(std::max(a.min.x, b.min.x)) == x &&
+               CellCoord(std::max(a.min.y, b.min.y)) == y &&
+               CellCoord(std::max(a.min.z, b.min.z)) == z;
+    }
+
+    // Two cells of one object can hash to the same bucket; it is stored
+    // there once so pairs are not enumerated twice
+    void AddToCells(uint32_t id, const CellRange& range) {
+        for (int a = 0; a < 3; ++a) {
+            occupied.min[a] = occupiedCells ? std::min(occupied.min[a], range.min[a]) : range.min[a];
+            occupied.max[a] = occupiedCells ? std::max(occupied.max[a], range.max[a]) : range.max[a];
+        }
+        occupiedCells = true;
+        ForEachCell(range, [&](int x, int y, int z) {
+            std::vector<uint32_t>& bucket = buckets[Hash(x, y, z)];
+            if (std::find(bucket.begin(), bucket.end(), id) == bucket.end()) bucket.push_back(id);
+        });
+    }
+
+    void RemoveFromCells(uint32_t id, const CellRange& range) {
+        ForEachCell(range, [&](int x, int y, int z) {
+            std::vector<uint32_t>& bucket = buckets[Hash(x, y, z)];
+            auto it = std::find(bucket.begin(), bucket.end(), id);
+            if (it != bucket.end()) {
+                *it = bucket.back();
+                bucket.pop_back();
+            }
+        });
+    }
+
+    void PairsInBuckets(size_t first, size_t last, std::vector<Pair>& out) const {
+        for (size_t b = first; b < last; ++b) {
+            const std::vector<uint32_t>& bucket = buckets[b];
+            for (size_t i = 0; i + 1 < bucket.size(); ++i) {
+                const AABB& boxA = objects[bucket[i]].box;
+                for (size_t j = i + 1; j < bucket.size(); ++j) {
+                    const AABB& boxB = objects[bucket[j]].box;
+                    if (!Overlaps(boxA, boxB)) continue;
+                    // Only the bucket of the owning cell reports the pair
+                    uint32_t owner = Hash(CellCoord(std::max(boxA.min.x, boxB.min.x)),
+                                          CellCoord(std::max(boxA.min.y, boxB.min.y)),
+                                          CellCoord(std::max(boxA.min.z, boxB.min.z)));
+                    if (owner != b) continue;
+                    out.emplace_back(std::min(bucket[i], bucket[j]), std::max(bucket[i], bucket[j]));
+                }
+            }
+        }
+    }
+};
+
+// Moving objects in a cube whose side grows with the count, so density
+// (and pairs per object) stays about the same at every size. Most boxes
+// are 0.5-2 units wide; 1% are 4-8 units.
+struct World {
+    float size;
+    std::vector<AABB> boxes;
+    std::vector<Vec3> velocities;
+
+    World(size_t count, uint32_t seed) : size(4.0f * std::cbrt(static_cast<float>(count))) {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> position(0.0f, size);
+        std::uniform_real_distribution<float> half(0.25f, 1.0f);
+        std::uniform_real_distribution<float> bigHalf(2.0f, 4.0f);
+        std::uniform_real_distribution<float> speed(-3.0f, 3.0f);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        boxes.resize(count);
+        velocities.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            Vec3 c(position(rng), position(rng), position(rng));
+            float h = unit(rng) < 0.01f ? bigHalf(rng) : half(rng);
+            Vec3 e(h, h * (0.5f + unit(rng)), h);
+            boxes[i] = {c - e, c + e};
+            velocities[i] = Vec3(speed(rng), speed(rng), speed(rng));
+        }
+    }
+
+    // One 60 Hz step; boxes bounce off the walls
+    void Step() {
+        const float dt = 1.0f / 60.0f;
+        for (size_t i = 0; i < boxes.size(); ++i) {
+            AABB& b = boxes[i];
+            Vec3& v = velocities[i];
+            Vec3 d = v * dt;
+            b.min = b.min + d;
+            b.max = b.max + d;
+            if ((b.min.x < 0.0f && v.x < 0.0f) || (b.max.x > size && v.x > 0.0f)) v.x = -v.x;
+            if ((b.min.y < 0.0f && v.y < 0.0f) || (b.max.y > size && v.y > 0.0f)) v.y = -v.y;
+            if ((b.min.z < 0.0f && v.z < 0.0f) || (b.max.z > size && v.z > 0.0f)) v.z = -v.z;
+        }
+    }
+};
+
+// O(n^2) reference
+void BruteForcePairs(const std::vector<AABB>& boxes, std::vector<Pair>& pairs) {
+    pairs.clear();
+    for (size_t i = 0; i < boxes.size(); ++i) {
+        for (size_t j = i + 1; j < boxes.size(); ++j) {
+            if (Overlaps(boxes[i], boxes[j])) pairs.emplace_back(static_cast<uint32_t>(i), static_cast<uint32_t>(j));
+        }
+    }
+}
+
+bool SamePairs(std::vector<Pair> a, std::vector<Pair> b) {
+    std::sort(a.begin(), a.end());
+    std::sort(b.begin(), b.end());
+    return a == b;
+}
+
 class OptimizationDemo {
 public:
-    void RunBaseline() {
-        std::cout << "Running baseline implementation...\n";
+    explicit OptimizationDemo(unsigned threads) : threads(threads) {}
+
+    // Per frame: step the world, update the structure, find all pairs
+    void RunBaseline(size_t count, int frames) {
+        World world(count, 93);
+        std::vector<Pair> pairs;
         Timer t;
+        for (int f = 0; f < frames; ++f) {
+            world.Step();
+            BruteForcePairs(world.boxes, pairs);
+        }
+        bruteMs = t.ElapsedMs() / frames;
+        brutePairs = pairs;
+        std::cout << "  O(n^2):      " << std::fixed << std::setprecision(2) << std::setw(9) << bruteMs
+                  << " ms/frame, " << pairs.size() << " pairs\n";
+    }
+
+    void RunOptimized(size_t count, int frames, bool verify) {
+        World world(count, 93);
+        SpatialHashGrid grid(4.0f, count);
+        for (const AABB& box : world.boxes) grid.Insert(box);
+
+        std::vector<Pair> pairs;
+        double moveMs = 0.0, pairMs = 0.0, pairThreadedMs = 0.0;
+        for (int f = 0; f < frames; ++f) {
+            world.Step();
+            Timer move;
+            for (size_t i = 0; i < count; ++i) grid.Move(static_cast<uint32_t>(i), world.boxes[i]);
+            moveMs += move.ElapsedMs();
+
+            Timer single;
+            grid.FindPairs(pairs, 1);
+            pairMs += single.ElapsedMs();
 
-        // Baseline code (unoptimized)
-        volatile int result = 0;
-        for (int i = 0; i < 1000000; ++i) {
-            result += i * 2;
+            Timer threaded;
+            grid.FindPairs(pairs, threads);
+            pairThreadedMs += threaded.ElapsedMs();
         }
 
-        std::cout << "Baseline time: " << t.ElapsedMs() << " ms\n";
+        // Rebuilding from scratch each frame instead of moving
+        Timer rebuild;
+        grid.Clear();
+        for (const AABB& box : world.boxes) grid.Insert(box);
+        double rebuildMs = rebuild.ElapsedMs();
+
+        std::cout << std::fixed << std::setprecision(2)
+                  << "  Hash grid:   move " << moveMs / frames << " ms ("
+                  << std::setprecision(1) << 100.0 * grid.RehashedMoves() / (count * static_cast<double>(frames))
+                  << "% changed cells, rebuild would be " << std::setprecision(2) << rebuildMs << " ms)\n"
+                  << "               pairs " << pairMs / frames << " ms on 1 thread, "
+                  << pairThreadedMs / frames << " ms on " << threads << ", " << pairs.size() << " pairs\n";
+        if (verify) {
+            std::cout << "               matches O(n^2): " << (SamePairs(pairs, brutePairs) ? "yes" : "NO") << "\n";
+        } else if (bruteMs > 0.0) {
+            double scale = static_cast<double>(count) / bruteCount;
+            std::cout << "               O(n^2) would take ~" << std::setprecision(0) << bruteMs * scale * scale
+                      << " ms/frame\n";
+        }
     }
 
-    void RunOptimized() {
-        std::cout << "Running optimized implementation...\n";
-        Timer t;
+    // 1000 of each query against a linear scan of every object
+    void RunQueries(size_t count) {
+        World world(count, 7);
+        SpatialHashGrid grid(4.0f, count);
+        for (const AABB& box : world.boxes) grid.Insert(box);
+
+        std::mt19937 rng(1);
+        std::uniform_real_distribution<float> position(0.0f, world.size);
+        std::uniform_real_distribution<float> direction(-1.0f, 1.0f);
+        const int queries = 1000;
+        std::vector<uint32_t> found;
+        size_t gridResults = 0, scanResults = 0, mismatches = 0;
+
+        Timer gridTimer;
+        for (int q = 0; q < queries; ++q) {
+            Vec3 c(position(rng), position(rng), position(rng));
+            found.clear();
+            grid.QueryAABB({c - Vec3(5, 5, 5), c + Vec3(5, 5, 5)}, found);
+            grid.QuerySphere(c, 5.0f, found);
+            gridResults += found.size();
+        }
+        double gridMs = gridTimer.ElapsedMs();
 
-        // Optimized code
-        volatile int result = 0;
-        for (int i = 0; i < 1000000; ++i) {
-            result += i << 1;  // Bitshift instead of multiplication
+        rng.seed(1);
+        Timer scanTimer;
+        for (int q = 0; q < queries; ++q) {
+            Vec3 c(position(rng), position(rng), position(rng));
+            AABB box{c - Vec3(5, 5, 5), c + Vec3(5, 5, 5)};
+            for (const AABB& other : world.boxes) {
+                scanResults += Overlaps(box, other);
+                scanResults += SphereOverlaps(other, c, 5.0f);
+            }
         }
+        double scanMs = scanTimer.ElapsedMs();
 
-        std::cout << "Optimized time: " << t.ElapsedMs() << " ms\n";
+        // Rays from random points in random directions, 50 units long
+        std::vector<Vec3> origins(queries), directions(queries);
+        for (int q = 0; q < queries; ++q) {
+            origins[q] = Vec3(position(rng), position(rng), position(rng));
+            Vec3 d(direction(rng), direction(rng), direction(rng));
+            directions[q] = d * (1.0f / std::sqrt(d.x * d.x + d.y * d.y + d.z * d.z + 1e-12f));
+        }
+        std::vector<RayHit> hits(queries);
+        Timer rayTimer;
+        for (int q = 0; q < queries; ++q) hits[q] = grid.Raycast(origins[q], directions[q], 50.0f);
+        double rayMs = rayTimer.ElapsedMs();
+
+        Timer rayScanTimer;
+        for (int q = 0; q < queries; ++q) {
+            Vec3 inv(1.0f / directions[q].x, 1.0f / directions[q].y, 1.0f / directions[q].z);
+            RayHit best;
+            for (size_t i = 0; i < world.boxes.size(); ++i) {
+                float t = RayEntry(world.boxes[i], origins[q], inv, std::min(best.t, 50.0f));
+                if (t < best.t) {
+                    best.t = t;
+                    best.id = static_cast<uint32_t>(i);
+                }
+            }
+            mismatches += best.t != hits[q].t;
+        }
+        double rayScanMs = rayScanTimer.ElapsedMs();
+
+        // Unbounded rays: the same rays with no length limit must still
+        // match the scan, and rays leaving the world must end as misses
+        const float unbounded = std::numeric_limits<float>::infinity();
+        size_t unboundedMismatches = 0, escapedHits = 0;
+        for (int q = 0; q < queries; ++q) {
+            Vec3 inv(1.0f / directions[q].x, 1.0f / directions[q].y, 1.0f / directions[q].z);
+            RayHit best;
+            for (size_t i = 0; i < world.boxes.size(); ++i) {
+                float t = RayEntry(world.boxes[i], origins[q], inv, best.t);
+                if (t < best.t) best.t = t;
+            }
+            unboundedMismatches += best.t != grid.Raycast(origins[q], directions[q], unbounded).t;
+
+            Vec3 outside = origins[q] + directions[q] * (4.0f * world.size);
+            escapedHits += grid.Raycast(outside, directions[q], unbounded).id != RayHit::NONE;
+        }
+
+        std::cout << std::fixed << std::setprecision(2)
+                  << "  AABB + sphere: grid " << gridMs << " ms, scan " << scanMs << " ms ("
+                  << gridResults << " / " << scanResults << " results)\n"
+                  << "  Raycast:       grid " << rayMs << " ms, scan " << rayScanMs << " ms ("
+                  << mismatches << " mismatches)\n"
+                  << "  Unbounded ray: " << unboundedMismatches << " mismatches, "
+                  << escapedHits << " hits from rays leaving the world (expect 0)\n";
     }
 
     void ShowOptimizationTips() {
         std::cout << "\nOptimization Tips for SpatialPartitioning:\n";
-        std::cout << "1. Profile before optimizing\n";
-        std::cout << "2. Focus on hot paths\n";
-        std::cout << "3. Measure the impact\n";
-        std::cout << "4. Consider readability vs performance\n";
+        std::cout << "1. Only objects sharing a cell are tested: O(n) pairs work instead of O(n^2)\n";
+        std::cout << "2. Size cells to about twice the common object; huge objects fill many cells\n";
+        std::cout << "3. Hashing cells into a fixed table needs no world bounds and no empty-cell storage\n";
+        std::cout << "4. Skip the hash table when a moved object stays in the same cells\n";
+        std::cout << "5. Report a pair only from one cell instead of de-duplicating afterwards\n";
     }
+
+    size_t bruteCount = 0;
+
+private:
+    unsigned threads;
+    double bruteMs = 0.0;
+    std::vector<Pair> brutePairs;
 };
 
 int main() {
     std::cout << "=== Lesson 93: Algorithm-Optimization ===\n";
     std::cout << "Optimization Topic: SpatialPartitioning\n\n";
 
-    OptimizationDemo demo;
+    const unsigned threads = std::max(2u, std::thread::hardware_concurrency());
+    OptimizationDemo demo(threads);
+
+    for (size_t count : {1000u, 10000u, 100000u, 1000000u}) {
+        std::cout << "--- " << count << " moving objects ---\n";
+        bool brute = count <= 10000;
+        int frames = count <= 10000 ? 10 : (count <= 100000 ? 5 : 2);
+        if (brute) {
+            demo.bruteCount = count;
+            demo.RunBaseline(count, frames);
+        }
+        demo.RunOptimized(count, frames, brute);
+        std::cout << "\n";
+    }
 
-    demo.RunBaseline();
-    demo.RunOptimized();
+    std::cout << "--- Range queries, 100000 objects, 1000 queries ---\n";
+    demo.RunQueries(100000);
     demo.ShowOptimizationTips();
 
     std::cout << "\n=== Benchmark Complete ===\n";